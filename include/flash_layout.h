@@ -0,0 +1,32 @@
+#ifndef FLASH_LAYOUT_H
+#define FLASH_LAYOUT_H
+
+// Flash regions used by the OTA code, for eagle.flash.4m2m.ld:
+//
+//   0x000000  sketch (eboot + app)
+//   ........  OTA staging, placed by Updater (or ota_delta) right below FS_PHYS_ADDR
+//   0x200000  FS_PHYS_ADDR: backup slot header (1 sector)
+//   0x201000  backup image (copy of the last confirmed sketch)
+//   ........  OTA journal, last JOURNAL_SECTORS sectors of the FS region
+//
+// The sketch does not mount a file system, the FS region is ours.
+// Host tools include this header without the core and get the 4m2m values.
+
+#ifdef ARDUINO
+#include <flash_hal.h>
+#else
+#define FS_PHYS_ADDR      0x200000u
+#define FS_PHYS_SIZE      0x1FA000u
+#define FLASH_SECTOR_SIZE 4096u
+#endif
+
+#define BACKUP_HDR_ADDR   (FS_PHYS_ADDR)
+#define BACKUP_IMG_ADDR   (FS_PHYS_ADDR + FLASH_SECTOR_SIZE)
+#ifndef JOURNAL_SECTORS
+#define JOURNAL_SECTORS 2
+#endif
+#define JOURNAL_ADDR      (FS_PHYS_ADDR + FS_PHYS_SIZE - JOURNAL_SECTORS * FLASH_SECTOR_SIZE)
+
+#define BACKUP_MAX_SIZE   (JOURNAL_ADDR - BACKUP_IMG_ADDR)
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef HTTP_BODY_H
+#define HTTP_BODY_H
+
+#include <Arduino.h>
+
+// A response body as a Stream, for parsers that read straight from the
+// connection (deserializeJson). HTTPClient::getStream() hands out the raw
+// connection: with HTTP/1.1 that includes the chunked framing, and on a
+// kept-alive connection the next response follows right after the body.
+// This stream stops at the end of the body (Content-Length) or decodes the
+// chunked transfer coding on the fly; drain() consumes what the parser left
+// (trailing whitespace, the last chunk, trailers) so the connection can be
+// reused. Without a length and without chunking the body ends with the
+// connection, which then cannot be reused.
+
+class HttpBodyStream : public Stream {
+ public:
+  HttpBodyStream(Stream& in, int contentLength, bool chunked);
+
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t) override { return 0; }
+
+  // Reads to the end of the body; true if it ended where the framing says
+  bool drain(uint32_t timeoutMs);
+  bool done() const { return _state == DONE; }
+  bool failed() const { return _state == FAILED; }
+
+ private:
+  enum State : uint8_t {
+    DATA,        // _left body bytes before the next framing
+    SIZE,        // chunk size, hex
+    SIZE_END,    // whitespace/CR after the size: no more digits
+    EXTENSION,   // ";name=value" after the size, ignored
+    DATA_END,    // CRLF after the chunk data
+    TRAILER,     // header lines after the last chunk, up to an empty line
+    UNTIL_CLOSE, // no length: everything until the connection ends
+    DONE,
+    FAILED,
+  };
+
+  bool frame();   // consumes available framing bytes; true when at body data
+
+  Stream& _in;
+  uint32_t _left;
+  uint16_t _lineLen = 0;
+  bool _chunked;
+  bool _digits = false;
+  State _state;
+};
+
+#endif
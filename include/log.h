@@ -0,0 +1,123 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+
+// Structured logging with compile-time level filtering.
+//
+//   LOGI("OTA", "Free heap: %u bytes", heap);   ->  "[OTA] Free heap: 1234 bytes"
+//
+// Levels above LOG_LEVEL expand to nothing: the format string is not
+// emitted and the arguments are not evaluated. Enabled calls only copy the
+// flash format pointer and the raw arguments into a ring buffer; formatting
+// and UART output happen later in logLoop(), limited to what the UART FIFO
+// takes without blocking. Supported conversions: %d %i %u %x %X %c %s %f %%
+// with flags/width/precision and the l/ll length modifiers.
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 1024     // bytes of pending records
+#endif
+#ifndef LOG_MAX_STR
+#define LOG_MAX_STR 96         // string arguments are copied, truncated to this
+#endif
+#ifndef LOG_MAX_ARGS
+#define LOG_MAX_ARGS 128       // packed argument bytes per record
+#endif
+
+#define LOG_ELIDED() do {} while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOGE(tag, fmt, ...) logWrite(LOG_LEVEL_ERROR, PSTR("[" tag "] " fmt), ##__VA_ARGS__)
+#else
+#define LOGE(tag, fmt, ...) LOG_ELIDED()
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOGW(tag, fmt, ...) logWrite(LOG_LEVEL_WARN, PSTR("[" tag "] " fmt), ##__VA_ARGS__)
+#else
+#define LOGW(tag, fmt, ...) LOG_ELIDED()
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOGI(tag, fmt, ...) logWrite(LOG_LEVEL_INFO, PSTR("[" tag "] " fmt), ##__VA_ARGS__)
+#else
+#define LOGI(tag, fmt, ...) LOG_ELIDED()
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOGD(tag, fmt, ...) logWrite(LOG_LEVEL_DEBUG, PSTR("[" tag "] " fmt), ##__VA_ARGS__)
+#else
+#define LOGD(tag, fmt, ...) LOG_ELIDED()
+#endif
+
+void logBegin(HardwareSerial& out);
+void logLoop();                  // non-blocking drain, call from loop() and long-running callbacks
+void logFlush();                 // blocking drain, before restart/deep sleep
+uint32_t logDropped();           // records lost to a full ring
+
+// --- record encoding, used by the macros ---
+
+enum LogArgType : uint8_t {
+  LOG_ARG_I32 = 'i',
+  LOG_ARG_U32 = 'u',
+  LOG_ARG_I64 = 'I',
+  LOG_ARG_U64 = 'U',
+  LOG_ARG_F32 = 'f',
+  LOG_ARG_STR = 's',
+};
+
+struct LogRecord {
+  uint8_t buf[LOG_MAX_ARGS];
+  uint8_t len = 0;
+  bool overflow = false;
+
+  void put(uint8_t type, const void* data, uint8_t n) {
+    if (overflow || (size_t)len + 1 + n > sizeof(buf)) { overflow = true; return; }
+    buf[len++] = type;
+    memcpy(buf + len, data, n);
+    len += n;
+  }
+};
+
+inline void logArg(LogRecord& r, int v) { int32_t x = v; r.put(LOG_ARG_I32, &x, 4); }
+inline void logArg(LogRecord& r, long v) { int32_t x = v; r.put(LOG_ARG_I32, &x, 4); }
+inline void logArg(LogRecord& r, unsigned int v) { uint32_t x = v; r.put(LOG_ARG_U32, &x, 4); }
+inline void logArg(LogRecord& r, unsigned long v) { uint32_t x = v; r.put(LOG_ARG_U32, &x, 4); }
+inline void logArg(LogRecord& r, long long v) { r.put(LOG_ARG_I64, &v, 8); }
+inline void logArg(LogRecord& r, unsigned long long v) { r.put(LOG_ARG_U64, &v, 8); }
+inline void logArg(LogRecord& r, char v) { int32_t x = v; r.put(LOG_ARG_I32, &x, 4); }
+inline void logArg(LogRecord& r, unsigned char v) { uint32_t x = v; r.put(LOG_ARG_U32, &x, 4); }
+inline void logArg(LogRecord& r, short v) { int32_t x = v; r.put(LOG_ARG_I32, &x, 4); }
+inline void logArg(LogRecord& r, unsigned short v) { uint32_t x = v; r.put(LOG_ARG_U32, &x, 4); }
+inline void logArg(LogRecord& r, bool v) { uint32_t x = v; r.put(LOG_ARG_U32, &x, 4); }
+inline void logArg(LogRecord& r, double v) { float x = v; r.put(LOG_ARG_F32, &x, 4); }
+void logArg(LogRecord& r, const char* s);
+inline void logArg(LogRecord& r, const String& s) { logArg(r, s.c_str()); }
+
+void logCommit(uint8_t level, PGM_P fmt, const LogRecord& r);
+
+inline void logPack(LogRecord&) {}
+template <typename T, typename... Rest>
+inline void logPack(LogRecord& r, const T& first, const Rest&... rest) {
+  logArg(r, first);
+  logPack(r, rest...);
+}
+
+template <typename... Args>
+inline void logWrite(uint8_t level, PGM_P fmt, const Args&... args) {
+  LogRecord r;
+  logPack(r, args...);
+  logCommit(level, fmt, r);
+}
+
+#endif
@@ -0,0 +1,215 @@
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "rollback.h"
+
+// The fields of the update manifest the device acts on. tools/release
+// publishes them twice:
+//
+//   manifest.json   the full record (digests, .gz, signatures, size report)
+//                   for tools and people; the device parses it through an
+//                   ArduinoJson filter into a static document
+//   manifest.cbor   only the fields below, as a CBOR map (RFC 8949) with
+//                   small unsigned keys, decoded straight off the connection
+//                   into ManifestFields: no document, no allocation
+//
+// The device reads CBOR when the URL ends in ".cbor" or the server answers
+// with Content-Type application/cbor (it asks for that with Accept, so a
+// server that negotiates can serve either under one URL). Unknown keys are
+// skipped, so later fields do not break older devices. Lengths are
+// definite; a string that does not fit its field fails the manifest.
+//
+// The CBOR part has no core dependencies and is shared with tools/release
+// (which decodes what it wrote as part of its validation).
+
+#define MANIFEST_MODEL_LEN 32
+#define MANIFEST_URL_LEN 256           // firmware image and hash list
+#define MANIFEST_MIRRORS_LEN 256       // base URLs, space separated (mirrorsAdd)
+#define MANIFEST_WINDOW_LEN 12         // "HH:MM-HH:MM"
+#define MANIFEST_CBOR_MAX_DEPTH 4      // nesting of skipped values
+
+enum ManifestKey : uint8_t {
+  MANIFEST_KEY_MODEL = 1,
+  MANIFEST_KEY_VERSION = 2,
+  MANIFEST_KEY_URL = 3,
+  MANIFEST_KEY_SECTORS = 4,            // "" = no incremental update
+  MANIFEST_KEY_MIRRORS = 5,            // array of text
+  MANIFEST_KEY_REBOOT_WINDOW = 6,
+  MANIFEST_KEY_REBOOT_DEADLINE = 7,    // unsigned, seconds
+};
+
+enum ManifestError : uint8_t {
+  MANIFEST_OK = 0,
+  MANIFEST_TRUNCATED,                  // input ended inside an item
+  MANIFEST_MALFORMED,                  // not a map, wrong type, indefinite length
+  MANIFEST_TOO_LONG,                   // a string does not fit its field
+};
+
+struct ManifestFields {
+  char model[MANIFEST_MODEL_LEN];
+  char version[ROLLBACK_VERSION_LEN];
+  char url[MANIFEST_URL_LEN];
+  char sectors[MANIFEST_URL_LEN];
+  char mirrors[MANIFEST_MIRRORS_LEN];
+  char rebootWindow[MANIFEST_WINDOW_LEN];
+  uint32_t rebootDeadline;             // 0 = none
+};
+
+inline const char* manifestErrorName(ManifestError e) {
+  switch (e) {
+    case MANIFEST_OK: return "ok";
+    case MANIFEST_TRUNCATED: return "truncated";
+    case MANIFEST_MALFORMED: return "malformed";
+    case MANIFEST_TOO_LONG: return "field too long";
+  }
+  return "?";
+}
+
+// In: anything with size_t readBytes(char*, size_t) that blocks until the
+// bytes are there or gives up (Arduino Stream, a memory reader on the host)
+template <typename In>
+class CborReader {
+ public:
+  explicit CborReader(In& in) : _in(in) {}
+
+  ManifestError error() const { return _error; }
+
+  // Head of the next item. arg is the value (0/1), the length (2..5), the
+  // tag (6) or the simple value (7); wider than 32 bits only for floats
+  bool head(uint8_t& major, uint32_t& arg) {
+    uint8_t b[8];
+    if (!bytes(b, 1)) return false;
+    major = b[0] >> 5;
+    uint8_t info = b[0] & 0x1F;
+    if (info < 24) {
+      arg = info;
+      return true;
+    }
+    if (info > 27) return fail(MANIFEST_MALFORMED);   // reserved, indefinite length
+    uint8_t n = 1 << (info - 24);
+    if (!bytes(b, n)) return false;
+    if (n == 8 && major != 7 && (b[0] | b[1] | b[2] | b[3])) return fail(MANIFEST_MALFORMED);
+    arg = 0;
+    for (uint8_t i = n == 8 ? 4 : 0; i < n; i++) arg = arg << 8 | b[i];
+    return true;
+  }
+
+  // Text of the head just read into out (cap with the NUL), appended at *used
+  bool text(uint8_t major, uint32_t len, char* out, size_t cap, size_t* used = nullptr) {
+    if (major != 3) return fail(MANIFEST_MALFORMED);
+    size_t at = used ? *used : 0;
+    if (len >= cap - at) return fail(MANIFEST_TOO_LONG);
+    if (!bytes((uint8_t*)out + at, len)) return false;
+    out[at + len] = 0;
+    if (used) *used = at + len;
+    return true;
+  }
+
+  // Rest of the item whose head was just read
+  bool skip(uint8_t major, uint32_t arg, uint8_t depth = 0) {
+    if (major == 2 || major == 3) {
+      uint8_t scratch[16];
+      while (arg) {
+        uint32_t n = arg < sizeof(scratch) ? arg : sizeof(scratch);
+        if (!bytes(scratch, n)) return false;
+        arg -= n;
+      }
+      return true;
+    }
+    if (major < 4 || major == 7) return true;
+    if (depth == MANIFEST_CBOR_MAX_DEPTH) return fail(MANIFEST_MALFORMED);
+    uint32_t items = major == 4 ? arg : major == 5 ? arg * 2 : 1;   // tag: the tagged item
+    if (major == 5 && arg > UINT32_MAX / 2) return fail(MANIFEST_MALFORMED);
+    for (uint32_t i = 0; i < items; i++) {
+      uint8_t m;
+      uint32_t a;
+      if (!head(m, a) || !skip(m, a, depth + 1)) return false;
+    }
+    return true;
+  }
+
+ private:
+  bool bytes(uint8_t* p, size_t n) {
+    return _in.readBytes((char*)p, n) == n || fail(MANIFEST_TRUNCATED);
+  }
+
+  bool fail(ManifestError e) {
+    if (!_error) _error = e;
+    return false;
+  }
+
+  In& _in;
+  ManifestError _error = MANIFEST_OK;
+};
+
+template <typename In>
+ManifestError manifestDecodeCbor(In& in, ManifestFields& out) {
+  memset(&out, 0, sizeof(out));
+  CborReader<In> r(in);
+  uint8_t major;
+  uint32_t count;
+  if (!r.head(major, count)) return r.error();
+  if (major != 5) return MANIFEST_MALFORMED;
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t key, arg;
+    if (!r.head(major, key)) return r.error();
+    if (major != 0) {   // not one of ours: skip key and value
+      if (!r.skip(major, key) || !r.head(major, arg) || !r.skip(major, arg)) return r.error();
+      continue;
+    }
+    if (!r.head(major, arg)) return r.error();
+    bool ok;
+    switch (key) {
+      case MANIFEST_KEY_MODEL: ok = r.text(major, arg, out.model, sizeof(out.model)); break;
+      case MANIFEST_KEY_VERSION: ok = r.text(major, arg, out.version, sizeof(out.version)); break;
+      case MANIFEST_KEY_URL: ok = r.text(major, arg, out.url, sizeof(out.url)); break;
+      case MANIFEST_KEY_SECTORS: ok = r.text(major, arg, out.sectors, sizeof(out.sectors)); break;
+      case MANIFEST_KEY_REBOOT_WINDOW:
+        ok = r.text(major, arg, out.rebootWindow, sizeof(out.rebootWindow));
+        break;
+      case MANIFEST_KEY_REBOOT_DEADLINE:
+        if (major != 0) return MANIFEST_MALFORMED;
+        out.rebootDeadline = arg;
+        ok = true;
+        break;
+      case MANIFEST_KEY_MIRRORS: {
+        if (major != 4) return MANIFEST_MALFORMED;
+        size_t used = 0;
+        ok = true;
+        for (uint32_t m = 0; ok && m < arg; m++) {
+          uint32_t len;
+          ok = r.head(major, len);
+          if (ok && m) {
+            if (used + 1 >= sizeof(out.mirrors)) return MANIFEST_TOO_LONG;
+            out.mirrors[used++] = ' ';
+          }
+          ok = ok && r.text(major, len, out.mirrors, sizeof(out.mirrors), &used);
+        }
+        break;
+      }
+      default:
+        ok = r.skip(major, arg);
+        break;
+    }
+    if (!ok) return r.error();
+  }
+  return MANIFEST_OK;
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+
+// Decodes the body into out, CBOR or JSON; false (logged) if it is unusable
+bool manifestParse(Stream& body, bool cbor, ManifestFields& out);
+
+// CBOR if the URL ends in ".cbor" or the server says so
+bool manifestIsCbor(const char* url, const String& contentType);
+
+#define MANIFEST_ACCEPT "application/cbor, application/json;q=0.9"
+#endif
+
+#endif
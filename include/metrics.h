@@ -0,0 +1,66 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+// OTA metrics in fixed static storage: outcome counters and power-of-two
+// histograms (bucket index from a count-leading-zeros, no floats). Served
+// as Prometheus text on GET /metrics together with the heap low-water
+// marks from telemetry and the failure codes from the OTA journal.
+
+#ifndef METRIC_BUCKETS
+#define METRIC_BUCKETS 12      // last bucket is +Inf
+#endif
+
+enum MetricPoll : uint8_t {
+  POLL_OK = 0,           // manifest parsed
+  POLL_NOT_MODIFIED,     // 304
+  POLL_HTTP_ERROR,       // other HTTP status
+  POLL_CONNECT_ERROR,    // TCP/TLS/HTTPClient error
+  POLL_BAD_MANIFEST,     // JSON error
+  POLL_DEFERRED,         // preflight said no
+  POLL_OUTCOMES
+};
+
+enum MetricUpdate : uint8_t {
+  UPDATE_OK = 0,
+  UPDATE_FAILED,
+  UPDATE_NO_UPDATE,
+  UPDATE_SKIPPED,        // blacklist / backoff
+  UPDATE_OUTCOMES
+};
+
+enum MetricConn : uint8_t {
+  CONN_REUSED = 0,       // manifest poll on the kept-alive connection
+  CONN_NEW,              // manifest poll with a fresh TLS handshake
+  CONN_DROPPED,          // kept-alive connection given up (server, heap, preflight)
+  CONN_EVENTS
+};
+
+enum MetricHist : uint8_t {
+  HIST_MANIFEST_MS = 0,  // GET + parse
+  HIST_TLS_CONNECT_MS,   // TCP connect + TLS handshake
+  HIST_DOWNLOAD_BPS,     // firmware bytes per second
+  HIST_FLASH_SECTOR_MS,  // erase + program of one full 4 KB sector (delta staging, backup copy)
+  HIST_MANIFEST_WARM_MS, // GET + parse on a reused connection, also in HIST_MANIFEST_MS
+  HIST_COUNT
+};
+
+struct MetricHistogram {
+  uint32_t count;
+  uint32_t sum;
+  uint32_t max;
+  uint16_t buckets[METRIC_BUCKETS];
+};
+
+void metricsPoll(MetricPoll outcome);
+void metricsUpdate(MetricUpdate outcome, int16_t error = 0);
+void metricsObserve(MetricHist hist, uint32_t value);
+void metricsDelta(uint16_t copied, uint16_t downloaded);   // sectors of a staged incremental update
+void metricsRedirects(uint16_t followed, uint16_t saved);   // redirect round-trips of one poll
+void metricsConnection(MetricConn event);
+
+const MetricHistogram& metricsHistogram(MetricHist hist);
+void metricsWriteText(Print& out);     // Prometheus text format 0.0.4
+
+#endif
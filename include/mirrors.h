@@ -0,0 +1,93 @@
+#ifndef MIRRORS_H
+#define MIRRORS_H
+
+#include <stdint.h>
+
+// Mirror selection for the manifest and the firmware. Every host keeps an
+// EWMA of the time to its response header (DNS + connect + TLS + first
+// byte). Requests try the mirrors best first, each with a budget of a few
+// times its EWMA, so a slow or dead host costs about one budget before the
+// next one is tried instead of the whole 20 s timeout; only the last
+// candidate gets the full timeout. A failure counts as MIRROR_FAIL_MS. The
+// rank of a host halves every MIRROR_HALVING_S without a sample, so a
+// mirror that failed is retried once it has been out long enough.
+//
+// Hosts are resolved right before the attempt, within its budget. lwIP
+// caches the answer for the record's TTL (the Arduino API neither exposes
+// the TTL nor lets a TLS connect with SNI use an address resolved
+// elsewhere), so the connect that follows resolves from that cache. A host
+// that did not resolve is skipped for DNS_NEGATIVE_TTL_S.
+//
+// The scoring has no core dependencies.
+
+#ifndef MIRROR_MAX
+#define MIRROR_MAX 4                  // per group, primary included
+#endif
+#define MIRROR_EWMA_SHIFT 2           // new sample weighs 1/4
+#define MIRROR_UNKNOWN_MS 1000UL      // rank of a host without samples: tried early once
+#define MIRROR_FAIL_MS 20000UL
+#define MIRROR_BUDGET_FACTOR 3
+#define MIRROR_MIN_BUDGET_MS 2500UL   // a TLS handshake alone takes ~1 s on the ESP8266
+#define MIRROR_HALVING_S 600UL
+#ifndef DNS_NEGATIVE_TTL_S
+#define DNS_NEGATIVE_TTL_S 60UL
+#endif
+
+struct MirrorScore {
+  uint32_t ewmaMs;          // 0 = no sample yet
+  uint32_t lastMs;          // clock of the last sample
+  uint16_t ok;
+  uint16_t failed;
+};
+
+inline void mirrorSample(MirrorScore& s, uint32_t ms, uint32_t now) {
+  if (!ms) ms = 1;
+  s.ewmaMs = s.ewmaMs ? s.ewmaMs - (s.ewmaMs >> MIRROR_EWMA_SHIFT) + (ms >> MIRROR_EWMA_SHIFT) : ms;
+  s.lastMs = now;
+}
+
+// Lower is better
+inline uint32_t mirrorRank(const MirrorScore& s, uint32_t now) {
+  if (!s.ewmaMs) return MIRROR_UNKNOWN_MS;
+  uint32_t halvings = (now - s.lastMs) / (MIRROR_HALVING_S * 1000UL);
+  return halvings < 32 ? s.ewmaMs >> halvings : 0;
+}
+
+inline uint32_t mirrorBudgetMs(const MirrorScore& s, uint32_t now, uint32_t timeoutMs) {
+  uint32_t b = mirrorRank(s, now) * MIRROR_BUDGET_FACTOR;
+  if (b < MIRROR_MIN_BUDGET_MS) b = MIRROR_MIN_BUDGET_MS;
+  return b < timeoutMs ? b : timeoutMs;
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <ESP8266HTTPClient.h>
+#include <WiFiClientSecureBearSSL.h>
+
+#include "redirect_cache.h"
+
+enum MirrorGroup : uint8_t {
+  MIRRORS_MANIFEST = 0,     // FW_MANIFEST_URL + FW_MANIFEST_MIRRORS
+  MIRRORS_FIRMWARE,         // manifest "url" + "mirrors"
+  MIRROR_GROUPS
+};
+
+// Mirrors are base URLs: the file name of the primary URL is appended
+void mirrorsSet(MirrorGroup g, const char* primaryUrl);
+bool mirrorsAdd(MirrorGroup g, const char* bases);   // space or comma separated
+uint8_t mirrorsCount(MirrorGroup g);
+const char* mirrorsUrl(MirrorGroup g, uint8_t i);
+uint8_t mirrorsBest(MirrorGroup g);
+void mirrorsFailed(MirrorGroup g, uint8_t i);   // a request made elsewhere failed
+
+// GET from the best mirror that answers 200/206/304, failing over as above.
+// sibling: another file next to the primary URL (hash list), else the
+// group's own file. Returns like redirectGet(); *used is the mirror index.
+int mirrorsGet(HTTPClient& http, BearSSL::WiFiClientSecure& tls, MirrorGroup g,
+               const char* sibling, uint32_t timeoutMs, uint8_t* used = nullptr,
+               RedirectPrepare prepare = nullptr, void* ctx = nullptr);
+
+void mirrorsWriteText(Print& out);   // Prometheus gauges per host
+#endif
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef OTA_ARENA_H
+#define OTA_ARENA_H
+
+#include <Arduino.h>
+#include <new>
+#include <utility>
+
+// Memory for the OTA pipeline that does not depend on the state of the
+// general heap when an update starts:
+//  - ArenaSlot<T>: static, placement-constructed storage for OTA objects
+//    (TLS client, JSON document) instead of new/make_unique.
+//  - one heap block reserved while the heap is still unfragmented and
+//    released right before TLS, so the BearSSL stack, context and buffers
+//    (allocated inside the core with new/malloc) find one contiguous region.
+
+template <typename T>
+class ArenaSlot {
+ public:
+  template <typename... Args>
+  T* emplace(Args&&... args) {
+    reset();
+    _obj = new (_storage) T(std::forward<Args>(args)...);
+    return _obj;
+  }
+
+  void reset() {
+    if (_obj) {
+      _obj->~T();
+      _obj = nullptr;
+    }
+  }
+
+  T* get() const { return _obj; }
+  T* operator->() const { return _obj; }
+  T& operator*() const { return *_obj; }
+  explicit operator bool() const { return _obj != nullptr; }
+
+ private:
+  alignas(T) uint8_t _storage[sizeof(T)];
+  T* _obj = nullptr;
+};
+
+bool otaArenaReserve(size_t bytes);   // take the block (no-op if held or bytes == 0)
+void otaArenaRelease();               // hand it back right before the OTA path allocates
+size_t otaArenaReserved();            // bytes currently held
+
+#endif
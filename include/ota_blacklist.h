@@ -0,0 +1,49 @@
+#ifndef OTA_BLACKLIST_H
+#define OTA_BLACKLIST_H
+
+#include <stdint.h>
+
+// Per-version suppression of failing updates, on top of the journal's
+// failure counters. After each failure the next attempt of that version
+// waits twice as long (BLACKLIST_BASE_S, 2x, 4x ... up to BLACKLIST_MAX_S);
+// after BLACKLIST_POISON_FAILURES it is not attempted again until the
+// manifest (version or url) changes, which also clears all counters.
+// A version that was rolled back counts as poisoned right away.
+// The backoff policy has no core dependencies and is shared with the
+// fleet simulator in tools/fleet_sim.
+
+#ifndef BLACKLIST_BASE_S
+#define BLACKLIST_BASE_S 300UL
+#endif
+#ifndef BLACKLIST_MAX_S
+#define BLACKLIST_MAX_S 86400UL
+#endif
+#ifndef BLACKLIST_POISON_FAILURES
+#define BLACKLIST_POISON_FAILURES 5
+#endif
+
+enum BlacklistVerdict : uint8_t {
+  BLACKLIST_ALLOW = 0,
+  BLACKLIST_BACKOFF,      // failed recently, retry after waitS
+  BLACKLIST_POISONED,     // not retried until the manifest changes
+};
+
+// Wait after the given number of failures (failures >= 1)
+inline uint32_t blacklistBackoffS(uint16_t failures) {
+  uint32_t s = BLACKLIST_BASE_S;
+  for (uint16_t i = 1; i < failures && s < BLACKLIST_MAX_S; i++) s *= 2;
+  return s < BLACKLIST_MAX_S ? s : BLACKLIST_MAX_S;
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+
+void blacklistManifest(const char* version, const char* url);   // every parsed manifest
+BlacklistVerdict blacklistCheck(const char* version, uint32_t* waitS = nullptr);
+void blacklistAttempt(const char* version);   // right before the download
+const char* blacklistVerdictName(BlacklistVerdict v);
+
+void blacklistWriteJson(Print& out);   // versions and aggregated failure codes
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef OTA_DELTA_H
+#define OTA_DELTA_H
+
+#include <stdint.h>
+
+// Sector-level incremental update. The publisher writes a hash list next to
+// each image (tools/release); the device hashes its running sketch sector
+// by sector, copies unchanged sectors into the OTA staging area and fetches
+// only the changed ones with Range requests. No previous image is needed on
+// the server. The staged image is verified against the
+// whole-image MD5 from the list and then handed to eboot like Updater does.
+//
+// Hash list (little endian):
+//   magic "SHL1" | image size u32 | sector size u32 | reserved u32 | image MD5 [16]
+//   then one 8-byte truncated MD5 per sector (last sector: only its bytes)
+//
+// Byte 2 of the image (flash mode) is hashed as 0: Updater rewrites it to the
+// chip's mode when flashing, so the running copy differs there.
+// The format part has no core dependencies and is shared with tools/release.
+
+#define DELTA_MAGIC       0x314C4853u   // "SHL1"
+#define DELTA_HASH_LEN    8
+#define DELTA_HEADER_LEN  32
+#define DELTA_FLASH_MODE_OFFSET 2
+
+#ifndef DELTA_MAX_SECTORS
+#define DELTA_MAX_SECTORS 256           // 1 MiB, the 4m2m sketch slot
+#endif
+
+struct DeltaHeader {
+  uint32_t magic;
+  uint32_t size;                        // image bytes
+  uint32_t sectorSize;
+  uint32_t reserved;
+  uint8_t md5[16];                      // whole image, flash mode byte as 0
+};
+static_assert(sizeof(DeltaHeader) == DELTA_HEADER_LEN, "hash list header");
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <WiFiClientSecureBearSSL.h>
+
+struct DeltaStats {
+  uint16_t sectors;       // in the new image
+  uint16_t copied;        // unchanged, copied from the running sketch
+  uint16_t downloaded;    // fetched with Range requests
+  uint16_t requests;      // Range requests (runs of changed sectors)
+  uint32_t bytes;         // firmware bytes downloaded
+  uint8_t mirror;         // MIRRORS_FIRMWARE index both came from
+};
+
+// Stages the image of the MIRRORS_FIRMWARE group into the OTA area and writes
+// the eboot copy command. The hash list (hashUrl, or the same file next to a
+// mirror's image) picks the mirror; the Range requests go to the same one.
+// False means nothing usable was staged: fall back to a full update.
+// progress is called with the image offset after each staged sector.
+bool deltaUpdate(BearSSL::WiFiClientSecure& client, const char* hashUrl,
+                 DeltaStats& stats, void (*progress)(uint32_t offset) = nullptr);
+#endif
+
+#endif
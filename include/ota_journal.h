@@ -0,0 +1,79 @@
+#ifndef OTA_JOURNAL_H
+#define OTA_JOURNAL_H
+
+#include <Arduino.h>
+
+// Append-only OTA journal in the last JOURNAL_SECTORS sectors of the FS
+// region (flash_layout.h). Records are a header word (type, length,
+// crc16) plus payload words, appended in O(1) at a write pointer kept in
+// RAM. When the active sector is full the next one is erased and starts
+// with a snapshot of the whole state, so sectors are used round-robin and
+// a boot replays at most one sector. A record with a bad crc (power cut
+// mid-write) ends the replay and forces a fresh sector.
+//
+// Polls are written only when their result changes, counters in between
+// reach flash with the next record or snapshot.
+
+#ifndef JOURNAL_MAX_VERSIONS
+#define JOURNAL_MAX_VERSIONS 4          // failure stats kept for this many versions
+#endif
+#ifndef JOURNAL_MAX_REASONS
+#define JOURNAL_MAX_REASONS 8           // distinct failure codes counted
+#endif
+#ifndef JOURNAL_PROGRESS_STEP
+#define JOURNAL_PROGRESS_STEP 65536     // download offset recorded every N bytes
+#endif
+#define JOURNAL_VERSION_LEN 32
+#define JOURNAL_ETAG_LEN 48
+
+#define JOURNAL_OTA_OK           0
+#define JOURNAL_OTA_INTERRUPTED  (-1000)   // reset during download/flash
+#define JOURNAL_OTA_REVERTED     (-1001)   // rolled back after failed boots
+#define JOURNAL_OTA_NO_BACKUP    (-1002)   // staged image discarded, running sketch not backed up
+
+struct JournalVersionStats {
+  char version[JOURNAL_VERSION_LEN];
+  uint16_t attempts;
+  uint16_t failures;
+  int16_t lastError;            // ESPhttpUpdate.getLastError() or JOURNAL_OTA_*
+  uint16_t reserved;
+  uint32_t lastAttemptS;        // wall clock, 0 if unknown
+};
+
+struct JournalReason {
+  int16_t code;
+  uint16_t count;
+};
+
+struct OtaJournalState {
+  uint32_t polls;
+  int16_t lastPollCode;         // HTTP code of the last manifest poll
+  uint16_t lastPollMs;          // manifest round trip
+  char etag[JOURNAL_ETAG_LEN];  // of the last manifest that needed no action
+  uint32_t manifestCrc;         // version + url of the last manifest seen
+
+  char otaVersion[JOURNAL_VERSION_LEN];  // last attempted version
+  uint32_t otaOffset;           // bytes downloaded when last recorded
+  uint32_t otaMs;               // duration of the last attempt
+  int16_t otaResult;
+  uint8_t otaInProgress;
+  uint8_t reserved;
+
+  JournalVersionStats versions[JOURNAL_MAX_VERSIONS];   // cleared when the manifest changes
+  JournalReason reasons[JOURNAL_MAX_REASONS];           // failure codes, all versions
+};
+
+void journalBegin();                      // replay; early in setup()
+const OtaJournalState& journalState();
+
+void journalPoll(int16_t code, uint32_t ms);
+void journalEtag(const char* etag);       // "" clears
+void journalOtaBegin(const char* version);
+void journalOtaProgress(uint32_t offset); // writes every JOURNAL_PROGRESS_STEP bytes
+void journalOtaEnd(int16_t result, uint32_t ms);
+void journalVersionFailed(const char* version, int16_t code);   // failure outside an attempt
+void journalManifest(uint32_t crc);       // a different crc clears the version stats
+
+const JournalVersionStats* journalVersion(const char* version);   // nullptr if unknown
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef PREFLIGHT_H
+#define PREFLIGHT_H
+
+#include <Arduino.h>
+
+// OTA memory preflight: each phase declares the allocations it is about to
+// make, the planner checks free heap and the largest free block against it.
+// If that is short, registered optional subsystems are torn down one by one
+// (in registration order) until the plan fits, otherwise the phase is
+// deferred with a reason code.
+
+// BearSSL numbers for core 3.x (WiFiClientSecureBearSSL / StackThunk)
+#define PREFLIGHT_TLS_IN_OVERHEAD  325    // added to the rx buffer size
+#define PREFLIGHT_TLS_OUT_OVERHEAD 85     // added to the tx buffer size
+#define PREFLIGHT_TLS_CONTEXT      4000   // ssl client + x509 contexts, session
+#define PREFLIGHT_TLS_STACK        6200   // BearSSL second stack, one block
+#define PREFLIGHT_ALLOC_OVERHEAD   8      // umm block header per allocation
+
+#ifndef PREFLIGHT_MARGIN
+#define PREFLIGHT_MARGIN 3072             // lwIP pbufs, SDK, callbacks
+#endif
+#ifndef PREFLIGHT_MAX_SHEDDERS
+#define PREFLIGHT_MAX_SHEDDERS 6
+#endif
+
+enum PreflightResult : uint8_t {
+  PREFLIGHT_OK = 0,        // fits as is
+  PREFLIGHT_OK_SHED,       // fits after tearing down optional subsystems
+  PREFLIGHT_LOW_HEAP,      // deferred: not enough free heap in total
+  PREFLIGHT_LOW_BLOCK,     // deferred: heap too fragmented for the largest buffer
+};
+
+struct PreflightPlan {
+  uint32_t heap = PREFLIGHT_MARGIN;   // total bytes needed
+  uint32_t block = 0;                 // largest single allocation
+
+  PreflightPlan& alloc(uint32_t bytes) {
+    heap += bytes + PREFLIGHT_ALLOC_OVERHEAD;
+    if (bytes > block) block = bytes;
+    return *this;
+  }
+
+  // one BearSSL client with setBufferSizes(rx, tx)
+  PreflightPlan& tls(uint16_t rx, uint16_t tx) {
+    return alloc(rx + PREFLIGHT_TLS_IN_OVERHEAD)
+          .alloc(tx + PREFLIGHT_TLS_OUT_OVERHEAD)
+          .alloc(PREFLIGHT_TLS_CONTEXT)
+          .alloc(PREFLIGHT_TLS_STACK);
+  }
+};
+
+// shed() frees the subsystem, restore() (optional) brings it back after the OTA attempt
+void preflightRegisterShedder(const char* name, void (*shed)(), void (*restore)() = nullptr);
+
+PreflightResult preflightCheck(const char* phase, const PreflightPlan& plan);
+void preflightRestore();            // restore everything shed since the last call
+
+PreflightResult preflightLastResult();
+const char* preflightResultName(PreflightResult r);
+
+#endif
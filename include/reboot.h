@@ -0,0 +1,45 @@
+#ifndef REBOOT_H
+#define REBOOT_H
+
+#include <Arduino.h>
+
+// Deferred reboot after an update: instead of restarting right away the
+// restart waits for the maintenance window from the manifest (or its
+// deadline), then lets the application quiesce through registered hooks
+// and restarts. A record in RTC memory marks the
+// restart as planned, so the next boot can skip its settle delays, and
+// carries the shutdown time to measure the downtime across the update.
+
+#ifndef REBOOT_MAX_HOOKS
+#define REBOOT_MAX_HOOKS 4
+#endif
+#ifndef REBOOT_QUIESCE_TIMEOUT_MS
+#define REBOOT_QUIESCE_TIMEOUT_MS 10000UL   // hooks that are not done by then are skipped
+#endif
+#ifndef REBOOT_MAX_DEFER_S
+#define REBOOT_MAX_DEFER_S 86400UL          // deadline when the manifest gives a window only
+#endif
+
+// Maintenance window in UTC minutes of the day, start == end means "any time"
+struct RebootPolicy {
+  uint16_t windowStart = 0;
+  uint16_t windowEnd = 0;
+  uint32_t deadlineS = 0;    // reboot at the latest this long after scheduling, 0 = default
+
+  // "HH:MM-HH:MM" (may wrap midnight), false and unchanged on bad input
+  bool parseWindow(const char* s);
+};
+
+// quiesce() returns true once the subsystem is flushed/stopped, it is
+// polled from rebootLoop() until then (at most REBOOT_QUIESCE_TIMEOUT_MS)
+void rebootRegisterHook(const char* name, bool (*quiesce)());
+
+void rebootSchedule(const char* reason, const RebootPolicy& policy);
+bool rebootPending();
+void rebootLoop();
+
+bool rebootBegin();       // early in setup(): true if this boot follows a planned restart
+void rebootServiceUp();   // after Wi-Fi is back: ends the downtime measurement
+int32_t rebootLastDowntimeMs();   // shutdown -> service up, -1 if unknown
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef REDIRECT_CACHE_H
+#define REDIRECT_CACHE_H
+
+#include <Arduino.h>
+#include <ESP8266HTTPClient.h>
+
+// Redirect targets of the manifest and firmware URLs. HTTPClient follows
+// redirects itself but never says where it ended up, so every poll paid
+// each hop again: a round-trip, and a TLS handshake when the host changes.
+// redirectGet() follows the chain itself and remembers permanent targets
+// (301/308) for REDIRECT_CACHE_TTL_S; the next request goes straight to the
+// final URL. A cached target that fails is dropped and the request starts
+// over at the original URL. Temporary redirects (302/303/307) are only
+// remembered on request for the duration of one update (signed download
+// URLs), with a sliding REDIRECT_SESSION_TTL_S.
+//
+// http:// hops use a plain WiFiClient, https:// ones the caller's TLS client,
+// so an http -> https redirect works (HTTPClient refuses scheme changes).
+// With OTA_TLS_TRUST authenticating hosts, http:// URLs and hops are
+// refused (REDIRECT_ERROR_INSECURE): a plain hop would bypass the check.
+
+#ifndef REDIRECT_CACHE_ENTRIES
+#define REDIRECT_CACHE_ENTRIES 3        // manifest, image, hash list
+#endif
+#ifndef REDIRECT_CACHE_TTL_S
+#define REDIRECT_CACHE_TTL_S 86400UL
+#endif
+#ifndef REDIRECT_SESSION_TTL_S
+#define REDIRECT_SESSION_TTL_S 60UL
+#endif
+#ifndef REDIRECT_MAX_HOPS
+#define REDIRECT_MAX_HOPS 5
+#endif
+#define REDIRECT_URL_LEN 256
+#define REDIRECT_ERROR_INSECURE (-100)   // http:// while TLS authentication is on
+
+// Runs before every request of a chain: begin() drops added headers
+typedef void (*RedirectPrepare)(HTTPClient& http, void* ctx);
+
+// GET url, from its cached target if there is one. Returns like http.GET(),
+// with http on the final response; the caller ends it. session: also keep
+// temporary targets for the following requests of this update.
+int redirectGet(HTTPClient& http, WiFiClient& tls, const char* url, bool session = false,
+                RedirectPrepare prepare = nullptr, void* ctx = nullptr);
+
+// For requests made elsewhere (ESPhttpUpdate): the cached target or url,
+// whether its scheme is allowed, the client for its scheme, and
+// redirectFailed() when the request failed
+const char* redirectResolve(const char* url);
+bool redirectAllowed(const char* url);
+WiFiClient& redirectClient(const char* url, WiFiClient& tls);
+void redirectFailed(const char* url);
+
+struct RedirectStats {
+  uint16_t followed;    // redirect round-trips made
+  uint16_t saved;       // round-trips skipped thanks to the cache
+};
+RedirectStats redirectTakeStats();   // since the last call, i.e. per poll
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Boot-count rollback for the single-slot ESP8266 update scheme.
+//
+// Before the restart into a new image the running (confirmed) sketch is
+// copied into the backup slot (flash_layout.h) and a header marks the new
+// image as on trial. Every boot while on trial is counted in RTC memory and
+// mirrored as boot marks in the header, so power cuts between crashes do
+// not reset the count. rollbackMarkHealthy() (Wi-Fi up, first manifest
+// check done) confirms the image. After ROLLBACK_MAX_BOOTS unconfirmed
+// boots the boot path hands eboot a copy command backup -> 0x0 and
+// restarts, no re-download needed.
+//
+// The header states and boot marks are flash words that only ever lose
+// bits, so counting, confirming and reverting never erase a sector.
+// The decision logic below has no core dependencies and is shared with
+// the host simulator in tools/boot_sim.
+
+#ifndef ROLLBACK_MAX_BOOTS
+#define ROLLBACK_MAX_BOOTS 3      // unconfirmed boots allowed before reverting
+#endif
+static_assert(ROLLBACK_MAX_BOOTS < 32, "boot marks are one 32 bit word");
+
+#define ROLLBACK_MAGIC    0x524F4C42u   // "ROLB"
+#define ROLLBACK_UNSET    0xFFFFFFFFu   // erased flash word
+#define ROLLBACK_SET      0u
+#define ROLLBACK_VERSION_LEN 32
+
+struct RollbackHeader {
+  uint32_t magic;
+  uint32_t size;                        // backup image bytes
+  uint32_t crc;                         // crc32 of the backup image
+  char fromVersion[ROLLBACK_VERSION_LEN];  // backup image (known good)
+  char toVersion[ROLLBACK_VERSION_LEN];    // image on trial
+  uint32_t bootMarks;                   // one bit cleared per trial boot
+  uint32_t confirmed;                   // ROLLBACK_SET once marked healthy
+  uint32_t reverted;                    // ROLLBACK_SET once rolled back
+};
+
+struct RollbackRtc {
+  uint32_t magic;
+  uint32_t boots;                       // boots of the trial image so far
+};
+
+enum RollbackAction : uint8_t {
+  ROLLBACK_NONE = 0,     // no image on trial
+  ROLLBACK_TRIAL,        // on trial, boot counted
+  ROLLBACK_REVERT,       // too many boots: copy the backup back
+};
+
+inline bool rollbackOnTrial(const RollbackHeader& h) {
+  return h.magic == ROLLBACK_MAGIC && h.confirmed == ROLLBACK_UNSET &&
+         h.reverted == ROLLBACK_UNSET;
+}
+
+inline uint32_t rollbackMarkedBoots(uint32_t marks) {
+  return 32 - __builtin_popcount(marks);
+}
+
+inline uint32_t rollbackBootMarks(uint32_t boots) {
+  return boots >= 32 ? 0 : 0xFFFFFFFFu << boots;
+}
+
+// Called once per boot with the flash header and the RTC record. The RTC
+// record is updated in place; the caller writes it back and programs
+// rollbackBootMarks(rtc.boots) into the header while on trial.
+inline RollbackAction rollbackDecide(const RollbackHeader& h, RollbackRtc& rtc,
+                                     uint32_t maxBoots = ROLLBACK_MAX_BOOTS) {
+  if (!rollbackOnTrial(h)) {
+    rtc.magic = ROLLBACK_MAGIC;
+    rtc.boots = 0;
+    return ROLLBACK_NONE;
+  }
+  // RTC lost (power-off) or behind: continue from the marks in flash
+  uint32_t marked = rollbackMarkedBoots(h.bootMarks);
+  if (rtc.magic != ROLLBACK_MAGIC || rtc.boots < marked) {
+    rtc.magic = ROLLBACK_MAGIC;
+    rtc.boots = marked;
+  }
+  rtc.boots++;
+  return rtc.boots > maxBoots ? ROLLBACK_REVERT : ROLLBACK_TRIAL;
+}
+
+inline uint32_t rollbackCrc32(uint32_t crc, const void* data, size_t len) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  crc = ~crc;
+  while (len--) {
+    crc ^= *p++;
+    for (uint8_t k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+  }
+  return ~crc;
+}
+
+#ifdef ARDUINO
+// Device side (src/rollback.cpp)
+void rollbackBoot();          // early in setup(), after journalBegin(): count the boot, maybe revert
+void rollbackMarkHealthy();   // confirm the trial image (no-op otherwise)
+bool rollbackPending();       // running image is on trial
+
+// Right after a successful download: eboot's copy command is already set,
+// so any reset from then on installs the new image. Backs up the running
+// sketch and marks toVersion as on trial; false clears the copy command
+// and the staged update is discarded.
+bool rollbackPrepare(const char* fromVersion, const char* toVersion);
+#endif
+
+#endif
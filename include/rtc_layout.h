@@ -0,0 +1,12 @@
+#ifndef RTC_LAYOUT_H
+#define RTC_LAYOUT_H
+
+// RTC user memory: 128 blocks of 4 bytes, kept across resets and deep
+// sleep, lost on power-off. Offsets are in blocks (ESP.rtcUserMemory*).
+
+#define RTC_BLOCK_EBOOT     0    // blocks 0..31: eboot command written by Updater
+#define RTC_BLOCK_ROLLBACK  32   // RollbackRtc (rollback.h), 2 blocks
+#define RTC_BLOCK_REBOOT    34   // planned restart record (reboot.cpp), 4 blocks
+#define RTC_BLOCK_TIME      38   // TimeRtc (time_sync.h), 4 blocks
+
+#endif
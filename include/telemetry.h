@@ -0,0 +1,57 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+
+// Heap/stack telemetry: periodic samples in a fixed ring buffer plus
+// low-water marks per phase, so OTA thresholds can be tuned from data.
+
+#ifndef TELEMETRY_RING_SIZE
+#define TELEMETRY_RING_SIZE 32        // samples kept (16 bytes each)
+#endif
+#ifndef TELEMETRY_SAMPLE_MS
+#define TELEMETRY_SAMPLE_MS 5000UL    // periodic sample interval in loop()
+#endif
+
+enum TelemetryPhase : uint8_t {
+  PHASE_BOOT = 0,
+  PHASE_PORTAL,
+  PHASE_IDLE,
+  PHASE_MANIFEST,
+  PHASE_TLS,
+  PHASE_FLASH,
+  PHASE_COUNT
+};
+
+struct TelemetrySample {
+  uint32_t ms;
+  uint32_t freeHeap;
+  uint16_t maxBlock;
+  uint16_t stackFree;   // cont stack high-water (free bytes never touched)
+  uint16_t loopMs;      // longest loop() iteration since previous sample
+  uint8_t  frag;
+  uint8_t  phase;
+};
+
+struct TelemetryLowWater {
+  uint32_t minFreeHeap;
+  uint32_t minMaxBlock;
+  uint32_t minStackFree;
+  uint16_t maxLoopMs;
+  uint8_t  maxFrag;
+  uint32_t samples;
+};
+
+void telemetryBegin();
+void telemetryPhase(TelemetryPhase phase);   // enter phase, takes a sample
+TelemetryPhase telemetryCurrentPhase();
+void telemetrySample();                      // sample now, current phase
+void telemetryLoop();                        // once per loop(): loop latency + periodic sample
+
+const TelemetryLowWater& telemetryLowWater(TelemetryPhase phase);
+const char* telemetryPhaseName(TelemetryPhase phase);
+
+void telemetryPrint(Print& out);             // human readable, serial
+void telemetryWriteJson(Print& out);         // GET /telemetry
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdint.h>
+
+// Wall clock for the rest of the firmware, without waiting for it at boot.
+// SNTP runs in the background; until it answers, the time saved in RTC
+// memory before the last reset is restored, advanced by the RTC timer
+// (which keeps counting across resets, not across power-off). Consumers
+// ask timeValid() instead of comparing time(nullptr) with a constant, and
+// register with timeOnSync() to hear when SNTP has set the clock.
+//
+//   TIME_NONE      no idea: power-on, SNTP not answered yet
+//   TIME_RESTORED  from RTC memory, off by the RTC drift over the reset
+//   TIME_SYNCED    set by SNTP this boot
+//
+// The clock is saved on sync, every TIME_SAVE_INTERVAL_MS and before a
+// planned restart. The restore arithmetic has no core dependencies.
+
+#ifndef TIME_SAVE_INTERVAL_MS
+#define TIME_SAVE_INTERVAL_MS 600000UL
+#endif
+#ifndef TIME_MAX_LISTENERS
+#define TIME_MAX_LISTENERS 4
+#endif
+#ifndef TIME_NTP_SERVERS
+#define TIME_NTP_SERVERS "pool.ntp.org", "time.nist.gov"
+#endif
+// Saved more than this long ago (by the RTC timer): too much drift to use
+#ifndef TIME_RESTORE_MAX_S
+#define TIME_RESTORE_MAX_S 3600UL
+#endif
+
+// Any time before this is the unset clock
+#define TIME_VALID_S 1600000000L
+
+enum TimeState : uint8_t {
+  TIME_NONE = 0,
+  TIME_RESTORED,
+  TIME_SYNCED,
+};
+
+#define TIME_MAGIC 0x544D4531u   // "TME1"
+
+struct TimeRtc {
+  uint32_t magic;
+  uint32_t wallS;        // wall clock at save
+  uint32_t rtcTicks;     // system_get_rtc_time() at save
+  uint32_t rtcCali;      // µs per tick << 12 (system_rtc_clock_cali_proc)
+};
+
+// Wall clock now from a saved record, 0 if it is unusable. The tick counter
+// is 32 bit (~7 h at ~5.7 µs), so records older than TIME_RESTORE_MAX_S
+// are refused rather than trusted across a wrap.
+inline uint32_t timeRestoreS(const TimeRtc& rec, uint32_t rtcTicks) {
+  if (rec.magic != TIME_MAGIC || rec.wallS < TIME_VALID_S || !rec.rtcCali) return 0;
+  uint64_t elapsedUs = ((uint64_t)(uint32_t)(rtcTicks - rec.rtcTicks) * rec.rtcCali) >> 12;
+  if (elapsedUs / 1000000 > TIME_RESTORE_MAX_S) return 0;
+  return rec.wallS + (uint32_t)(elapsedUs / 1000000);
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+
+void timeBegin();          // early in setup(): restore from RTC memory
+void timeStartSync();      // once Wi-Fi is up: start SNTP, returns at once
+void timeLoop();           // dispatches sync events, saves periodically
+void timeSave();           // to RTC memory, if the clock is valid
+
+bool timeValid();          // TIME_RESTORED or TIME_SYNCED
+TimeState timeState();
+const char* timeStateName();
+
+// Called from timeLoop() (not the SNTP callback) after each SNTP update
+void timeOnSync(void (*fn)());
+
+void timeWriteText(Print& out);   // Prometheus: state and boot-to-sync time
+#endif
+
+#endif
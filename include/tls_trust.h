@@ -0,0 +1,92 @@
+#ifndef TLS_TRUST_H
+#define TLS_TRUST_H
+
+#include <stdint.h>
+#include <strings.h>
+#include <time.h>
+
+// How the OTA TLS clients decide whom to trust, chosen at build time with
+// OTA_TLS_TRUST. It is applied in TimedTlsClient::connect(), so every host
+// is covered: manifest, mirrors, redirect hops and firmware.
+//
+//   TLS_TRUST_INSECURE  setInsecure(): encrypted, nobody authenticated
+//   TLS_TRUST_KEY       the server's public key must be one pinned for
+//                       that host. BearSSL's known-key engine skips the
+//                       X.509 chain entirely: no certificate parsing, no
+//                       clock, least RAM and time. Several keys per host
+//                       (current + next) are tried in order, one
+//                       handshake each, so a rotation can be pre-announced.
+//   TLS_TRUST_ANCHORS   full chain validation against root certificates.
+//                       Survives leaf renewals, but needs the time: while
+//                       !timeValid() (time_sync.h), OTA_TLS_CLOCK_POLICY
+//                       either defers the poll or checks validity at the
+//                       build time (accepts what was valid when the
+//                       firmware was built; a certificate issued later
+//                       fails until the clock is set).
+//
+// Pins and anchors are PEM in PROGMEM, in OTA_TLS_TRUST_FILE as written by
+// tools/tls_pins: TLS_PINS (TlsPin[], per host in the order to try) and
+// TLS_ANCHORS (concatenated certificates). It is not shipped; generate it
+// from the live hosts, review it and commit it with the build that uses
+// it. A key is parsed only for the connect that uses it, the anchors once
+// on the first validated connect.
+//
+// The clock policy has no core dependencies.
+
+#define TLS_TRUST_INSECURE 0
+#define TLS_TRUST_KEY      1
+#define TLS_TRUST_ANCHORS  2
+
+#define TLS_CLOCK_WAIT  0     // no valid time: defer the poll
+#define TLS_CLOCK_BUILD 1     // no valid time: validate at FW_BUILD_EPOCH
+
+#ifndef OTA_TLS_TRUST
+#define OTA_TLS_TRUST TLS_TRUST_INSECURE
+#endif
+#ifndef OTA_TLS_CLOCK_POLICY
+#define OTA_TLS_CLOCK_POLICY TLS_CLOCK_BUILD
+#endif
+#ifndef OTA_TLS_TRUST_FILE
+#define OTA_TLS_TRUST_FILE "tls_trust_data.h"
+#endif
+// Any time before this build is certainly wrong (platformio.ini sets it)
+#ifndef FW_BUILD_EPOCH
+#define FW_BUILD_EPOCH 1735689600L    // 2025-01-01
+#endif
+
+struct TlsPin {
+  const char* host;
+  const char* keyPem;       // PROGMEM
+};
+
+// With authentication on, an http:// URL would bypass it: refused
+inline bool tlsTrustAllowsUrl(const char* url, uint8_t mode) {
+  return mode == TLS_TRUST_INSECURE || strncasecmp(url, "http://", 7) != 0;
+}
+
+// Time to check certificates against; 0 = wait for the clock
+inline time_t tlsCheckTime(time_t now, time_t buildEpoch, uint8_t policy) {
+  if (now >= buildEpoch) return now;
+  return policy == TLS_CLOCK_BUILD ? buildEpoch : 0;
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <WiFiClientSecureBearSSL.h>
+
+// Keys to try for host (KEY mode), else 1; 0 = no pin, do not connect
+uint8_t tlsTrustAttempts(const char* host);
+
+// Sets up client for attempt n at host; false if it must not connect
+bool tlsTrustApply(BearSSL::WiFiClientSecure& client, const char* host, uint8_t attempt);
+
+// After a failed attempt: true (counted, logged) if the handshake failed,
+// false for DNS/TCP errors, where another key would not help
+bool tlsTrustFailed(BearSSL::WiFiClientSecure& client, const char* host, uint8_t attempt);
+
+bool tlsTrustReady();           // false: the clock policy says wait
+const char* tlsTrustModeName();
+void tlsTrustWriteText(Print& out);   // Prometheus: mode and failed handshakes
+#endif
+
+#endif
@@ -14,6 +14,12 @@
 
 #if defined(ESP8266) || defined(ESP32)
 
+// WM_NODEBUG: drop debug calls at compile time, arguments (String
+// concatenations, WiFi getters) are not evaluated and no strings are linked
+#ifdef WM_NODEBUG
+#define DEBUG_WM(...) do {} while (0)
+#endif
+
 #ifdef ESP32
 uint8_t WiFiManager::_lastconxresulttmp = WL_IDLE_STATUS;
 #endif
@@ -653,7 +659,16 @@ void WiFiManager::setupHTTPServer(){
   server->on(WM_G(R_close),      std::bind(&WiFiManager::handleClose, this));
   server->on(WM_G(R_erase),      std::bind(&WiFiManager::handleErase, this, false));
   server->on(WM_G(R_status),     std::bind(&WiFiManager::handleWiFiStatus, this));
+  server->on(WM_G(R_wifiscan),   std::bind(&WiFiManager::handleWifiScanJson, this));
+  #ifdef WM_ASSETS_GZ
+  server->on(WM_G(R_css),        std::bind(&WiFiManager::handleAssetGz, this, HTTP_HEAD_CTCSS, WM_CSS_GZ, WM_CSS_GZ_LEN, WM_CSS_GZ_ETAG));
+  server->on(WM_G(R_js),         std::bind(&WiFiManager::handleAssetGz, this, HTTP_HEAD_CTJS, WM_JS_GZ, WM_JS_GZ_LEN, WM_JS_GZ_ETAG));
+  #endif
   server->onNotFound (std::bind(&WiFiManager::handleNotFound, this));
+
+  // request headers the handlers need, conditional GET for static assets
+  const char * headerkeys[] = {"If-None-Match"};
+  server->collectHeaders(headerkeys, sizeof(headerkeys)/sizeof(headerkeys[0]));
   
   server->on(WM_G(R_update), std::bind(&WiFiManager::handleUpdate, this));
   server->on(WM_G(R_updatedone), HTTP_POST, std::bind(&WiFiManager::handleUpdateDone, this), std::bind(&WiFiManager::handleUpdating, this));
@@ -975,6 +990,8 @@ bool WiFiManager::shutdownConfigPortal(){
   server.reset();
 
   WiFi.scanDelete(); // free wifi scan results
+  _scanItems.clear();
+  _scanItems.shrink_to_fit();
 
   if(!configPortalActive) return false;
 
@@ -1272,28 +1289,121 @@ void WiFiManager::startWPS() {
 }
 #endif
 
-String WiFiManager::getHTTPHead(String title){
-  String page;
-  page += FPSTR(HTTP_HEAD_START);
-  page.replace(FPSTR(T_v), title);
+/**
+ * start a streamed page, response headers and <head>
+ * the page is chunked (or close delimited for http/1.0), no content length needed
+ */
+void WiFiManager::HTTPSendHead(PageStream &page, const String &title){
+  HTTPSendNoCacheHeaders(); // pages are always dynamic
+  server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server->send(200, FPSTR(HTTP_HEAD_CT), "");
+
+  page.tpl(HTTP_HEAD_START, {{T_v, title}});
+  #ifdef WM_ASSETS_GZ
+  // cached by the client, see handleAssetGz
+  page.tpl(HTTP_HEAD_ASSETS, {{T_1, FPSTR(WM_CSS_GZ_VER)}, {T_2, FPSTR(WM_JS_GZ_VER)}});
+  #else
   page += FPSTR(HTTP_SCRIPT);
   page += FPSTR(HTTP_STYLE);
+  #endif
   page += _customHeadElement;
+  page.tpl(HTTP_HEAD_END, {{T_c, _bodyClass}}); // add class str
+}
+
+void WiFiManager::HTTPSend(const String &content){
+  HTTPSendNoCacheHeaders(); // pages are always dynamic
+  server->send(200, FPSTR(HTTP_HEAD_CT), content);
+}
+
+/**
+ * PageStream, small pieces are collected in _buf and sent as one chunk,
+ * flash strings larger than the buffer go to the socket directly (sendContent_P)
+ */
+void WiFiManager::PageStream::flush(){
+  if(!_len) return;
+  _server.sendContent(_buf, _len);
+  _len = 0;
+}
 
-  if(_bodyClass != ""){
-    String p = FPSTR(HTTP_HEAD_END);
-    p.replace(FPSTR(T_c), _bodyClass); // add class str
-    page += p;
+void WiFiManager::PageStream::write_P(PGM_P data, size_t len){
+  if(len >= sizeof(_buf)){
+    flush();
+    _server.sendContent_P(data, len);
+    return;
   }
-  else {
-    page += FPSTR(HTTP_HEAD_END);
-  } 
+  while(len){
+    if(_len == sizeof(_buf)) flush();
+    size_t n = std::min(len, sizeof(_buf) - _len);
+    memcpy_P(_buf + _len, data, n);
+    _len += n;
+    data += n;
+    len  -= n;
+  }
+}
 
-  return page;
+WiFiManager::PageStream& WiFiManager::PageStream::operator+=(const __FlashStringHelper *str){
+  if(str) write_P((PGM_P)str, strlen_P((PGM_P)str));
+  return *this;
 }
 
-void WiFiManager::HTTPSend(const String &content){
-  server->send(200, FPSTR(HTTP_HEAD_CT), content);
+WiFiManager::PageStream& WiFiManager::PageStream::operator+=(const String &str){
+  write_P(str.c_str(), str.length()); // memcpy_P is safe on ram
+  return *this;
+}
+
+WiFiManager::PageStream& WiFiManager::PageStream::operator+=(const char *str){
+  if(str) write_P(str, strlen_P(str));
+  return *this;
+}
+
+/**
+ * stream a flash template, tokens ({v}, {1} ..) are replaced by their value on the way,
+ * the template itself is never copied to ram, unknown tokens are sent as is
+ */
+void WiFiManager::PageStream::tpl(PGM_P tpl, std::initializer_list<wm_token_t> tokens){
+  PGM_P run = tpl; // start of pending literal text
+  PGM_P p   = tpl;
+  char c;
+  while((c = pgm_read_byte(p)) != 0){
+    if(c != '{'){
+      p++;
+      continue;
+    }
+    const wm_token_t *hit = nullptr;
+    size_t tlen = 0;
+    for(const wm_token_t &t : tokens){
+      // both sides are in flash, compare through pgm_read_byte
+      for(tlen = 0; pgm_read_byte(t.token + tlen) && pgm_read_byte(p + tlen) == pgm_read_byte(t.token + tlen); tlen++);
+      if(!pgm_read_byte(t.token + tlen)){
+        hit = &t;
+        break;
+      }
+    }
+    if(!hit){
+      p++;
+      continue;
+    }
+    write_P(run, p - run);
+    *this += hit->value;
+    p  += tlen;
+    run = p;
+  }
+  write_P(run, p - run);
+}
+
+void WiFiManager::PageStream::end(){
+  flush();
+  _server.sendContent(""); // end chunked
+}
+
+/**
+ * cache headers for dynamic responses (pages, json, 404)
+ * static assets go through handleAssetGz and are cacheable instead
+ */
+void WiFiManager::HTTPSendNoCacheHeaders(){
+  server->sendHeader(F("Cache-Control"), F("no-cache, no-store, must-revalidate")); // @HTTPHEAD send cache
+  server->sendHeader(F("Pragma"), F("no-cache"));
+  server->sendHeader(F("Expires"), F("-1"));
 }
 
 /** 
@@ -1332,17 +1442,17 @@ void WiFiManager::handleRoot() {
   #endif
   if (captivePortal()) return; // If captive portal redirect instead of displaying the page
   handleRequest();
-  String page = getHTTPHead(_title); // @token options @todo replace options with title
-  String str  = FPSTR(HTTP_ROOT_MAIN); // @todo custom title
-  str.replace(FPSTR(T_t),_title);
-  str.replace(FPSTR(T_v),configPortalActive ? _apName : (getWiFiHostname() + " - " + WiFi.localIP().toString())); // use ip if ap is not active for heading @todo use hostname?
-  page += str;
+  PageStream page(*server);
+  HTTPSendHead(page, _title); // @token options @todo replace options with title
+  page.tpl(HTTP_ROOT_MAIN, { // @todo custom title
+    {T_t, _title},
+    {T_v, configPortalActive ? _apName : (getWiFiHostname() + " - " + WiFi.localIP().toString())} // use ip if ap is not active for heading @todo use hostname?
+  });
   page += FPSTR(HTTP_PORTAL_OPTIONS);
   page += getMenuOut();
   reportStatus(page);
   page += FPSTR(HTTP_END);
-
-  HTTPSend(page);
+  page.end();
   if(_preloadwifiscan) WiFi_scanNetworks(_scancachetime,true); // preload wifiscan throttled, async
   // @todo buggy, captive portals make a query on every page load, causing this to run every time in addition to the real page load
   // I dont understand why, when you are already in the captive portal, I guess they want to know that its still up and not done or gone
@@ -1357,34 +1467,33 @@ void WiFiManager::handleWifi(boolean scan) {
   DEBUG_WM(WM_DEBUG_VERBOSE,F("<- HTTP Wifi"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titlewifi)); // @token titlewifi
+  PageStream page(*server);
+  HTTPSendHead(page, FPSTR(S_titlewifi)); // @token titlewifi
   if (scan) {
     #ifdef WM_DEBUG_LEVEL
     // DEBUG_WM(WM_DEBUG_DEV,"refresh flag:",server->hasArg(F("refresh")));
     #endif
-    WiFi_scanNetworks(server->hasArg(F("refresh")),false); //wifiscan, force if arg refresh
-    page += getScanItemOut();
+    bool refresh = server->hasArg(F("refresh"));
+    if(!refresh && WiFi_scanIsCached()){
+      page += getScanItemOut(); // cached, render inline
+    }
+    else {
+      // never block the page on a scan, the client script polls /wifiscan.json
+      if(_asyncScan && WiFi.scanComplete() != WIFI_SCAN_RUNNING) WiFi_scanNetworks(refresh,true);
+      page.tpl(HTTP_SCAN_ASYNC, {{T_v, FPSTR(S_scanning)}, {T_n, FPSTR(S_nonetworks)}});
+    }
   }
-  String pitem = "";
-
-  pitem = FPSTR(HTTP_FORM_START);
-  pitem.replace(FPSTR(T_v), F("wifisave")); // set form action
-  page += pitem;
 
-  pitem = FPSTR(HTTP_FORM_WIFI);
-  pitem.replace(FPSTR(T_v), WiFi_SSID());
+  page.tpl(HTTP_FORM_START, {{T_v, F("wifisave")}}); // set form action
 
+  String psk;
   if(_showPassword){
-    pitem.replace(FPSTR(T_p), WiFi_psk());
+    psk = WiFi_psk();
   }
   else if(WiFi_psk() != ""){
-    pitem.replace(FPSTR(T_p),FPSTR(S_passph));    
-  }
-  else {
-    pitem.replace(FPSTR(T_p),"");    
+    psk = FPSTR(S_passph);
   }
-
-  page += pitem;
+  page.tpl(HTTP_FORM_WIFI, {{T_v, WiFi_SSID()}, {T_p, psk}});
 
   page += getStaticOut();
   page += FPSTR(HTTP_FORM_WIFI_END);
@@ -1397,8 +1506,7 @@ void WiFiManager::handleWifi(boolean scan) {
   if(_showBack) page += FPSTR(HTTP_BACKBTN);
   reportStatus(page);
   page += FPSTR(HTTP_END);
-
-  HTTPSend(page);
+  page.end();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(WM_DEBUG_DEV,F("Sent config page"));
@@ -1413,21 +1521,17 @@ void WiFiManager::handleParam(){
   DEBUG_WM(WM_DEBUG_VERBOSE,F("<- HTTP Param"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titleparam)); // @token titlewifi
-
-  String pitem = "";
+  PageStream page(*server);
+  HTTPSendHead(page, FPSTR(S_titleparam)); // @token titlewifi
 
-  pitem = FPSTR(HTTP_FORM_START);
-  pitem.replace(FPSTR(T_v), F("paramsave"));
-  page += pitem;
+  page.tpl(HTTP_FORM_START, {{T_v, F("paramsave")}});
 
   page += getParamOut();
   page += FPSTR(HTTP_FORM_END);
   if(_showBack) page += FPSTR(HTTP_BACKBTN);
   reportStatus(page);
   page += FPSTR(HTTP_END);
-
-  HTTPSend(page);
+  page.end();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(WM_DEBUG_DEV,F("Sent param page"));
@@ -1475,6 +1579,9 @@ bool WiFiManager::WiFi_scanNetworks(unsigned int cachetime,bool async){
 bool WiFiManager::WiFi_scanNetworks(unsigned int cachetime){
     return WiFi_scanNetworks(millis()-_lastscan > cachetime,false);
 }
+bool WiFiManager::WiFi_scanIsCached(){
+    return _lastscan && _numNetworks > 0 && (millis()-_lastscan <= _scancachetime) && WiFi.scanComplete() >= 0;
+}
 bool WiFiManager::WiFi_scanNetworks(bool force,bool async){
     #ifdef WM_DEBUG_LEVEL
     // DEBUG_WM(WM_DEBUG_DEV,"scanNetworks async:",async == true);
@@ -1553,6 +1660,43 @@ bool WiFiManager::WiFi_scanNetworks(bool force,bool async){
     return false;
 }
 
+/**
+ * snapshot the sdk scan results into _scanItems, rssi sorted (strongest first)
+ * duplicates are flagged through an ssid hash set instead of pairwise String compares
+ * the snapshot is reused until the next scan completes
+ * @return int number of items
+ */
+int WiFiManager::WiFi_scanSnapshot(){
+  int n = _numNetworks > 0 ? _numNetworks : 0;
+  if(n > 255) n = 255; // sdk index is uint8_t
+  if(_scanItemsAt == _lastscan && (int)_scanItems.size() == n) return n;
+
+  _scanItems.clear();
+  _scanItems.reserve(n);
+  for (int i = 0; i < n; i++) {
+    wm_scanitem_t item;
+    item.rssi  = WiFi.RSSI(i);
+    item.enc   = WiFi.encryptionType(i);
+    item.index = i;
+    item.dup   = false;
+    String ssid = WiFi.SSID(i);
+    item.hash  = wm_ssidHash(ssid.c_str(), ssid.length());
+    _scanItems.push_back(item);
+  }
+
+  // RSSI SORT, then remove duplicates, first seen is strongest (wm_scan.h)
+  wm_scanSortDedup(_scanItems, _removeDuplicateAPs, [this](uint8_t seen, uint8_t item) -> bool {
+    if (WiFi.SSID(seen) != WiFi.SSID(item)) return false;
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(WM_DEBUG_VERBOSE,F("DUP AP:"),WiFi.SSID(item));
+    #endif
+    return true;
+  });
+
+  _scanItemsAt = _lastscan;
+  return n;
+}
+
 String WiFiManager::WiFiManager::getScanItemOut(){
     String page;
 
@@ -1570,44 +1714,8 @@ String WiFiManager::WiFiManager::getScanItemOut(){
       #ifdef WM_DEBUG_LEVEL
       DEBUG_WM(n,F("networks found"));
       #endif
-      //sort networks
-      int indices[n];
-      for (int i = 0; i < n; i++) {
-        indices[i] = i;
-      }
-
-      // RSSI SORT
-      for (int i = 0; i < n; i++) {
-        for (int j = i + 1; j < n; j++) {
-          if (WiFi.RSSI(indices[j]) > WiFi.RSSI(indices[i])) {
-            std::swap(indices[i], indices[j]);
-          }
-        }
-      }
-
-      /* test std:sort
-        std::sort(indices, indices + n, [](const int & a, const int & b) -> bool
-        {
-        return WiFi.RSSI(a) > WiFi.RSSI(b);
-        });
-       */
-
-      // remove duplicates ( must be RSSI sorted )
-      if (_removeDuplicateAPs) {
-        String cssid;
-        for (int i = 0; i < n; i++) {
-          if (indices[i] == -1) continue;
-          cssid = WiFi.SSID(indices[i]);
-          for (int j = i + 1; j < n; j++) {
-            if (cssid == WiFi.SSID(indices[j])) {
-              #ifdef WM_DEBUG_LEVEL
-              DEBUG_WM(WM_DEBUG_VERBOSE,F("DUP AP:"),WiFi.SSID(indices[j]));
-              #endif
-              indices[j] = -1; // set dup aps to index -1
-            }
-          }
-        }
-      }
+      // rssi sorted, dups flagged, see WiFi_scanSnapshot
+      n = WiFi_scanSnapshot();
 
       // token precheck, to speed up replacements on large ap lists
       String HTTP_ITEM_STR = FPSTR(HTTP_ITEM);
@@ -1627,26 +1735,28 @@ String WiFiManager::WiFiManager::getScanItemOut(){
       
       //display networks in page
       for (int i = 0; i < n; i++) {
-        if (indices[i] == -1) continue; // skip dups
+        const wm_scanitem_t &ap = _scanItems[i];
+        if (ap.dup) continue; // skip dups
 
         #ifdef WM_DEBUG_LEVEL
-        DEBUG_WM(WM_DEBUG_VERBOSE,F("AP: "),(String)WiFi.RSSI(indices[i]) + " " + (String)WiFi.SSID(indices[i]));
+        DEBUG_WM(WM_DEBUG_VERBOSE,F("AP: "),(String)ap.rssi + " " + (String)WiFi.SSID(ap.index));
         #endif
 
-        int rssiperc = getRSSIasQuality(WiFi.RSSI(indices[i]));
-        uint8_t enc_type = WiFi.encryptionType(indices[i]);
+        int rssiperc = getRSSIasQuality(ap.rssi);
+        uint8_t enc_type = ap.enc;
 
         if (_minimumQuality == -1 || _minimumQuality < rssiperc) {
           String item = HTTP_ITEM_STR;
-          if(WiFi.SSID(indices[i]) == ""){
-            // Serial.println(WiFi.BSSIDstr(indices[i]));
+          String ssid = WiFi.SSID(ap.index);
+          if(ssid == ""){
+            // Serial.println(WiFi.BSSIDstr(ap.index));
             continue; // No idea why I am seeing these, lets just skip them for now
           }
-          item.replace(FPSTR(T_V), htmlEntities(WiFi.SSID(indices[i]))); // ssid no encoding
-          item.replace(FPSTR(T_v), htmlEntities(WiFi.SSID(indices[i]),true)); // ssid no encoding
+          item.replace(FPSTR(T_V), htmlEntities(ssid)); // ssid no encoding
+          item.replace(FPSTR(T_v), htmlEntities(ssid,true)); // ssid no encoding
           if(tok_e) item.replace(FPSTR(T_e), encryptionTypeStr(enc_type));
           if(tok_r) item.replace(FPSTR(T_r), (String)rssiperc); // rssi percentage 0-100
-          if(tok_R) item.replace(FPSTR(T_R), (String)WiFi.RSSI(indices[i])); // rssi db
+          if(tok_R) item.replace(FPSTR(T_R), (String)ap.rssi); // rssi db
           if(tok_q) item.replace(FPSTR(T_q), (String)int(round(map(rssiperc,0,100,1,4)))); //quality icon 1-4
           if(tok_i){
             if (enc_type != WM_WIFIOPEN) {
@@ -1801,6 +1911,94 @@ void WiFiManager::handleWiFiStatus(){
   HTTPSend(page);
 }
 
+/**
+ * HTTPD CALLBACK static portal asset, pre gzipped in flash
+ * sent as is with Content-Encoding gzip, clients cache it across pages
+ * pages link it with its content version, so it never changes under a url and may be cached forever
+ * conditional GET (If-None-Match) is answered with an empty 304
+ */
+void WiFiManager::handleAssetGz(PGM_P contentType, PGM_P data, size_t len, PGM_P etag){
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(WM_DEBUG_VERBOSE,F("<- HTTP asset"),server->uri());
+  #endif
+  server->sendHeader(F("Cache-Control"), F("public, max-age=31536000, immutable")); // @HTTPHEAD send cache
+  server->sendHeader(F("ETag"), FPSTR(etag));
+  if(server->hasHeader(F("If-None-Match")) && server->header(F("If-None-Match")).indexOf(FPSTR(etag)) >= 0){
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(WM_DEBUG_DEV,F("asset not modified"));
+    #endif
+    server->send(304);
+    return;
+  }
+  server->sendHeader(F("Content-Encoding"), F("gzip")); // @HTTPHEAD send gzip
+  server->send_P(200, contentType, data, len);
+}
+
+/**
+ * HTTPD CALLBACK wifi scan results as json, polled by HTTP_SCAN_ASYNC
+ * results are served from the scan cache while younger than _scancachetime
+ * {"scanning":0,"age":ms,"p":showperc,"aps":[["ssid",quality%,locked],..]}
+ */
+void WiFiManager::handleWifiScanJson(){
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(WM_DEBUG_VERBOSE,F("<- HTTP WiFi scan json"));
+  #endif
+  handleRequest();
+  HTTPSendNoCacheHeaders();
+
+  if(WiFi.scanComplete() != WIFI_SCAN_RUNNING){
+    WiFi_scanNetworks(server->hasArg(F("refresh")),true); // honors _scancachetime, blocks only if !_asyncScan
+  }
+  // sdk results are not readable while a scan is running
+  if(WiFi.scanComplete() == WIFI_SCAN_RUNNING){
+    server->send(200, FPSTR(HTTP_HEAD_CTJSON), F("{\"scanning\":1,\"aps\":[]}"));
+    return;
+  }
+
+  int n = WiFi_scanSnapshot();
+  server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server->send(200, FPSTR(HTTP_HEAD_CTJSON), "");
+
+  String chunk;
+  chunk.reserve(256);
+  chunk  = F("{\"scanning\":0,\"age\":");
+  chunk += (String)(millis()-_lastscan);
+  chunk += F(",\"p\":");
+  chunk += _scanDispOptions ? '1' : '0';
+  chunk += F(",\"aps\":[");
+  bool first = true;
+  for (int i = 0; i < n; i++) {
+    const wm_scanitem_t &ap = _scanItems[i];
+    if (ap.dup) continue;
+    int rssiperc = getRSSIasQuality(ap.rssi);
+    if (_minimumQuality != -1 && _minimumQuality >= rssiperc) continue;
+    String ssid = WiFi.SSID(ap.index);
+    if (ssid == "") continue;
+
+    if(!first) chunk += ',';
+    first = false;
+    chunk += F("[\"");
+    for (size_t c = 0; c < ssid.length(); c++) {
+      char ch = ssid[c];
+      if (ch == '"' || ch == '\\') { chunk += '\\'; chunk += ch; }
+      else if ((uint8_t)ch < 0x20) chunk += ' ';
+      else chunk += ch;
+    }
+    chunk += F("\",");
+    chunk += (String)rssiperc;
+    chunk += ap.enc != WM_WIFIOPEN ? F(",1]") : F(",0]");
+    // stream as we go, keeps the response off the heap on large ap lists
+    if (chunk.length() > 200) {
+      server->sendContent(chunk);
+      chunk = "";
+    }
+    delay(0);
+  }
+  chunk += F("]}");
+  server->sendContent(chunk);
+  server->sendContent(""); // end chunked
+}
+
 /** 
  * HTTPD CALLBACK save form and redirect to WLAN config page again
  */
@@ -1875,22 +2073,21 @@ void WiFiManager::handleWifiSave() {
 
   if(_paramsInWifi) doParamSave();
 
-  String page;
+  server->sendHeader(FPSTR(HTTP_HEAD_CORS), FPSTR(HTTP_HEAD_CORS_ALLOW_ALL)); // @HTTPHEAD send cors
+  PageStream page(*server);
 
   if(_ssid == ""){
-    page = getHTTPHead(FPSTR(S_titlewifisettings)); // @token titleparamsaved
+    HTTPSendHead(page, FPSTR(S_titlewifisettings)); // @token titleparamsaved
     page += FPSTR(HTTP_PARAMSAVED);
   }
   else {
-    page = getHTTPHead(FPSTR(S_titlewifisaved)); // @token titlewifisaved
+    HTTPSendHead(page, FPSTR(S_titlewifisaved)); // @token titlewifisaved
     page += FPSTR(HTTP_SAVED);
   }
 
   if(_showBack) page += FPSTR(HTTP_BACKBTN);
   page += FPSTR(HTTP_END);
-
-  server->sendHeader(FPSTR(HTTP_HEAD_CORS), FPSTR(HTTP_HEAD_CORS_ALLOW_ALL)); // @HTTPHEAD send cors
-  HTTPSend(page);
+  page.end();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(WM_DEBUG_DEV,F("Sent wifi save page"));
@@ -1911,12 +2108,12 @@ void WiFiManager::handleParamSave() {
 
   doParamSave();
 
-  String page = getHTTPHead(FPSTR(S_titleparamsaved)); // @token titleparamsaved
+  PageStream page(*server);
+  HTTPSendHead(page, FPSTR(S_titleparamsaved)); // @token titleparamsaved
   page += FPSTR(HTTP_PARAMSAVED);
   if(_showBack) page += FPSTR(HTTP_BACKBTN); 
   page += FPSTR(HTTP_END);
-
-  HTTPSend(page);
+  page.end();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(WM_DEBUG_DEV,F("Sent param save page"));
@@ -1977,7 +2174,8 @@ void WiFiManager::handleInfo() {
   DEBUG_WM(WM_DEBUG_VERBOSE,F("<- HTTP Info"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titleinfo)); // @token titleinfo
+  PageStream page(*server);
+  HTTPSendHead(page, FPSTR(S_titleinfo)); // @token titleinfo
   reportStatus(page);
 
   uint16_t infos = 0;
@@ -1986,7 +2184,7 @@ void WiFiManager::handleInfo() {
   //@todo wrap in build flag to remove all info code for memory saving
   #ifdef ESP8266
     infos = 28;
-    String infoids[] = {
+    const __FlashStringHelper *infoids[] = { // flash, not 28 heap strings
       F("esphead"),
       F("uptime"),
       F("chipid"),
@@ -2020,7 +2218,7 @@ void WiFiManager::handleInfo() {
   #elif defined(ESP32)
     // add esp_chip_info ?
     infos = 27;
-    String infoids[] = {
+    const __FlashStringHelper *infoids[] = { // flash, not 28 heap strings
       F("esphead"),
       F("uptime"),
       F("chipid"),
@@ -2072,8 +2270,7 @@ void WiFiManager::handleInfo() {
   if(_showBack) page += FPSTR(HTTP_BACKBTN);
   page += FPSTR(HTTP_HELP);
   page += FPSTR(HTTP_END);
-
-  HTTPSend(page);
+  page.end();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(WM_DEBUG_DEV,F("Sent info page"));
@@ -2322,11 +2519,11 @@ void WiFiManager::handleExit() {
   DEBUG_WM(WM_DEBUG_VERBOSE,F("<- HTTP Exit"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titleexit)); // @token titleexit
+  PageStream page(*server);
+  HTTPSendHead(page, FPSTR(S_titleexit)); // @token titleexit
   page += FPSTR(S_exiting); // @token exiting
   // ('Logout', 401, {'WWW-Authenticate': 'Basic realm="Login required"'})
-  server->sendHeader(F("Cache-Control"), F("no-cache, no-store, must-revalidate")); // @HTTPHEAD send cache
-  HTTPSend(page);
+  page.end();
   delay(2000);
   abort = true;
 }
@@ -2339,11 +2536,11 @@ void WiFiManager::handleReset() {
   DEBUG_WM(WM_DEBUG_VERBOSE,F("<- HTTP Reset"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titlereset)); //@token titlereset
+  PageStream page(*server);
+  HTTPSendHead(page, FPSTR(S_titlereset)); //@token titlereset
   page += FPSTR(S_resetting); //@token resetting
   page += FPSTR(HTTP_END);
-
-  HTTPSend(page);
+  page.end();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(F("RESETTING ESP"));
@@ -2364,10 +2561,11 @@ void WiFiManager::handleErase(boolean opt) {
   DEBUG_WM(WM_DEBUG_NOTIFY,F("<- HTTP Erase"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titleerase)); // @token titleerase
-
   bool ret = erase(opt);
 
+  PageStream page(*server);
+  HTTPSendHead(page, FPSTR(S_titleerase)); // @token titleerase
+
   if(ret) page += FPSTR(S_resetting); // @token resetting
   else {
     page += FPSTR(S_error); // @token erroroccur
@@ -2377,7 +2575,7 @@ void WiFiManager::handleErase(boolean opt) {
   }
 
   page += FPSTR(HTTP_END);
-  HTTPSend(page);
+  page.end();
 
   if(ret){
     delay(2000);
@@ -2410,9 +2608,7 @@ void WiFiManager::handleNotFound() {
       message += " " + server->argName ( i ) + ": " + server->arg ( i ) + "\n";
     }
   }
-  server->sendHeader(F("Cache-Control"), F("no-cache, no-store, must-revalidate")); // @HTTPHEAD send cache
-  server->sendHeader(F("Pragma"), F("no-cache"));
-  server->sendHeader(F("Expires"), F("-1"));
+  HTTPSendNoCacheHeaders();
   server->send ( 404, FPSTR(HTTP_HEAD_CT2), message );
 }
 
@@ -2469,55 +2665,48 @@ void WiFiManager::handleClose(){
   DEBUG_WM(WM_DEBUG_VERBOSE,F("<- HTTP close"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titleclose)); // @token titleclose
+  PageStream page(*server);
+  HTTPSendHead(page, FPSTR(S_titleclose)); // @token titleclose
   page += FPSTR(S_closing); // @token closing
-  HTTPSend(page);
+  page.end();
 }
 
-void WiFiManager::reportStatus(String &page){
+void WiFiManager::reportStatus(PageStream &page){
   // updateConxResult(WiFi.status()); // @todo: this defeats the purpose of last result, update elsewhere or add logic here
   DEBUG_WM(WM_DEBUG_DEV,F("[WIFI] reportStatus prev:"),getWLStatusString(_lastconxresult));
   DEBUG_WM(WM_DEBUG_DEV,F("[WIFI] reportStatus current:"),getWLStatusString(WiFi.status()));
-  String str;
   if (WiFi_SSID() != ""){
     if (WiFi.status()==WL_CONNECTED){
-      str = FPSTR(HTTP_STATUS_ON);
-      str.replace(FPSTR(T_i),WiFi.localIP().toString());
-      str.replace(FPSTR(T_v),htmlEntities(WiFi_SSID()));
+      page.tpl(HTTP_STATUS_ON, {{T_i, WiFi.localIP().toString()}, {T_v, htmlEntities(WiFi_SSID())}});
     }
     else {
-      str = FPSTR(HTTP_STATUS_OFF);
-      str.replace(FPSTR(T_v),htmlEntities(WiFi_SSID()));
+      PGM_P reason = nullptr;
       if(_lastconxresult == WL_STATION_WRONG_PASSWORD){
         // wrong password
-        str.replace(FPSTR(T_c),"D"); // class
-        str.replace(FPSTR(T_r),FPSTR(HTTP_STATUS_OFFPW));
+        reason = HTTP_STATUS_OFFPW;
       }
       else if(_lastconxresult == WL_NO_SSID_AVAIL){
         // connect failed, or ap not found
-        str.replace(FPSTR(T_c),"D");
-        str.replace(FPSTR(T_r),FPSTR(HTTP_STATUS_OFFNOAP));
+        reason = HTTP_STATUS_OFFNOAP;
       }
       else if(_lastconxresult == WL_CONNECT_FAILED){
         // connect failed
-        str.replace(FPSTR(T_c),"D");
-        str.replace(FPSTR(T_r),FPSTR(HTTP_STATUS_OFFFAIL));
+        reason = HTTP_STATUS_OFFFAIL;
       }
       else if(_lastconxresult == WL_CONNECTION_LOST){
         // connect failed, MOST likely 4WAY_HANDSHAKE_TIMEOUT/incorrect password, state is ambiguous however
-        str.replace(FPSTR(T_c),"D");
-        str.replace(FPSTR(T_r),FPSTR(HTTP_STATUS_OFFFAIL));
+        reason = HTTP_STATUS_OFFFAIL;
       }
-      else{
-        str.replace(FPSTR(T_c),"");
-        str.replace(FPSTR(T_r),"");
-      } 
+      page.tpl(HTTP_STATUS_OFF, {
+        {T_v, htmlEntities(WiFi_SSID())},
+        {T_c, reason ? F("D") : F("")}, // class
+        {T_r, reason ? FPSTR(reason) : F("")}
+      });
     }
   }
   else {
-    str = FPSTR(HTTP_STATUS_NONE);
+    page += FPSTR(HTTP_STATUS_NONE);
   }
-  page += str;
 }
 
 // PUBLIC
@@ -3326,6 +3515,7 @@ String WiFiManager::getWiFiPass(bool persistent){
 
 // DEBUG
 // @todo fix DEBUG_WM(0,0);
+#ifndef WM_NODEBUG
 template <typename Generic>
 void WiFiManager::DEBUG_WM(Generic text) {
   DEBUG_WM(WM_DEBUG_NOTIFY,text,"");
@@ -3370,14 +3560,19 @@ void WiFiManager::DEBUG_WM(wm_debuglevel_t level,Generic text,Genericb textb) {
   }
 
   _debugPort.print(_debugPrefix);
-  if(_debugLevel >= debugLvlShow) _debugPort.print("["+(String)level+"] ");
+  if(_debugLevel >= debugLvlShow){
+    _debugPort.print('[');
+    _debugPort.print((uint8_t)level);
+    _debugPort.print(F("] "));
+  }
   _debugPort.print(text);
   if(textb){
-    _debugPort.print(" ");
+    _debugPort.print(' ');
     _debugPort.print(textb);
   }
   _debugPort.println();
 }
+#endif // WM_NODEBUG
 
 /**
  * [debugSoftAPConfig description]
@@ -3874,16 +4069,16 @@ void WiFiManager::handleUpdate() {
 	DEBUG_WM(WM_DEBUG_VERBOSE,F("<- Handle update"));
   #endif
 	if (captivePortal()) return; // If captive portal redirect instead of displaying the page
-	String page = getHTTPHead(_title); // @token options
-	String str = FPSTR(HTTP_ROOT_MAIN);
-  str.replace(FPSTR(T_t), _title);
-	str.replace(FPSTR(T_v), configPortalActive ? _apName : (getWiFiHostname() + " - " + WiFi.localIP().toString())); // use ip if ap is not active for heading
-	page += str;
+	PageStream page(*server);
+	HTTPSendHead(page, _title); // @token options
+	page.tpl(HTTP_ROOT_MAIN, {
+	  {T_t, _title},
+	  {T_v, configPortalActive ? _apName : (getWiFiHostname() + " - " + WiFi.localIP().toString())} // use ip if ap is not active for heading
+	});
 
 	page += FPSTR(HTTP_UPDATE);
 	page += FPSTR(HTTP_END);
-
-	HTTPSend(page);
+	page.end();
 
 }
 
@@ -3984,11 +4179,12 @@ void WiFiManager::handleUpdateDone() {
 	DEBUG_WM(WM_DEBUG_VERBOSE, F("<- Handle update done"));
 	// if (captivePortal()) return; // If captive portal redirect instead of displaying the page
 
-	String page = getHTTPHead(FPSTR(S_options)); // @token options
-	String str  = FPSTR(HTTP_ROOT_MAIN);
-  str.replace(FPSTR(T_t),_title);
-	str.replace(FPSTR(T_v), configPortalActive ? _apName : WiFi.localIP().toString()); // use ip if ap is not active for heading
-	page += str;
+	PageStream page(*server);
+	HTTPSendHead(page, FPSTR(S_options)); // @token options
+	page.tpl(HTTP_ROOT_MAIN, {
+	  {T_t, _title},
+	  {T_v, configPortalActive ? _apName : WiFi.localIP().toString()} // use ip if ap is not active for heading
+	});
 
 	if (Update.hasError()) {
 		page += FPSTR(HTTP_UPDATE_FAIL);
@@ -4004,8 +4200,7 @@ void WiFiManager::handleUpdateDone() {
 		DEBUG_WM(F("[OTA] update ok"));
 	}
 	page += FPSTR(HTTP_END);
-
-	HTTPSend(page);
+	page.end();
 
 	delay(1000); // send page
 	if (!Update.hasError()) {
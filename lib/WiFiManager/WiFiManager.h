@@ -21,6 +21,8 @@
 #endif
 
 #include <vector>
+#include <initializer_list>
+#include <algorithm>
 
 // #define WM_MDNS            // includes MDNS, also set MDNS with sethostname
 // #define WM_FIXERASECONFIG  // use erase flash fix
@@ -133,6 +135,13 @@
 #include <memory>
 
 
+// debug output follows the firmware log level (LOG_LEVEL, include/log.h): below debug (4)
+// DEBUG_WM compiles to nothing, so no String arguments are built and nothing is
+// printed to Serial outside the log ring buffer; define WM_DEBUG_LEVEL to keep it
+#if !defined(WM_NODEBUG) && !defined(WM_DEBUG_LEVEL) && defined(LOG_LEVEL) && LOG_LEVEL < 4
+#define WM_NODEBUG
+#endif
+
 // Include wm strings vars
 // Pass in strings env override via WM_STRINGS_FILE
 #ifndef WM_STRINGS_FILE
@@ -140,6 +149,22 @@
 #endif
 #include WM_STRINGS_FILE
 
+#include "wm_scan.h"
+
+// gzipped HTTP_STYLE/HTTP_SCRIPT served as /wm.css /wm.js, generated by the pre-build step
+// falls back to inlining them into every page if absent
+#if !defined(WM_NOASSETSGZ) && defined(__has_include)
+#if __has_include("wm_assets_gz.h")
+#include "wm_assets_gz.h"
+#define WM_ASSETS_GZ
+#endif
+#endif
+
+// portal pages are written to the client in chunks of this size while they are built
+#ifndef WM_PAGE_CHUNK
+#define WM_PAGE_CHUNK 256
+#endif
+
 // prep string concat vars
 #define WM_STRING2(x) #x
 #define WM_STRING(x) WM_STRING2(x)    
@@ -532,6 +557,10 @@ class WiFiManager
     unsigned long _startscan              = 0; // ms for timing wifi scans
     unsigned long _startconn              = 0; // ms for timing wifi connects
 
+    // wifiscan snapshot, taken once per scan so sort/dedup never call back into the sdk per compare
+    std::vector<wm_scanitem_t> _scanItems;  // rssi sorted, see WiFi_scanSnapshot()
+    unsigned long _scanItemsAt            = 0; // _lastscan the snapshot was taken for
+
     // defaults
     const byte    DNS_PORT                = 53;
     String        _apName                 = "no-net";
@@ -665,7 +694,33 @@ protected:
 public:
     void          handleNotFound();
 protected:
+    // {x} token and its value for PageStream::tpl
+    typedef struct {
+      PGM_P  token;
+      String value;
+    } wm_token_t;
+
+    // page output, flash strings go to the socket without a RAM copy,
+    // tokens are filled in while the template is streamed
+    class PageStream {
+      public:
+        explicit PageStream(WM_WebServer &server) : _server(server) {}
+        PageStream& operator+=(const __FlashStringHelper *str);
+        PageStream& operator+=(const String &str);
+        PageStream& operator+=(const char *str); // ram or flash
+        void        tpl(PGM_P tpl, std::initializer_list<wm_token_t> tokens);
+        void        end();
+      private:
+        void        write_P(PGM_P data, size_t len);
+        void        flush();
+        WM_WebServer &_server;
+        char        _buf[WM_PAGE_CHUNK];
+        size_t      _len = 0;
+    };
+
     void          HTTPSend(const String &content);
+    void          HTTPSendHead(PageStream &page, const String &title);
+    void          HTTPSendNoCacheHeaders();
     void          handleRoot();
     void          handleWifi(boolean scan);
     void          handleWifiSave();
@@ -678,6 +733,8 @@ protected:
     void          handleErase(boolean opt);
     void          handleParam();
     void          handleWiFiStatus();
+    void          handleWifiScanJson();
+    void          handleAssetGz(PGM_P contentType, PGM_P data, size_t len, PGM_P etag);
     void          handleRequest();
     void          handleParamSave();
     void          doParamSave();
@@ -709,6 +766,8 @@ protected:
     bool          WiFi_scanNetworks(unsigned int cachetime,bool async);
     bool          WiFi_scanNetworks(unsigned int cachetime);
     void          WiFi_scanComplete(int networksFound);
+    int           WiFi_scanSnapshot();
+    bool          WiFi_scanIsCached();
     bool          WiFiSetCountry();
 
     #ifdef ESP32
@@ -751,14 +810,13 @@ protected:
     String        getIpForm(String id, String title, String value);
     String        getScanItemOut();
     String        getStaticOut();
-    String        getHTTPHead(String title);
     String        getMenuOut();
     //helpers
     boolean       isIp(String str);
     String        toStringIp(IPAddress ip);
     boolean       validApPassword();
     String        encryptionTypeStr(uint8_t authmode);
-    void          reportStatus(String &page);
+    void          reportStatus(PageStream &page);
     String        getInfoData(String id);
 
     // flags
@@ -784,7 +842,11 @@ protected:
     int         _max_params;
     WiFiManagerParameter** _params    = NULL;
 
+    #ifdef WM_NODEBUG
+    boolean _debug  = false;
+    #else
     boolean _debug  = true;
+    #endif
     String _debugPrefix = FPSTR(S_debugPrefix);
 
     wm_debuglevel_t debugLvlShow = WM_DEBUG_VERBOSE; // at which level start showing [n] level tags
@@ -815,6 +877,7 @@ protected:
     Print& _debugPort = Serial; // debug output stream ref
     #endif
 
+    #ifndef WM_NODEBUG
     template <typename Generic>
     void        DEBUG_WM(Generic text);
 
@@ -824,6 +887,7 @@ protected:
     void        DEBUG_WM(Generic text,Genericb textb);
     template <typename Generic, typename Genericb>
     void        DEBUG_WM(wm_debuglevel_t level, Generic text,Genericb textb);
+    #endif
 
     // callbacks
     // @todo use cb list (vector) maybe event ids, allow no return value
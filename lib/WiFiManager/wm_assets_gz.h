@@ -0,0 +1,74 @@
+/**
+ * wm_assets_gz.h
+ * GENERATED by scripts/gzip_portal_assets.py from wm_strings_en.h, do not edit
+ * gzipped portal assets, served as /wm.css and /wm.js
+ */
+
+#ifndef _WM_ASSETS_GZ_H
+#define _WM_ASSETS_GZ_H
+
+// 2953 bytes raw, 1431 bytes gzip
+const char WM_CSS_GZ_VER[] PROGMEM = "2a205ccf676feb03";
+const char WM_CSS_GZ_ETAG[] PROGMEM = "\"2a205ccf676feb03\"";
+const size_t WM_CSS_GZ_LEN = 1431;
+const char WM_CSS_GZ[] PROGMEM =
+  "\037\213\010\000\000\000\000\000\002\003\255\126\351\157\342\070\024\377\127\262\032\215\150\305\025\110\002\041\150\244\205\000"
+  "\035\012\264\034\345\150\127\375\340\304\046\061\044\161\310\301\321\210\377\175\355\044\114\323\016\133\255\126\113\076\140\277"
+  "\367\173\207\337\341\347\222\136\320\010\074\105\001\072\006\105\140\141\303\121\164\344\004\310\153\256\211\023\024\327\300\306"
+  "\326\111\331\043\017\002\007\234\041\336\027\260\343\206\101\301\107\026\322\203\310\005\020\142\307\120\044\367\230\010\370\370"
+  "\015\051\025\144\067\155\340\031\330\141\014\216\157\152\344\310\070\014\251\021\017\042\257\110\051\347\104\223\026\006\001\161"
+  "\122\205\205\222\355\033\121\212\361\000\304\241\257\224\004\217\352\073\140\030\230\012\127\341\371\357\211\340\137\301\311\105"
+  "\077\030\206\274\026\062\024\335\104\372\226\252\177\215\022\021\020\006\344\234\032\311\300\162\011\051\367\101\066\347\207\232"
+  "\215\203\334\153\244\207\236\117\074\305\045\070\016\106\342\221\102\117\002\364\255\341\221\320\201\105\235\130\024\361\255\262"
+  "\006\002\322\233\351\156\275\136\067\055\354\240\242\211\260\141\006\112\265\044\062\357\063\261\051\125\337\217\363\371\064\271"
+  "\065\266\020\265\236\232\253\320\340\371\304\302\220\113\255\234\113\007\017\270\134\066\133\026\132\007\115\210\175\327\002\047"
+  "\005\073\261\155\315\042\372\266\151\143\247\230\230\251\326\170\232\037\033\034\323\275\304\323\375\031\104\251\317\074\317\047"
+  "\016\036\022\237\353\164\037\133\200\110\047\036\010\060\161\024\207\070\350\014\024\223\320\122\210\076\236\374\063\224\306\006"
+  "\171\314\217\163\151\027\245\141\250\324\142\007\342\222\340\233\227\252\341\071\126\067\231\303\170\014\234\161\134\220\131\135"
+  "\131\004\004\011\213\152\054\355\212\274\002\326\064\051\121\046\027\056\361\061\063\136\074\052\174\002\252\174\011\052\062\207"
+  "\022\140\365\153\240\120\275\000\205\257\201\242\174\001\212\137\003\153\142\002\264\024\015\255\211\207\376\011\047\263\244\245"
+  "\241\052\306\307\147\335\104\045\055\216\006\066\211\012\313\076\245\044\006\013\164\221\252\324\151\072\151\033\053\271\334\245"
+  "\322\130\002\262\311\270\132\062\031\117\074\344\042\152\300\041\351\252\171\305\113\332\216\265\244\277\337\171\330\006\006\122"
+  "\102\317\272\311\101\020\000\045\336\227\135\307\240\040\037\325\304\002\136\264\037\247\007\176\160\147\220\026\375\075\314\346"
+  "\146\167\156\320\325\035\333\266\046\152\153\104\377\072\350\245\357\015\031\341\276\327\036\055\272\253\162\271\054\267\376\375"
+  "\257\363\363\176\043\131\154\245\012\323\331\223\065\152\365\067\017\002\276\267\167\241\374\006\353\373\236\354\276\351\224\333"
+  "\366\147\363\151\173\361\163\003\352\317\225\266\352\267\016\152\153\366\060\133\020\241\274\317\227\333\363\056\136\071\175\262"
+  "\332\222\225\264\151\115\106\307\247\237\157\203\206\276\230\071\373\316\361\320\221\265\336\121\036\233\057\215\235\334\263\015"
+  "\163\325\066\167\055\332\025\307\155\243\072\366\217\373\251\136\125\125\265\007\315\211\252\115\267\103\322\232\010\273\362\141"
+  "\071\157\357\356\004\351\345\030\054\336\226\142\027\326\206\216\061\076\265\347\125\225\150\260\337\231\110\144\274\354\113\216"
+  "\072\077\304\047\231\315\027\217\323\201\244\076\367\373\077\162\267\315\363\237\066\202\030\160\067\264\133\265\055\016\212\254"
+  "\133\040\332\143\035\025\135\174\104\126\061\156\103\205\253\336\026\156\030\317\103\364\012\011\323\164\065\252\320\305\267\321"
+  "\257\102\051\134\152\207\213\376\227\034\016\143\237\215\044\207\352\172\224\037\230\214\060\134\374\227\034\176\310\147\353\321"
+  "\173\064\342\225\223\344\263\073\353\277\115\357\136\336\163\152\014\066\352\160\302\354\332\111\116\215\166\035\166\332\052\031"
+  "\035\272\335\325\324\036\130\213\147\141\130\056\013\017\103\363\364\266\353\357\146\163\303\070\311\341\321\061\325\251\064\042"
+  "\362\161\030\344\053\042\170\251\037\016\206\277\337\217\133\145\262\336\067\362\242\050\010\342\174\265\162\214\275\126\133\371"
+  "\075\363\261\274\040\152\165\352\317\366\215\373\372\121\156\073\317\303\145\276\265\171\222\152\041\054\207\150\074\202\132\275"
+  "\077\226\333\276\136\106\165\123\126\327\333\106\245\152\230\376\303\152\071\166\073\252\150\356\037\362\235\212\124\343\133\225"
+  "\311\370\161\172\062\145\161\061\030\156\066\160\277\036\367\354\174\036\067\272\313\035\057\210\062\265\271\061\315\247\274\010"
+  "\373\232\272\314\057\067\057\330\156\264\006\133\161\376\062\162\034\265\033\306\241\351\132\275\247\355\054\234\330\252\112\353"
+  "\043\223\306\170\336\160\015\066\202\343\226\077\237\343\351\172\271\175\253\374\373\235\314\326\361\234\376\074\167\020\102\051"
+  "\265\310\356\232\313\000\241\222\131\152\072\020\352\365\172\154\202\063\305\050\121\134\014\210\113\057\374\164\243\021\072\162"
+  "\355\344\026\243\260\322\070\272\242\344\062\351\142\000\323\164\205\336\271\046\010\165\241\046\360\051\040\043\230\245\317\256"
+  "\010\162\337\044\135\223\245\124\365\354\135\362\027\003\006\121\166\076\152\304\202\147\010\243\053\363\214\176\045\011\331\064"
+  "\224\254\365\056\367\055\033\041\001\214\350\350\014\260\016\254\164\330\161\064\066\315\163\311\214\056\127\161\074\143\223\147"
+  "\111\024\170\300\271\134\262\274\317\021\027\350\070\070\065\337\311\264\347\231\014\047\370\037\210\141\072\204\251\120\063\175"
+  "\303\160\351\043\046\125\315\202\367\333\043\046\215\121\202\120\200\036\340\075\212\122\243\364\271\360\235\373\003\333\056\361"
+  "\002\340\004\027\265\007\200\203\053\376\360\376\231\075\050\113\330\141\307\055\144\326\034\370\260\063\053\334\025\107\370\032"
+  "\373\262\257\251\254\072\056\056\340\014\363\167\005\125\231\175\227\352\144\345\227\251\146\111\222\056\234\144\240\136\347\245"
+  "\165\372\211\371\321\221\335\137\036\261\320\017\154\033\257\321\345\052\246\257\067\032\147\045\201\334\124\156\233\277\021\316"
+  "\012\115\066\320\054\004\271\137\341\145\045\323\074\377\015\155\235\300\112\211\013\000\000";
+
+// 345 bytes raw, 218 bytes gzip
+const char WM_JS_GZ_VER[] PROGMEM = "2eb5321f889ab297";
+const char WM_JS_GZ_ETAG[] PROGMEM = "\"2eb5321f889ab297\"";
+const size_t WM_JS_GZ_LEN = 218;
+const char WM_JS_GZ[] PROGMEM =
+  "\037\213\010\000\000\000\000\000\002\003\175\117\313\152\003\061\014\374\025\367\044\373\020\177\100\215\051\155\351\041\320\133"
+  "\373\003\136\077\202\100\321\232\265\066\335\220\344\337\353\205\044\267\344\044\151\146\064\314\224\231\243\340\310\052\152\062"
+  "\247\064\306\171\237\131\354\056\313\027\345\165\375\070\156\223\206\006\306\036\002\315\331\323\312\275\213\114\070\314\222\065"
+  "\244\040\141\323\032\046\060\347\063\131\144\316\323\157\136\144\075\244\317\317\221\245\333\270\252\274\042\313\035\271\032\377"
+  "\340\100\310\073\033\051\264\366\215\115\154\354\322\200\334\064\020\030\367\060\113\355\131\022\266\060\120\116\335\364\245\072"
+  "\054\272\232\247\372\322\311\246\215\273\270\162\053\134\264\121\247\103\230\324\322\115\236\075\273\305\312\261\146\357\075\324"
+  "\036\365\157\234\022\274\135\061\130\053\302\353\355\272\363\356\362\017\021\360\023\344\131\001\000\000";
+
+#endif
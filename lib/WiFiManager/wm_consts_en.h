@@ -60,6 +60,9 @@ const char R_erase[]              PROGMEM = "/erase";
 const char R_status[]             PROGMEM = "/status";
 const char R_update[]             PROGMEM = "/update";
 const char R_updatedone[]         PROGMEM = "/u";
+const char R_wifiscan[]           PROGMEM = "/wifiscan.json";
+const char R_css[]                PROGMEM = "/wm.css";
+const char R_js[]                 PROGMEM = "/wm.js";
 
 
 //Strings
@@ -96,6 +99,9 @@ const char T_h[]                  PROGMEM = "{h}"; // @token h
 const char HTTP_HEAD_CL[]         PROGMEM = "Content-Length";
 const char HTTP_HEAD_CT[]         PROGMEM = "text/html";
 const char HTTP_HEAD_CT2[]        PROGMEM = "text/plain";
+const char HTTP_HEAD_CTJSON[]     PROGMEM = "application/json";
+const char HTTP_HEAD_CTCSS[]      PROGMEM = "text/css";
+const char HTTP_HEAD_CTJS[]       PROGMEM = "application/javascript";
 const char HTTP_HEAD_CORS[]       PROGMEM = "Access-Control-Allow-Origin";
 const char HTTP_HEAD_CORS_ALLOW_ALL[]  PROGMEM = "*";
 
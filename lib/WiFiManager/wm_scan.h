@@ -0,0 +1,65 @@
+/**
+ * wm_scan.h
+ * wifiscan snapshot sort and dedup, used by WiFiManager::WiFi_scanSnapshot()
+ * no core dependencies, so tools/scan_bench runs the same code on the host
+ */
+
+#ifndef _WM_SCAN_H
+#define _WM_SCAN_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <algorithm>
+#include <vector>
+
+// one scan result, taken once per scan so sort/dedup never call back into the sdk per compare
+typedef struct {
+  int32_t  rssi;
+  uint32_t hash;  // fnv-1a of ssid bytes, for dedup
+  uint8_t  index; // sdk scan result index
+  uint8_t  enc;   // encryption type
+  bool     dup;   // weaker duplicate of an earlier ssid
+} wm_scanitem_t;
+
+inline uint32_t wm_ssidHash(const char *ssid, size_t len){
+  uint32_t hash = 2166136261UL; // fnv-1a 32
+  for (size_t c = 0; c < len; c++) {
+    hash ^= (uint8_t)ssid[c];
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+/**
+ * rssi sort (strongest first, index breaks ties so output order is stable across page loads)
+ * and, if dedup, flag every weaker item whose ssid was already seen
+ * @param sameSsid bool(uint8_t indexA, uint8_t indexB), only called on hash matches
+ */
+template <typename SameSsid>
+void wm_scanSortDedup(std::vector<wm_scanitem_t> &items, bool dedup, SameSsid sameSsid){
+  std::sort(items.begin(), items.end(), [](const wm_scanitem_t &a, const wm_scanitem_t &b) -> bool {
+    return a.rssi != b.rssi ? a.rssi > b.rssi : a.index < b.index;
+  });
+  size_t n = items.size();
+  if (!dedup || n < 2) return;
+
+  size_t cap = 4;
+  while (cap < n * 2) cap <<= 1;
+  std::vector<int16_t> slots(cap, -1); // open addressing, indexes into items
+  for (size_t i = 0; i < n; i++) {
+    wm_scanitem_t &item = items[i];
+    size_t s = item.hash & (cap - 1);
+    while (slots[s] != -1) {
+      const wm_scanitem_t &seen = items[slots[s]];
+      // hash match is confirmed on the ssid itself, collisions must not hide networks
+      if (seen.hash == item.hash && sameSsid(seen.index, item.index)) {
+        item.dup = true;
+        break;
+      }
+      s = (s + 1) & (cap - 1);
+    }
+    if (!item.dup) slots[s] = i;
+  }
+}
+
+#endif
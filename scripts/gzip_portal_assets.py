@@ -0,0 +1,130 @@
+"""
+Pre-build step: gzip the static WiFiManager portal assets into PROGMEM blobs.
+
+HTTP_STYLE and HTTP_SCRIPT from the strings file the build selects
+(WM_STRINGS_FILE in build_flags, wm_strings_en.h by default) are extracted,
+gzipped and written to wm_assets_gz.h next to the library sources. WiFiManager
+then serves them as cacheable /wm.css and /wm.js (Content-Encoding: gzip)
+instead of inlining them into every page. The content hash is both the
+strong ETag and the ?version query the pages link with, so a firmware that
+changes the assets busts client caches and one that does not keeps them.
+
+Used as a PlatformIO extra script (pre:), or standalone:
+    python scripts/gzip_portal_assets.py [path/to/WiFiManager [wm_strings_xx.h]]
+"""
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+DEFAULT_STRINGS = "wm_strings_en.h"  # WiFiManager.h default
+
+ASSETS = (
+    # symbol prefix, source array, wrapper tag to strip
+    ("WM_CSS", "HTTP_STYLE", "style"),
+    ("WM_JS", "HTTP_SCRIPT", "script"),
+)
+
+
+def c_array(src, name):
+    """Concatenated string literals of `const char name[] PROGMEM = "..." "...";`"""
+    m = re.search(r"const char " + name + r"\[\]\s+PROGMEM\s*=(.*?);\s*(//[^\n]*)?\n", src, re.S)
+    if not m:
+        raise SystemExit("gzip_portal_assets: %s not found" % name)
+    body = re.sub(r"^\s*//.*$", "", m.group(1), flags=re.M)
+    out = ""
+    for lit in re.findall(r'"((?:[^"\\]|\\.)*)"', body):
+        out += bytes(lit, "utf-8").decode("unicode_escape")
+    return out
+
+
+def strip_tag(text, tag):
+    text = text.strip()
+    open_tag, close_tag = "<%s>" % tag, "</%s>" % tag
+    if not (text.startswith(open_tag) and text.endswith(close_tag)):
+        raise SystemExit("gzip_portal_assets: unexpected %s wrapper" % tag)
+    return text[len(open_tag):-len(close_tag)]
+
+
+def render(blobs, strings):
+    lines = [
+        "/**",
+        " * wm_assets_gz.h",
+        " * GENERATED by scripts/gzip_portal_assets.py from %s, do not edit" % strings,
+        " * gzipped portal assets, served as /wm.css and /wm.js",
+        " */",
+        "",
+        "#ifndef _WM_ASSETS_GZ_H",
+        "#define _WM_ASSETS_GZ_H",
+        "",
+    ]
+    for prefix, raw, gz in blobs:
+        ver = hashlib.sha1(raw).hexdigest()[:16]
+        lines.append("// %d bytes raw, %d bytes gzip" % (len(raw), len(gz)))
+        lines.append('const char %s_GZ_VER[] PROGMEM = "%s";' % (prefix, ver))
+        lines.append('const char %s_GZ_ETAG[] PROGMEM = "\\"%s\\"";' % (prefix, ver))
+        lines.append("const size_t %s_GZ_LEN = %d;" % (prefix, len(gz)))
+        # octal escapes in a string literal: valid whether char is signed or not
+        lines.append("const char %s_GZ[] PROGMEM =" % prefix)
+        for i in range(0, len(gz), 32):
+            lines.append('  "' + "".join("\\%03o" % b for b in gz[i:i + 32]) + '"')
+        lines[-1] += ";"
+        lines.append("")
+    lines.append("#endif")
+    return "\n".join(lines) + "\n"
+
+
+def strings_file(cppdefines):
+    """WM_STRINGS_FILE as WiFiManager.h will see it, from parsed -D flags"""
+    for d in cppdefines or ():
+        if isinstance(d, (tuple, list)) and d[0] == "WM_STRINGS_FILE":
+            return str(d[1]).replace("\\", "").strip('"')
+    return DEFAULT_STRINGS
+
+
+def check_not_shadowed(libdeps_dir):
+    """lib/WiFiManager is the fork; a WiFiManager installed into libdeps (lib_deps,
+    a stray "pio pkg install") would be picked instead, without the changes"""
+    installed = os.path.join(libdeps_dir, "WiFiManager")
+    if os.path.isdir(installed):
+        raise SystemExit("gzip_portal_assets: %s shadows lib/WiFiManager (the fork), "
+                         "remove it and drop WiFiManager from lib_deps" % installed)
+
+
+def generate(libdir, strings=None, include_dirs=()):
+    strings = strings or DEFAULT_STRINGS
+    # a project strings file is found through the include path, like the #include
+    for d in (libdir,) + tuple(include_dirs):
+        if os.path.exists(os.path.join(d, strings)):
+            break
+    else:
+        raise SystemExit("gzip_portal_assets: WM_STRINGS_FILE %s not found" % strings)
+    src = open(os.path.join(d, strings), encoding="utf-8").read()
+    blobs = []
+    for prefix, name, tag in ASSETS:
+        raw = strip_tag(c_array(src, name), tag).encode("utf-8")
+        blobs.append((prefix, raw, gzip.compress(raw, 9, mtime=0)))
+    out = render(blobs, strings)
+    path = os.path.join(libdir, "wm_assets_gz.h")
+    if os.path.exists(path) and open(path, encoding="utf-8").read() == out:
+        return blobs
+    with open(path, "w", encoding="utf-8") as f:
+        f.write(out)
+    for prefix, raw, gz in blobs:
+        print("gzip_portal_assets: %s %d -> %d bytes (%s)" % (prefix, len(raw), len(gz), strings))
+    return blobs
+
+
+try:
+    Import("env")  # noqa: F821, PlatformIO
+    # pre: runs before build_flags reach CPPDEFINES, parse them here
+    check_not_shadowed(env.subst("$PROJECT_LIBDEPS_DIR/$PIOENV"))  # noqa: F821
+    defines = env.ParseFlags(env.get("BUILD_FLAGS", [])).get("CPPDEFINES")  # noqa: F821
+    generate(os.path.join(env.subst("$PROJECT_DIR"), "lib", "WiFiManager"), strings_file(defines),  # noqa: F821
+             (env.subst("$PROJECT_INCLUDE_DIR"), env.subst("$PROJECT_SRC_DIR")))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        here = os.path.dirname(os.path.abspath(__file__))
+        default = os.path.join(here, "..", "lib", "WiFiManager")
+        generate(sys.argv[1] if len(sys.argv) > 1 else default, sys.argv[2] if len(sys.argv) > 2 else None)
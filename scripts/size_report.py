@@ -0,0 +1,182 @@
+"""
+Size, section and static RAM report for a firmware build, with budgets.
+
+Reads the linked ELF with the xtensa binutils (size -A, nm -S), sums the
+sections per memory region (IRAM, DRAM, flash), lists the largest symbols
+per region and estimates the heap left at boot (DRAM minus .data/.rodata/.bss).
+The budgets come from the custom_budget_* options of the PlatformIO env:
+
+    custom_budget_bin  = max firmware.bin bytes (must fit the OTA slot)
+    custom_budget_iram = max IRAM bytes
+    custom_budget_heap = min heap at boot, bytes
+
+Writes <stem>.json (for devices/tools) and <stem>.txt (for humans) and
+exits 1 when a budget is exceeded, so CI does not publish the build.
+
+    python scripts/size_report.py [--env d1_mini] [--out DIR] [--stem NAME] [--version VER]
+"""
+import argparse
+import configparser
+import glob
+import json
+import os
+import subprocess
+import sys
+
+# ESP8266 memory map
+REGIONS = (
+    # name, start, end
+    ("iram", 0x40100000, 0x4010C000),
+    ("dram", 0x3FFE8000, 0x3FFFC000),
+    ("flash", 0x40200000, 0x40400000),
+)
+DRAM_SIZE = 0x3FFFC000 - 0x3FFE8000
+TOP_SYMBOLS = 15
+
+
+def region_of(addr):
+    for name, start, end in REGIONS:
+        if start <= addr < end:
+            return name
+    return None
+
+
+def find_tool(name, prefix):
+    if prefix is not None:
+        return prefix + name
+    core = os.environ.get("PLATFORMIO_CORE_DIR", os.path.expanduser("~/.platformio"))
+    hits = glob.glob(os.path.join(core, "packages", "toolchain-xtensa*", "bin", "xtensa-lx106-elf-" + name))
+    return hits[0] if hits else "xtensa-lx106-elf-" + name
+
+
+def run(cmd):
+    return subprocess.run(cmd, check=True, capture_output=True, text=True).stdout
+
+
+def sections(elf, prefix):
+    """[(name, size, addr)] of allocated sections, from size -A"""
+    out = []
+    for line in run([find_tool("size", prefix), "-A", "-d", elf]).splitlines():
+        parts = line.split()
+        if len(parts) != 3 or not parts[0].startswith("."):
+            continue
+        name, size, addr = parts[0], int(parts[1]), int(parts[2])
+        if size and addr:
+            out.append((name, size, addr))
+    return out
+
+
+def symbols(elf, prefix):
+    """{region: [(name, size)]} largest first, from nm -S"""
+    per = {name: [] for name, _, _ in REGIONS}
+    for line in run([find_tool("nm", prefix), "-S", "--size-sort", "-C", elf]).splitlines():
+        parts = line.split(None, 3)
+        if len(parts) != 4:
+            continue
+        addr, size, _kind, name = parts
+        region = region_of(int(addr, 16))
+        if region:
+            per[region].append((name, int(size, 16)))
+    return {r: sorted(s, key=lambda x: -x[1])[:TOP_SYMBOLS] for r, s in per.items()}
+
+
+def budgets(ini, env):
+    cfg = configparser.ConfigParser(inline_comment_prefixes=(";",))
+    cfg.read(ini)
+    sec = cfg["env:" + env]
+    return {key: int(sec.get("custom_budget_" + key, "0"), 0) for key in ("bin", "iram", "heap")}
+
+
+def build_report(elf, binfile, prefix, budget, version):
+    secs = sections(elf, prefix)
+    used = {name: 0 for name, _, _ in REGIONS}
+    for _name, size, addr in secs:
+        region = region_of(addr)
+        if region:
+            used[region] += size
+    dram = {name: size for name, size, addr in secs if region_of(addr) == "dram"}
+    report = {
+        "version": version,
+        "bin": os.path.getsize(binfile),
+        "iram": used["iram"],
+        "dram": used["dram"],
+        "dram_sections": dram,
+        "heap_boot": DRAM_SIZE - used["dram"],
+        "flash": used["flash"],
+        "sections": {name: size for name, size, _ in secs},
+        "symbols": symbols(elf, prefix),
+        "budget": budget,
+    }
+    failed = []
+    if budget["bin"] and report["bin"] > budget["bin"]:
+        failed.append("bin %d > %d" % (report["bin"], budget["bin"]))
+    if budget["iram"] and report["iram"] > budget["iram"]:
+        failed.append("iram %d > %d" % (report["iram"], budget["iram"]))
+    if budget["heap"] and report["heap_boot"] < budget["heap"]:
+        failed.append("heap_boot %d < %d" % (report["heap_boot"], budget["heap"]))
+    report["failed"] = failed
+    return report
+
+
+def render_text(r):
+    def row(label, value, limit, worse_if_above=True):
+        if not limit:
+            return "%-10s %8d" % (label, value)
+        pct = 100.0 * value / limit
+        mark = "FAIL" if (value > limit if worse_if_above else value < limit) else "ok"
+        return "%-10s %8d  budget %8d  %5.1f%%  %s" % (label, value, limit, pct, mark)
+
+    b = r["budget"]
+    lines = ["firmware %s" % r["version"], ""]
+    lines.append(row("bin", r["bin"], b["bin"]))
+    lines.append(row("iram", r["iram"], b["iram"]))
+    lines.append(row("heap_boot", r["heap_boot"], b["heap"], worse_if_above=False))
+    lines.append(row("dram", r["dram"], 0) + "  (" + ", ".join("%s %d" % kv for kv in sorted(r["dram_sections"].items())) + ")")
+    lines.append(row("flash", r["flash"], 0))
+    lines.append("")
+    lines.append("sections:")
+    for name, size in sorted(r["sections"].items(), key=lambda kv: -kv[1]):
+        lines.append("  %-24s %8d" % (name, size))
+    for region in ("dram", "iram", "flash"):
+        lines.append("")
+        lines.append("largest %s symbols:" % region)
+        for name, size in r["symbols"][region]:
+            lines.append("  %8d  %s" % (size, name))
+    if r["failed"]:
+        lines.append("")
+        lines.append("BUDGET EXCEEDED: " + "; ".join(r["failed"]))
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    root = os.path.join(here, "..")
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("--env", default="d1_mini")
+    ap.add_argument("--elf")
+    ap.add_argument("--bin")
+    ap.add_argument("--ini", default=os.path.join(root, "platformio.ini"))
+    ap.add_argument("--toolchain-prefix", help="e.g. xtensa-lx106-elf-, default: PlatformIO package")
+    ap.add_argument("--version", default="")
+    ap.add_argument("--out", default=".")
+    ap.add_argument("--stem", default="size-report")
+    args = ap.parse_args()
+
+    build = os.path.join(root, ".pio", "build", args.env)
+    elf = args.elf or os.path.join(build, "firmware.elf")
+    binfile = args.bin or os.path.join(build, "firmware.bin")
+
+    report = build_report(elf, binfile, args.toolchain_prefix, budgets(args.ini, args.env), args.version)
+    text = render_text(report)
+
+    os.makedirs(args.out, exist_ok=True)
+    with open(os.path.join(args.out, args.stem + ".json"), "w") as f:
+        json.dump(report, f, indent=1)
+    with open(os.path.join(args.out, args.stem + ".txt"), "w") as f:
+        f.write(text)
+    sys.stdout.write(text)
+    return 1 if report["failed"] else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
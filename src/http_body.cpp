@@ -0,0 +1,118 @@
+#include "http_body.h"
+
+HttpBodyStream::HttpBodyStream(Stream& in, int contentLength, bool chunked)
+    : _in(in), _left(0), _chunked(chunked) {
+  if (chunked) {
+    _state = SIZE;
+  } else if (contentLength >= 0) {
+    _left = contentLength;
+    _state = contentLength ? DATA : DONE;
+  } else {
+    _state = UNTIL_CLOSE;
+  }
+}
+
+static int hexValue(int c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+bool HttpBodyStream::frame() {
+  while (_state != DATA && _state != UNTIL_CLOSE && _state != DONE && _state != FAILED &&
+         _in.available() > 0) {
+    int c = _in.read();
+    switch (_state) {
+      case SIZE:
+        if (hexValue(c) >= 0) {
+          if (_left > 0x0FFFFFFF) {
+            _state = FAILED;   // would overflow, no sane chunk is that big
+            break;
+          }
+          _left = _left * 16 + hexValue(c);
+          _digits = true;
+        } else if (!_digits) {
+          _state = FAILED;
+        } else if (c == ';') {
+          _state = EXTENSION;
+        } else if (c == '\n') {
+          _state = _left ? DATA : TRAILER;
+          _lineLen = 0;
+        } else if (c == '\r' || c == ' ' || c == '\t') {
+          _state = SIZE_END;   // "1 2" is not 0x12
+        } else {
+          _state = FAILED;
+        }
+        break;
+      case SIZE_END:
+        if (c == ';') {
+          _state = EXTENSION;
+        } else if (c == '\n') {
+          _state = _left ? DATA : TRAILER;
+          _lineLen = 0;
+        } else if (c != '\r' && c != ' ' && c != '\t') {
+          _state = FAILED;
+        }
+        break;
+      case EXTENSION:
+        if (c == '\n') {
+          _state = _left ? DATA : TRAILER;
+          _lineLen = 0;
+        }
+        break;
+      case DATA_END:
+        if (c == '\n') {
+          _state = SIZE;
+          _left = 0;
+          _digits = false;
+        } else if (c != '\r') {
+          _state = FAILED;
+        }
+        break;
+      case TRAILER:
+        if (c == '\n') {
+          if (!_lineLen) _state = DONE;
+          _lineLen = 0;
+        } else if (c != '\r') {
+          _lineLen++;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return _state == DATA || _state == UNTIL_CLOSE;
+}
+
+int HttpBodyStream::available() {
+  if (!frame()) return 0;
+  int n = _in.available();
+  if (_state == DATA && n > 0 && (uint32_t)n > _left) n = _left;
+  return n;
+}
+
+int HttpBodyStream::read() {
+  if (!frame()) return -1;
+  int c = _in.read();
+  if (c < 0 || _state == UNTIL_CLOSE) return c;
+  if (--_left == 0) _state = _chunked ? DATA_END : DONE;
+  return c;
+}
+
+int HttpBodyStream::peek() {
+  return frame() ? _in.peek() : -1;
+}
+
+bool HttpBodyStream::drain(uint32_t timeoutMs) {
+  if (_state == UNTIL_CLOSE) return false;
+  uint32_t start = millis();
+  while (_state != DONE && _state != FAILED && millis() - start < timeoutMs) {
+    if (available() > 0) {
+      read();
+    } else {
+      yield();
+    }
+  }
+  return _state == DONE;
+}
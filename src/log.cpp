@@ -0,0 +1,204 @@
+#include "log.h"
+
+// Ring of pending records:
+//   [u8 len][u8 level][PGM_P fmt][args: u8 type + payload ...]
+// len covers the whole record. Writers drop the record when it does not fit.
+
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of two");
+static_assert(2 + sizeof(PGM_P) + LOG_MAX_ARGS <= 255, "log record too large");
+
+static uint8_t ring[LOG_RING_SIZE];
+static uint16_t head = 0;         // write position (free running)
+static uint16_t tail = 0;         // read position (free running)
+static uint32_t dropped = 0;
+static uint32_t droppedReported = 0;
+
+static HardwareSerial* port = nullptr;
+static char line[192];            // formatted record being drained
+static uint16_t lineLen = 0;
+static uint16_t linePos = 0;
+static bool midLine = false;      // last line ended in '\r' (progress)
+
+void logBegin(HardwareSerial& out) {
+  port = &out;
+}
+
+uint32_t logDropped() {
+  return dropped;
+}
+
+void logArg(LogRecord& r, const char* s) {
+  if (!s) s = "(null)";
+  size_t n = strnlen(s, LOG_MAX_STR);
+  uint8_t tmp[LOG_MAX_STR + 1];
+  tmp[0] = (uint8_t)n;
+  memcpy(tmp + 1, s, n);
+  r.put(LOG_ARG_STR, tmp, n + 1);
+}
+
+static inline uint16_t ringUsed() {
+  return (uint16_t)(head - tail);
+}
+
+static void ringPut(const void* data, uint16_t n) {
+  const uint8_t* p = (const uint8_t*)data;
+  for (uint16_t i = 0; i < n; i++) ring[(head + i) & (LOG_RING_SIZE - 1)] = p[i];
+  head += n;
+}
+
+static void ringGet(void* data, uint16_t n) {
+  uint8_t* p = (uint8_t*)data;
+  for (uint16_t i = 0; i < n; i++) p[i] = ring[(tail + i) & (LOG_RING_SIZE - 1)];
+  tail += n;
+}
+
+void logCommit(uint8_t level, PGM_P fmt, const LogRecord& r) {
+  uint16_t len = 2 + sizeof(PGM_P) + r.len;
+  if (!port || LOG_RING_SIZE - ringUsed() < len) {
+    dropped++;
+    return;
+  }
+  uint8_t hdr[2] = { (uint8_t)len, level };
+  ringPut(hdr, 2);
+  ringPut(&fmt, sizeof(PGM_P));
+  ringPut(r.buf, r.len);
+}
+
+// one conversion, spec is "%[flags][width][.prec]" + conversion char
+static int formatOne(char* out, size_t cap, char* spec, size_t specLen, char conv,
+                     const uint8_t*& arg, const uint8_t* end) {
+  if (arg >= end) return snprintf(out, cap, "?");
+  uint8_t type = *arg++;
+  switch (type) {
+    case LOG_ARG_I32:
+    case LOG_ARG_U32: {
+      uint32_t v;
+      memcpy(&v, arg, 4);
+      arg += 4;
+      if (conv == 'f') conv = 'd';
+      spec[specLen] = conv;
+      spec[specLen + 1] = 0;
+      if (conv == 'd' || conv == 'i' || conv == 'c') return snprintf(out, cap, spec, (int)(int32_t)v);
+      if (conv == 's') return snprintf(out, cap, "?");
+      return snprintf(out, cap, spec, (unsigned)v);
+    }
+    case LOG_ARG_I64:
+    case LOG_ARG_U64: {
+      uint64_t v;
+      memcpy(&v, arg, 8);
+      arg += 8;
+      if (conv == 's' || conv == 'c' || conv == 'f') return snprintf(out, cap, "?");
+      spec[specLen] = 'l';
+      spec[specLen + 1] = 'l';
+      spec[specLen + 2] = conv;
+      spec[specLen + 3] = 0;
+      if (conv == 'd' || conv == 'i') return snprintf(out, cap, spec, (long long)v);
+      return snprintf(out, cap, spec, (unsigned long long)v);
+    }
+    case LOG_ARG_F32: {
+      float v;
+      memcpy(&v, arg, 4);
+      arg += 4;
+      spec[specLen] = 'f';
+      spec[specLen + 1] = 0;
+      return snprintf(out, cap, spec, (double)v);
+    }
+    case LOG_ARG_STR: {
+      uint8_t n = *arg++;
+      char s[LOG_MAX_STR + 1];
+      memcpy(s, arg, n);
+      s[n] = 0;
+      arg += n;
+      spec[specLen] = 's';
+      spec[specLen + 1] = 0;
+      return snprintf(out, cap, spec, s);
+    }
+  }
+  arg = end;  // unknown type, stop consuming
+  return snprintf(out, cap, "?");
+}
+
+static uint16_t formatRecord(char* out, size_t cap, PGM_P fmt, const uint8_t* arg, const uint8_t* end) {
+  size_t pos = 0;
+  for (;;) {
+    char c = pgm_read_byte(fmt++);
+    if (!c || pos + 1 >= cap) break;
+    if (c != '%') {
+      out[pos++] = c;
+      continue;
+    }
+    char spec[20];
+    size_t specLen = 0;
+    spec[specLen++] = '%';
+    char conv = 0;
+    while ((c = pgm_read_byte(fmt)) != 0) {
+      fmt++;
+      if (strchr("diuxXcsf%", c)) { conv = c; break; }
+      if (c == 'l' || c == 'h' || c == 'z') continue;  // length comes from the stored type
+      if (specLen < sizeof(spec) - 4) spec[specLen++] = c;
+    }
+    if (!conv) break;
+    if (conv == '%') {
+      out[pos++] = '%';
+      continue;
+    }
+    int n = formatOne(out + pos, cap - pos, spec, specLen, conv, arg, end);
+    if (n > 0) pos += min<size_t>((size_t)n, cap - pos - 1);
+  }
+  // every record is one line, unless it rewrites the current one ('\r' progress)
+  if (pos == 0 || (out[pos - 1] != '\n' && out[pos - 1] != '\r')) {
+    if (pos + 1 >= cap) pos = cap - 2;
+    out[pos++] = '\n';
+  }
+  out[pos] = 0;
+  return pos;
+}
+
+static bool nextLine() {
+  if (dropped != droppedReported) {
+    lineLen = snprintf(line, sizeof(line), "%s[LOG] %u records dropped\n", midLine ? "\n" : "",
+                       (unsigned)(dropped - droppedReported));
+    droppedReported = dropped;
+    linePos = 0;
+    midLine = false;
+    return true;
+  }
+  if (ringUsed() == 0) return false;
+
+  uint8_t hdr[2];
+  PGM_P fmt;
+  uint8_t args[LOG_MAX_ARGS];
+  ringGet(hdr, 2);
+  ringGet(&fmt, sizeof(PGM_P));
+  uint16_t argLen = hdr[0] - 2 - sizeof(PGM_P);
+  ringGet(args, argLen);
+
+  // slot 0 is reserved to terminate a pending '\r' progress line
+  lineLen = 1 + formatRecord(line + 1, sizeof(line) - 1, fmt, args, args + argLen);
+  bool cr = line[lineLen - 1] == '\r';
+  line[0] = '\n';
+  linePos = (midLine && !cr) ? 0 : 1;
+  midLine = cr;
+  return true;
+}
+
+void logLoop() {
+  if (!port) return;
+  for (;;) {
+    if (linePos >= lineLen && !nextLine()) return;
+    int room = port->availableForWrite();
+    if (room <= 0) return;
+    uint16_t n = min<uint16_t>((uint16_t)room, lineLen - linePos);
+    port->write((const uint8_t*)line + linePos, n);
+    linePos += n;
+  }
+}
+
+void logFlush() {
+  if (!port) return;
+  while (linePos < lineLen || ringUsed() || dropped != droppedReported) {
+    logLoop();
+    yield();
+  }
+  port->flush();
+}
@@ -4,8 +4,25 @@
 #include <ESP8266HTTPClient.h>
 #include <ESP8266httpUpdate.h>
 #include <WiFiClientSecureBearSSL.h>
-#include <ArduinoJson.h>
 #include <WiFiManager.h>
+#include <ESP8266WebServer.h>
+
+#include "http_body.h"
+#include "log.h"
+#include "manifest.h"
+#include "metrics.h"
+#include "mirrors.h"
+#include "ota_arena.h"
+#include "ota_blacklist.h"
+#include "ota_delta.h"
+#include "ota_journal.h"
+#include "preflight.h"
+#include "reboot.h"
+#include "redirect_cache.h"
+#include "rollback.h"
+#include "telemetry.h"
+#include "time_sync.h"
+#include "tls_trust.h"
 
 #ifndef FW_MODEL
 #define FW_MODEL "esp8266-power"
@@ -14,29 +31,129 @@
 #define FW_VERSION "v1.0.0"
 #endif
 #ifndef FW_MANIFEST_URL
-#define FW_MANIFEST_URL "http://raw.githubusercontent.com/yvsim001/esp8266_OTA/gh-pages/manifest.json"
+#define FW_MANIFEST_URL "https://raw.githubusercontent.com/yvsim001/esp8266_OTA/gh-pages/manifest.cbor"
+#endif
+// Weitere Basis-URLs mit demselben Manifest, durch Leerzeichen getrennt
+#ifndef FW_MANIFEST_MIRRORS
+#define FW_MANIFEST_MIRRORS ""
 #endif
 
 const int LED = LED_BUILTIN;
 
+// TLS-Buffer (rx, tx) pro Phase, dieselben Werte gehen in den Preflight-Plan
+const uint16_t MANIFEST_TLS_RX = 16384;  // raw.githubusercontent.com kann kein MFLN
+const uint16_t MANIFEST_TLS_TX = 512;
+const uint16_t FW_TLS_RX = 1024;
+const uint16_t FW_TLS_TX = 512;
+const size_t HTTP_CLIENT_OVERHEAD = 1024;  // HTTPClient, Header-Strings, URL
+
+// Beim Boot reservierter Block für die größte TLS-Phase (Manifest), 0 = aus
+#ifndef OTA_ARENA_RESERVE
+#define OTA_ARENA_RESERVE (PreflightPlan().tls(MANIFEST_TLS_RX, MANIFEST_TLS_TX).heap - PREFLIGHT_MARGIN)
+#endif
+
+// Freier Heap, der bei offener Manifest-Verbindung bleiben muss, sonst wird sie
+// geschlossen und der Reserve-Block wieder belegt. 0 = nie offen halten
+#ifndef MANIFEST_KEEPALIVE_MIN_HEAP
+#define MANIFEST_KEEPALIVE_MIN_HEAP 12288
+#endif
+
+#ifndef OTA_CHECK_INTERVAL_MS
+#define OTA_CHECK_INTERVAL_MS 60000UL
+#endif
+
+// BearSSL-Client, der das Vertrauen pro Host setzt (tls_trust.h),
+// TCP-Connect + TLS-Handshake für /metrics misst und zählt und den Handshake
+// als Telemetrie-Phase TLS erfasst.
+// HTTPClient arbeitet auf clone(): ohne Override wäre die Kopie ein einfacher
+// WiFiClientSecure (gleiche Session, aber ohne Messung)
+class TimedTlsClient : public BearSSL::WiFiClientSecure {
+public:
+  static uint32_t connects;
+
+  using BearSSL::WiFiClientSecure::connect;
+  int connect(const char* host, uint16_t port) override {
+    // Mehrere gepinnte Schlüssel: einer nach dem anderen, je ein Handshake
+    int ok = 0;
+    TelemetryPhase outer = telemetryCurrentPhase();
+    telemetryPhase(PHASE_TLS);
+    uint8_t attempts = tlsTrustAttempts(host);
+    for (uint8_t i = 0; !ok && i < attempts && tlsTrustApply(*this, host, i); i++) {
+      connects++;
+      uint32_t start = millis();
+      ok = BearSSL::WiFiClientSecure::connect(host, port);
+      // Direkt nach dem Handshake: Buffer und Kontext belegt, Stack-Tiefe
+      // des Handshakes im Stack-Hochwasser
+      telemetrySample();
+      if (ok) {
+        metricsObserve(HIST_TLS_CONNECT_MS, millis() - start);
+      } else if (!tlsTrustFailed(*this, host, i)) {
+        break;  // DNS/TCP: ein anderer Schlüssel hilft nicht
+      }
+    }
+    telemetryPhase(outer);
+    return ok;
+  }
+
+  std::unique_ptr<WiFiClient> clone() const override {
+    return std::unique_ptr<WiFiClient>(new TimedTlsClient(*this));
+  }
+};
+uint32_t TimedTlsClient::connects = 0;
+
 // Global state
 bool isUpdating = false;
 uint32_t lastOtaCheck = 0;
+bool otaWaitsForClock = false;  // letzter Poll mangels Uhrzeit zurückgestellt
+bool otaCheckDue = false;       // SNTP hat die Uhr gestellt: nicht auf das Intervall warten
+
+// OTA-Objekte in statischem Speicher statt auf dem Heap
+ArenaSlot<TimedTlsClient> tlsClient;
+// HTTP/1.1 keep-alive: HTTPClient und TLS-Session des Manifests bleiben bis zum
+// nächsten Poll stehen, der dann ohne Handshake auskommt
+ArenaSlot<HTTPClient> manifestHttp;
+bool manifestWarm = false;
+ManifestFields manifest;  // letztes Manifest; url, sectors (leer = kein Delta) und version nutzt Phase 2
+RebootPolicy rebootPolicy;
+
+// Status-Server (nach WiFi-Connect, Portal ist dann schon beendet)
+ESP8266WebServer statusServer(80);
+const size_t STATUS_CHUNK = 256;  // Puffer je Antwort, auf dem Stack
 
 // --- PROTOTYPE ---
 bool httpCheckAndUpdate();
+void otaCleanup();
+void manifestDrop(const char* why);
 void printMemoryStats();
+void handleTelemetry();
+void handleOta();
+void handleMetrics();
 
 void setup() {
   Serial.begin(115200);
+  logBegin(Serial);
+  telemetryBegin();
+  journalBegin();  // OTA-Verlauf aus dem Flash, erkennt abgebrochene Updates
+  rollbackBoot();  // zählt Boots eines neuen Images, setzt ggf. zurück
+  bool fastBoot = rebootBegin();  // geplanter Neustart: Wartezeiten überspringen
+  timeBegin();  // Uhrzeit aus dem RTC-Speicher, bis SNTP antwortet
+  otaArenaReserve(OTA_ARENA_RESERVE);  // Heap ist hier noch unfragmentiert
+  if (otaArenaReserved() && ESP.getFreeHeap() < MANIFEST_KEEPALIVE_MIN_HEAP) {
+    // custom_budget_heap zu knapp: für die Anwendung bleibt weniger als geplant
+    LOGW("MEM", "Arena leaves %u bytes heap", ESP.getFreeHeap());
+  }
   pinMode(LED, OUTPUT);
   digitalWrite(LED, HIGH);
   
-  delay(500);
+  if (!fastBoot) delay(500);
   Serial.println();
-  Serial.println(F("[BOOT] ESP8266 OTA System"));
-  Serial.printf("[BOOT] Model: %s\n", FW_MODEL);
-  Serial.printf("[BOOT] Version: %s\n", FW_VERSION);
+  LOGI("BOOT", "ESP8266 OTA System");
+  LOGI("BOOT", "Model: %s", FW_MODEL);
+  LOGI("BOOT", "Version: %s", FW_VERSION);
+  LOGI("BOOT", "TLS trust: %s", tlsTrustModeName());
+  if (!redirectAllowed(FW_MANIFEST_URL)) {
+    LOGE("BOOT", "Manifest URL is http://, refused while TLS authentication is on");
+  }
   
   printMemoryStats();
 
@@ -48,24 +165,54 @@ void setup() {
   
   WiFiManager wm;
   wm.setConfigPortalTimeout(180);
+  wm._asyncScan = true;  // /wifi renders at once, results follow via /wifiscan.json
+  wm.setAPCallback([](WiFiManager*) {
+    otaArenaRelease();  // Portal braucht den Speicher, nach dem Connect neu reservieren
+    telemetryPhase(PHASE_PORTAL);
+  });
   
-  Serial.println(F("[WiFi] Initializing..."));
+  LOGI("WiFi", "Initializing...");
+  logFlush();  // autoConnect blockiert, kein loop()
   bool ok = wm.autoConnect("ESP8266-Setup");
   
   if (!ok) {
-    Serial.println(F("[WiFi] Config failed. Rebooting..."));
+    LOGE("WiFi", "Config failed. Rebooting...");
+    logFlush();
     delay(1000);
     ESP.restart();
   }
   
-  Serial.print(F("[WiFi] Connected: "));
-  Serial.println(WiFi.localIP());
-  Serial.printf("[WiFi] Signal strength: %d dBm\n", WiFi.RSSI());
-
-  configTime(0, 0, "pool.ntp.org", "time.nist.gov");
+  LOGI("WiFi", "Connected: %s", WiFi.localIP().toString());
+  LOGI("WiFi", "Signal strength: %d dBm", WiFi.RSSI());
+  rebootServiceUp();
+  otaArenaReserve(OTA_ARENA_RESERVE);
+  telemetryPhase(PHASE_IDLE);
+
+  statusServer.on("/telemetry", HTTP_GET, handleTelemetry);
+  statusServer.on("/ota", HTTP_GET, handleOta);
+  statusServer.on("/metrics", HTTP_GET, handleMetrics);
+  statusServer.begin();
+
+  // Optionales, das der Preflight vor TLS abbauen darf (Portal ist hier schon weg)
+  preflightRegisterShedder("scan", []() { WiFi.scanDelete(); });
+  preflightRegisterShedder("status", []() { statusServer.stop(); }, []() { statusServer.begin(); });
+  preflightRegisterShedder("keepalive", []() { manifestDrop("preflight"); });
+
+  // Vor einem geplanten Neustart: Logs raus, keine neuen Requests mehr
+  rebootRegisterHook("status", []() { statusServer.stop(); return true; });
+  rebootRegisterHook("time", []() { timeSave(); return true; });
+  rebootRegisterHook("log", []() { logFlush(); return true; });
+
+  // SNTP läuft im Hintergrund; wer die Uhr braucht, fragt timeValid().
+  // Ein mangels Uhrzeit zurückgestellter Poll läuft, sobald sie gestellt ist
+  timeOnSync([]() { otaCheckDue = otaWaitsForClock; });
+  timeStartSync();
+
+  mirrorsSet(MIRRORS_MANIFEST, FW_MANIFEST_URL);
+  mirrorsAdd(MIRRORS_MANIFEST, FW_MANIFEST_MIRRORS);
   
-  delay(2000);
   httpCheckAndUpdate();
+  otaCleanup();
   
   lastOtaCheck = millis();
 }
@@ -73,10 +220,26 @@ void setup() {
 void loop() {
   uint32_t now = millis();
 
-  if ((now - lastOtaCheck) > 60000UL && !isUpdating) {
-    Serial.println(F("[LOOP] OTA check time..."));
+  if ((otaCheckDue || (now - lastOtaCheck) > OTA_CHECK_INTERVAL_MS) && !isUpdating && !rebootPending()) {
+    LOGI("LOOP", "OTA check time...");
     httpCheckAndUpdate();
+    otaCleanup();
     lastOtaCheck = now;
+    otaCheckDue = false;
+  }
+
+  // Offene Manifest-Verbindung aufgeben, wenn der Server sie schließt oder der Heap knapp wird
+  if (manifestWarm && (!tlsClient->connected() || ESP.getFreeHeap() < MANIFEST_KEEPALIVE_MIN_HEAP)) {
+    manifestDrop(tlsClient->connected() ? "low heap" : "closed by server");
+    otaArenaReserve(OTA_ARENA_RESERVE);
+  }
+
+  statusServer.handleClient();
+
+  // 'm' im Serial Monitor: Heap low-water marks
+  if (Serial.available() && Serial.read() == 'm') {
+    logFlush();
+    telemetryPrint(Serial);
   }
 
   static uint32_t ledToggle = 0;
@@ -85,120 +248,314 @@ void loop() {
     ledToggle = now;
   }
 
+  timeLoop();
+  rebootLoop();
+  telemetryLoop();
+  logLoop();
   delay(100);
 }
 
+// Antwort des Status-Servers chunked in Stücken von STATUS_CHUNK Bytes aus
+// einem festen Puffer, statt den ganzen Text in einem wachsenden String auf
+// dem Heap zu sammeln (der neben einer offenen TLS-Verbindung fragmentiert)
+class StatusResponse : public Print {
+ public:
+  StatusResponse(const char* contentType) {
+    statusServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    statusServer.send(200, contentType, "");
+  }
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* data, size_t n) override {
+    for (size_t left = n; left;) {
+      size_t take = min(left, sizeof(_buf) - _len);
+      memcpy(_buf + _len, data, take);
+      _len += take;
+      data += take;
+      left -= take;
+      if (_len == sizeof(_buf)) flush();
+    }
+    return n;
+  }
+  void flush() override {
+    if (_len) statusServer.sendContent(_buf, _len);
+    _len = 0;
+  }
+  void end() {
+    flush();
+    statusServer.sendContent("");  // letzter Chunk
+  }
+
+ private:
+  char _buf[STATUS_CHUNK];
+  size_t _len = 0;
+};
+
+void handleTelemetry() {
+  StatusResponse out("application/json");
+  telemetryWriteJson(out);
+  out.end();
+}
+
+void handleOta() {
+  StatusResponse out("application/json");
+  blacklistWriteJson(out);
+  out.end();
+}
+
+void handleMetrics() {
+  StatusResponse out("text/plain; version=0.0.4");
+  metricsWriteText(out);
+  out.end();
+}
+
 void printMemoryStats() {
-  Serial.printf("[MEM] Free heap: %u bytes\n", ESP.getFreeHeap());
-  Serial.printf("[MEM] Heap fragmentation: %u%%\n", ESP.getHeapFragmentation());
-  Serial.printf("[MEM] Max free block: %u bytes\n", ESP.getMaxFreeBlockSize());
+  LOGI("MEM", "Free heap: %u bytes", ESP.getFreeHeap());
+  LOGI("MEM", "Heap fragmentation: %u%%", ESP.getHeapFragmentation());
+  LOGI("MEM", "Max free block: %u bytes", ESP.getMaxFreeBlockSize());
+}
+
+// Nach jedem OTA-Versuch: statische Objekte abbauen, Abgebautes wiederherstellen.
+// Eine noch offene Manifest-Verbindung bleibt, solange genug Heap frei ist
+void otaCleanup() {
+  RedirectStats redirects = redirectTakeStats();
+  if (redirects.followed || redirects.saved) {
+    LOGI("OTA", "Redirects: %u followed, %u round-trips saved", redirects.followed, redirects.saved);
+  }
+  metricsRedirects(redirects.followed, redirects.saved);
+  manifestWarm = manifestHttp && tlsClient && tlsClient->connected() &&
+                 MANIFEST_KEEPALIVE_MIN_HEAP && ESP.getFreeHeap() >= MANIFEST_KEEPALIVE_MIN_HEAP;
+  if (!manifestWarm) {
+    manifestHttp.reset();  // vor dem Client: der Destruktor schließt die gemeinsame Session
+    tlsClient.reset();
+  }
+  preflightRestore();
+  if (!manifestWarm) otaArenaReserve(OTA_ARENA_RESERVE);  // sonst belegt die Verbindung den Platz
+  telemetryPhase(PHASE_IDLE);
+}
+
+// Offene Manifest-Verbindung schließen (Reserve-Block belegt der Aufrufer)
+void manifestDrop(const char* why) {
+  if (!manifestWarm) return;
+  LOGI("OTA", "Keep-alive connection dropped: %s", why);
+  manifestHttp.reset();
+  tlsClient.reset();
+  manifestWarm = false;
+  metricsConnection(CONN_DROPPED);
 }
 
 bool httpCheckAndUpdate() {
   if (isUpdating) {
-    Serial.println(F("[OTA] Already updating"));
+    LOGW("OTA", "Already updating");
     return false;
   }
 
-  uint32_t freeHeap = ESP.getFreeHeap();
-  Serial.printf("[OTA] Free heap: %u bytes\n", freeHeap);
-  
-  if (freeHeap < 30000) {
-    Serial.printf("[OTA] Insufficient memory (%u < 30000)\n", freeHeap);
+  // Zertifikatsprüfung ohne gültige Uhrzeit: je nach OTA_TLS_CLOCK_POLICY warten,
+  // timeOnSync() holt den Poll nach
+  otaWaitsForClock = !tlsTrustReady();
+  if (otaWaitsForClock) {
+    LOGI("OTA", "No valid time yet, poll deferred until SNTP sync");
+    metricsPoll(POLL_DEFERRED);
     return false;
   }
 
-  // === PHASE 1: Manifest ===
-  Serial.println(F("[OTA] Fetching manifest..."));
-  
-  std::unique_ptr<BearSSL::WiFiClientSecure> client(new BearSSL::WiFiClientSecure);
-  client->setInsecure();
-  client->setTimeout(20000);
+  // Reserve-Block freigeben: BearSSL-Stack, Kontext und Buffer landen darin
+  otaArenaRelease();
+
+  // Offene Verbindung: TLS-Buffer sind schon belegt. Baut der Preflight sie
+  // ab, braucht der Poll doch den vollen Plan
+  bool warm = manifestWarm;
+  PreflightPlan manifestPlan;
+  if (!warm) manifestPlan.tls(MANIFEST_TLS_RX, MANIFEST_TLS_TX);
+  manifestPlan.alloc(HTTP_CLIENT_OVERHEAD);
+  PreflightResult pr = preflightCheck("manifest", manifestPlan);
+  if (warm && !manifestWarm && pr < PREFLIGHT_LOW_HEAP) {
+    warm = false;
+    pr = preflightCheck("manifest", manifestPlan.tls(MANIFEST_TLS_RX, MANIFEST_TLS_TX));
+  }
+  if (pr >= PREFLIGHT_LOW_HEAP) {
+    metricsPoll(POLL_DEFERRED);
+    return false;  // nächster Versuch beim nächsten Check-Intervall
+  }
 
-  HTTPClient http;
-  http.setFollowRedirects(HTTPC_FORCE_FOLLOW_REDIRECTS);
-  http.setTimeout(20000);
-  http.useHTTP10(true);
+  // === PHASE 1: Manifest ===
+  LOGI("OTA", "Fetching manifest...");
+  telemetryPhase(PHASE_MANIFEST);
+
+  TimedTlsClient* client = tlsClient.get();
+  if (!warm) {
+    client = tlsClient.emplace();
+    client->setBufferSizes(MANIFEST_TLS_RX, MANIFEST_TLS_TX);
+    manifestHttp.emplace();
+  }
+  manifestWarm = false;  // gehört jetzt diesem Poll, otaCleanup entscheidet neu
+  uint32_t connects = TimedTlsClient::connects;
+
+  // HTTP/1.1 wegen keep-alive; der Body kann dann chunked kommen
+  HTTPClient& http = *manifestHttp;
+  http.useHTTP10(false);
+  http.setReuse(true);
+
+  // Schnellster Spiegel zuerst, langsame werden früh abgebrochen; Weiterleitungen
+  // folgt redirectGet() selbst und merkt sich permanente Ziele.
+  // ETag gibt es nur, wenn das letzte Manifest "aktuell" ergab: ein 304
+  // darf keinen fälligen Update-Versuch verdecken
+  uint32_t pollStart = millis();
+  int code = mirrorsGet(http, *client, MIRRORS_MANIFEST, nullptr, 20000, nullptr, [](HTTPClient& h, void*) {
+    static const char* HEADERS[] = { "ETag", "Transfer-Encoding", "Content-Type" };
+    h.collectHeaders(HEADERS, 3);
+    h.addHeader("Accept", MANIFEST_ACCEPT);
+    if (journalState().etag[0]) h.addHeader("If-None-Match", journalState().etag);
+  });
+  // Ohne neuen Handshake lief der Poll über die offene Verbindung
+  // (über http:// zählt er immer als neu)
+  bool reused = warm && TimedTlsClient::connects == connects;
+  LOGI("OTA", "HTTP: %d%s", code, reused ? " (kept-alive)" : "");
+  if (code > 0) metricsConnection(reused ? CONN_REUSED : CONN_NEW);
 
-  if (!http.begin(*client, String(FW_MANIFEST_URL))) {
-    Serial.println(F("[OTA] http.begin() failed"));
+  if (code == HTTP_CODE_NOT_MODIFIED) {
+    http.end();
+    journalPoll(code, millis() - pollStart);
+    metricsObserve(HIST_MANIFEST_MS, millis() - pollStart);
+    if (reused) metricsObserve(HIST_MANIFEST_WARM_MS, millis() - pollStart);
+    metricsPoll(POLL_NOT_MODIFIED);
+    rollbackMarkHealthy();
+    LOGI("OTA", "Up-to-date (304)");
     return false;
   }
 
-  int code = http.GET();
-  Serial.printf("[OTA] HTTP: %d\n", code);
-
   if (code != HTTP_CODE_OK) {
     http.end();
+    journalPoll(code, millis() - pollStart);
+    metricsPoll(code < 0 ? POLL_CONNECT_ERROR : POLL_HTTP_ERROR);
     return false;
   }
 
-  DynamicJsonDocument doc(1024);
-  DeserializationError err = deserializeJson(doc, http.getStream());
+  char etag[JOURNAL_ETAG_LEN];
+  strlcpy(etag, http.header("ETag").c_str(), sizeof(etag));
+
+  // CBOR (manifest.cbor oder per Accept ausgehandelt) direkt in die Felder, sonst JSON
+  HttpBodyStream body(http.getStream(), http.getSize(),
+                      http.header("Transfer-Encoding").equalsIgnoreCase("chunked"));
+  body.setTimeout(20000);
+  bool parsed = manifestParse(body, manifestIsCbor(FW_MANIFEST_URL, http.header("Content-Type")), manifest);
+  // Rest des Bodys lesen, sonst beginnt die nächste Antwort mitten darin
+  if (!parsed || !body.drain(1000)) http.getStream().stop();
   http.end();
-  client.reset();  // Speicher freigeben!
+  journalPoll(code, millis() - pollStart);
 
-  if (err) {
-    Serial.printf("[OTA] JSON error: %s\n", err.c_str());
+  if (!parsed) {
+    metricsPoll(POLL_BAD_MANIFEST);
     return false;
   }
+  metricsObserve(HIST_MANIFEST_MS, millis() - pollStart);
+  if (reused) metricsObserve(HIST_MANIFEST_WARM_MS, millis() - pollStart);
+  metricsPoll(POLL_OK);
+
+  // WiFi steht und das Manifest kam an: ein Image auf Probe gilt als gesund
+  rollbackMarkHealthy();
 
-  const char* model = doc["model"] | "";
-  const char* version = doc["version"] | "";
-  const char* url = doc["url"] | "";
+  const char* model = manifest.model;
+  const char* version = manifest.version;
+  const char* url = manifest.url;
 
-  Serial.printf("[OTA] Model: %s | Version: %s\n", model, version);
+  LOGI("OTA", "Model: %s | Version: %s", model, version);
 
   if (strcmp(model, FW_MODEL) != 0) {
-    Serial.println(F("[OTA] Model mismatch"));
+    LOGW("OTA", "Model mismatch");
     return false;
   }
 
+  blacklistManifest(version, url);  // neues Manifest: Fehlerzähler zurücksetzen
+
   if (strcmp(version, FW_VERSION) == 0) {
-    Serial.println(F("[OTA] Up-to-date"));
+    LOGI("OTA", "Up-to-date");
+    journalEtag(etag);
+    metricsUpdate(UPDATE_NO_UPDATE);
     return false;
   }
 
-  Serial.printf("[OTA] New: %s -> %s\n", FW_VERSION, version);
+  LOGI("OTA", "New: %s -> %s", FW_VERSION, version);
+
+  uint32_t waitS;
+  switch (blacklistCheck(version, &waitS)) {
+    case BLACKLIST_POISONED:
+      LOGW("OTA", "%s blacklisted until the manifest changes", version);
+      journalEtag(etag);  // gleiches Manifest ergibt dasselbe, 304 genügt
+      metricsUpdate(UPDATE_SKIPPED);
+      return false;
+    case BLACKLIST_BACKOFF:
+      LOGI("OTA", "%s failed recently, retry in %us", version, waitS);
+      metricsUpdate(UPDATE_SKIPPED);
+      return false;
+    case BLACKLIST_ALLOW:
+      break;
+  }
+  journalEtag("");
 
-  // WICHTIG: Speicher aufräumen vor OTA!
-  doc.clear();
+  // Spiegel des Images: Basis-URLs, Dateinamen wie in "url" und "sectors"
+  mirrorsSet(MIRRORS_FIRMWARE, manifest.url);
+  mirrorsAdd(MIRRORS_FIRMWARE, manifest.mirrors);
+
+  // Neustart-Fenster (UTC), z.B. "reboot_window": "02:00-04:00", "reboot_deadline": 86400
+  rebootPolicy = RebootPolicy();
+  rebootPolicy.parseWindow(manifest.rebootWindow);
+  rebootPolicy.deadlineS = manifest.rebootDeadline;
+
+  // WICHTIG: Speicher aufräumen vor OTA! Die Manifest-Verbindung zuerst
+  manifestHttp.reset();
+  tlsClient.reset();
   yield();
   delay(100);
   
   printMemoryStats();
   
   // === PHASE 2: OTA Update mit kleineren Buffern ===
-
+  // Updater puffert einen Flash-Sektor
+  PreflightPlan flashPlan;
+  flashPlan.tls(FW_TLS_RX, FW_TLS_TX)
+           .alloc(FLASH_SECTOR_SIZE)
+           .alloc(HTTP_CLIENT_OVERHEAD);
+  if (preflightCheck("flash", flashPlan) >= PREFLIGHT_LOW_HEAP) {
+    return false;
+  }
   
-  Serial.println(F("[OTA] Starting download..."));
+  LOGI("OTA", "Starting download...");
   
   isUpdating = true;
   
   // KRITISCH: Kleinere Buffer für D1 Mini!
-  std::unique_ptr<BearSSL::WiFiClientSecure> fwClient(new BearSSL::WiFiClientSecure);
-  fwClient->setInsecure();
-  fwClient->setBufferSizes(1024, 512);  // REDUZIERT von (2048, 1024)!
+  TimedTlsClient* fwClient = tlsClient.emplace();
+  fwClient->setBufferSizes(FW_TLS_RX, FW_TLS_TX);  // REDUZIERT von (2048, 1024)!
   fwClient->setTimeout(60000);
 
   // Watchdog-Handling
   ESPhttpUpdate.onStart([]() {
-    Serial.println(F("[OTA] Flashing..."));
+    LOGI("OTA", "Flashing...");
+    telemetryPhase(PHASE_FLASH);
     ESP.wdtDisable();
     digitalWrite(LED, LOW);
   });
 
   uint32_t lastYield = millis();
-  ESPhttpUpdate.onProgress([&lastYield](int cur, int total) {
+  uint32_t otaBytes = 0;
+  ESPhttpUpdate.onProgress([&lastYield, &otaBytes](int cur, int total) {
     uint32_t now = millis();
     
     // SEHR HÄUFIG yield() aufrufen!
     if ((now - lastYield) > 100) {  // Alle 100ms
       int pct = (total > 0) ? (cur * 100) / total : 0;
-      Serial.printf("[OTA] %d%% (%d/%d)\r", pct, cur, total);
+      LOGI("OTA", "%d%% (%d/%d)\r", pct, cur, total);
+      telemetrySample();
       lastYield = now;
     }
     
+    journalOtaProgress(cur);
+    otaBytes = cur;
+
+    // Log-Ring nur so weit leeren wie der UART-FIFO Platz hat
+    logLoop();
+
     // KRITISCH: WiFi-Stack füttern
     yield();
     delay(1);  // Gib WiFi-Stack Zeit
@@ -206,12 +563,12 @@ bool httpCheckAndUpdate() {
   });
 
   ESPhttpUpdate.onEnd([]() {
-    Serial.println(F("\n[OTA] Complete!"));
+    LOGI("OTA", "Complete!");
     ESP.wdtEnable(WDTO_8S);
   });
 
   ESPhttpUpdate.onError([](int err) {
-    Serial.printf("[OTA] ERROR %d: %s\n", err, ESPhttpUpdate.getLastErrorString().c_str());
+    LOGE("OTA", "ERROR %d: %s", err, ESPhttpUpdate.getLastErrorString());
     ESP.wdtEnable(WDTO_8S);
   });
 
@@ -221,25 +578,75 @@ bool httpCheckAndUpdate() {
   // Setze LED-Mode für Update (optional)
   ESPhttpUpdate.setLedPin(LED_BUILTIN, LOW);
 
-  Serial.printf("[OTA] URL: %s\n", url);
-  t_httpUpdate_return ret = ESPhttpUpdate.update(*fwClient, String(url));
+  LOGI("OTA", "URL: %s", manifest.url);
+  blacklistAttempt(manifest.version);
+  journalOtaBegin(manifest.version);
+  uint32_t otaStart = millis();
+
+  // Erst inkrementell (nur geänderte Sektoren), sonst das ganze Image
+  t_httpUpdate_return ret;
+  bool insecure = false;  // http:// bei aktiver TLS-Authentifizierung
+  DeltaStats delta;
+  if (manifest.sectors[0] && deltaUpdate(*fwClient, manifest.sectors, delta, journalOtaProgress)) {
+    ret = HTTP_UPDATE_OK;
+  } else {
+    if (manifest.sectors[0]) LOGW("OTA", "Incremental update failed, full download");
+    fwClient->stop();  // halb gelesene Range-Antwort verwerfen
+    uint8_t mirror = mirrorsBest(MIRRORS_FIRMWARE);
+    const char* fwUrl = mirrorsUrl(MIRRORS_FIRMWARE, mirror);
+    const char* target = redirectResolve(fwUrl);
+    if (!redirectAllowed(target)) {
+      LOGE("OTA", "%s: http:// refused, TLS authentication is on", target);
+      ret = HTTP_UPDATE_FAILED;
+      insecure = true;
+    } else {
+      ret = ESPhttpUpdate.update(redirectClient(target, *fwClient), String(target));
+    }
+    if (ret == HTTP_UPDATE_FAILED && !insecure) {
+      redirectFailed(fwUrl);
+      int err = ESPhttpUpdate.getLastError();
+      if (err < 0 && err != HTTP_UE_TOO_LESS_SPACE) mirrorsFailed(MIRRORS_FIRMWARE, mirror);
+    }
+  }
+
+  uint32_t otaMs = millis() - otaStart;
 
   isUpdating = false;
+  int16_t otaResult = insecure ? REDIRECT_ERROR_INSECURE
+                     : ret == HTTP_UPDATE_FAILED ? ESPhttpUpdate.getLastError() : JOURNAL_OTA_OK;
+  // Der eboot-Kopierbefehl steht schon im RTC-Speicher: jeder Reset ab hier
+  // (WDT, Absturz, Stromausfall vor dem Zeitfenster) installiert das neue
+  // Image. Darum jetzt sichern und den Probelauf markieren, nicht erst vor
+  // dem geplanten Neustart
+  if (ret == HTTP_UPDATE_OK && !rollbackPrepare(FW_VERSION, manifest.version)) {
+    otaResult = JOURNAL_OTA_NO_BACKUP;  // Kopierbefehl gelöscht, Update verworfen
+  }
+  journalOtaEnd(otaResult, otaMs);
+  if (otaBytes && otaMs) metricsObserve(HIST_DOWNLOAD_BPS, (uint64_t)otaBytes * 1000 / otaMs);
 
   switch (ret) {
     case HTTP_UPDATE_FAILED:
-      Serial.printf("[OTA] FAILED: %s\n", ESPhttpUpdate.getLastErrorString().c_str());
+      LOGE("OTA", "FAILED: %s", insecure ? "http:// refused" : ESPhttpUpdate.getLastErrorString().c_str());
+      metricsUpdate(UPDATE_FAILED, otaResult);
       printMemoryStats();
+      logFlush();
+      telemetryPrint(Serial);
       return false;
 
     case HTTP_UPDATE_NO_UPDATES:
-      Serial.println(F("[OTA] No updates"));
+      LOGI("OTA", "No updates");
+      metricsUpdate(UPDATE_NO_UPDATE);
       return false;
 
     case HTTP_UPDATE_OK:
-      Serial.println(F("[OTA] SUCCESS! Rebooting..."));
-      delay(2000);
-      ESP.restart();
+      tlsClient.reset();
+      if (otaResult == JOURNAL_OTA_NO_BACKUP) {
+        metricsUpdate(UPDATE_FAILED, JOURNAL_OTA_NO_BACKUP);
+        return false;
+      }
+      metricsUpdate(UPDATE_OK);
+      LOGI("OTA", "SUCCESS! Reboot scheduled");
+      rebootSchedule("ota", rebootPolicy);
       return true;
   }
 
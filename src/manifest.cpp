@@ -0,0 +1,82 @@
+#include <Arduino.h>
+
+#include "manifest.h"
+#include "log.h"
+
+// 0: CBOR only, without ArduinoJson (tools/native when the library is not
+// there); a JSON manifest then fails like a malformed one
+#ifndef MANIFEST_JSON
+#define MANIFEST_JSON 1
+#endif
+
+#if MANIFEST_JSON
+#include <ArduinoJson.h>
+
+#ifndef MANIFEST_JSON_SIZE
+#define MANIFEST_JSON_SIZE 1024
+#endif
+
+// Only the fields the device reads: checksums, .gz, signatures etc. stay
+// out, so "mirrors" fits in MANIFEST_JSON_SIZE
+static const char MANIFEST_FILTER[] = "{\"model\":true,\"version\":true,\"url\":true,\"sectors\":true,"
+                                      "\"mirrors\":true,\"reboot_window\":true,\"reboot_deadline\":true}";
+
+static StaticJsonDocument<MANIFEST_JSON_SIZE> doc;
+
+static bool copy(char* out, size_t cap, const char* value, const char* name) {
+  if (strlcpy(out, value, cap) < cap) return true;
+  LOGE("MANIFEST", "\"%s\" too long (max %u)", name, (unsigned)cap - 1);
+  return false;
+}
+
+static bool fromJson(Stream& body, ManifestFields& out) {
+  StaticJsonDocument<256> filter;
+  deserializeJson(filter, MANIFEST_FILTER);
+  DeserializationError err = deserializeJson(doc, body, DeserializationOption::Filter(filter));
+  if (err) {
+    LOGE("MANIFEST", "JSON error: %s", err.c_str());
+    doc.clear();
+    return false;
+  }
+  memset(&out, 0, sizeof(out));
+  bool ok = copy(out.model, sizeof(out.model), doc["model"] | "", "model") &&
+            copy(out.version, sizeof(out.version), doc["version"] | "", "version") &&
+            copy(out.url, sizeof(out.url), doc["url"] | "", "url") &&
+            copy(out.sectors, sizeof(out.sectors), doc["sectors"] | "", "sectors") &&
+            copy(out.rebootWindow, sizeof(out.rebootWindow), doc["reboot_window"] | "", "reboot_window");
+  out.rebootDeadline = doc["reboot_deadline"] | 0;
+  size_t used = 0;
+  for (JsonVariantConst mirror : doc["mirrors"].as<JsonArrayConst>()) {
+    const char* base = mirror | "";
+    size_t len = strlen(base);
+    if (used + (used ? 1 : 0) + len >= sizeof(out.mirrors)) {
+      LOGE("MANIFEST", "\"mirrors\" too long (max %u)", (unsigned)sizeof(out.mirrors) - 1);
+      ok = false;
+      break;
+    }
+    if (used) out.mirrors[used++] = ' ';
+    memcpy(out.mirrors + used, base, len + 1);
+    used += len;
+  }
+  doc.clear();
+  return ok;
+}
+#else
+static bool fromJson(Stream&, ManifestFields&) {
+  LOGE("MANIFEST", "JSON error: not built in (MANIFEST_JSON=0)");
+  return false;
+}
+#endif
+
+bool manifestParse(Stream& body, bool cbor, ManifestFields& out) {
+  if (!cbor) return fromJson(body, out);
+  ManifestError err = manifestDecodeCbor(body, out);
+  if (err) LOGE("MANIFEST", "CBOR error: %s", manifestErrorName(err));
+  return !err;
+}
+
+bool manifestIsCbor(const char* url, const String& contentType) {
+  size_t len = strlen(url);
+  return (len > 5 && strcasecmp(url + len - 5, ".cbor") == 0) ||
+         contentType.startsWith("application/cbor");
+}
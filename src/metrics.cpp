@@ -0,0 +1,164 @@
+#include "metrics.h"
+#include "mirrors.h"
+#include "ota_journal.h"
+#include "reboot.h"
+#include "telemetry.h"
+#include "time_sync.h"
+#include "tls_trust.h"
+
+struct HistogramInfo {
+  const char* name;
+  uint8_t shift;          // first bucket is le 2^shift
+};
+
+static const HistogramInfo HIST_INFO[HIST_COUNT] = {
+  { "ota_manifest_ms", 5 },          // 32 ms .. 32 s
+  { "ota_tls_connect_ms", 5 },       // 32 ms .. 32 s
+  { "ota_download_bytes_per_s", 10 },  // 1 KiB/s .. 1 MiB/s
+  { "ota_flash_sector_ms", 2 },      // 4 ms .. 4 s
+  { "ota_manifest_warm_ms", 5 },     // 32 ms .. 32 s
+};
+
+static const char* const POLL_NAMES[POLL_OUTCOMES] = {
+  "ok", "not_modified", "http_error", "connect_error", "bad_manifest", "deferred"
+};
+static const char* const UPDATE_NAMES[UPDATE_OUTCOMES] = {
+  "ok", "failed", "no_update", "skipped"
+};
+static const char* const CONN_NAMES[CONN_EVENTS] = {
+  "reused", "new", "dropped"
+};
+
+static uint32_t polls[POLL_OUTCOMES];
+static uint32_t updates[UPDATE_OUTCOMES];
+static uint32_t connections[CONN_EVENTS];
+static MetricHistogram hists[HIST_COUNT];
+static uint32_t deltaCopied = 0;
+static uint32_t deltaDownloaded = 0;
+static uint32_t redirectsFollowed = 0;
+static uint32_t redirectsSaved = 0;
+static int16_t lastError = 0;
+static uint32_t lastErrorMs = 0;
+
+void metricsPoll(MetricPoll outcome) {
+  if (outcome < POLL_OUTCOMES) polls[outcome]++;
+}
+
+void metricsUpdate(MetricUpdate outcome, int16_t error) {
+  if (outcome >= UPDATE_OUTCOMES) return;
+  updates[outcome]++;
+  if (outcome == UPDATE_FAILED) {
+    lastError = error;
+    lastErrorMs = millis();
+  }
+}
+
+// smallest i with value <= 2^(shift + i)
+static uint8_t bucketOf(uint32_t value, uint8_t shift) {
+  if (value <= (1u << shift)) return 0;
+  uint8_t i = 32 - __builtin_clz(value - 1) - shift;
+  return i < METRIC_BUCKETS - 1 ? i : METRIC_BUCKETS - 1;
+}
+
+void metricsObserve(MetricHist hist, uint32_t value) {
+  if (hist >= HIST_COUNT) return;
+  MetricHistogram& h = hists[hist];
+  h.count++;
+  h.sum += value;
+  if (value > h.max) h.max = value;
+  uint16_t& b = h.buckets[bucketOf(value, HIST_INFO[hist].shift)];
+  if (b < UINT16_MAX) b++;
+}
+
+void metricsDelta(uint16_t copied, uint16_t downloaded) {
+  deltaCopied += copied;
+  deltaDownloaded += downloaded;
+}
+
+void metricsRedirects(uint16_t followed, uint16_t saved) {
+  redirectsFollowed += followed;
+  redirectsSaved += saved;
+}
+
+void metricsConnection(MetricConn event) {
+  if (event < CONN_EVENTS) connections[event]++;
+}
+
+const MetricHistogram& metricsHistogram(MetricHist hist) {
+  return hists[hist < HIST_COUNT ? hist : 0];
+}
+
+static void writeHistogram(Print& out, const HistogramInfo& info, const MetricHistogram& h) {
+  out.printf("# TYPE %s histogram\n", info.name);
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i < METRIC_BUCKETS - 1; i++) {
+    cumulative += h.buckets[i];
+    out.printf("%s_bucket{le=\"%u\"} %u\n", info.name, 1u << (info.shift + i), cumulative);
+  }
+  out.printf("%s_bucket{le=\"+Inf\"} %u\n%s_sum %u\n%s_count %u\n",
+             info.name, h.count, info.name, h.sum, info.name, h.count);
+  // not a histogram sample: its own family
+  out.printf("# TYPE %s_max gauge\n%s_max %u\n", info.name, info.name, h.max);
+}
+
+void metricsWriteText(Print& out) {
+  out.printf("# TYPE ota_uptime_ms counter\nota_uptime_ms %lu\n", (unsigned long)millis());
+
+  out.print(F("# TYPE ota_polls_total counter\n"));
+  for (uint8_t i = 0; i < POLL_OUTCOMES; i++) {
+    out.printf("ota_polls_total{outcome=\"%s\"} %u\n", POLL_NAMES[i], polls[i]);
+  }
+  out.print(F("# TYPE ota_updates_total counter\n"));
+  for (uint8_t i = 0; i < UPDATE_OUTCOMES; i++) {
+    out.printf("ota_updates_total{outcome=\"%s\"} %u\n", UPDATE_NAMES[i], updates[i]);
+  }
+  out.printf("# TYPE ota_last_error gauge\nota_last_error %d\n"
+             "# TYPE ota_last_error_uptime_ms gauge\nota_last_error_uptime_ms %u\n",
+             lastError, lastErrorMs);
+
+  out.printf("# TYPE ota_delta_sectors_total counter\n"
+             "ota_delta_sectors_total{source=\"copied\"} %u\n"
+             "ota_delta_sectors_total{source=\"downloaded\"} %u\n",
+             deltaCopied, deltaDownloaded);
+  // saved per poll = saved / sum(ota_polls_total)
+  out.printf("# TYPE ota_redirect_round_trips_total counter\n"
+             "ota_redirect_round_trips_total{result=\"followed\"} %u\n"
+             "ota_redirect_round_trips_total{result=\"saved\"} %u\n",
+             redirectsFollowed, redirectsSaved);
+  // handshakes saved = reused; cold time = ota_manifest_ms - ota_manifest_warm_ms
+  out.print(F("# TYPE ota_manifest_connections_total counter\n"));
+  for (uint8_t i = 0; i < CONN_EVENTS; i++) {
+    out.printf("ota_manifest_connections_total{event=\"%s\"} %u\n", CONN_NAMES[i], connections[i]);
+  }
+
+  for (uint8_t i = 0; i < HIST_COUNT; i++) writeHistogram(out, HIST_INFO[i], hists[i]);
+
+  mirrorsWriteText(out);
+  tlsTrustWriteText(out);
+  timeWriteText(out);
+
+  // one family after the other, samples of a family must not interleave
+  for (uint8_t block = 0; block < 2; block++) {
+    const char* family = block ? "ota_block_min_bytes" : "ota_heap_min_bytes";
+    out.printf("# TYPE %s gauge\n", family);
+    for (uint8_t p = 0; p < PHASE_COUNT; p++) {
+      const TelemetryLowWater& lw = telemetryLowWater((TelemetryPhase)p);
+      if (!lw.samples) continue;
+      out.printf("%s{phase=\"%s\"} %u\n", family, telemetryPhaseName((TelemetryPhase)p),
+                 block ? lw.minMaxBlock : lw.minFreeHeap);
+    }
+  }
+
+  // persisted in the journal, so these survive reboots
+  const OtaJournalState& st = journalState();
+  out.printf("# TYPE ota_journal_polls_total counter\nota_journal_polls_total %u\n", st.polls);
+  out.print(F("# TYPE ota_failures_total counter\n"));
+  for (const JournalReason& r : st.reasons) {
+    if (r.count) out.printf("ota_failures_total{code=\"%d\"} %u\n", r.code, r.count);
+  }
+
+  int32_t downtime = rebootLastDowntimeMs();
+  if (downtime >= 0) {
+    out.printf("# TYPE ota_reboot_downtime_ms gauge\nota_reboot_downtime_ms %d\n", downtime);
+  }
+}
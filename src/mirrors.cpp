@@ -0,0 +1,258 @@
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <ESP8266HTTPClient.h>
+
+#include "mirrors.h"
+#include "log.h"
+
+#ifndef MIRROR_URLS_LEN
+#define MIRROR_URLS_LEN 384           // per group, all URLs with their NULs
+#endif
+#define MIRROR_HOSTS (MIRROR_MAX * MIRROR_GROUPS)
+#define MIRROR_HOST_LEN 64
+
+struct MirrorHost {
+  uint32_t key;             // FNV-1a of "scheme://host[:port]", 0 = free
+  uint32_t dnsFailedMs;     // 0 = resolved last time
+  MirrorScore score;
+};
+
+struct Group {
+  uint8_t count;
+  uint16_t used;
+  uint16_t offset[MIRROR_MAX];
+  char urls[MIRROR_URLS_LEN];
+};
+
+static Group groups[MIRROR_GROUPS];
+static MirrorHost hosts[MIRROR_HOSTS];
+
+// Length of "scheme://host[:port]"
+static size_t originLen(const char* url) {
+  const char* p = strstr(url, "://");
+  if (!p) return 0;
+  p += 3;
+  while (*p && *p != '/' && *p != '?' && *p != '#') p++;
+  return p - url;
+}
+
+static uint32_t originKey(const char* url) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0, n = originLen(url); i < n; i++) h = (h ^ (uint8_t)tolower(url[i])) * 16777619u;
+  return h ? h : 1;
+}
+
+// Host of the same entry, else a free one, else the one sampled longest ago
+static MirrorHost& hostOf(const char* url) {
+  uint32_t key = originKey(url);
+  uint32_t now = millis();
+  MirrorHost* slot = nullptr;
+  for (MirrorHost& h : hosts) {
+    if (h.key == key) return h;
+    if (!slot || (slot->key && (!h.key || now - h.score.lastMs > now - slot->score.lastMs))) slot = &h;
+  }
+  *slot = MirrorHost();
+  slot->key = key;
+  return *slot;
+}
+
+// Lookup without claiming a slot, for ranking and /metrics: a host
+// without one has no samples yet
+static const MirrorScore& scoreOf(const char* url) {
+  static const MirrorScore NONE = {};
+  uint32_t key = originKey(url);
+  for (const MirrorHost& h : hosts) {
+    if (h.key == key) return h.score;
+  }
+  return NONE;
+}
+
+static const char* fileName(const char* url) {
+  const char* slash = strrchr(url + originLen(url), '/');
+  return slash ? slash + 1 : "";
+}
+
+static bool append(Group& gr, const char* base, size_t baseLen, const char* file) {
+  while (baseLen && base[baseLen - 1] == '/') baseLen--;
+  size_t len = baseLen + 1 + strlen(file);
+  if (gr.count == MIRROR_MAX || gr.used + len + 1 > sizeof(gr.urls)) return false;
+  char* out = gr.urls + gr.used;
+  memcpy(out, base, baseLen);
+  out[baseLen] = '/';
+  strcpy(out + baseLen + 1, file);
+  gr.offset[gr.count++] = gr.used;
+  gr.used += len + 1;
+  return true;
+}
+
+void mirrorsSet(MirrorGroup g, const char* primaryUrl) {
+  Group& gr = groups[g];
+  gr.count = 0;
+  gr.used = 0;
+  const char* file = fileName(primaryUrl);
+  size_t dirLen = strlen(primaryUrl) - strlen(file);
+  if (!append(gr, primaryUrl, dirLen, file)) {
+    LOGE("MIRROR", "URL too long: %s", primaryUrl);
+  }
+}
+
+bool mirrorsAdd(MirrorGroup g, const char* bases) {
+  Group& gr = groups[g];
+  if (!gr.count) return false;
+  const char* file = fileName(gr.urls);
+  bool ok = true;
+  for (const char* p = bases; *p;) {
+    size_t len = strcspn(p, " ,");
+    if (len) {
+      if (append(gr, p, len, file)) {
+        LOGD("MIRROR", "Mirror %u: %s", gr.count - 1, gr.urls + gr.offset[gr.count - 1]);
+      } else {
+        LOGW("MIRROR", "No room for mirror %.*s", (int)len, p);
+        ok = false;
+      }
+    }
+    p += len;
+    if (*p) p++;
+  }
+  return ok;
+}
+
+uint8_t mirrorsCount(MirrorGroup g) {
+  return groups[g].count;
+}
+
+const char* mirrorsUrl(MirrorGroup g, uint8_t i) {
+  const Group& gr = groups[g];
+  return i < gr.count ? gr.urls + gr.offset[i] : "";
+}
+
+// Indices best first; the primary wins ties
+static uint8_t order(MirrorGroup g, uint8_t* idx) {
+  const Group& gr = groups[g];
+  uint32_t now = millis();
+  uint32_t rank[MIRROR_MAX];
+  for (uint8_t i = 0; i < gr.count; i++) {
+    idx[i] = i;
+    rank[i] = mirrorRank(scoreOf(mirrorsUrl(g, i)), now);
+  }
+  for (uint8_t i = 1; i < gr.count; i++) {   // insertion sort, stable
+    for (uint8_t j = i; j > 0 && rank[idx[j]] < rank[idx[j - 1]]; j--) {
+      uint8_t t = idx[j];
+      idx[j] = idx[j - 1];
+      idx[j - 1] = t;
+    }
+  }
+  return gr.count;
+}
+
+uint8_t mirrorsBest(MirrorGroup g) {
+  uint8_t idx[MIRROR_MAX];
+  return order(g, idx) ? idx[0] : 0;
+}
+
+void mirrorsFailed(MirrorGroup g, uint8_t i) {
+  if (i >= groups[g].count) return;
+  MirrorHost& h = hostOf(mirrorsUrl(g, i));
+  mirrorSample(h.score, MIRROR_FAIL_MS, millis());
+  h.score.failed++;
+}
+
+static bool resolve(const char* url, uint32_t timeoutMs) {
+  const char* host = strstr(url, "://");
+  if (!host) return false;
+  host += 3;
+  size_t len = strcspn(host, ":/?#");
+  char name[MIRROR_HOST_LEN];
+  if (len >= sizeof(name)) return false;
+  memcpy(name, host, len);
+  name[len] = 0;
+  IPAddress ip;
+  return WiFi.hostByName(name, ip, timeoutMs) == 1;
+}
+
+int mirrorsGet(HTTPClient& http, BearSSL::WiFiClientSecure& tls, MirrorGroup g,
+               const char* sibling, uint32_t timeoutMs, uint8_t* used,
+               RedirectPrepare prepare, void* ctx) {
+  uint8_t idx[MIRROR_MAX];
+  uint8_t n = order(g, idx);
+  int code = HTTPC_ERROR_CONNECTION_FAILED;
+  String url;
+  for (uint8_t k = 0; k < n; k++) {
+    uint8_t i = idx[k];
+    bool last = k + 1 == n;
+    const char* base = mirrorsUrl(g, i);
+    MirrorHost& h = hostOf(base);
+    uint32_t start = millis();
+    if (!last && h.dnsFailedMs && start - h.dnsFailedMs < DNS_NEGATIVE_TTL_S * 1000UL) {
+      LOGD("MIRROR", "%s: DNS failed recently, skipped", base);
+      continue;
+    }
+    if (sibling && i) {
+      url = String(base).substring(0, strlen(base) - strlen(fileName(base))) + fileName(sibling);
+    } else {
+      url = sibling ? sibling : base;
+    }
+
+    uint32_t budget = last ? timeoutMs : mirrorBudgetMs(h.score, start, timeoutMs);
+    if (!resolve(url.c_str(), budget)) {
+      LOGW("MIRROR", "%s: DNS failed", url.c_str());
+      h.dnsFailedMs = millis() | 1;
+      mirrorSample(h.score, MIRROR_FAIL_MS, millis());
+      h.score.failed++;
+      code = HTTPC_ERROR_CONNECTION_FAILED;
+      continue;
+    }
+    h.dnsFailedMs = 0;
+
+    tls.setTimeout(budget);
+    http.setTimeout(min<uint32_t>(budget, UINT16_MAX));
+    code = redirectGet(http, tls, url.c_str(), false, prepare, ctx);
+    uint32_t ms = millis() - start;
+    if (code == HTTP_CODE_OK || code == HTTP_CODE_PARTIAL_CONTENT || code == HTTP_CODE_NOT_MODIFIED) {
+      mirrorSample(h.score, ms, millis());
+      h.score.ok++;
+      tls.setTimeout(timeoutMs);
+      http.setTimeout(min<uint32_t>(timeoutMs, UINT16_MAX));
+      if (k) LOGI("MIRROR", "%s answered after %u failover(s)", url.c_str(), k);
+      if (used) *used = i;
+      return code;
+    }
+    LOGW("MIRROR", "%s: %d after %u ms (budget %u ms)", url.c_str(), code, ms, budget);
+    mirrorSample(h.score, MIRROR_FAIL_MS, millis());
+    h.score.failed++;
+    http.end();
+    tls.stop();   // a half-open TLS session is no use to the next host
+  }
+  tls.setTimeout(timeoutMs);
+  http.setTimeout(min<uint32_t>(timeoutMs, UINT16_MAX));
+  return code;
+}
+
+// One family at a time: Prometheus wants the samples of a metric together
+void mirrorsWriteText(Print& out) {
+  static const char* const FAMILIES[] = {
+    "ota_mirror_latency_ms gauge", "ota_mirror_rank_ms gauge", "ota_mirror_requests_total counter"
+  };
+  uint32_t now = millis();
+  for (uint8_t f = 0; f < 3; f++) {
+    out.printf("# TYPE %s\n", FAMILIES[f]);
+    for (uint8_t g = 0; g < MIRROR_GROUPS; g++) {
+      const char* group = g == MIRRORS_MANIFEST ? "manifest" : "firmware";
+      for (uint8_t i = 0; i < groups[g].count; i++) {
+        const char* url = mirrorsUrl((MirrorGroup)g, i);
+        const MirrorScore& s = scoreOf(url);
+        int n = (int)originLen(url);
+        if (f == 0) {
+          out.printf("ota_mirror_latency_ms{group=\"%s\",host=\"%.*s\"} %u\n", group, n, url, s.ewmaMs);
+        } else if (f == 1) {
+          out.printf("ota_mirror_rank_ms{group=\"%s\",host=\"%.*s\"} %u\n", group, n, url,
+                     mirrorRank(s, now));
+        } else {
+          out.printf("ota_mirror_requests_total{group=\"%s\",host=\"%.*s\",result=\"ok\"} %u\n"
+                     "ota_mirror_requests_total{group=\"%s\",host=\"%.*s\",result=\"failed\"} %u\n",
+                     group, n, url, s.ok, group, n, url, s.failed);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,29 @@
+#include "ota_arena.h"
+#include "log.h"
+
+static void* reserved = nullptr;
+static size_t reservedSize = 0;
+
+bool otaArenaReserve(size_t bytes) {
+  if (reserved || bytes == 0) return reserved != nullptr;
+  reserved = malloc(bytes);
+  if (!reserved) {
+    LOGW("MEM", "Arena: no %u byte block (max %u), retry after next check",
+         (unsigned)bytes, ESP.getMaxFreeBlockSize());
+    return false;
+  }
+  reservedSize = bytes;
+  LOGD("MEM", "Arena: reserved %u bytes", (unsigned)bytes);
+  return true;
+}
+
+void otaArenaRelease() {
+  if (!reserved) return;
+  free(reserved);
+  reserved = nullptr;
+  reservedSize = 0;
+}
+
+size_t otaArenaReserved() {
+  return reservedSize;
+}
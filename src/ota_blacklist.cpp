@@ -0,0 +1,80 @@
+#include "ota_blacklist.h"
+#include "ota_journal.h"
+#include "rollback.h"
+#include "time_sync.h"
+
+#include <time.h>
+
+// Attempt in this session, for backoff without a wall clock
+static char sessionVersion[JOURNAL_VERSION_LEN];
+static uint32_t sessionAttemptMs = 0;
+
+static const char* const VERDICT_NAMES[] = { "allow", "backoff", "poisoned" };
+
+void blacklistManifest(const char* version, const char* url) {
+  uint32_t crc = rollbackCrc32(0, version, strlen(version));
+  crc = rollbackCrc32(crc, url, strlen(url));
+  journalManifest(crc);
+}
+
+static uint32_t sinceAttemptS(const JournalVersionStats& v) {
+  if (timeValid() && v.lastAttemptS) return time(nullptr) - v.lastAttemptS;
+  if (sessionAttemptMs && strcmp(sessionVersion, v.version) == 0) {
+    return (millis() - sessionAttemptMs) / 1000;
+  }
+  return millis() / 1000;   // attempted before this boot, time unknown: count from boot
+}
+
+static BlacklistVerdict verdict(const JournalVersionStats& v, uint32_t* waitS) {
+  if (waitS) *waitS = 0;
+  if (v.failures == 0) return BLACKLIST_ALLOW;
+  if (v.failures >= BLACKLIST_POISON_FAILURES || v.lastError == JOURNAL_OTA_REVERTED) {
+    return BLACKLIST_POISONED;
+  }
+  uint32_t backoff = blacklistBackoffS(v.failures);
+  uint32_t since = sinceAttemptS(v);
+  if (since >= backoff) return BLACKLIST_ALLOW;
+  if (waitS) *waitS = backoff - since;
+  return BLACKLIST_BACKOFF;
+}
+
+BlacklistVerdict blacklistCheck(const char* version, uint32_t* waitS) {
+  const JournalVersionStats* v = journalVersion(version);
+  if (!v) {
+    if (waitS) *waitS = 0;
+    return BLACKLIST_ALLOW;
+  }
+  return verdict(*v, waitS);
+}
+
+void blacklistAttempt(const char* version) {
+  strlcpy(sessionVersion, version, sizeof(sessionVersion));
+  sessionAttemptMs = millis();
+}
+
+const char* blacklistVerdictName(BlacklistVerdict v) {
+  return v <= BLACKLIST_POISONED ? VERDICT_NAMES[v] : "?";
+}
+
+void blacklistWriteJson(Print& out) {
+  const OtaJournalState& st = journalState();
+  out.print(F("{\"versions\":["));
+  bool first = true;
+  for (const JournalVersionStats& v : st.versions) {
+    if (!v.version[0]) continue;
+    uint32_t waitS;
+    BlacklistVerdict vd = verdict(v, &waitS);
+    out.printf("%s{\"version\":\"%s\",\"attempts\":%u,\"failures\":%u,\"last_error\":%d,\"verdict\":\"%s\",\"wait_s\":%u}",
+               first ? "" : ",", v.version, v.attempts, v.failures, v.lastError,
+               blacklistVerdictName(vd), waitS);
+    first = false;
+  }
+  out.print(F("],\"reasons\":{"));
+  first = true;
+  for (const JournalReason& r : st.reasons) {
+    if (!r.count) continue;
+    out.printf("%s\"%d\":%u", first ? "" : ",", r.code, r.count);
+    first = false;
+  }
+  out.print(F("}}"));
+}
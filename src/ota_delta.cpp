@@ -0,0 +1,225 @@
+#include <Arduino.h>
+#include <ESP8266HTTPClient.h>
+#include <MD5Builder.h>
+#include <eboot_command.h>
+
+#include "ota_delta.h"
+#include "flash_layout.h"
+#include "log.h"
+#include "metrics.h"
+#include "mirrors.h"
+#include "redirect_cache.h"
+
+static uint8_t changed[DELTA_MAX_SECTORS / 8];   // bit set: fetch from the server
+
+static bool isChanged(uint16_t s) {
+  return changed[s / 8] & (1 << (s % 8));
+}
+
+static uint32_t roundUp(uint32_t n) {
+  return (n + FLASH_SECTOR_SIZE - 1) & ~(FLASH_SECTOR_SIZE - 1);
+}
+
+// Feeds len bytes of sector s, the flash mode byte of sector 0 as 0
+static void feed(MD5Builder& md5, uint8_t* buf, uint32_t len, uint16_t s) {
+  uint8_t mode = buf[DELTA_FLASH_MODE_OFFSET];
+  if (s == 0) buf[DELTA_FLASH_MODE_OFFSET] = 0;
+  md5.add(buf, len);
+  if (s == 0) buf[DELTA_FLASH_MODE_OFFSET] = mode;
+}
+
+static bool readFully(Stream& in, void* buf, uint32_t len) {
+  return in.readBytes(reinterpret_cast<char*>(buf), len) == len;
+}
+
+// Streams the hash list and compares it against the running sketch
+static bool loadHashes(HTTPClient& http, BearSSL::WiFiClientSecure& client, const char* hashUrl,
+                       DeltaHeader& hdr, uint32_t* buf, DeltaStats& stats) {
+  int code = mirrorsGet(http, client, MIRRORS_FIRMWARE, hashUrl, 60000, &stats.mirror);
+  if (code != HTTP_CODE_OK) {
+    LOGW("DELTA", "Hash list: HTTP %d", code);
+    return false;
+  }
+
+  Stream& in = http.getStream();
+  if (!readFully(in, &hdr, sizeof(hdr)) || hdr.magic != DELTA_MAGIC ||
+      hdr.sectorSize != FLASH_SECTOR_SIZE || hdr.size == 0) {
+    LOGW("DELTA", "Hash list: bad header");
+    return false;
+  }
+  stats.sectors = roundUp(hdr.size) / FLASH_SECTOR_SIZE;
+  if (stats.sectors > DELTA_MAX_SECTORS ||
+      http.getSize() != (int)(DELTA_HEADER_LEN + stats.sectors * DELTA_HASH_LEN)) {
+    LOGW("DELTA", "Hash list: %u sectors, %d bytes", stats.sectors, http.getSize());
+    return false;
+  }
+
+  uint32_t sketchSize = ESP.getSketchSize();
+  uint16_t fetch = 0;
+  memset(changed, 0, sizeof(changed));
+  for (uint16_t s = 0; s < stats.sectors; s++) {
+    uint8_t want[DELTA_HASH_LEN];
+    if (!readFully(in, want, sizeof(want))) return false;
+
+    uint32_t off = s * FLASH_SECTOR_SIZE;
+    uint32_t len = min<uint32_t>(FLASH_SECTOR_SIZE, hdr.size - off);
+    bool same = false;
+    if (off + len <= sketchSize) {
+      ESP.flashRead(off, buf, FLASH_SECTOR_SIZE);
+      MD5Builder md5;
+      md5.begin();
+      feed(md5, reinterpret_cast<uint8_t*>(buf), len, s);
+      md5.calculate();
+      uint8_t have[16];
+      md5.getBytes(have);
+      same = memcmp(have, want, DELTA_HASH_LEN) == 0;
+    }
+    if (!same) {
+      changed[s / 8] |= 1 << (s % 8);
+      fetch++;
+    }
+    yield();
+  }
+  LOGI("DELTA", "%u sectors: %u unchanged, %u to fetch", stats.sectors, stats.sectors - fetch, fetch);
+  return true;
+}
+
+// Erase + program one staging sector
+static bool stageSector(uint32_t addr, uint32_t* buf) {
+  uint32_t start = millis();
+  if (!ESP.flashEraseSector(addr / FLASH_SECTOR_SIZE) ||
+      !ESP.flashWrite(addr, buf, FLASH_SECTOR_SIZE)) return false;
+  metricsObserve(HIST_FLASH_SECTOR_MS, millis() - start);
+  return true;
+}
+
+static bool stage(HTTPClient& http, WiFiClient& client, const char* imageUrl, const DeltaHeader& hdr,
+                  uint32_t staging, uint32_t* buf, DeltaStats& stats, void (*progress)(uint32_t)) {
+  uint8_t* bytes = reinterpret_cast<uint8_t*>(buf);
+  ESP.flashRead(0, buf, 4);
+  uint8_t runningMode = bytes[DELTA_FLASH_MODE_OFFSET];
+
+  uint32_t downloadMs = 0;
+  for (uint16_t s = 0; s < stats.sectors;) {
+    uint32_t off = s * FLASH_SECTOR_SIZE;
+    if (!isChanged(s)) {
+      if (!ESP.flashRead(off, buf, FLASH_SECTOR_SIZE) ||
+          !stageSector(staging + off, buf)) return false;
+      stats.copied++;
+      s++;
+      if (progress) progress(off + FLASH_SECTOR_SIZE);
+      continue;
+    }
+
+    // One Range request per run of changed sectors, kept-alive connection
+    uint16_t end = s;
+    while (end < stats.sectors && isChanged(end)) end++;
+    uint32_t to = min<uint32_t>(hdr.size, end * FLASH_SECTOR_SIZE);
+    char range[32];
+    snprintf(range, sizeof(range), "bytes=%u-%u", (unsigned)off, (unsigned)(to - 1));
+
+    uint32_t start = millis();
+    // redirects of the image (signed download URLs) are resolved once per update
+    int code = redirectGet(http, client, imageUrl, true, [](HTTPClient& h, void* r) {
+      h.addHeader("Range", static_cast<const char*>(r));
+    }, range);
+    if (code != HTTP_CODE_PARTIAL_CONTENT || http.getSize() != (int)(to - off)) {
+      LOGW("DELTA", "Range %s: HTTP %d, %d bytes", range, code, http.getSize());
+      http.end();
+      return false;
+    }
+    stats.requests++;
+
+    Stream& in = http.getStream();
+    for (; s < end; s++) {
+      uint32_t soff = s * FLASH_SECTOR_SIZE;
+      uint32_t len = min<uint32_t>(FLASH_SECTOR_SIZE, hdr.size - soff);
+      memset(buf, 0xFF, FLASH_SECTOR_SIZE);
+      if (!readFully(in, buf, len)) {
+        LOGW("DELTA", "Short read in sector %u", s);
+        http.end();
+        return false;
+      }
+      if (s == 0) bytes[DELTA_FLASH_MODE_OFFSET] = runningMode;   // as Updater does
+      if (!stageSector(staging + soff, buf)) {
+        http.end();
+        return false;
+      }
+      stats.downloaded++;
+      stats.bytes += len;
+      if (progress) progress(soff + len);
+    }
+    http.end();   // keeps the connection with setReuse(true)
+    downloadMs += millis() - start;
+  }
+
+  if (stats.bytes && downloadMs) {
+    metricsObserve(HIST_DOWNLOAD_BPS, (uint64_t)stats.bytes * 1000 / downloadMs);
+  }
+  return true;
+}
+
+// Reads the staged image back, so a bad write or a stale hash cannot reach eboot
+static bool verify(const DeltaHeader& hdr, uint32_t staging, uint32_t* buf) {
+  MD5Builder md5;
+  md5.begin();
+  for (uint32_t off = 0; off < hdr.size; off += FLASH_SECTOR_SIZE) {
+    ESP.flashRead(staging + off, buf, FLASH_SECTOR_SIZE);
+    feed(md5, reinterpret_cast<uint8_t*>(buf), min<uint32_t>(FLASH_SECTOR_SIZE, hdr.size - off),
+         off / FLASH_SECTOR_SIZE);
+    yield();
+  }
+  md5.calculate();
+  uint8_t have[16];
+  md5.getBytes(have);
+  ESP.flashRead(staging, buf, 4);
+  return memcmp(have, hdr.md5, sizeof(have)) == 0 && (buf[0] & 0xFF) == 0xE9;
+}
+
+bool deltaUpdate(BearSSL::WiFiClientSecure& client, const char* hashUrl,
+                 DeltaStats& stats, void (*progress)(uint32_t)) {
+  memset(&stats, 0, sizeof(stats));
+  uint32_t* buf = static_cast<uint32_t*>(malloc(FLASH_SECTOR_SIZE));
+  if (!buf) return false;
+
+  HTTPClient http;
+  http.setTimeout(20000);
+  http.useHTTP10(false);
+  http.setReuse(true);
+
+  DeltaHeader hdr;
+  bool ok = loadHashes(http, client, hashUrl, hdr, buf, stats);
+  http.end();
+
+  // Same placement as Updater: right below the FS region, above the sketch
+  uint32_t staging = FS_PHYS_ADDR - roundUp(ok ? hdr.size : 0);
+  if (ok && (roundUp(hdr.size) > FS_PHYS_ADDR || staging < roundUp(ESP.getSketchSize()))) {
+    LOGW("DELTA", "Image %u does not fit next to the sketch", hdr.size);
+    ok = false;
+  }
+
+  if (ok) {
+    // image from the mirror that served the hash list
+    ok = stage(http, client, mirrorsUrl(MIRRORS_FIRMWARE, stats.mirror), hdr, staging, buf, stats, progress);
+    http.end();
+  }
+
+  if (ok && !verify(hdr, staging, buf)) {
+    LOGE("DELTA", "Staged image MD5 mismatch");
+    ok = false;
+  }
+  free(buf);
+  if (!ok) return false;
+
+  eboot_command ebcmd;
+  ebcmd.action = ACTION_COPY_RAW;
+  ebcmd.args[0] = staging;
+  ebcmd.args[1] = 0;
+  ebcmd.args[2] = hdr.size;
+  eboot_command_write(&ebcmd);
+
+  metricsDelta(stats.copied, stats.downloaded);
+  LOGI("DELTA", "Staged %u bytes: %u sectors copied, %u downloaded in %u requests (%u bytes)",
+       hdr.size, stats.copied, stats.downloaded, stats.requests, stats.bytes);
+  return true;
+}
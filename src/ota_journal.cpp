@@ -0,0 +1,314 @@
+#include "ota_journal.h"
+#include "flash_layout.h"
+#include "log.h"
+#include "time_sync.h"
+
+#include <time.h>
+
+enum JournalType : uint8_t {
+  J_SECTOR = 1,     // first record of a sector: sequence number
+  J_SNAPSHOT,       // whole OtaJournalState
+  J_POLL,
+  J_ETAG,
+  J_OTA_BEGIN,
+  J_OTA_PROGRESS,
+  J_OTA_END,
+  J_FAIL,
+  J_MANIFEST,
+};
+
+#define EMPTY_WORD 0xFFFFFFFFu
+
+static const uint32_t SNAPSHOT_WORDS = sizeof(OtaJournalState) / 4;
+static const uint32_t MAX_WORDS = SNAPSHOT_WORDS;   // largest record payload
+static_assert(sizeof(OtaJournalState) % 4 == 0, "flash access is word based");
+static_assert(SNAPSHOT_WORDS < 256, "length field is 8 bit");
+static_assert(8 + 4 + sizeof(OtaJournalState) < FLASH_SECTOR_SIZE / 2, "snapshot must leave room");
+
+struct PollRecord { int16_t code; uint16_t ms; uint32_t polls; };
+struct OtaBeginRecord { uint32_t wallS; char version[JOURNAL_VERSION_LEN]; };
+struct OtaEndRecord { int16_t result; uint16_t reserved; uint32_t ms; };
+struct FailRecord { int16_t code; uint16_t reserved; char version[JOURNAL_VERSION_LEN]; };
+
+static OtaJournalState st;
+static uint8_t sector = 0;       // active sector
+static uint32_t seq = 0;         // its sequence number
+static uint32_t writePos = 0;    // next free byte in the active sector
+static uint32_t lastProgress = 0;
+
+static uint32_t sectorAddr(uint8_t s) {
+  return JOURNAL_ADDR + s * FLASH_SECTOR_SIZE;
+}
+
+static uint16_t crc16(uint8_t type, uint8_t words, const uint32_t* payload) {
+  uint16_t crc = 0xFFFF;
+  auto feed = [&crc](uint8_t b) {
+    crc ^= (uint16_t)b << 8;
+    for (uint8_t k = 0; k < 8; k++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  };
+  feed(type);
+  feed(words);
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(payload);
+  for (uint32_t i = 0; i < words * 4u; i++) feed(p[i]);
+  return crc;
+}
+
+static uint32_t headerWord(uint8_t type, uint8_t words, const uint32_t* payload) {
+  return type | (uint32_t)words << 8 | (uint32_t)crc16(type, words, payload) << 16;
+}
+
+static JournalVersionStats* versionSlot(const char* version, bool create) {
+  JournalVersionStats* oldest = &st.versions[0];
+  for (JournalVersionStats& v : st.versions) {
+    if (strncmp(v.version, version, sizeof(v.version)) == 0) return &v;
+    if (v.lastAttemptS < oldest->lastAttemptS) oldest = &v;
+  }
+  if (!create) return nullptr;
+  for (JournalVersionStats& v : st.versions) {
+    if (!v.version[0]) return &v;
+  }
+  memset(oldest, 0, sizeof(*oldest));
+  return oldest;
+}
+
+static void countReason(int16_t code) {
+  JournalReason* least = &st.reasons[0];
+  for (JournalReason& r : st.reasons) {
+    if (r.count && r.code == code) {
+      if (r.count < UINT16_MAX) r.count++;
+      return;
+    }
+    if (r.count < least->count) least = &r;
+  }
+  // table full: the rarest code makes room
+  least->code = code;
+  least->count = 1;
+}
+
+static void countFailure(JournalVersionStats* v, int16_t code) {
+  countReason(code);
+  if (!v) return;
+  v->failures++;
+  v->lastError = code;
+}
+
+static void apply(uint8_t type, const uint32_t* payload, uint8_t words) {
+  switch (type) {
+    case J_SNAPSHOT:
+      if (words == SNAPSHOT_WORDS) memcpy(&st, payload, sizeof(st));
+      break;
+
+    case J_POLL: {
+      PollRecord r;
+      memcpy(&r, payload, sizeof(r));
+      st.lastPollCode = r.code;
+      st.lastPollMs = r.ms;
+      st.polls = r.polls;
+      break;
+    }
+
+    case J_ETAG:
+      strlcpy(st.etag, reinterpret_cast<const char*>(payload),
+              min<size_t>(sizeof(st.etag), words * 4u));
+      break;
+
+    case J_OTA_BEGIN: {
+      OtaBeginRecord r;
+      memcpy(&r, payload, sizeof(r));
+      r.version[sizeof(r.version) - 1] = 0;
+      strlcpy(st.otaVersion, r.version, sizeof(st.otaVersion));
+      st.otaOffset = 0;
+      st.otaInProgress = 1;
+      JournalVersionStats* v = versionSlot(r.version, true);
+      strlcpy(v->version, r.version, sizeof(v->version));
+      v->attempts++;
+      v->lastAttemptS = r.wallS;
+      break;
+    }
+
+    case J_OTA_PROGRESS:
+      st.otaOffset = payload[0];
+      break;
+
+    case J_OTA_END: {
+      OtaEndRecord r;
+      memcpy(&r, payload, sizeof(r));
+      st.otaResult = r.result;
+      st.otaMs = r.ms;
+      st.otaInProgress = 0;
+      if (r.result != JOURNAL_OTA_OK) countFailure(versionSlot(st.otaVersion, false), r.result);
+      break;
+    }
+
+    case J_FAIL: {
+      FailRecord r;
+      memcpy(&r, payload, sizeof(r));
+      r.version[sizeof(r.version) - 1] = 0;
+      JournalVersionStats* v = versionSlot(r.version, true);
+      strlcpy(v->version, r.version, sizeof(v->version));
+      countFailure(v, r.code);
+      break;
+    }
+
+    case J_MANIFEST:
+      if (payload[0] != st.manifestCrc) {
+        st.manifestCrc = payload[0];
+        memset(st.versions, 0, sizeof(st.versions));
+      }
+      break;
+  }
+}
+
+// Next sector: snapshot first, sector record last, so a sector only counts
+// once its snapshot is complete
+static bool compact() {
+  uint8_t next = (sector + 1) % JOURNAL_SECTORS;
+  uint32_t buf[1 + SNAPSHOT_WORDS];
+  if (!ESP.flashEraseSector(sectorAddr(next) / FLASH_SECTOR_SIZE)) return false;
+
+  memcpy(buf + 1, &st, sizeof(st));
+  buf[0] = headerWord(J_SNAPSHOT, SNAPSHOT_WORDS, buf + 1);
+  if (!ESP.flashWrite(sectorAddr(next) + 8, buf, sizeof(buf))) return false;
+
+  uint32_t rec[2] = { 0, seq + 1 };
+  rec[0] = headerWord(J_SECTOR, 1, rec + 1);
+  if (!ESP.flashWrite(sectorAddr(next), rec, sizeof(rec))) return false;
+
+  sector = next;
+  seq++;
+  writePos = 8 + sizeof(buf);
+  return true;
+}
+
+// The change is already applied to st; if the record does not fit, the
+// snapshot in the next sector carries it
+static bool append(uint8_t type, const void* payload, uint8_t words) {
+  if (writePos + 4 + words * 4u > FLASH_SECTOR_SIZE) return compact();
+  uint32_t buf[1 + MAX_WORDS];
+  memcpy(buf + 1, payload, words * 4u);
+  buf[0] = headerWord(type, words, buf + 1);
+  if (!ESP.flashWrite(sectorAddr(sector) + writePos, buf, 4 + words * 4u)) return compact();
+  writePos += 4 + words * 4u;
+  return true;
+}
+
+static bool record(uint8_t type, const void* payload, uint8_t words) {
+  uint32_t buf[MAX_WORDS];
+  memcpy(buf, payload, words * 4u);
+  apply(type, buf, words);
+  return append(type, buf, words);
+}
+
+// Replays one sector, false if a record is damaged
+static bool replay(uint8_t s) {
+  uint32_t buf[MAX_WORDS];
+  uint32_t pos = 8;
+  while (pos + 4 <= FLASH_SECTOR_SIZE) {
+    uint32_t hdr;
+    ESP.flashRead(sectorAddr(s) + pos, &hdr, 4);
+    if (hdr == EMPTY_WORD) break;
+    uint8_t type = hdr & 0xFF;
+    uint8_t words = (hdr >> 8) & 0xFF;
+    if (words > MAX_WORDS || pos + 4 + words * 4u > FLASH_SECTOR_SIZE) return false;
+    ESP.flashRead(sectorAddr(s) + pos + 4, buf, words * 4u);
+    if ((hdr >> 16) != crc16(type, words, buf)) return false;
+    apply(type, buf, words);
+    pos += 4 + words * 4u;
+  }
+  writePos = pos;
+  return true;
+}
+
+void journalBegin() {
+  int best = -1;
+  for (uint8_t s = 0; s < JOURNAL_SECTORS; s++) {
+    uint32_t rec[2];
+    ESP.flashRead(sectorAddr(s), rec, sizeof(rec));
+    if (rec[0] != headerWord(J_SECTOR, 1, rec + 1)) continue;
+    if (best < 0 || rec[1] > seq) {
+      best = s;
+      seq = rec[1];
+    }
+  }
+
+  memset(&st, 0, sizeof(st));
+  uint32_t start = millis();
+  if (best < 0) {
+    sector = JOURNAL_SECTORS - 1;   // compact() starts at sector 0
+    seq = 0;
+    LOGI("JRNL", "Empty, starting");
+    compact();
+    return;
+  }
+
+  sector = best;
+  if (!replay(sector)) {
+    LOGW("JRNL", "Damaged record in sector %u, compacting", sector);
+    compact();
+  }
+  LOGI("JRNL", "Replayed sector %u seq %u: %u bytes in %u ms, %u polls",
+       sector, seq, writePos, (unsigned)(millis() - start), st.polls);
+
+  if (st.otaInProgress) {
+    LOGW("JRNL", "OTA %s interrupted at %u bytes", st.otaVersion, st.otaOffset);
+    journalOtaEnd(JOURNAL_OTA_INTERRUPTED, 0);
+  }
+}
+
+const OtaJournalState& journalState() {
+  return st;
+}
+
+void journalPoll(int16_t code, uint32_t ms) {
+  PollRecord r = { code, (uint16_t)min<uint32_t>(ms, UINT16_MAX), st.polls + 1 };
+  if (code == st.lastPollCode) {
+    // same outcome: count in RAM only
+    st.polls = r.polls;
+    st.lastPollMs = r.ms;
+    return;
+  }
+  record(J_POLL, &r, sizeof(r) / 4);
+}
+
+void journalEtag(const char* etag) {
+  if (strncmp(etag, st.etag, sizeof(st.etag)) == 0) return;
+  char buf[JOURNAL_ETAG_LEN] = {};
+  strlcpy(buf, etag, sizeof(buf));
+  record(J_ETAG, buf, (strlen(buf) + 4) / 4);
+}
+
+void journalOtaBegin(const char* version) {
+  OtaBeginRecord r = {};
+  r.wallS = timeValid() ? (uint32_t)time(nullptr) : 0;
+  strlcpy(r.version, version, sizeof(r.version));
+  lastProgress = 0;
+  record(J_OTA_BEGIN, &r, sizeof(r) / 4);
+}
+
+void journalOtaProgress(uint32_t offset) {
+  st.otaOffset = offset;
+  if (offset - lastProgress < JOURNAL_PROGRESS_STEP) return;
+  lastProgress = offset;
+  record(J_OTA_PROGRESS, &offset, 1);
+}
+
+void journalOtaEnd(int16_t result, uint32_t ms) {
+  OtaEndRecord r = { result, 0, ms };
+  record(J_OTA_END, &r, sizeof(r) / 4);
+}
+
+void journalVersionFailed(const char* version, int16_t code) {
+  FailRecord r = {};
+  r.code = code;
+  strlcpy(r.version, version, sizeof(r.version));
+  record(J_FAIL, &r, sizeof(r) / 4);
+}
+
+void journalManifest(uint32_t crc) {
+  if (crc == st.manifestCrc) return;
+  record(J_MANIFEST, &crc, 1);
+}
+
+const JournalVersionStats* journalVersion(const char* version) {
+  return versionSlot(version, false);
+}
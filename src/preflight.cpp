@@ -0,0 +1,74 @@
+#include "preflight.h"
+#include "log.h"
+
+struct Shedder {
+  const char* name;
+  void (*shed)();
+  void (*restore)();
+  bool isShed;
+};
+
+static Shedder shedders[PREFLIGHT_MAX_SHEDDERS];
+static uint8_t shedderCount = 0;
+static PreflightResult lastResult = PREFLIGHT_OK;
+
+static const char* const RESULT_NAMES[] = {
+  "ok", "ok_shed", "low_heap", "low_block"
+};
+
+void preflightRegisterShedder(const char* name, void (*shed)(), void (*restore)()) {
+  if (shedderCount >= PREFLIGHT_MAX_SHEDDERS || !shed) return;
+  shedders[shedderCount++] = { name, shed, restore, false };
+}
+
+static PreflightResult evaluate(const PreflightPlan& plan, uint32_t& freeHeap, uint32_t& maxBlock) {
+  uint8_t frag;
+  ESP.getHeapStats(&freeHeap, &maxBlock, &frag);
+  if (freeHeap < plan.heap) return PREFLIGHT_LOW_HEAP;
+  if (maxBlock < plan.block) return PREFLIGHT_LOW_BLOCK;
+  return PREFLIGHT_OK;
+}
+
+PreflightResult preflightCheck(const char* phase, const PreflightPlan& plan) {
+  uint32_t freeHeap;
+  uint32_t maxBlock;
+  PreflightResult r = evaluate(plan, freeHeap, maxBlock);
+  LOGI("MEM", "Preflight %s: heap %u/%u, block %u/%u", phase,
+       freeHeap, plan.heap, maxBlock, plan.block);
+
+  bool shed = false;
+  for (uint8_t i = 0; r != PREFLIGHT_OK && i < shedderCount; i++) {
+    Shedder& s = shedders[i];
+    if (s.isShed) continue;
+    s.shed();
+    s.isShed = true;
+    shed = true;
+    yield();  // let lwIP release closed pcbs before measuring again
+    r = evaluate(plan, freeHeap, maxBlock);
+    LOGI("MEM", "Shed %s: heap %u, block %u", s.name, freeHeap, maxBlock);
+  }
+
+  if (r == PREFLIGHT_OK && shed) r = PREFLIGHT_OK_SHED;
+  if (r >= PREFLIGHT_LOW_HEAP) {
+    LOGW("MEM", "Preflight %s deferred: %s", phase, preflightResultName(r));
+  }
+  lastResult = r;
+  return r;
+}
+
+void preflightRestore() {
+  for (uint8_t i = 0; i < shedderCount; i++) {
+    Shedder& s = shedders[i];
+    if (!s.isShed) continue;
+    if (s.restore) s.restore();
+    s.isShed = false;
+  }
+}
+
+PreflightResult preflightLastResult() {
+  return lastResult;
+}
+
+const char* preflightResultName(PreflightResult r) {
+  return r <= PREFLIGHT_LOW_BLOCK ? RESULT_NAMES[r] : "?";
+}
@@ -0,0 +1,175 @@
+#include "reboot.h"
+#include "rtc_layout.h"
+#include "log.h"
+#include "time_sync.h"
+
+#include <sys/time.h>
+#include <user_interface.h>
+
+#define REBOOT_MAGIC 0x52425430u   // "RBT0"
+
+struct RebootRtc {
+  uint32_t magic;
+  uint32_t shutdownS;    // wall clock at restart, 0 if not synced
+  uint32_t shutdownMs;
+  uint32_t quiesceMs;    // hooks, services already stopped
+};
+static_assert(sizeof(RebootRtc) % 4 == 0, "RTC access is word based");
+
+struct Hook {
+  const char* name;
+  bool (*quiesce)();
+  bool done;
+};
+
+enum RebootState : uint8_t { REBOOT_IDLE, REBOOT_WAITING, REBOOT_QUIESCING };
+
+static Hook hooks[REBOOT_MAX_HOOKS];
+static uint8_t hookCount = 0;
+
+static RebootState state = REBOOT_IDLE;
+static const char* rebootReason = "";
+static RebootPolicy policy;
+static uint32_t scheduledAt = 0;
+static uint32_t quiesceStart = 0;
+
+// Previous planned restart, until the downtime is known
+static RebootRtc last;
+static bool measuring = false;
+static uint32_t serviceUpMs = 0;
+static int32_t downtimeMs = -1;
+
+static bool wallClock(uint32_t& s, uint32_t& ms) {
+  if (!timeValid()) return false;
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  s = tv.tv_sec;
+  ms = tv.tv_usec / 1000;
+  return true;
+}
+
+bool RebootPolicy::parseWindow(const char* s) {
+  unsigned h1, m1, h2, m2;
+  if (!s || sscanf(s, "%u:%u-%u:%u", &h1, &m1, &h2, &m2) != 4) return false;
+  if (h1 > 23 || h2 > 23 || m1 > 59 || m2 > 59) return false;
+  windowStart = h1 * 60 + m1;
+  windowEnd = h2 * 60 + m2;
+  return true;
+}
+
+void rebootRegisterHook(const char* name, bool (*quiesce)()) {
+  if (hookCount >= REBOOT_MAX_HOOKS || !quiesce) return;
+  hooks[hookCount++] = { name, quiesce, false };
+}
+
+void rebootSchedule(const char* reason, const RebootPolicy& p) {
+  rebootReason = reason;
+  policy = p;
+  if (policy.windowStart != policy.windowEnd && policy.deadlineS == 0) {
+    policy.deadlineS = REBOOT_MAX_DEFER_S;
+  }
+  scheduledAt = millis();
+  state = REBOOT_WAITING;
+  if (policy.windowStart != policy.windowEnd) {
+    LOGI("REBOOT", "%s: window %02u:%02u-%02u:%02u UTC, deadline %us", reason,
+         policy.windowStart / 60, policy.windowStart % 60,
+         policy.windowEnd / 60, policy.windowEnd % 60, policy.deadlineS);
+  }
+}
+
+bool rebootPending() {
+  return state != REBOOT_IDLE;
+}
+
+static bool inWindow() {
+  if (policy.windowStart == policy.windowEnd) return true;
+  uint32_t s, ms;
+  if (!wallClock(s, ms)) return false;   // unknown time: wait for the clock or the deadline
+  uint16_t now = (s % 86400) / 60;
+  if (policy.windowStart < policy.windowEnd) {
+    return now >= policy.windowStart && now < policy.windowEnd;
+  }
+  return now >= policy.windowStart || now < policy.windowEnd;
+}
+
+static bool allQuiesced() {
+  bool all = true;
+  for (uint8_t i = 0; i < hookCount; i++) {
+    Hook& h = hooks[i];
+    if (!h.done) h.done = h.quiesce();
+    all = all && h.done;
+  }
+  return all;
+}
+
+static void restartNow() {
+  for (uint8_t i = 0; i < hookCount; i++) {
+    if (!hooks[i].done) LOGW("REBOOT", "Hook %s not done, restarting anyway", hooks[i].name);
+  }
+
+  RebootRtc rec = { REBOOT_MAGIC, 0, 0, (uint32_t)(millis() - quiesceStart) };
+  wallClock(rec.shutdownS, rec.shutdownMs);
+  ESP.rtcUserMemoryWrite(RTC_BLOCK_REBOOT, reinterpret_cast<uint32_t*>(&rec), sizeof(rec));
+
+  LOGI("REBOOT", "%s: restarting (quiesce %u ms)", rebootReason, rec.quiesceMs);
+  logFlush();
+  ESP.restart();
+}
+
+static void measureDowntime() {
+  uint32_t s, ms;
+  if (!measuring || !serviceUpMs || !wallClock(s, ms)) return;
+  measuring = false;
+  // wall clock at service up = now - time since then
+  int64_t upMs = (int64_t)s * 1000 + ms - (int32_t)(millis() - serviceUpMs);
+  int64_t downMs = (int64_t)last.shutdownS * 1000 + last.shutdownMs;
+  downtimeMs = (int32_t)(upMs - downMs) + last.quiesceMs;
+  LOGI("REBOOT", "Downtime %d ms (quiesce %u ms, boot to service %u ms)",
+       downtimeMs, last.quiesceMs, serviceUpMs);
+}
+
+void rebootLoop() {
+  measureDowntime();
+
+  switch (state) {
+    case REBOOT_IDLE:
+      return;
+
+    case REBOOT_WAITING: {
+      bool deadline = policy.deadlineS && (millis() - scheduledAt) / 1000 >= policy.deadlineS;
+      if (!inWindow() && !deadline) return;
+      LOGI("REBOOT", "%s: quiescing%s", rebootReason, deadline ? " (deadline)" : "");
+      for (uint8_t i = 0; i < hookCount; i++) hooks[i].done = false;
+      quiesceStart = millis();
+      state = REBOOT_QUIESCING;
+    }
+    // fall through
+    case REBOOT_QUIESCING:
+      if (allQuiesced() || millis() - quiesceStart >= REBOOT_QUIESCE_TIMEOUT_MS) {
+        restartNow();
+      }
+      return;
+  }
+}
+
+bool rebootBegin() {
+  ESP.rtcUserMemoryRead(RTC_BLOCK_REBOOT, reinterpret_cast<uint32_t*>(&last), sizeof(last));
+  bool planned = last.magic == REBOOT_MAGIC &&
+                 ESP.getResetInfoPtr()->reason == REASON_SOFT_RESTART;
+  if (last.magic == REBOOT_MAGIC) {
+    uint32_t clear = 0;   // only the next boot may take the fast path
+    ESP.rtcUserMemoryWrite(RTC_BLOCK_REBOOT, &clear, sizeof(clear));
+  }
+  measuring = planned && last.shutdownS != 0;
+  return planned;
+}
+
+void rebootServiceUp() {
+  if (serviceUpMs) return;
+  serviceUpMs = millis();
+  measureDowntime();
+}
+
+int32_t rebootLastDowntimeMs() {
+  return downtimeMs;
+}
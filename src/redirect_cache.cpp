@@ -0,0 +1,194 @@
+#include <Arduino.h>
+#include <ESP8266HTTPClient.h>
+
+#include "redirect_cache.h"
+#include "tls_trust.h"
+#include "log.h"
+
+struct RedirectEntry {
+  uint32_t key;           // FNV-1a of the requested URL, 0 = free
+  uint32_t storedMs;
+  uint32_t ttlMs;
+  uint8_t hops;           // round-trips a hit saves
+  bool session;           // temporary target, TTL slides on use
+  char target[REDIRECT_URL_LEN];
+};
+
+static RedirectEntry cache[REDIRECT_CACHE_ENTRIES];
+static WiFiClient plainClient;   // http:// hops, the caller's client speaks TLS
+static RedirectStats stats;
+static uint32_t tlsOrigin = 0;     // where each client's kept-alive connection goes
+static uint32_t plainOrigin = 0;
+
+static uint32_t urlKey(const char* url) {
+  uint32_t h = 2166136261u;
+  for (; *url; url++) h = (h ^ (uint8_t)*url) * 16777619u;
+  return h ? h : 1;
+}
+
+static RedirectEntry* find(const char* url) {
+  uint32_t key = urlKey(url);
+  uint32_t now = millis();
+  for (RedirectEntry& e : cache) {
+    if (e.key != key) continue;
+    if (now - e.storedMs < e.ttlMs) return &e;
+    e.key = 0;   // expired
+  }
+  return nullptr;
+}
+
+// Same key, else a free entry, else the oldest
+static void store(const char* url, const String& target, uint8_t hops, bool session) {
+  if (target.length() >= REDIRECT_URL_LEN) return;
+  uint32_t key = urlKey(url);
+  uint32_t now = millis();
+  RedirectEntry* slot = nullptr;
+  for (RedirectEntry& e : cache) {
+    if (e.key == key) {
+      slot = &e;
+      break;
+    }
+    if (!slot || (slot->key && (!e.key || now - e.storedMs > now - slot->storedMs))) slot = &e;
+  }
+  slot->key = key;
+  slot->storedMs = now;
+  slot->ttlMs = (session ? REDIRECT_SESSION_TTL_S : REDIRECT_CACHE_TTL_S) * 1000UL;
+  slot->hops = hops;
+  slot->session = session;
+  strlcpy(slot->target, target.c_str(), sizeof(slot->target));
+  LOGD("REDIR", "%s -> %s (%u hops, %s)", url, slot->target, hops, session ? "session" : "permanent");
+}
+
+// Length of "scheme://host[:port]"
+static size_t originLen(const char* url) {
+  const char* p = strstr(url, "://");
+  if (!p) return 0;
+  p += 3;
+  while (*p && *p != '/' && *p != '?' && *p != '#') p++;
+  return p - url;
+}
+
+static uint32_t originKey(const String& url) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0, n = originLen(url.c_str()); i < n; i++) {
+    h = (h ^ (uint8_t)tolower(url[i])) * 16777619u;
+  }
+  return h;
+}
+
+// Location relative to base; empty if it cannot be resolved
+static String absolute(const String& base, const String& location) {
+  if (location.startsWith("http://") || location.startsWith("https://")) return location;
+  if (location.startsWith("//")) return base.substring(0, base.indexOf(':') + 1) + location;
+  if (location.startsWith("/")) return base.substring(0, originLen(base.c_str())) + location;
+  return String();   // document-relative: not used by the hosts we talk to
+}
+
+static bool isRedirect(int code) {
+  return code == HTTP_CODE_MOVED_PERMANENTLY || code == HTTP_CODE_FOUND ||
+         code == HTTP_CODE_SEE_OTHER || code == HTTP_CODE_TEMPORARY_REDIRECT ||
+         code == HTTP_CODE_PERMANENT_REDIRECT;
+}
+
+bool redirectAllowed(const char* url) {
+  return tlsTrustAllowsUrl(url, OTA_TLS_TRUST);
+}
+
+WiFiClient& redirectClient(const char* url, WiFiClient& tls) {
+  return strncasecmp(url, "http://", 7) == 0 ? plainClient : tls;
+}
+
+int redirectGet(HTTPClient& http, WiFiClient& tls, const char* url, bool session,
+                RedirectPrepare prepare, void* ctx) {
+  http.setFollowRedirects(HTTPC_DISABLE_FOLLOW_REDIRECTS);
+
+  RedirectEntry* hit = find(url);
+  String at = hit ? hit->target : url;
+  String permanentTarget;
+  uint8_t hops = 0;
+  uint8_t permanent = 0;   // leading 301/308 hops
+  int code;
+  for (;;) {
+    if (!redirectAllowed(at.c_str())) {
+      LOGE("REDIR", "%s: http:// refused, TLS authentication is on", at.c_str());
+      code = REDIRECT_ERROR_INSECURE;
+      break;
+    }
+    WiFiClient& client = redirectClient(at.c_str(), tls);
+    uint32_t& open = &client == &plainClient ? plainOrigin : tlsOrigin;
+    uint32_t origin = originKey(at);
+    if (open != origin && client.connected()) client.stop();   // HTTPClient would reuse it for any host
+    open = origin;
+    if (!http.begin(client, at)) {
+      LOGE("REDIR", "http.begin(%s) failed", at.c_str());
+      code = HTTPC_ERROR_CONNECTION_FAILED;
+      break;
+    }
+    if (prepare) prepare(http, ctx);
+    code = http.GET();
+    if (!isRedirect(code)) break;
+    if (hops == REDIRECT_MAX_HOPS) {
+      LOGW("REDIR", "%s: more than %u redirects", url, REDIRECT_MAX_HOPS);
+      break;
+    }
+    String next = absolute(at, http.getLocation());
+    if (!next.length()) {
+      LOGW("REDIR", "%s: unusable Location \"%s\"", at.c_str(), http.getLocation().c_str());
+      break;
+    }
+    http.end();
+    hops++;
+    if (permanent + 1 == hops &&
+        (code == HTTP_CODE_MOVED_PERMANENTLY || code == HTTP_CODE_PERMANENT_REDIRECT)) {
+      permanent = hops;
+      permanentTarget = next;
+    }
+    at = next;
+  }
+  stats.followed += hops;
+
+  bool failed = code < 0 || code >= 400 || isRedirect(code);
+  if (hit && failed) {
+    // stale target: forget it and go through the original URL once more
+    LOGW("REDIR", "%s: cached target failed (%d), dropped", url, code);
+    hit->key = 0;
+    if (code < 0) return code;   // network trouble, a retry would just wait again
+    http.end();
+    return redirectGet(http, tls, url, session, prepare, ctx);
+  }
+
+  // hops after a hit continue the chain from the cached target
+  uint8_t base = hit ? hit->hops : 0;
+  bool fromSession = hit && hit->session;
+  if (hit) {
+    stats.saved += base;
+    if (fromSession) hit->storedMs = millis();
+  }
+  if (!failed && session && hops > permanent) {
+    store(url, at, base + hops, true);
+  } else if (!failed && permanent && !fromSession) {
+    store(url, permanentTarget, base + permanent, false);
+  }
+  return code;
+}
+
+const char* redirectResolve(const char* url) {
+  RedirectEntry* hit = find(url);
+  if (!hit) return url;
+  stats.saved += hit->hops;
+  if (hit->session) hit->storedMs = millis();
+  return hit->target;
+}
+
+void redirectFailed(const char* url) {
+  RedirectEntry* hit = find(url);
+  if (!hit) return;
+  LOGW("REDIR", "%s: cached target failed, dropped", url);
+  hit->key = 0;
+}
+
+RedirectStats redirectTakeStats() {
+  RedirectStats s = stats;
+  stats = RedirectStats();
+  return s;
+}
@@ -0,0 +1,157 @@
+#include <Arduino.h>
+#include <eboot_command.h>
+
+#include "rollback.h"
+#include "flash_layout.h"
+#include "rtc_layout.h"
+#include "ota_journal.h"
+#include "log.h"
+#include "metrics.h"
+
+static_assert(sizeof(RollbackHeader) % 4 == 0, "flash access is word based");
+static_assert(sizeof(RollbackRtc) % 4 == 0, "RTC access is word based");
+
+static RollbackHeader header;   // copy of the flash header, read in rollbackBoot()
+
+static const size_t COPY_CHUNK = 512;   // divides FLASH_SECTOR_SIZE
+
+static void readRtc(RollbackRtc& rtc) {
+  ESP.rtcUserMemoryRead(RTC_BLOCK_ROLLBACK, reinterpret_cast<uint32_t*>(&rtc), sizeof(rtc));
+}
+
+static void writeRtc(const RollbackRtc& rtc) {
+  ESP.rtcUserMemoryWrite(RTC_BLOCK_ROLLBACK,
+                         reinterpret_cast<uint32_t*>(const_cast<RollbackRtc*>(&rtc)), sizeof(rtc));
+}
+
+// Clears bits of a header word in flash; programming only, no erase
+static bool programHeaderWord(size_t offset, uint32_t value) {
+  return ESP.flashWrite(BACKUP_HDR_ADDR + offset, &value, sizeof(value));
+}
+
+static uint32_t imageCrc(uint32_t addr, uint32_t size) {
+  uint32_t buf[COPY_CHUNK / 4];
+  uint32_t crc = 0;
+  for (uint32_t off = 0; off < size; off += COPY_CHUNK) {
+    uint32_t n = size - off < COPY_CHUNK ? size - off : COPY_CHUNK;
+    ESP.flashRead(addr + off, buf, COPY_CHUNK);
+    crc = rollbackCrc32(crc, buf, n);
+    if ((off & (FLASH_SECTOR_SIZE - 1)) == 0) yield();
+  }
+  return crc;
+}
+
+void rollbackBoot() {
+  ESP.flashRead(BACKUP_HDR_ADDR, reinterpret_cast<uint32_t*>(&header), sizeof(header));
+  RollbackRtc rtc;
+  readRtc(rtc);
+  RollbackAction action = rollbackDecide(header, rtc);
+  writeRtc(rtc);
+
+  if (action == ROLLBACK_NONE) return;
+  programHeaderWord(offsetof(RollbackHeader, bootMarks), rollbackBootMarks(rtc.boots));
+  if (action == ROLLBACK_TRIAL) {
+    LOGI("BOOT", "Trial %s: boot %u/%u", header.toVersion, rtc.boots, ROLLBACK_MAX_BOOTS);
+    return;
+  }
+
+  LOGE("BOOT", "%s not confirmed after %u boots, reverting to %s",
+       header.toVersion, rtc.boots - 1, header.fromVersion);
+  // Before anything else: a bad backup must not turn into a reboot loop
+  programHeaderWord(offsetof(RollbackHeader, reverted), ROLLBACK_SET);
+  header.reverted = ROLLBACK_SET;
+
+  if (header.size > BACKUP_MAX_SIZE || imageCrc(BACKUP_IMG_ADDR, header.size) != header.crc) {
+    LOGE("BOOT", "Backup corrupt, staying on %s", header.toVersion);
+    return;
+  }
+
+  journalVersionFailed(header.toVersion, JOURNAL_OTA_REVERTED);  // blacklists it
+
+  eboot_command cmd;
+  memset(&cmd, 0, sizeof(cmd));
+  cmd.action = ACTION_COPY_RAW;
+  cmd.args[0] = BACKUP_IMG_ADDR;
+  cmd.args[1] = 0x00000;
+  cmd.args[2] = header.size;
+  eboot_command_write(&cmd);
+
+  logFlush();
+  ESP.restart();
+}
+
+void rollbackMarkHealthy() {
+  if (!rollbackOnTrial(header)) return;
+  programHeaderWord(offsetof(RollbackHeader, confirmed), ROLLBACK_SET);
+  header.confirmed = ROLLBACK_SET;
+
+  RollbackRtc rtc;
+  readRtc(rtc);
+  LOGI("OTA", "%s confirmed after %u boot(s)", header.toVersion, rtc.boots);
+  rtc.boots = 0;
+  writeRtc(rtc);
+}
+
+bool rollbackPending() {
+  return rollbackOnTrial(header);
+}
+
+static bool copySketch(uint32_t size) {
+  uint32_t buf[COPY_CHUNK / 4];
+  uint32_t sectorStart = 0;
+  for (uint32_t off = 0; off < size; off += COPY_CHUNK) {
+    if ((off & (FLASH_SECTOR_SIZE - 1)) == 0) {
+      if (off) metricsObserve(HIST_FLASH_SECTOR_MS, millis() - sectorStart);
+      yield();
+      sectorStart = millis();
+      if (!ESP.flashEraseSector((BACKUP_IMG_ADDR + off) / FLASH_SECTOR_SIZE)) return false;
+    }
+    if (!ESP.flashRead(off, buf, COPY_CHUNK) ||
+        !ESP.flashWrite(BACKUP_IMG_ADDR + off, buf, COPY_CHUNK)) return false;
+  }
+  // a partial last sector would skew the per-sector time
+  if (size && (size & (FLASH_SECTOR_SIZE - 1)) == 0) metricsObserve(HIST_FLASH_SECTOR_MS, millis() - sectorStart);
+  return true;
+}
+
+bool rollbackPrepare(const char* fromVersion, const char* toVersion) {
+  uint32_t size = ESP.getSketchSize();
+  if (size > BACKUP_MAX_SIZE) {
+    LOGE("OTA", "Sketch %u > backup slot %u", size, (unsigned)BACKUP_MAX_SIZE);
+    eboot_command_clear();
+    return false;
+  }
+
+  uint32_t crc = imageCrc(0, size);
+  // Slot already holds this image (e.g. after a reverted trial): skip the erase
+  bool current = header.magic == ROLLBACK_MAGIC && header.size == size && header.crc == crc &&
+                 imageCrc(BACKUP_IMG_ADDR, size) == crc;
+  if (!current) {
+    LOGI("OTA", "Backing up %u bytes...", size);
+    if (!copySketch(size) || imageCrc(BACKUP_IMG_ADDR, size) != crc) {
+      LOGE("OTA", "Backup failed, update discarded");
+      eboot_command_clear();
+      return false;
+    }
+  }
+
+  RollbackHeader h;
+  memset(&h, 0xFF, sizeof(h));
+  h.magic = ROLLBACK_MAGIC;
+  h.size = size;
+  h.crc = crc;
+  strlcpy(h.fromVersion, fromVersion, sizeof(h.fromVersion));
+  strlcpy(h.toVersion, toVersion, sizeof(h.toVersion));
+
+  if (!ESP.flashEraseSector(BACKUP_HDR_ADDR / FLASH_SECTOR_SIZE) ||
+      !ESP.flashWrite(BACKUP_HDR_ADDR, reinterpret_cast<uint32_t*>(&h), sizeof(h))) {
+    LOGE("OTA", "Backup header write failed, update discarded");
+    eboot_command_clear();
+    return false;
+  }
+  header = h;
+
+  RollbackRtc rtc = { ROLLBACK_MAGIC, 0 };
+  writeRtc(rtc);
+  return true;
+}
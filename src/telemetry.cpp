@@ -0,0 +1,128 @@
+#include "telemetry.h"
+
+static TelemetrySample ring[TELEMETRY_RING_SIZE];
+static uint8_t ringHead = 0;      // next write slot
+static uint8_t ringCount = 0;
+
+static TelemetryLowWater lowWater[PHASE_COUNT];
+static TelemetryPhase currentPhase = PHASE_BOOT;
+
+static uint32_t lastSample = 0;
+static uint32_t lastLoop = 0;
+static uint16_t loopMaxMs = 0;    // longest iteration since last sample
+
+static const char* const PHASE_NAMES[PHASE_COUNT] = {
+  "boot", "portal", "idle", "manifest", "tls", "flash"
+};
+
+static void resetLowWater(TelemetryLowWater& lw) {
+  lw.minFreeHeap = UINT32_MAX;
+  lw.minMaxBlock = UINT32_MAX;
+  lw.minStackFree = UINT32_MAX;
+  lw.maxLoopMs = 0;
+  lw.maxFrag = 0;
+  lw.samples = 0;
+}
+
+void telemetryBegin() {
+  for (uint8_t i = 0; i < PHASE_COUNT; i++) resetLowWater(lowWater[i]);
+  ringHead = 0;
+  ringCount = 0;
+  currentPhase = PHASE_BOOT;
+  lastLoop = millis();
+  telemetrySample();
+}
+
+void telemetryPhase(TelemetryPhase phase) {
+  if (phase >= PHASE_COUNT) return;
+  currentPhase = phase;
+  telemetrySample();
+}
+
+TelemetryPhase telemetryCurrentPhase() {
+  return currentPhase;
+}
+
+void telemetrySample() {
+  uint32_t freeHeap;
+  uint32_t maxBlock;
+  uint8_t frag;
+  ESP.getHeapStats(&freeHeap, &maxBlock, &frag);
+  uint32_t stackFree = ESP.getFreeContStack();
+
+  TelemetrySample& s = ring[ringHead];
+  s.ms = millis();
+  s.freeHeap = freeHeap;
+  s.maxBlock = (uint16_t)min<uint32_t>(maxBlock, UINT16_MAX);
+  s.stackFree = (uint16_t)min<uint32_t>(stackFree, UINT16_MAX);
+  s.loopMs = loopMaxMs;
+  s.frag = frag;
+  s.phase = currentPhase;
+  ringHead = (ringHead + 1) % TELEMETRY_RING_SIZE;
+  if (ringCount < TELEMETRY_RING_SIZE) ringCount++;
+
+  TelemetryLowWater& lw = lowWater[currentPhase];
+  if (freeHeap < lw.minFreeHeap) lw.minFreeHeap = freeHeap;
+  if (maxBlock < lw.minMaxBlock) lw.minMaxBlock = maxBlock;
+  if (stackFree < lw.minStackFree) lw.minStackFree = stackFree;
+  if (loopMaxMs > lw.maxLoopMs) lw.maxLoopMs = loopMaxMs;
+  if (frag > lw.maxFrag) lw.maxFrag = frag;
+  lw.samples++;
+
+  lastSample = s.ms;
+  loopMaxMs = 0;
+}
+
+void telemetryLoop() {
+  uint32_t now = millis();
+  uint32_t dt = now - lastLoop;
+  lastLoop = now;
+  if (dt > loopMaxMs) loopMaxMs = (uint16_t)min<uint32_t>(dt, UINT16_MAX);
+
+  if ((now - lastSample) >= TELEMETRY_SAMPLE_MS) {
+    telemetrySample();
+  }
+}
+
+const TelemetryLowWater& telemetryLowWater(TelemetryPhase phase) {
+  return lowWater[phase < PHASE_COUNT ? phase : PHASE_IDLE];
+}
+
+const char* telemetryPhaseName(TelemetryPhase phase) {
+  return phase < PHASE_COUNT ? PHASE_NAMES[phase] : "?";
+}
+
+void telemetryPrint(Print& out) {
+  out.printf("[MEM] phase=%s uptime=%lus\n", telemetryPhaseName(currentPhase), (unsigned long)(millis() / 1000));
+  out.println(F("[MEM] phase     samples minHeap minBlock maxFrag minStack maxLoop"));
+  for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+    const TelemetryLowWater& lw = lowWater[i];
+    if (!lw.samples) continue;
+    out.printf("[MEM] %-9s %7u %7u %8u %6u%% %8u %5ums\n",
+               PHASE_NAMES[i], lw.samples, lw.minFreeHeap, lw.minMaxBlock,
+               lw.maxFrag, lw.minStackFree, lw.maxLoopMs);
+  }
+}
+
+void telemetryWriteJson(Print& out) {
+  out.printf("{\"uptime\":%lu,\"phase\":\"%s\",\"phases\":{",
+             (unsigned long)millis(), telemetryPhaseName(currentPhase));
+  bool first = true;
+  for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+    const TelemetryLowWater& lw = lowWater[i];
+    if (!lw.samples) continue;
+    out.printf("%s\"%s\":{\"samples\":%u,\"min_heap\":%u,\"min_block\":%u,\"max_frag\":%u,\"min_stack\":%u,\"max_loop_ms\":%u}",
+               first ? "" : ",", PHASE_NAMES[i], lw.samples, lw.minFreeHeap,
+               lw.minMaxBlock, lw.maxFrag, lw.minStackFree, lw.maxLoopMs);
+    first = false;
+  }
+  out.print(F("},\"samples\":["));
+  // oldest first
+  uint8_t start = (ringHead + TELEMETRY_RING_SIZE - ringCount) % TELEMETRY_RING_SIZE;
+  for (uint8_t n = 0; n < ringCount; n++) {
+    const TelemetrySample& s = ring[(start + n) % TELEMETRY_RING_SIZE];
+    out.printf("%s[%u,%u,%u,%u,%u,%u,%u]", n ? "," : "",
+               s.ms, s.freeHeap, s.maxBlock, s.frag, s.stackFree, s.loopMs, s.phase);
+  }
+  out.print(F("]}"));
+}
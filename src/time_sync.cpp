@@ -0,0 +1,88 @@
+#include "time_sync.h"
+#include "rtc_layout.h"
+#include "log.h"
+
+#include <coredecls.h>
+#include <sys/time.h>
+#include <time.h>
+#include <user_interface.h>
+
+static_assert(sizeof(TimeRtc) % 4 == 0, "RTC access is word based");
+
+static TimeState state = TIME_NONE;
+static volatile bool syncPending = false;   // set in the SNTP callback
+static uint32_t syncMs = 0;                 // millis() at the first sync, 0 = not yet
+static uint32_t syncCount = 0;
+static uint32_t lastSaveMs = 0;
+
+static void (*listeners[TIME_MAX_LISTENERS])();
+static uint8_t listenerCount = 0;
+
+static void onTimeSet(bool fromSntp) {
+  if (!fromSntp) return;   // our own settimeofday() in timeBegin()
+  if (!syncMs) syncMs = millis();
+  syncPending = true;
+}
+
+void timeBegin() {
+  settimeofday_cb(onTimeSet);
+  TimeRtc rec;
+  ESP.rtcUserMemoryRead(RTC_BLOCK_TIME, reinterpret_cast<uint32_t*>(&rec), sizeof(rec));
+  uint32_t now = timeRestoreS(rec, system_get_rtc_time());
+  if (!now) return;
+  struct timeval tv = { (time_t)now, 0 };
+  settimeofday(&tv, nullptr);
+  state = TIME_RESTORED;
+  LOGI("TIME", "Restored from RTC memory: %u", now);
+}
+
+void timeStartSync() {
+  configTime(0, 0, TIME_NTP_SERVERS);
+}
+
+void timeSave() {
+  if (!timeValid()) return;
+  TimeRtc rec = { TIME_MAGIC, (uint32_t)time(nullptr), system_get_rtc_time(), system_rtc_clock_cali_proc() };
+  ESP.rtcUserMemoryWrite(RTC_BLOCK_TIME, reinterpret_cast<uint32_t*>(&rec), sizeof(rec));
+  lastSaveMs = millis();
+}
+
+void timeLoop() {
+  if (syncPending) {
+    syncPending = false;
+    syncCount++;
+    if (state != TIME_SYNCED) LOGI("TIME", "SNTP sync after %u ms", syncMs);
+    state = TIME_SYNCED;
+    timeSave();
+    for (uint8_t i = 0; i < listenerCount; i++) listeners[i]();
+  }
+  if (timeValid() && millis() - lastSaveMs >= TIME_SAVE_INTERVAL_MS) timeSave();
+}
+
+bool timeValid() {
+  return state != TIME_NONE;
+}
+
+TimeState timeState() {
+  return state;
+}
+
+const char* timeStateName() {
+  switch (state) {
+    case TIME_RESTORED: return "restored";
+    case TIME_SYNCED: return "synced";
+    default: return "none";
+  }
+}
+
+void timeOnSync(void (*fn)()) {
+  if (listenerCount >= TIME_MAX_LISTENERS || !fn) return;
+  listeners[listenerCount++] = fn;
+}
+
+void timeWriteText(Print& out) {
+  out.printf("# TYPE ota_time_state gauge\nota_time_state{state=\"%s\"} 1\n"
+             "# TYPE ota_time_syncs_total counter\nota_time_syncs_total %u\n",
+             timeStateName(), syncCount);
+  if (syncMs) out.printf("# TYPE ota_time_sync_ms gauge\nota_time_sync_ms %u\n", syncMs);
+}
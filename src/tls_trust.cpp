@@ -0,0 +1,110 @@
+#include <Arduino.h>
+#include <time.h>
+
+#include "tls_trust.h"
+#include "log.h"
+#include "ota_arena.h"
+#include "time_sync.h"
+
+#if OTA_TLS_TRUST != TLS_TRUST_INSECURE
+#if !__has_include(OTA_TLS_TRUST_FILE)
+#error "OTA_TLS_TRUST needs OTA_TLS_TRUST_FILE: generate it with tools/tls_pins"
+#endif
+#include OTA_TLS_TRUST_FILE
+#endif
+
+static uint32_t handshakeErrors = 0;
+
+#if OTA_TLS_TRUST == TLS_TRUST_KEY
+static ArenaSlot<BearSSL::PublicKey> key;
+
+// Pin n of host, nullptr past the last
+static const char* pinOf(const char* host, uint8_t n) {
+  for (const TlsPin& p : TLS_PINS) {
+    if (strcasecmp(p.host, host) == 0 && n-- == 0) return p.keyPem;
+  }
+  return nullptr;
+}
+#elif OTA_TLS_TRUST == TLS_TRUST_ANCHORS
+static ArenaSlot<BearSSL::X509List> anchors;
+
+static time_t checkTime() {
+  return tlsCheckTime(timeValid() ? time(nullptr) : 0, FW_BUILD_EPOCH, OTA_TLS_CLOCK_POLICY);
+}
+#endif
+
+uint8_t tlsTrustAttempts(const char* host) {
+#if OTA_TLS_TRUST == TLS_TRUST_KEY
+  uint8_t n = 0;
+  while (pinOf(host, n)) n++;
+  if (!n) LOGE("TLS", "%s: no pinned key, not connecting", host);
+  return n;
+#else
+  (void)host;
+  return 1;
+#endif
+}
+
+bool tlsTrustApply(BearSSL::WiFiClientSecure& client, const char* host, uint8_t attempt) {
+#if OTA_TLS_TRUST == TLS_TRUST_KEY
+  const char* pem = pinOf(host, attempt);
+  if (!pem) return false;
+  key.emplace(pem);
+  if (!key->isRSA() && !key->isEC()) {
+    LOGE("TLS", "%s: pinned key %u does not parse", host, attempt);
+    return false;
+  }
+  client.setKnownKey(key.get());
+  return true;
+#elif OTA_TLS_TRUST == TLS_TRUST_ANCHORS
+  (void)attempt;
+  time_t t = checkTime();
+  if (!t) {
+    LOGW("TLS", "%s: no valid time, not connecting", host);
+    return false;
+  }
+  if (!anchors) {
+    anchors.emplace(TLS_ANCHORS);
+    LOGI("TLS", "%u trust anchors loaded", (unsigned)anchors->getCount());
+  }
+  client.setTrustAnchors(anchors.get());
+  client.setX509Time(t);
+  return true;
+#else
+  (void)host;
+  (void)attempt;
+  client.setInsecure();
+  return true;
+#endif
+}
+
+bool tlsTrustFailed(BearSSL::WiFiClientSecure& client, const char* host, uint8_t attempt) {
+  char msg[64];
+  int err = client.getLastSSLError(msg, sizeof(msg));
+  if (!err) return false;
+  handshakeErrors++;
+  LOGW("TLS", "%s: handshake failed (%s, attempt %u): %d %s", host, tlsTrustModeName(), attempt, err, msg);
+  return true;
+}
+
+bool tlsTrustReady() {
+#if OTA_TLS_TRUST == TLS_TRUST_ANCHORS
+  return checkTime() != 0;
+#else
+  return true;
+#endif
+}
+
+const char* tlsTrustModeName() {
+  switch (OTA_TLS_TRUST) {
+    case TLS_TRUST_KEY: return "key";
+    case TLS_TRUST_ANCHORS: return "anchors";
+    default: return "insecure";
+  }
+}
+
+void tlsTrustWriteText(Print& out) {
+  out.printf("# TYPE ota_tls_trust gauge\nota_tls_trust{mode=\"%s\"} 1\n"
+             "# TYPE ota_tls_handshake_errors_total counter\nota_tls_handshake_errors_total %u\n",
+             tlsTrustModeName(), handshakeErrors);
+}
@@ -0,0 +1,175 @@
+// Host simulation of the boot-time OTA reserve (include/ota_arena.h) on a
+// umm-like heap model: 8-byte blocks, 4-byte header per allocation, best
+// fit, coalescing on free.
+//
+//   g++ -std=c++17 -O2 tools/arena_sim/arena_sim.cpp -o arena_sim && ./arena_sim [heap_boot ...]
+//
+// For each heap_boot (bytes left after .data/.rodata/.bss, what
+// scripts/size_report.py checks against custom_budget_heap) it prints the
+// memory budget of the idle device: free heap in setup(), the reserve, what
+// the application has left beside it, and whether a warm manifest
+// connection can stay open (MANIFEST_KEEPALIVE_MIN_HEAP). Then it runs app
+// churn (web requests, Strings, pbufs with some survivors) and the
+// manifest-phase TLS allocations, with and without the reserve, over many
+// seeds: how often the TLS sequence still fits and the average largest
+// free block when it starts.
+//
+// Exit code 1 if custom_budget_heap (first argument, default below) leaves
+// the application less than MANIFEST_KEEPALIVE_MIN_HEAP while the reserve
+// or a warm connection is held.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+// include/preflight.h (core 3.x BearSSL) and src/main.cpp
+const size_t TLS_IN_OVERHEAD = 325;
+const size_t TLS_OUT_OVERHEAD = 85;
+const size_t TLS_CONTEXT = 4000;
+const size_t TLS_STACK = 6200;
+const size_t ALLOC_OVERHEAD = 8;
+const size_t PREFLIGHT_MARGIN = 3072;
+const size_t MANIFEST_TLS_RX = 16384;
+const size_t MANIFEST_TLS_TX = 512;
+const size_t MANIFEST_KEEPALIVE_MIN_HEAP = 12288;
+
+// Allocated by the SDK, lwIP and the Wi-Fi stack before setup() runs, the
+// estimate behind custom_budget_heap; on a device it is heap_boot from the
+// size report minus the free heap that setup() logs
+const size_t SDK_WIFI_HEAP = 9216;
+
+const size_t CUSTOM_BUDGET_HEAP = 49152;   // platformio.ini
+
+const size_t TLS_ALLOCS[] = { TLS_STACK, TLS_CONTEXT, MANIFEST_TLS_RX + TLS_IN_OVERHEAD,
+                              MANIFEST_TLS_TX + TLS_OUT_OVERHEAD };
+
+// OTA_ARENA_RESERVE: PreflightPlan().tls(rx, tx).heap - PREFLIGHT_MARGIN
+size_t reserveBytes() {
+  size_t total = 0;
+  for (size_t a : TLS_ALLOCS) total += a + ALLOC_OVERHEAD;
+  return total;
+}
+
+struct Heap {
+  std::map<size_t, size_t> freeList;   // start block -> length in blocks
+  std::map<size_t, size_t> used;
+
+  explicit Heap(size_t bytes) { freeList[0] = bytes / 8; }
+
+  long alloc(size_t bytes) {
+    size_t n = (bytes + 4 + 7) / 8;
+    auto pick = freeList.end();
+    for (auto it = freeList.begin(); it != freeList.end(); ++it) {
+      if (it->second >= n && (pick == freeList.end() || it->second < pick->second)) pick = it;
+    }
+    if (pick == freeList.end()) return -1;
+    size_t start = pick->first, len = pick->second;
+    freeList.erase(pick);
+    if (len > n) freeList[start + n] = len - n;
+    used[start] = n;
+    return (long)start;
+  }
+
+  void release(long p) {
+    if (p < 0) return;
+    auto u = used.find(p);
+    size_t start = p, n = u->second;
+    used.erase(u);
+    auto next = freeList.find(start + n);
+    if (next != freeList.end()) {
+      n += next->second;
+      freeList.erase(next);
+    }
+    auto prev = freeList.lower_bound(start);
+    if (prev != freeList.begin()) {
+      --prev;
+      if (prev->first + prev->second == start) {
+        start = prev->first;
+        n += prev->second;
+        freeList.erase(prev);
+      }
+    }
+    freeList[start] = n;
+  }
+
+  size_t maxBlock() const {
+    size_t m = 0;
+    for (const auto& f : freeList) m = std::max(m, f.second);
+    return m ? m * 8 - 4 : 0;
+  }
+};
+
+struct Outcome {
+  bool tlsFits;
+  size_t maxBlock;
+};
+
+Outcome run(size_t heapBytes, bool reserve, unsigned seed) {
+  std::mt19937 rng(seed);
+  Heap heap(heapBytes);
+  long block = reserve ? heap.alloc(reserveBytes()) : -1;
+  std::vector<long> live;
+  for (int step = 0; step < 4000; step++) {
+    if (!live.empty() && rng() % 100 < 48) {
+      size_t i = rng() % live.size();
+      heap.release(live[i]);
+      live[i] = live.back();
+      live.pop_back();
+    } else {
+      long p = heap.alloc(16 + rng() % (rng() % 8 == 0 ? 1400 : 200));
+      if (p >= 0) live.push_back(p);
+    }
+    if (live.size() > 60) {
+      heap.release(live.front());
+      live.erase(live.begin());
+    }
+  }
+  heap.release(block);
+  Outcome out = { true, heap.maxBlock() };
+  for (size_t a : TLS_ALLOCS) out.tlsFits &= heap.alloc(a) >= 0;
+  return out;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<size_t> budgets;
+  for (int i = 1; i < argc; i++) budgets.push_back(strtoul(argv[i], nullptr, 0));
+  if (budgets.empty()) budgets = { CUSTOM_BUDGET_HEAP, 40960, 53248 };
+
+  const size_t reserve = reserveBytes();
+  const int runs = 2000;
+  printf("reserve %zu, manifest TLS plan %zu, keep-alive floor %zu, SDK/Wi-Fi %zu\n\n", reserve,
+         reserve + PREFLIGHT_MARGIN, MANIFEST_KEEPALIVE_MIN_HEAP, SDK_WIFI_HEAP);
+  printf("%9s %9s %9s %9s %13s %13s %13s\n", "heap_boot", "setup", "app", "warm", "fits none",
+         "fits reserve", "block reserve");
+  bool failed = false;
+  for (size_t heapBoot : budgets) {
+    long setup = (long)heapBoot - (long)SDK_WIFI_HEAP;
+    long app = setup - (long)reserve;   // idle: reserve held, or the warm connection in its place
+    bool warm = app >= (long)MANIFEST_KEEPALIVE_MIN_HEAP;
+    int fits[2] = { 0, 0 };
+    double block = 0;
+    for (int mode = 0; mode < 2 && setup > 0; mode++) {
+      for (int seed = 0; seed < runs; seed++) {
+        Outcome o = run(setup, mode == 1, seed);
+        fits[mode] += o.tlsFits;
+        if (mode == 1) block += o.maxBlock;
+      }
+    }
+    printf("%9zu %9ld %9ld %9s %8d/%d %8d/%d %13.0f\n", heapBoot, setup, app, warm ? "yes" : "no",
+           fits[0], runs, fits[1], runs, block / runs);
+    if (heapBoot == budgets.front() && !warm) failed = true;
+  }
+  if (failed) {
+    fprintf(stderr, "arena_sim: heap_boot %zu leaves the application less than %zu bytes\n",
+            budgets.front(), MANIFEST_KEEPALIVE_MIN_HEAP);
+    return 1;
+  }
+  return 0;
+}
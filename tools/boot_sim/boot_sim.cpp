@@ -0,0 +1,291 @@
+// Host simulation of the boot/rollback state machine (include/rollback.h).
+//
+// Models NOR flash (program clears bits, erase sets a sector to 0xFF), RTC
+// user memory (kept across resets, garbage after power-off), eboot's copy
+// command and the device-side steps of src/rollback.cpp, then runs update
+// scenarios and checks which image ends up running.
+//
+//   g++ -std=c++17 -O2 -Iinclude tools/boot_sim/boot_sim.cpp -o boot_sim && ./boot_sim
+//
+// Exit code 1 if any scenario ends on the wrong image.
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "flash_layout.h"
+#include "rollback.h"
+
+namespace {
+
+const uint32_t FLASH_SIZE = 0x400000;
+const uint32_t IMAGE_SIZE = 300 * 1024;
+
+enum Behaviour { RUNS_OK, CRASHES_IN_SETUP, NO_WIFI };
+
+struct Image {
+  std::string version;
+  Behaviour behaviour;
+};
+
+struct Device {
+  std::vector<uint8_t> flash = std::vector<uint8_t>(FLASH_SIZE, 0xFF);
+  std::vector<Image> images;     // image id -> behaviour, id is stored in the image
+  std::mt19937 rng{1};
+
+  // RTC user memory
+  bool rtcValid = false;
+  RollbackRtc rtc{};
+  bool ebootPending = false;
+  uint32_t ebootSrc = 0, ebootDst = 0, ebootSize = 0;
+
+  unsigned boots = 0, erases = 0;
+
+  // --- flash ---
+  void erase(uint32_t sector) {
+    memset(&flash[sector * FLASH_SECTOR_SIZE], 0xFF, FLASH_SECTOR_SIZE);
+    erases++;
+  }
+  void program(uint32_t addr, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < len; i++) flash[addr + i] &= p[i];
+  }
+  void read(uint32_t addr, void* data, size_t len) const { memcpy(data, &flash[addr], len); }
+  uint32_t crc(uint32_t addr, uint32_t size) const { return rollbackCrc32(0, &flash[addr], size); }
+  void copy(uint32_t src, uint32_t dst, uint32_t size) {
+    for (uint32_t off = 0; off < size; off += FLASH_SECTOR_SIZE) {
+      erase((dst + off) / FLASH_SECTOR_SIZE);
+      uint32_t n = size - off < FLASH_SECTOR_SIZE ? size - off : FLASH_SECTOR_SIZE;
+      std::vector<uint8_t> buf(n);
+      read(src + off, buf.data(), n);
+      program(dst + off, buf.data(), n);
+    }
+  }
+
+  // --- images ---
+  uint32_t addImage(const std::string& version, Behaviour b) {
+    images.push_back({version, b});
+    return images.size() - 1;
+  }
+  void writeImage(uint32_t addr, uint32_t id) {
+    for (uint32_t off = 0; off < IMAGE_SIZE; off += FLASH_SECTOR_SIZE) erase((addr + off) / FLASH_SECTOR_SIZE);
+    std::vector<uint8_t> img(IMAGE_SIZE);
+    std::mt19937 gen(id + 100);
+    for (auto& b : img) b = gen();
+    memcpy(img.data(), &id, sizeof(id));
+    program(addr, img.data(), img.size());
+  }
+  const Image& running() const {
+    uint32_t id;
+    read(0, &id, sizeof(id));
+    return images.at(id);
+  }
+
+  // --- events ---
+  void powerCycle() {
+    rtcValid = false;
+    memset(&rtc, 0, sizeof(rtc));
+    rtc.magic = rng();   // RTC memory is random after power-on
+    ebootPending = false;
+  }
+
+  // Updater + rollbackPrepare() at HTTP_UPDATE_OK: stage below FS, which
+  // sets eboot's copy command, then back up the sketch right away. Any
+  // reset after this (planned restart or not) installs the image on trial.
+  // backupFails: rollbackPrepare() returns false and clears the command
+  bool update(uint32_t id, bool backupFails = false) {
+    uint32_t staging = (FS_PHYS_ADDR - IMAGE_SIZE) & ~(FLASH_SECTOR_SIZE - 1);
+    writeImage(staging, id);
+    ebootPending = true;
+    ebootSrc = staging; ebootDst = 0; ebootSize = IMAGE_SIZE;
+    if (backupFails) {
+      ebootPending = false;
+      return false;
+    }
+
+    RollbackHeader hdr;
+    read(BACKUP_HDR_ADDR, &hdr, sizeof(hdr));
+    uint32_t sketchCrc = crc(0, IMAGE_SIZE);
+    bool current = hdr.magic == ROLLBACK_MAGIC && hdr.size == IMAGE_SIZE && hdr.crc == sketchCrc &&
+                   crc(BACKUP_IMG_ADDR, IMAGE_SIZE) == sketchCrc;
+    if (!current) copy(0, BACKUP_IMG_ADDR, IMAGE_SIZE);
+
+    RollbackHeader h;
+    memset(&h, 0xFF, sizeof(h));
+    h.magic = ROLLBACK_MAGIC;
+    h.size = IMAGE_SIZE;
+    h.crc = sketchCrc;
+    snprintf(h.fromVersion, sizeof(h.fromVersion), "%s", running().version.c_str());
+    snprintf(h.toVersion, sizeof(h.toVersion), "%s", images[id].version.c_str());
+    erase(BACKUP_HDR_ADDR / FLASH_SECTOR_SIZE);
+    program(BACKUP_HDR_ADDR, &h, sizeof(h));
+    rtc = { ROLLBACK_MAGIC, 0 };
+    rtcValid = true;
+    return true;
+  }
+
+  // eboot, then setup() of the image at 0x0 up to the first manifest check.
+  // Returns true if the image confirmed itself.
+  bool boot() {
+    boots++;
+    if (ebootPending) {
+      copy(ebootSrc, ebootDst, ebootSize);
+      ebootPending = false;
+    }
+
+    // rollbackBoot()
+    RollbackHeader hdr;
+    read(BACKUP_HDR_ADDR, &hdr, sizeof(hdr));
+    RollbackAction action = rollbackDecide(hdr, rtc);
+    rtcValid = true;
+    if (action != ROLLBACK_NONE) {
+      uint32_t marks = rollbackBootMarks(rtc.boots);
+      program(BACKUP_HDR_ADDR + offsetof(RollbackHeader, bootMarks), &marks, sizeof(marks));
+    }
+    if (action == ROLLBACK_REVERT) {
+      uint32_t set = ROLLBACK_SET;
+      program(BACKUP_HDR_ADDR + offsetof(RollbackHeader, reverted), &set, sizeof(set));
+      if (hdr.size <= BACKUP_MAX_SIZE && crc(BACKUP_IMG_ADDR, hdr.size) == hdr.crc) {
+        ebootPending = true;
+        ebootSrc = BACKUP_IMG_ADDR; ebootDst = 0; ebootSize = hdr.size;
+        return boot();   // ESP.restart()
+      }
+    }
+
+    switch (running().behaviour) {
+      case CRASHES_IN_SETUP:
+      case NO_WIFI:
+        return false;    // exception / restart after the portal timeout
+      case RUNS_OK:
+        break;
+    }
+    // rollbackMarkHealthy()
+    if (rollbackOnTrial(hdr) || action == ROLLBACK_TRIAL) {
+      read(BACKUP_HDR_ADDR, &hdr, sizeof(hdr));
+      if (rollbackOnTrial(hdr)) {
+        uint32_t set = ROLLBACK_SET;
+        program(BACKUP_HDR_ADDR + offsetof(RollbackHeader, confirmed), &set, sizeof(set));
+        rtc.boots = 0;
+      }
+    }
+    return true;
+  }
+
+  // Boots until the running image confirms itself or maxBoots is reached
+  void bootUntilStable(unsigned maxBoots, unsigned powerCycleEvery = 0) {
+    for (unsigned i = 0; i < maxBoots; i++) {
+      if (powerCycleEvery && i && i % powerCycleEvery == 0) powerCycle();
+      if (boot()) return;
+    }
+  }
+};
+
+struct Result {
+  const char* name;
+  std::string expected;
+  std::string actual;
+  unsigned boots;
+  unsigned erases;
+};
+
+std::vector<Result> results;
+
+void report(const char* name, Device& d, const std::string& expected) {
+  results.push_back({name, expected, d.running().version, d.boots, d.erases});
+}
+
+Device fresh(uint32_t& v1) {
+  Device d;
+  v1 = d.addImage("v1", RUNS_OK);
+  d.writeImage(0, v1);
+  d.powerCycle();
+  d.bootUntilStable(1);
+  d.boots = d.erases = 0;
+  return d;
+}
+
+}  // namespace
+
+int main() {
+  uint32_t v1;
+
+  {
+    Device d = fresh(v1);
+    uint32_t v2 = d.addImage("v2", RUNS_OK);
+    d.update(v2);
+    d.bootUntilStable(10);
+    report("good update", d, "v2");
+  }
+  {
+    Device d = fresh(v1);
+    uint32_t v2 = d.addImage("v2-crash", CRASHES_IN_SETUP);
+    d.update(v2);
+    d.bootUntilStable(10);
+    report("crash in setup", d, "v1");
+  }
+  {
+    Device d = fresh(v1);
+    uint32_t v2 = d.addImage("v2-crash", CRASHES_IN_SETUP);
+    d.update(v2);
+    d.bootUntilStable(20, 2);   // power cut after every second boot
+    report("crash + power cuts", d, "v1");
+  }
+  {
+    Device d = fresh(v1);
+    uint32_t v2 = d.addImage("v2-nowifi", NO_WIFI);
+    d.update(v2);
+    d.bootUntilStable(10);
+    report("no wifi on trial", d, "v1");
+  }
+  {
+    Device d = fresh(v1);
+    uint32_t v2 = d.addImage("v2-crash", CRASHES_IN_SETUP);
+    d.update(v2);
+    d.flash[BACKUP_IMG_ADDR + 1000] ^= 0x01;   // backup bit rot
+    d.bootUntilStable(10);
+    bool noLoop = d.boots == ROLLBACK_MAX_BOOTS + 1 + 6;   // reverted flag stops counting
+    report("corrupt backup", d, noLoop ? "v2-crash" : "(boot loop)");
+  }
+  {
+    Device d = fresh(v1);
+    uint32_t v2 = d.addImage("v2-crash", CRASHES_IN_SETUP);
+    uint32_t v3 = d.addImage("v3", RUNS_OK);
+    d.update(v2);
+    d.bootUntilStable(10);
+    unsigned before = d.erases;
+    d.update(v3);   // backup slot already holds v1: no backup erase
+    unsigned backupErases = d.erases - before;
+    d.bootUntilStable(10);
+    report("revert then update", d, backupErases <= IMAGE_SIZE / FLASH_SECTOR_SIZE + 1 ? "v3" : "(re-backup)");
+  }
+  {
+    Device d = fresh(v1);
+    uint32_t v2 = d.addImage("v2", RUNS_OK);
+    uint32_t v3 = d.addImage("v3-crash", CRASHES_IN_SETUP);
+    d.update(v2);
+    d.bootUntilStable(10);
+    d.update(v3);
+    d.bootUntilStable(10);
+    report("revert to previous update", d, "v2");
+  }
+  {
+    Device d = fresh(v1);
+    uint32_t v2 = d.addImage("v2-crash", CRASHES_IN_SETUP);
+    d.update(v2, true);
+    d.bootUntilStable(10);   // WDT reset while the reboot waits for its window
+    report("backup failed, then reset", d, "v1");
+  }
+
+  int failed = 0;
+  printf("%-28s %-10s %-10s %6s %7s\n", "scenario", "expected", "running", "boots", "erases");
+  for (const Result& r : results) {
+    bool ok = r.expected == r.actual;
+    failed += !ok;
+    printf("%-28s %-10s %-10s %6u %7u %s\n", r.name, r.expected.c_str(), r.actual.c_str(),
+           r.boots, r.erases, ok ? "" : "FAIL");
+  }
+  return failed ? 1 : 0;
+}
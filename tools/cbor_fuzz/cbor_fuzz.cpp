@@ -0,0 +1,161 @@
+// Robustness test of the CBOR manifest decoder (include/manifest.h) under
+// AddressSanitizer: every truncation of a real manifest.cbor, random byte
+// mutations of it, and hand-made inputs for the cases the decoder has to
+// refuse or skip (unknown keys and nested values, nesting deeper than
+// MANIFEST_CBOR_MAX_DEPTH, indefinite lengths, oversized strings and
+// counts).
+//
+//   g++ -std=c++17 -O1 -g -fsanitize=address,undefined -fno-sanitize-recover=all -Iinclude tools/cbor_fuzz/cbor_fuzz.cpp -o cbor_fuzz
+//   ./cbor_fuzz public/manifest.cbor [mutations] [seed]
+//
+// Beside a sanitizer report, a run fails (exit 1) if a truncated input
+// decodes, a decoded field is not terminated inside its buffer, or one of
+// the hand-made cases gives another result than the expected one.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+
+#include "manifest.h"
+
+namespace {
+
+// Copies what it hands out, so ASan sees reads past the input as such
+class Reader {
+public:
+  explicit Reader(const std::string& s) : s_(s) {}
+
+  size_t readBytes(char* out, size_t n) {
+    n = std::min(n, s_.size() - at_);
+    memcpy(out, s_.data() + at_, n);
+    at_ += n;
+    return n;
+  }
+
+  size_t consumed() const { return at_; }
+
+private:
+  const std::string& s_;
+  size_t at_ = 0;
+};
+
+int failures = 0;
+
+void fail(const char* what, const std::string& input) {
+  fprintf(stderr, "FAIL %s (input %zu bytes:", what, input.size());
+  for (size_t i = 0; i < input.size() && i < 24; i++) fprintf(stderr, " %02x", (uint8_t)input[i]);
+  fprintf(stderr, "%s)\n", input.size() > 24 ? " ..." : "");
+  failures++;
+}
+
+bool terminated(const char* field, size_t cap) {
+  return memchr(field, 0, cap) != nullptr;
+}
+
+bool fieldsTerminated(const ManifestFields& m) {
+  return terminated(m.model, sizeof(m.model)) && terminated(m.version, sizeof(m.version)) &&
+         terminated(m.url, sizeof(m.url)) && terminated(m.sectors, sizeof(m.sectors)) &&
+         terminated(m.mirrors, sizeof(m.mirrors)) && terminated(m.rebootWindow, sizeof(m.rebootWindow));
+}
+
+ManifestError decode(const std::string& input, ManifestFields& out) {
+  Reader in(input);
+  ManifestError e = manifestDecodeCbor(in, out);
+  if (e == MANIFEST_OK && !fieldsTerminated(out)) fail("field not terminated", input);
+  return e;
+}
+
+std::string bytes(std::initializer_list<uint8_t> b) {
+  return std::string(b.begin(), b.end());
+}
+
+void expect(const char* name, const std::string& input, ManifestError want) {
+  ManifestFields m;
+  ManifestError got = decode(input, m);
+  printf("  %-32s %s\n", name, manifestErrorName(got));
+  if (got != want) fail(name, input);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: cbor_fuzz manifest.cbor [mutations] [seed]\n");
+    return 2;
+  }
+  std::ifstream f(argv[1], std::ios::binary);
+  std::string cbor((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  long mutations = argc > 2 ? atol(argv[2]) : 200000;
+  unsigned seed = argc > 3 ? strtoul(argv[3], nullptr, 0) : 1;
+  ManifestFields m;
+  if (cbor.empty() || decode(cbor, m) != MANIFEST_OK) {
+    fprintf(stderr, "cbor_fuzz: %s is not a manifest the decoder accepts\n", argv[1]);
+    return 1;
+  }
+
+  // Every strict prefix must fail, none may read past its end
+  int counts[4] = {};
+  for (size_t n = 0; n < cbor.size(); n++) {
+    std::string prefix = cbor.substr(0, n);
+    ManifestError e = decode(prefix, m);
+    counts[e]++;
+    if (e == MANIFEST_OK) fail("truncated input decoded", prefix);
+  }
+  printf("truncations: %zu, ok %d, truncated %d, malformed %d, too long %d\n", cbor.size(), counts[0],
+         counts[1], counts[2], counts[3]);
+
+  // 1..4 random bytes changed: any result is fine, as long as it is safe
+  std::mt19937 rng(seed);
+  std::fill(counts, counts + 4, 0);
+  for (long i = 0; i < mutations; i++) {
+    std::string t = cbor;
+    for (int k = 1 + rng() % 4; k; k--) t[rng() % t.size()] = (char)rng();
+    counts[decode(t, m)]++;
+  }
+  printf("mutations: %ld (seed %u), ok %d, truncated %d, malformed %d, too long %d\n", mutations, seed,
+         counts[0], counts[1], counts[2], counts[3]);
+
+  printf("cases:\n");
+  // {1: "ab", 99: [{0: 1.0 (half)}, h'7a'], 7: 86400}: key 99 and its
+  // nested value skipped, the rest read
+  std::string unknown = bytes({ 0xA3, 0x01, 0x62, 'a', 'b', 0x18, 99, 0x82, 0xA1, 0x00, 0xF9, 0x3C, 0x00,
+                                0x41, 'z', 0x07, 0x1A, 0x00, 0x01, 0x51, 0x80 });
+  expect("unknown key, nested value", unknown, MANIFEST_OK);
+  decode(unknown, m);
+  if (strcmp(m.model, "ab") != 0 || m.rebootDeadline != 86400) fail("fields around unknown key", unknown);
+  // text key "x" -> 0: skipped like unknown numbers
+  expect("text key", bytes({ 0xA1, 0x61, 'x', 0x00 }), MANIFEST_OK);
+
+  std::string deep = bytes({ 0xA1, 0x18, 50 });
+  for (int i = 0; i < 100; i++) deep += (char)0x81;
+  deep += (char)0x00;
+  expect("nesting 100 deep", deep, MANIFEST_MALFORMED);
+  expect("indefinite map", bytes({ 0xBF, 0x01, 0x61, 'a', 0xFF }), MANIFEST_MALFORMED);
+  expect("indefinite text", bytes({ 0xA1, 0x01, 0x7F, 0x61, 'a', 0xFF }), MANIFEST_MALFORMED);
+  expect("not a map", bytes({ 0x82, 0x01, 0x02 }), MANIFEST_MALFORMED);
+  expect("model not text", bytes({ 0xA1, 0x01, 0x01 }), MANIFEST_MALFORMED);
+
+  std::string longModel = bytes({ 0xA1, 0x01, 0x78, MANIFEST_MODEL_LEN });
+  longModel += std::string(MANIFEST_MODEL_LEN, 'm');
+  expect("model one byte too long", longModel, MANIFEST_TOO_LONG);
+  // a 4 GB string and a 4 G entry map announced in a few bytes: refused
+  // or truncated without allocating or reading past the input
+  expect("4 GB text", bytes({ 0xA1, 0x01, 0x7A, 0xFF, 0xFF, 0xFF, 0xFF }), MANIFEST_TOO_LONG);
+  expect("4 GB unknown bytes", bytes({ 0xA1, 0x18, 99, 0x5A, 0xFF, 0xFF, 0xFF, 0xFF, 0x00 }),
+         MANIFEST_TRUNCATED);
+  expect("4 G entry map", bytes({ 0xBA, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x61, 'a' }), MANIFEST_TRUNCATED);
+  expect("4 G mirrors", bytes({ 0xA1, 0x05, 0x9A, 0xFF, 0xFF, 0xFF, 0xFF, 0x61, 'a' }), MANIFEST_TRUNCATED);
+  expect("64-bit length", bytes({ 0xA1, 0x01, 0x7B, 0, 0, 0, 1, 0, 0, 0, 0 }), MANIFEST_MALFORMED);
+
+  if (failures) {
+    fprintf(stderr, "cbor_fuzz: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("cbor_fuzz: ok\n");
+  return 0;
+}
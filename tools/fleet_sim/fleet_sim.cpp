@@ -0,0 +1,566 @@
+// Fleet simulator: many devices running the OTA loop of src/main.cpp against
+// one origin, to see the load on the manifest host and how fast a release
+// converges.
+//
+// Discrete-event, in epochs of --epoch seconds. Within an epoch devices are
+// independent: a device is one small state machine with its own next event
+// time and its own random stream, so workers process blocks of devices in
+// parallel and steal blocks from each other when their deque runs dry. At
+// the epoch barrier the per-worker counters are merged. The origin couples
+// the devices only through that barrier: with --capacity, the manifest QPS
+// of the last epoch decides how many polls of the next one get a 429. The
+// result does not depend on --threads.
+//
+// Modelled per device, following main.cpp and the OTA modules:
+//   poll every --poll s (loop() check), skipped while a reboot is pending;
+//   If-None-Match once the manifest said "up to date" or the version is
+//   poisoned (304, no body); the manifest connection is kept alive between
+//   polls (otaCleanup()) until the origin closes it after --keepalive-idle s
+//   idle or --keepalive-requests requests, a poll fails, the firmware phase
+//   takes the memory or the device restarts or goes offline, otherwise each
+//   poll pays a TCP + TLS handshake (--keepalive-idle 0: always);
+//   blacklist backoff and poisoning (include/ota_blacklist.h); incremental
+//   download of --delta of the image sectors plus the hash list, else the
+//   whole image; reboot in the manifest window or at its deadline
+//   (src/reboot.cpp); --bad-image boots crash and roll back (rollback.h)
+//   which poisons the version; first poll right after boot (setup()).
+// Network: lognormal RTT and bandwidth per device, per-request failures,
+// download resets per MiB, offline spells. Manifest and firmware traffic
+// (each with its own handshakes) are counted separately.
+//
+//   g++ -std=c++17 -O2 -pthread -Iinclude tools/fleet_sim/fleet_sim.cpp -o fleet_sim
+//   ./fleet_sim --devices 100000 --days 3 --capacity 500
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ota_blacklist.h"
+#include "rollback.h"
+
+namespace {
+
+struct Config {
+  uint32_t devices = 10000;
+  double days = 3;
+  double pollS = 60;
+  double epochS = 10;
+  double startS = 12 * 3600;          // UTC time of day at t = 0
+  double releaseS = 600;              // new manifest goes live
+  unsigned threads = 0;
+  uint64_t seed = 1;
+
+  double rttMs = 80;                  // median, lognormal sigma 0.6
+  double bandwidthKBs = 40;           // median, lognormal sigma 0.8
+  double pollFail = 0.01;             // connect/TLS/HTTP errors per request
+  double resetPerMiB = 0.05;          // download dies per MiB transferred
+  double offline = 0.02;              // chance a poll finds the device offline
+  double offlineMeanS = 3600;
+
+  double imageKB = 400;
+  double delta = 0.1;                 // changed sector fraction, 0 = full downloads
+  double badImage = 0;                // chance the new image does not confirm
+  int windowStart = 2 * 60;           // UTC minutes, start == end: no window
+  int windowEnd = 4 * 60;
+  double deadlineS = 86400;
+  double bootS = 8;                   // restart + Wi-Fi + first poll
+  double capacityQps = 0;             // manifest requests/s before 429s, 0 = unlimited
+  double keepaliveIdleS = 120;        // origin closes idle connections, 0 = no keep-alive
+  uint32_t keepaliveRequests = 100;   // origin closes after this many requests
+
+  double manifestBytes = 450;
+  double handshakeBytes = 5500;       // TLS 1.2 handshake incl. certificate chain
+  double headerBytes = 350;
+};
+
+enum State : uint8_t { POLL, REBOOT, DONE };
+
+struct Device {
+  double next = 0;
+  uint64_t rng = 0;
+  float rttS = 0;
+  float bytesPerS = 0;
+  double lastAttempt = -1e18;
+  double adoptedAt = -1;
+  double warmUntil = -1;              // kept-alive manifest connection usable until
+  uint32_t warmRequests = 0;
+  uint16_t failures = 0;
+  uint16_t attempts = 0;
+  State state = POLL;
+  bool etag = true;                   // up to date with the old manifest at t = 0
+  bool seenRelease = false;
+  bool poisoned = false;
+  bool reverted = false;
+};
+
+// splitmix64: one independent stream per device
+double uniform(uint64_t& s) {
+  uint64_t z = (s += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  z ^= z >> 31;
+  return (z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double normal(uint64_t& s) {
+  double u1 = std::max(uniform(s), 1e-12), u2 = uniform(s);
+  return std::sqrt(-2 * std::log(u1)) * std::cos(2 * M_PI * u2);
+}
+
+double lognormal(uint64_t& s, double median, double sigma) {
+  return median * std::exp(sigma * normal(s));
+}
+
+double exponential(uint64_t& s, double mean) {
+  return -mean * std::log(std::max(uniform(s), 1e-12));
+}
+
+// Per worker, per epoch; merged at the barrier
+struct Counters {
+  uint64_t manifest = 0, notModified = 0, rateLimited = 0, pollErrors = 0;
+  uint64_t firmwareRequests = 0, downloads = 0, downloadFailures = 0;
+  uint64_t manifestHandshakes = 0, firmwareHandshakes = 0, reboots = 0, reverts = 0, adoptions = 0;
+  double manifestBytes = 0, firmwareBytes = 0;
+
+  void add(const Counters& o) {
+    manifest += o.manifest;
+    notModified += o.notModified;
+    rateLimited += o.rateLimited;
+    pollErrors += o.pollErrors;
+    firmwareRequests += o.firmwareRequests;
+    downloads += o.downloads;
+    downloadFailures += o.downloadFailures;
+    manifestHandshakes += o.manifestHandshakes;
+    firmwareHandshakes += o.firmwareHandshakes;
+    reboots += o.reboots;
+    reverts += o.reverts;
+    adoptions += o.adoptions;
+    manifestBytes += o.manifestBytes;
+    firmwareBytes += o.firmwareBytes;
+  }
+};
+
+struct Worker {
+  Counters epoch;
+  // bytes spread over the duration of their request
+  std::vector<double> manifestBytes, firmwareBytes;
+  std::deque<std::pair<uint32_t, uint32_t>> blocks;
+  std::mutex m;
+};
+
+class Sim {
+public:
+  explicit Sim(const Config& c) : c_(c) {
+    epochs_ = (size_t)std::ceil(c.days * 86400 / c.epochS);
+    devices_.resize(c.devices);
+    for (uint32_t i = 0; i < c.devices; i++) {
+      Device& d = devices_[i];
+      d.rng = c.seed * 0x100000001B3ull + i;
+      d.rttS = lognormal(d.rng, c.rttMs / 1000, 0.6);
+      d.bytesPerS = lognormal(d.rng, c.bandwidthKBs * 1024, 0.8);
+      d.next = uniform(d.rng) * c.pollS;   // loop() phases are spread by boot times
+    }
+    sectors_ = std::ceil(c.imageKB * 1024 / 4096);
+  }
+
+  void run() {
+    unsigned n = c_.threads ? c_.threads : std::max(1u, std::thread::hardware_concurrency());
+    workers_ = std::vector<Worker>(n);
+    for (Worker& w : workers_) {
+      w.manifestBytes.assign(epochs_ + 1, 0);
+      w.firmwareBytes.assign(epochs_ + 1, 0);
+    }
+    epochStats_.resize(epochs_);
+    adopted_.assign(epochs_, 0);
+
+    uint64_t adoptedSoFar = 0;
+    for (size_t e = 0; e < epochs_; e++) {
+      epochEnd_ = (e + 1) * c_.epochS;
+      double prevQps = e ? epochStats_[e - 1].manifest / c_.epochS : 0;
+      p429_ = c_.capacityQps > 0 && prevQps > c_.capacityQps ? 1 - c_.capacityQps / prevQps : 0;
+
+      // deal blocks round-robin, then everyone works and steals
+      const uint32_t BLOCK = 512;
+      for (uint32_t b = 0, k = 0; b < c_.devices; b += BLOCK, k++) {
+        workers_[k % n].blocks.emplace_back(b, std::min<uint32_t>(c_.devices, b + BLOCK));
+      }
+      std::vector<std::thread> threads;
+      for (unsigned w = 0; w < n; w++) threads.emplace_back([this, w] { work(w); });
+      for (std::thread& t : threads) t.join();
+
+      Counters merged;
+      for (Worker& w : workers_) {
+        merged.add(w.epoch);
+        w.epoch = Counters();
+      }
+      epochStats_[e] = merged;
+      adoptedSoFar += merged.adoptions;
+      adopted_[e] = adoptedSoFar;
+    }
+    for (Worker& w : workers_) {
+      for (size_t e = 0; e < epochs_; e++) {
+        epochStats_[e].manifestBytes += w.manifestBytes[e];
+        epochStats_[e].firmwareBytes += w.firmwareBytes[e];
+      }
+    }
+  }
+
+  void report() const {
+    printf("%u devices, %.1f days, poll %.0f s, image %.0f KiB, %s, window %02d:%02d-%02d:%02d UTC, "
+           "release at +%.0f s, start %02d:%02d UTC\n\n",
+           c_.devices, c_.days, c_.pollS, c_.imageKB,
+           c_.delta > 0 ? ("delta " + std::to_string((int)(c_.delta * 100)) + " %").c_str() : "full downloads",
+           c_.windowStart / 60, c_.windowStart % 60, c_.windowEnd / 60, c_.windowEnd % 60, c_.releaseS,
+           (int)c_.startS / 3600, (int)c_.startS % 3600 / 60);
+
+    // hourly table
+    printf("%6s %10s %10s %8s %8s %10s %11s %11s %9s\n", "hour", "mf qps", "mf peak", "304 %", "429",
+           "mf KiB/s", "fw MiB/s", "fw peak", "adopted");
+    size_t perHour = (size_t)(3600 / c_.epochS);
+    for (size_t h = 0; h * perHour < epochs_; h++) {
+      Counters sum;
+      double peakQps = 0, peakBw = 0;
+      size_t last = std::min(epochs_, (h + 1) * perHour);
+      for (size_t e = h * perHour; e < last; e++) {
+        sum.add(epochStats_[e]);
+        peakQps = std::max(peakQps, epochStats_[e].manifest / c_.epochS);
+        peakBw = std::max(peakBw, epochStats_[e].firmwareBytes / c_.epochS);
+      }
+      double span = (last - h * perHour) * c_.epochS;
+      printf("%6zu %10.1f %10.1f %8.1f %8llu %10.1f %11.2f %11.2f %8.1f%%\n", h, sum.manifest / span, peakQps,
+             sum.manifest ? 100.0 * sum.notModified / sum.manifest : 0, (unsigned long long)sum.rateLimited,
+             sum.manifestBytes / span / 1024, sum.firmwareBytes / span / 1048576, peakBw / 1048576,
+             100.0 * adopted_[last - 1] / c_.devices);
+    }
+
+    Counters total;
+    double peakQps = 0, peakBw = 0;
+    for (const Counters& e : epochStats_) {
+      total.add(e);
+      peakQps = std::max(peakQps, e.manifest / c_.epochS);
+      peakBw = std::max(peakBw, e.firmwareBytes / c_.epochS);
+    }
+    double span = epochs_ * c_.epochS;
+    printf("\norigin: manifest %.1f qps avg, %.1f peak (%.1f %% 304, %llu 429, %llu errors)\n",
+           total.manifest / span, peakQps, 100.0 * total.notModified / std::max<uint64_t>(1, total.manifest),
+           (unsigned long long)total.rateLimited, (unsigned long long)total.pollErrors);
+    printf("        manifest %llu TLS handshakes (%.1f %% of polls kept-alive), %.2f GiB, %.1f KiB/s avg\n",
+           (unsigned long long)total.manifestHandshakes,
+           100.0 * (total.manifest - std::min(total.manifest, total.manifestHandshakes)) /
+               std::max<uint64_t>(1, total.manifest),
+           total.manifestBytes / 1073741824.0, total.manifestBytes / span / 1024);
+    printf("        firmware %llu requests, %llu downloads (%llu failed), %llu TLS handshakes, %.2f GiB, "
+           "%.2f MiB/s avg, %.2f peak\n",
+           (unsigned long long)total.firmwareRequests, (unsigned long long)total.downloads,
+           (unsigned long long)total.downloadFailures, (unsigned long long)total.firmwareHandshakes,
+           total.firmwareBytes / 1073741824.0, total.firmwareBytes / span / 1048576, peakBw / 1048576);
+
+    // adoption, counted from the release
+    printf("adoption:");
+    for (double q : { 0.5, 0.95, 1.0 }) {
+      uint64_t need = (uint64_t)std::ceil(q * c_.devices);
+      size_t e = 0;
+      while (e < epochs_ && adopted_[e] < need) e++;
+      if (e < epochs_) printf("  %g%% %s", q * 100, duration((e + 1) * c_.epochS - c_.releaseS).c_str());
+      else printf("  %g%% not reached", q * 100);
+    }
+    printf("  (%llu reboots, %llu rolled back)\n", (unsigned long long)total.reboots,
+           (unsigned long long)total.reverts);
+
+    // failure tail
+    std::vector<double> adoptTimes;
+    unsigned histogram[7] = {};
+    unsigned poisoned = 0, pending = 0, maxAttempts = 0;
+    for (const Device& d : devices_) {
+      histogram[std::min<unsigned>(d.failures, 6)]++;
+      poisoned += d.poisoned;
+      pending += d.adoptedAt < 0 && !d.poisoned;
+      maxAttempts = std::max<unsigned>(maxAttempts, d.attempts);
+      if (d.adoptedAt >= 0) adoptTimes.push_back(d.adoptedAt - c_.releaseS);
+    }
+    std::sort(adoptTimes.begin(), adoptTimes.end());
+    auto pct = [&](double q) {
+      return adoptTimes.empty() ? std::string("-")
+                                : duration(adoptTimes[std::min(adoptTimes.size() - 1, (size_t)(q * adoptTimes.size()))]);
+    };
+    printf("tail: time to adopt p50 %s p95 %s p99 %s max %s; failed attempts per device:",
+           pct(0.5).c_str(), pct(0.95).c_str(), pct(0.99).c_str(),
+           adoptTimes.empty() ? "-" : duration(adoptTimes.back()).c_str());
+    for (unsigned f = 0; f < 7; f++) printf(" %u%s:%u", f, f == 6 ? "+" : "", histogram[f]);
+    printf("\n      %u poisoned, %u still pending, max %u attempts on one device\n", poisoned, pending,
+           maxAttempts);
+  }
+
+private:
+  static std::string duration(double s) {
+    char buf[32];
+    if (s < 3600) snprintf(buf, sizeof(buf), "%.1f min", s / 60);
+    else snprintf(buf, sizeof(buf), "%.1f h", s / 3600);
+    return buf;
+  }
+
+  bool popBlock(unsigned self, std::pair<uint32_t, uint32_t>& block) {
+    {
+      std::lock_guard<std::mutex> l(workers_[self].m);
+      if (!workers_[self].blocks.empty()) {
+        block = workers_[self].blocks.front();
+        workers_[self].blocks.pop_front();
+        return true;
+      }
+    }
+    for (size_t k = 1; k < workers_.size(); k++) {   // steal from the back of the others
+      Worker& v = workers_[(self + k) % workers_.size()];
+      std::lock_guard<std::mutex> l(v.m);
+      if (!v.blocks.empty()) {
+        block = v.blocks.back();
+        v.blocks.pop_back();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void work(unsigned self) {
+    Worker& w = workers_[self];
+    std::pair<uint32_t, uint32_t> block;
+    while (popBlock(self, block)) {
+      for (uint32_t i = block.first; i < block.second; i++) {
+        Device& d = devices_[i];
+        while (d.state != DONE && d.next < epochEnd_) step(d, w);
+      }
+    }
+  }
+
+  bool inWindow(double t) const {
+    if (c_.windowStart == c_.windowEnd) return true;
+    int minute = (int)std::fmod((c_.startS + t) / 60, 1440);
+    if (c_.windowStart < c_.windowEnd) return minute >= c_.windowStart && minute < c_.windowEnd;
+    return minute >= c_.windowStart || minute < c_.windowEnd;
+  }
+
+  // rebootLoop(): first time in the window, or the deadline
+  double rebootTime(double t) const {
+    if (c_.windowStart == c_.windowEnd || inWindow(t)) return t;
+    double dayS = std::fmod(c_.startS + t, 86400);
+    double untilWindow = std::fmod(c_.windowStart * 60.0 - dayS + 86400, 86400);
+    return t + std::min(untilWindow, c_.deadlineS);
+  }
+
+  void spreadBytes(std::vector<double>& byEpoch, double from, double to, double bytes) {
+    to = std::max(to, from + 1e-3);
+    for (double t = from; t < to;) {
+      size_t e = std::min(epochs_, (size_t)(t / c_.epochS));
+      double end = std::min(to, (e + 1) * c_.epochS);
+      byEpoch[e] += bytes * (end - t) / (to - from);
+      t = end;
+    }
+  }
+
+  // One request: TCP + TLS handshake + request/response on a fresh
+  // connection, request/response only on a kept-alive one
+  double requestS(Device& d, bool warm = false) const {
+    return (warm ? 1 : 3) * d.rttS * std::exp(0.3 * normal(d.rng));
+  }
+
+  // otaCleanup() / loop(): can the next poll reuse the manifest connection
+  bool warmAt(const Device& d, double t) const {
+    return t < d.warmUntil && d.warmRequests < c_.keepaliveRequests;
+  }
+
+  void step(Device& d, Worker& w) {
+    double t = d.next;
+    Counters& k = w.epoch;
+
+    if (d.state == REBOOT) {
+      k.reboots++;
+      if (uniform(d.rng) < c_.badImage) {
+        // crashes through ROLLBACK_MAX_BOOTS trial boots, then eboot restores the backup
+        k.reverts++;
+        d.reverted = true;
+        d.poisoned = true;   // rollbackBoot(): journalVersionFailed(.., REVERTED)
+        d.next = t + c_.bootS * (ROLLBACK_MAX_BOOTS + 1);
+      } else {
+        d.adoptedAt = t + c_.bootS;
+        k.adoptions++;
+        d.next = t + c_.bootS;
+      }
+      d.state = POLL;
+      d.warmUntil = -1;    // restarted: cold
+      return;
+    }
+
+    // POLL
+    if (uniform(d.rng) < c_.offline) {
+      d.next = t + exponential(d.rng, c_.offlineMeanS);
+      d.warmUntil = -1;
+      return;
+    }
+    bool released = t >= c_.releaseS;
+    if (released && !d.seenRelease) {
+      d.etag = false;    // manifest changed: the stored ETag no longer matches
+      d.seenRelease = true;
+    }
+
+    double start = t;
+    bool warm = warmAt(d, t);
+    double end = t + requestS(d, warm);
+    k.manifest++;
+    double pollBytes = c_.headerBytes;
+    if (!warm) {
+      k.manifestHandshakes++;
+      pollBytes += c_.handshakeBytes;
+      d.warmRequests = 0;
+    }
+    d.warmRequests++;
+    bool keep = c_.keepaliveIdleS > 0;
+    if (uniform(d.rng) < p429_) {
+      k.rateLimited++;
+    } else if (uniform(d.rng) < c_.pollFail) {
+      k.pollErrors++;
+      keep = false;        // connect/TLS/HTTP error: connection gone
+    } else if (d.etag) {
+      k.notModified++;
+    } else {
+      pollBytes += c_.manifestBytes;
+      bool upToDate = !released || d.adoptedAt >= 0;
+      if (upToDate || d.poisoned) {
+        d.etag = true;
+      } else if (d.failures == 0 || start - d.lastAttempt >= blacklistBackoffS(d.failures)) {
+        spreadBytes(w.manifestBytes, start, end, pollBytes);
+        pollBytes = 0;
+        keep = false;      // manifestHttp/tlsClient.reset() before the firmware TLS client
+        end = download(d, w, end);
+      }
+    }
+    spreadBytes(w.manifestBytes, start, end, pollBytes);
+    d.warmUntil = keep ? end + c_.keepaliveIdleS : -1;
+
+    if (d.state == POLL) d.next = std::max(start + c_.pollS + 0.1, end);
+  }
+
+  // Firmware phase; returns when httpCheckAndUpdate() returns
+  double download(Device& d, Worker& w, double t) {
+    Counters& k = w.epoch;
+    d.attempts++;
+    d.lastAttempt = t;
+    k.downloads++;
+
+    double imageBytes = c_.imageKB * 1024;
+    double bytes = imageBytes;
+    unsigned requests = 1;
+    if (c_.delta > 0) {
+      // hash list, then one Range request per run of changed sectors
+      unsigned changed = std::max(1.0, std::round(sectors_ * c_.delta));
+      bytes = 32 + 8 * sectors_ + changed * 4096.0;
+      requests = 1 + std::max(1u, changed / 4);
+    }
+    k.firmwareRequests += requests;
+    k.firmwareHandshakes++;   // one connection, kept alive across the Range requests
+
+    double speed = d.bytesPerS * std::exp(0.3 * normal(d.rng));
+    double duration = requestS(d) + requests * d.rttS + bytes / speed;
+    double pFail = 1 - std::pow(1 - c_.resetPerMiB, bytes / 1048576);
+    if (uniform(d.rng) < pFail) {
+      double frac = uniform(d.rng);
+      spreadBytes(w.firmwareBytes, t, t + duration * frac, c_.handshakeBytes + bytes * frac);
+      k.downloadFailures++;
+      d.failures++;
+      if (d.failures >= BLACKLIST_POISON_FAILURES) d.poisoned = true;
+      return t + duration * frac;
+    }
+    spreadBytes(w.firmwareBytes, t, t + duration, c_.handshakeBytes + bytes + requests * c_.headerBytes);
+    double done = t + duration;
+    d.state = REBOOT;   // no polls while the reboot is pending
+    d.next = rebootTime(done);
+    return done;
+  }
+
+  Config c_;
+  std::vector<Device> devices_;
+  std::vector<Worker> workers_;
+  std::vector<Counters> epochStats_;
+  std::vector<uint64_t> adopted_;
+  size_t epochs_ = 0;
+  double epochEnd_ = 0;
+  double p429_ = 0;
+  double sectors_ = 0;
+};
+
+bool parseWindow(const char* s, Config& c) {
+  unsigned h1, m1, h2, m2;
+  if (sscanf(s, "%u:%u-%u:%u", &h1, &m1, &h2, &m2) != 4 || h1 > 23 || h2 > 23 || m1 > 59 || m2 > 59) {
+    return false;
+  }
+  c.windowStart = h1 * 60 + m1;
+  c.windowEnd = h2 * 60 + m2;
+  return true;
+}
+
+int usage() {
+  fprintf(stderr,
+          "usage: fleet_sim [--devices N] [--days D] [--threads N] [--seed N] [--epoch S]\n"
+          "                 [--poll S] [--release S] [--start HH:MM] [--window HH:MM-HH:MM|none]\n"
+          "                 [--deadline S] [--image KiB] [--delta FRACTION] [--bad-image P]\n"
+          "                 [--rtt MS] [--bandwidth KiB/s] [--poll-fail P] [--reset-per-mib P]\n"
+          "                 [--offline P] [--offline-mean S] [--capacity QPS]\n"
+          "                 [--keepalive-idle S] [--keepalive-requests N]\n");
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config c;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    if (i + 1 >= argc) return usage();
+    const char* v = argv[++i];
+    double x = atof(v);
+    if (a == "--devices") c.devices = (uint32_t)x;
+    else if (a == "--days") c.days = x;
+    else if (a == "--threads") c.threads = (unsigned)x;
+    else if (a == "--seed") c.seed = strtoull(v, nullptr, 10);
+    else if (a == "--epoch") c.epochS = x;
+    else if (a == "--poll") c.pollS = x;
+    else if (a == "--release") c.releaseS = x;
+    else if (a == "--start") {
+      unsigned h, m;
+      if (sscanf(v, "%u:%u", &h, &m) != 2) return usage();
+      c.startS = h * 3600 + m * 60;
+    } else if (a == "--window") {
+      if (strcmp(v, "none") == 0) c.windowStart = c.windowEnd = 0;
+      else if (!parseWindow(v, c)) return usage();
+    } else if (a == "--deadline") c.deadlineS = x;
+    else if (a == "--image") c.imageKB = x;
+    else if (a == "--delta") c.delta = x;
+    else if (a == "--bad-image") c.badImage = x;
+    else if (a == "--rtt") c.rttMs = x;
+    else if (a == "--bandwidth") c.bandwidthKBs = x;
+    else if (a == "--poll-fail") c.pollFail = x;
+    else if (a == "--reset-per-mib") c.resetPerMiB = x;
+    else if (a == "--offline") c.offline = x;
+    else if (a == "--offline-mean") c.offlineMeanS = x;
+    else if (a == "--capacity") c.capacityQps = x;
+    else if (a == "--keepalive-idle") c.keepaliveIdleS = x;
+    else if (a == "--keepalive-requests") c.keepaliveRequests = (uint32_t)x;
+    else return usage();
+  }
+  if (!c.devices || c.days <= 0 || c.epochS <= 0 || c.pollS <= 0) return usage();
+
+  auto start = std::chrono::steady_clock::now();
+  Sim sim(c);
+  sim.run();
+  sim.report();
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  fprintf(stderr, "simulated in %.2f s\n", s);
+  return 0;
+}
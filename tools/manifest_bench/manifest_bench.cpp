@@ -0,0 +1,192 @@
+// Manifest parse benchmark: the JSON path of src/manifest.cpp (ArduinoJson
+// with the device's filter into a static document, then copied into
+// ManifestFields) against the CBOR path (manifestDecodeCbor straight into
+// ManifestFields), on the files tools/release wrote. Both read through a
+// virtual byte-at-a-time reader, like Stream on the device, so the ratio
+// carries over even though the host is ~50x faster.
+//
+//   g++ -std=c++17 -O2 -Iinclude -I.pio/libdeps/d1_mini/ArduinoJson/src tools/manifest_bench/manifest_bench.cpp -o manifest_bench
+//   ./manifest_bench public/manifest.json public/manifest.cbor [iterations]
+//
+// ArduinoJson comes with the PlatformIO build (pio pkg install -e d1_mini),
+// or as the pinned single header: make -C tools/native arduinojson, then
+// -Itools/native/ArduinoJson instead. Built without it the bench exits 1,
+// unless --cbor-only says the JSON column is not wanted.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "manifest.h"
+
+#if __has_include(<ArduinoJson.h>)
+#include <ArduinoJson.h>
+#define HAVE_ARDUINOJSON 1
+#endif
+
+namespace {
+
+const size_t JSON_DOC_SIZE = 1024;     // MANIFEST_JSON_SIZE
+const size_t JSON_FILTER_SIZE = 256;
+
+// Stream stand-in: one virtual call per byte, as HttpBodyStream::read()
+class ByteReader {
+public:
+  ByteReader(const std::string& s) : s_(s) {}
+  virtual ~ByteReader() {}
+
+  virtual int read() { return at_ < s_.size() ? (uint8_t)s_[at_++] : -1; }
+
+  size_t readBytes(char* out, size_t n) {
+    size_t i = 0;
+    for (int c; i < n && (c = read()) >= 0; i++) out[i] = (char)c;
+    return i;
+  }
+
+  size_t consumed() const { return at_; }
+
+private:
+  const std::string& s_;
+  size_t at_ = 0;
+};
+
+bool readFile(const char* path, std::string& out) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) return false;
+  out.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+  return true;
+}
+
+template <typename F>
+double medianNs(int iterations, F&& run) {
+  std::vector<double> ns;
+  for (int rep = 0; rep < 9; rep++) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) run();
+    ns.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                 iterations);
+  }
+  std::sort(ns.begin(), ns.end());
+  return ns[ns.size() / 2];
+}
+
+#ifdef HAVE_ARDUINOJSON
+// Same filter as src/manifest.cpp
+const char FILTER[] = "{\"model\":true,\"version\":true,\"url\":true,\"sectors\":true,"
+                      "\"mirrors\":true,\"reboot_window\":true,\"reboot_deadline\":true}";
+
+StaticJsonDocument<JSON_DOC_SIZE> doc;
+size_t docUsed = 0;
+
+void copy(char* out, size_t cap, const char* v) {
+  snprintf(out, cap, "%s", v);
+}
+
+bool parseJson(const std::string& json, ManifestFields& out) {
+  StaticJsonDocument<JSON_FILTER_SIZE> filter;
+  deserializeJson(filter, FILTER);
+  ByteReader in(json);
+  if (deserializeJson(doc, in, DeserializationOption::Filter(filter))) return false;
+  docUsed = doc.memoryUsage();
+  memset(&out, 0, sizeof(out));
+  copy(out.model, sizeof(out.model), doc["model"] | "");
+  copy(out.version, sizeof(out.version), doc["version"] | "");
+  copy(out.url, sizeof(out.url), doc["url"] | "");
+  copy(out.sectors, sizeof(out.sectors), doc["sectors"] | "");
+  copy(out.rebootWindow, sizeof(out.rebootWindow), doc["reboot_window"] | "");
+  out.rebootDeadline = doc["reboot_deadline"] | 0;
+  size_t used = 0;
+  for (JsonVariantConst m : doc["mirrors"].as<JsonArrayConst>()) {
+    used += snprintf(out.mirrors + used, sizeof(out.mirrors) - used, "%s%s", used ? " " : "", m | "");
+  }
+  doc.clear();
+  return true;
+}
+#endif
+
+bool sameFields(const ManifestFields& a, const ManifestFields& b) {
+  return !strcmp(a.model, b.model) && !strcmp(a.version, b.version) && !strcmp(a.url, b.url) &&
+         !strcmp(a.sectors, b.sectors) && !strcmp(a.mirrors, b.mirrors) &&
+         !strcmp(a.rebootWindow, b.rebootWindow) && a.rebootDeadline == b.rebootDeadline;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool cborOnly = false;
+  std::vector<const char*> args;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--cbor-only")) {
+      cborOnly = true;
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
+  if (args.size() < 2) {
+    fprintf(stderr, "usage: manifest_bench [--cbor-only] manifest.json manifest.cbor [iterations]\n");
+    return 2;
+  }
+#ifndef HAVE_ARDUINOJSON
+  if (!cborOnly) {
+    fprintf(stderr, "manifest_bench: built without ArduinoJson, the JSON parse cannot be measured;\n"
+                    "  add its include path (see the top of manifest_bench.cpp) or pass --cbor-only\n");
+    return 1;
+  }
+#endif
+  std::string json, cbor;
+  if (!readFile(args[0], json) || !readFile(args[1], cbor)) {
+    fprintf(stderr, "manifest_bench: cannot read the manifests\n");
+    return 1;
+  }
+  int iterations = args.size() > 2 ? std::max(1, atoi(args[2])) : 20000;
+
+  ManifestFields fromCbor;
+  ByteReader check(cbor);
+  ManifestError e = manifestDecodeCbor(check, fromCbor);
+  if (e) {
+    fprintf(stderr, "manifest_bench: %s: %s\n", args[1], manifestErrorName(e));
+    return 1;
+  }
+  double cborNs = medianNs(iterations, [&] {
+    ByteReader in(cbor);
+    ManifestFields f;
+    manifestDecodeCbor(in, f);
+  });
+
+  printf("%-6s %8s %12s %14s %14s\n", "format", "bytes", "parse ns", "static RAM", "of which used");
+  if (cborOnly) {
+    (void)sameFields;
+    printf("%-6s %8zu %12s %14zu %14s\n", "json", json.size(), "-",
+           JSON_DOC_SIZE + JSON_FILTER_SIZE + sizeof(ManifestFields), "-");
+  } else {
+#ifdef HAVE_ARDUINOJSON
+    ManifestFields fromJson;
+    if (!parseJson(json, fromJson)) {
+      fprintf(stderr, "manifest_bench: %s: JSON error\n", args[0]);
+      return 1;
+    }
+    if (!sameFields(fromJson, fromCbor)) {
+      fprintf(stderr, "manifest_bench: the two manifests disagree\n");
+      return 1;
+    }
+    double jsonNs = medianNs(iterations, [&] {
+      ManifestFields f;
+      parseJson(json, f);
+    });
+    // document + filter document + the fields they are copied into
+    printf("%-6s %8zu %12.0f %14zu %14zu\n", "json", json.size(), jsonNs,
+           JSON_DOC_SIZE + JSON_FILTER_SIZE + sizeof(ManifestFields), docUsed + sizeof(ManifestFields));
+#endif
+  }
+  // the fields and the reader (stack); nothing else
+  printf("%-6s %8zu %12.0f %14zu %14zu\n", "cbor", cbor.size(), cborNs,
+         sizeof(ManifestFields) + sizeof(CborReader<ByteReader>),
+         sizeof(ManifestFields) + sizeof(CborReader<ByteReader>));
+  return 0;
+}
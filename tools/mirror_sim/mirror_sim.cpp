@@ -0,0 +1,202 @@
+// Host simulation of the mirror scoring (include/mirrors.h).
+//
+// Checks the EWMA, the decay and the budgets of mirrorSample(),
+// mirrorRank() and mirrorBudgetMs(), then replays a day of manifest polls
+// against a primary and a mirror with the order and budgets of
+// src/mirrors.cpp (best rank first, the primary wins ties, the last
+// candidate gets the full timeout). The primary is down for --outage
+// minutes; a request costs the response time of the host that answers
+// plus the budget of every host tried before it.
+//
+//   g++ -std=c++17 -O2 -Iinclude tools/mirror_sim/mirror_sim.cpp -o mirror_sim && ./mirror_sim
+//   ./mirror_sim --poll 60 --outage 60 --primary-ms 300 --mirror-ms 600
+//
+// Exit code 1 if a check fails.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <string>
+
+#include "mirrors.h"
+
+using std::max;
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+  printf("  %-56s %s\n", what.c_str(), ok ? "ok" : "FAIL");
+  if (!ok) failures++;
+}
+
+const uint32_t TIMEOUT_MS = 20000;
+const uint32_t HALVING_MS = MIRROR_HALVING_S * 1000;
+
+void scoring() {
+  printf("scoring:\n");
+  MirrorScore s = {};
+  check(mirrorRank(s, 12345) == MIRROR_UNKNOWN_MS, "no sample: MIRROR_UNKNOWN_MS");
+  check(mirrorBudgetMs(s, 0, TIMEOUT_MS) == MIRROR_UNKNOWN_MS * MIRROR_BUDGET_FACTOR, "no sample: its budget");
+
+  mirrorSample(s, 800, 1000);
+  check(s.ewmaMs == 800 && mirrorRank(s, 1000) == 800, "first sample taken as is");
+  mirrorSample(s, 400, 2000);
+  check(s.ewmaMs == 700, "next sample weighs 1/4");
+  for (int i = 0; i < 50; i++) mirrorSample(s, 400, 2000);
+  check(s.ewmaMs >= 400 && s.ewmaMs <= 403, "steady samples: converges to them");
+  MirrorScore zero = {};
+  mirrorSample(zero, 0, 0);
+  check(zero.ewmaMs == 1, "0 ms sample counts as 1 ms, not as no sample");
+
+  s = {};
+  mirrorSample(s, 1600, 5000);
+  check(mirrorRank(s, 5000 + HALVING_MS - 1) == 1600, "full rank up to MIRROR_HALVING_S");
+  check(mirrorRank(s, 5000 + HALVING_MS) == 800, "halved after MIRROR_HALVING_S");
+  check(mirrorRank(s, 5000 + 3 * HALVING_MS) == 200, "halved per MIRROR_HALVING_S");
+  check(mirrorRank(s, 5000 + 40 * HALVING_MS) == 0, "no shift past 31 halvings");
+  s.lastMs = 0xFFFFF000;
+  check(mirrorRank(s, 0x1000) == 1600, "across the millis() wrap");
+
+  s = {};
+  mirrorSample(s, 100, 0);
+  check(mirrorBudgetMs(s, 0, TIMEOUT_MS) == MIRROR_MIN_BUDGET_MS, "fast host: MIRROR_MIN_BUDGET_MS");
+  s.ewmaMs = 1500;
+  check(mirrorBudgetMs(s, 0, TIMEOUT_MS) == 1500 * MIRROR_BUDGET_FACTOR, "budget MIRROR_BUDGET_FACTOR x its rank");
+  s.ewmaMs = MIRROR_FAIL_MS;
+  check(mirrorBudgetMs(s, 0, TIMEOUT_MS) == TIMEOUT_MS, "never more than the timeout");
+  check(mirrorBudgetMs(s, 0, 1000) == 1000, "short timeout wins over the minimum");
+}
+
+struct Host {
+  uint32_t ms;          // response time when up
+  MirrorScore score;
+};
+
+struct Day {
+  uint32_t requests = 0, failed = 0, probes = 0;
+  uint64_t totalMs = 0, outageMs = 0;
+  uint32_t outageRequests = 0, worstOutageMs = 0;
+  uint32_t backFirstS = 0;   // after the outage, until the primary is tried first again
+};
+
+// One day of polls; ranked = false tries the primary first every time
+Day day(uint32_t pollS, uint32_t outageMin, uint32_t primaryMs, uint32_t mirrorMs, bool ranked) {
+  Host hosts[2] = { { primaryMs, {} }, { mirrorMs, {} } };
+  const uint32_t outageFrom = 3600, outageTo = outageFrom + outageMin * 60;
+  Day d;
+  for (uint32_t t = 0; t < 86400; t += pollS) {
+    uint32_t now = t * 1000;
+    bool down = t >= outageFrom && t < outageTo;
+    uint8_t idx[2] = { 0, 1 };
+    if (ranked && mirrorRank(hosts[1].score, now) < mirrorRank(hosts[0].score, now)) {
+      idx[0] = 1;
+      idx[1] = 0;
+    }
+    if (t >= outageTo && !d.backFirstS && idx[0] == 0) d.backFirstS = t - outageTo + 1;
+
+    uint32_t cost = 0;
+    bool ok = false;
+    for (uint8_t k = 0; k < 2 && !ok; k++) {
+      Host& h = hosts[idx[k]];
+      uint32_t budget = k == 1 ? TIMEOUT_MS : mirrorBudgetMs(h.score, now, TIMEOUT_MS);
+      if (idx[k] == 0 && down) {
+        if (k == 0 && t > outageFrom) d.probes++;   // tried first again after it failed
+        cost += budget;
+        mirrorSample(h.score, MIRROR_FAIL_MS, now + cost);
+      } else if (h.ms > budget) {
+        cost += budget;
+        mirrorSample(h.score, MIRROR_FAIL_MS, now + cost);
+      } else {
+        cost += h.ms;
+        mirrorSample(h.score, h.ms, now + cost);
+        ok = true;
+      }
+    }
+    d.requests++;
+    if (!ok) d.failed++;
+    d.totalMs += cost;
+    if (down) {
+      d.outageRequests++;
+      d.outageMs += cost;
+      if (cost > d.worstOutageMs) d.worstOutageMs = cost;
+    }
+  }
+  return d;
+}
+
+uint32_t halvingsTo(uint32_t ewmaMs, uint32_t rankMs) {
+  uint32_t h = 0;
+  while ((ewmaMs >> h) > rankMs) h++;
+  return h;
+}
+
+uint32_t arg(int argc, char** argv, const char* name, uint32_t def) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (!strcmp(argv[i], name)) return (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+  }
+  return def;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 >= argc || (strcmp(argv[i], "--poll") && strcmp(argv[i], "--outage") &&
+                          strcmp(argv[i], "--primary-ms") && strcmp(argv[i], "--mirror-ms"))) {
+      fprintf(stderr, "usage: mirror_sim [--poll S] [--outage MIN] [--primary-ms MS] [--mirror-ms MS]\n");
+      return 2;
+    }
+  }
+  uint32_t pollS = arg(argc, argv, "--poll", 60);
+  uint32_t outageMin = arg(argc, argv, "--outage", 60);
+  uint32_t primaryMs = arg(argc, argv, "--primary-ms", 300);
+  uint32_t mirrorMs = arg(argc, argv, "--mirror-ms", 600);
+  // the outage starts after an hour and ends with enough of the day left
+  // to see the primary come back
+  if (!pollS || !outageMin || outageMin > 1200 || primaryMs >= mirrorMs || mirrorMs >= MIRROR_MIN_BUDGET_MS) {
+    fprintf(stderr, "mirror_sim: needs --poll > 0, --outage 1..1200 and primary-ms < mirror-ms < %lu\n",
+            MIRROR_MIN_BUDGET_MS);
+    return 2;
+  }
+
+  scoring();
+
+  printf("day: poll %u s, primary %u ms down %u min, mirror %u ms\n", pollS, primaryMs, outageMin, mirrorMs);
+  Day fixed = day(pollS, outageMin, primaryMs, mirrorMs, false);
+  Day ranked = day(pollS, outageMin, primaryMs, mirrorMs, true);
+  printf("  %-8s %8s %8s %12s %12s %10s\n", "order", "requests", "failed", "mean ms", "outage mean", "worst");
+  for (const Day* d : { &fixed, &ranked }) {
+    printf("  %-8s %8u %8u %12.0f %12.0f %10u\n", d == &fixed ? "fixed" : "ranked", d->requests, d->failed,
+           (double)d->totalMs / d->requests, d->outageRequests ? (double)d->outageMs / d->outageRequests : 0.0,
+           d->worstOutageMs);
+  }
+  printf("  ranked: %u probes of the primary during the outage, first again %u s after it\n", ranked.probes,
+         ranked.backFirstS);
+
+  // A failed primary is tried first again once its rank decayed to the
+  // mirror's (ties go to the primary): the spacing of the probes comes from
+  // the EWMA after one failure, the return after the outage from an EWMA at
+  // MIRROR_FAIL_MS at worst. A probe costs at most the budget of that rank.
+  uint32_t failedEwma = primaryMs - (primaryMs >> MIRROR_EWMA_SHIFT) + (MIRROR_FAIL_MS >> MIRROR_EWMA_SHIFT);
+  uint32_t probeS = halvingsTo(failedEwma, mirrorMs) * MIRROR_HALVING_S;
+  uint32_t returnS = halvingsTo(MIRROR_FAIL_MS, mirrorMs) * MIRROR_HALVING_S;
+  uint32_t probeMs = max<uint32_t>(MIRROR_MIN_BUDGET_MS, MIRROR_BUDGET_FACTOR * max(primaryMs, mirrorMs)) + mirrorMs;
+
+  check(ranked.failed == 0, "every request answered");
+  check(ranked.worstOutageMs <= probeMs, "outage costs one primary budget at most, not the timeout");
+  check(ranked.outageMs <= fixed.outageMs, "ranked order no dearer during the outage");
+  check(ranked.probes <= outageMin * 60 / probeS + 1, "primary probed once per decay at most");
+  check(ranked.backFirstS > 0 && ranked.backFirstS <= returnS + pollS,
+        "primary first again within its decay after the outage");
+
+  if (failures) {
+    fprintf(stderr, "mirror_sim: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("mirror_sim: ok\n");
+  return 0;
+}
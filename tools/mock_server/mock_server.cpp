@@ -0,0 +1,629 @@
+// Mock update server for offline OTA testing: serves a release directory
+// (manifest.json + firmware/, as written by tools/release) over HTTP and
+// HTTPS, with faults injected per request from a scenario file.
+//
+//   g++ -std=c++17 -O2 -pthread tools/mock_server/mock_server.cpp -lssl -lcrypto -o mock_server
+//   ./mock_server tools/mock_server/scenarios/flaky.txt
+//
+// Build the release for this host and point a device at it with the
+// d1_mini_mock env (platformio.ini):
+//   ./release --bin firmware.bin --out public ... --base-url http://<host>:8080/firmware
+//   OTA_MOCK_URL=http://<host>:8080/manifest.json pio run -e d1_mini_mock -t upload
+//
+// Scenario file, one directive per line, '#' starts a comment:
+//
+//   root DIR                       directory to serve (default: public)
+//   listen http PORT
+//   listen https PORT [CERT KEY]   PEM files; without them a throwaway
+//                                  self-signed certificate is made at start
+//   rule GLOB [port N] [skip N] [times N] ACTION...
+//                                  applies to matching paths (on listener port N
+//                                  only, if given: several listeners act as
+//                                  separate mirrors); skip the first N matches,
+//                                  then apply N times (default always). All
+//                                  matching rules combine, in order.
+//
+// Actions (several per rule):
+//   latency MS                     delay before the response header
+//   throttle BYTES_PER_S           pace the body
+//   reset BYTES                    TCP reset after BYTES body bytes
+//   corrupt OFFSET                 flip the file byte at OFFSET (bad MD5)
+//   length DELTA                   Content-Length off by DELTA, then close
+//   redirect N [CODE]              chain of N redirects (default 302), ending
+//                                  at /__r/0-CODE/<path>, where the rules apply
+//   status CODE                    answer CODE with an empty body (304, 429, 500 ...)
+//   retry-after S                  Retry-After header (with status)
+//   chunked                        Transfer-Encoding: chunked instead of Content-Length
+//   norange                        ignore Range, always 200 with the whole file
+//   close                          Connection: close after this response
+//
+// Without rules every file gets an ETag (If-None-Match -> 304), Range
+// support (-> 206) and HTTP/1.1 keep-alive. Each request is logged as one
+// line; Ctrl-C prints totals per host, path and status.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fnmatch.h>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Rule {
+  std::string glob;
+  int port = 0;                         // 0: every listener
+  unsigned skip = 0;
+  long times = -1;                      // -1: always
+  unsigned matched = 0;                 // guarded by rulesMutex
+  unsigned latencyMs = 0;
+  uint64_t throttle = 0;
+  long long reset = -1;
+  long long corrupt = -1;
+  long long lengthDelta = 0;
+  unsigned redirects = 0;
+  int redirectCode = 302;
+  int status = 0;
+  int retryAfter = -1;
+  bool chunked = false;
+  bool noRange = false;
+  bool close = false;
+};
+
+struct Listen {
+  bool tls = false;
+  int port = 0;
+  std::string cert, key;
+};
+
+struct Scenario {
+  std::string root = "public";
+  std::vector<Listen> listens;
+  std::vector<Rule> rules;
+};
+
+// Effective behaviour for one request, all matching rules combined
+struct Behaviour {
+  unsigned latencyMs = 0;
+  uint64_t throttle = 0;
+  long long reset = -1;
+  long long corrupt = -1;
+  long long lengthDelta = 0;
+  unsigned redirects = 0;
+  int redirectCode = 302;
+  int status = 0;
+  int retryAfter = -1;
+  bool chunked = false;
+  bool noRange = false;
+  bool close = false;
+};
+
+Scenario scenario;
+std::mutex rulesMutex;
+std::mutex logMutex;
+std::map<std::string, uint64_t> totals;   // "path status" -> requests
+uint64_t totalBytes = 0;
+auto startTime = std::chrono::steady_clock::now();
+
+bool parseScenario(const std::string& path, Scenario& sc) {
+  std::ifstream in(path);
+  if (!in) {
+    fprintf(stderr, "mock_server: cannot read %s\n", path.c_str());
+    return false;
+  }
+  std::string line;
+  int lineNo = 0;
+  while (std::getline(in, line)) {
+    lineNo++;
+    size_t hash = line.find('#');
+    if (hash != std::string::npos) line.resize(hash);
+    std::istringstream ss(line);
+    std::vector<std::string> t;
+    for (std::string w; ss >> w;) t.push_back(w);
+    if (t.empty()) continue;
+
+    auto fail = [&](const char* what) {
+      fprintf(stderr, "mock_server: %s:%d: %s\n", path.c_str(), lineNo, what);
+      return false;
+    };
+    if (t[0] == "root" && t.size() == 2) {
+      sc.root = t[1];
+    } else if (t[0] == "listen" && t.size() >= 3) {
+      Listen l;
+      l.tls = t[1] == "https";
+      l.port = atoi(t[2].c_str());
+      if (t.size() == 5) {
+        l.cert = t[3];
+        l.key = t[4];
+      }
+      if (!l.port || (t[1] != "http" && t[1] != "https")) return fail("listen http|https PORT [CERT KEY]");
+      sc.listens.push_back(l);
+    } else if (t[0] == "rule" && t.size() >= 2) {
+      Rule r;
+      r.glob = t[1];
+      for (size_t i = 2; i < t.size(); i++) {
+        const std::string& a = t[i];
+        bool hasArg = i + 1 < t.size();
+        auto arg = [&]() { return std::stoll(t[++i]); };
+        if (a == "chunked") r.chunked = true;
+        else if (a == "norange") r.noRange = true;
+        else if (a == "close") r.close = true;
+        else if (!hasArg) return fail(("missing value for " + a).c_str());
+        else if (a == "port") r.port = arg();
+        else if (a == "skip") r.skip = arg();
+        else if (a == "times") r.times = arg();
+        else if (a == "latency") r.latencyMs = arg();
+        else if (a == "throttle") r.throttle = arg();
+        else if (a == "reset") r.reset = arg();
+        else if (a == "corrupt") r.corrupt = arg();
+        else if (a == "length") r.lengthDelta = arg();
+        else if (a == "status") r.status = arg();
+        else if (a == "retry-after") r.retryAfter = arg();
+        else if (a == "redirect") {
+          r.redirects = arg();
+          if (i + 1 < t.size() && isdigit((unsigned char)t[i + 1][0]) && t[i + 1].size() == 3) {
+            r.redirectCode = arg();
+          }
+        } else return fail(("unknown action " + a).c_str());
+      }
+      sc.rules.push_back(r);
+    } else {
+      return fail("expected root, listen or rule");
+    }
+  }
+  if (sc.listens.empty()) sc.listens.push_back(Listen{ false, 8080, "", "" });
+  return true;
+}
+
+// count = false only looks: a redirect chain counts once, at its last hop
+Behaviour behaviourFor(const std::string& path, int port, bool count) {
+  Behaviour b;
+  std::lock_guard<std::mutex> l(rulesMutex);
+  for (Rule& r : scenario.rules) {
+    if (fnmatch(r.glob.c_str(), path.c_str(), 0) != 0 || (r.port && r.port != port)) continue;
+    unsigned n = count ? r.matched++ : r.matched;
+    if (n < r.skip || (r.times >= 0 && n >= r.skip + r.times)) continue;
+    b.latencyMs += r.latencyMs;
+    if (r.throttle && (!b.throttle || r.throttle < b.throttle)) b.throttle = r.throttle;
+    if (r.reset >= 0) b.reset = r.reset;
+    if (r.corrupt >= 0) b.corrupt = r.corrupt;
+    b.lengthDelta += r.lengthDelta;
+    if (r.redirects) {
+      b.redirects = r.redirects;
+      b.redirectCode = r.redirectCode;
+    }
+    if (r.status) b.status = r.status;
+    if (r.retryAfter >= 0) b.retryAfter = r.retryAfter;
+    b.chunked |= r.chunked;
+    b.noRange |= r.noRange;
+    b.close |= r.close;
+  }
+  return b;
+}
+
+// --- connections ------------------------------------------------------------
+
+class Conn {
+public:
+  Conn(int fd, SSL* ssl) : fd_(fd), ssl_(ssl) {}
+  ~Conn() {
+    if (ssl_) {
+      if (!reset_) SSL_shutdown(ssl_);
+      SSL_free(ssl_);
+    }
+    close(fd_);
+  }
+
+  int read(char* buf, size_t n) {
+    return ssl_ ? SSL_read(ssl_, buf, n) : ::recv(fd_, buf, n, 0);
+  }
+
+  bool write(const void* p, size_t n) {
+    const char* c = static_cast<const char*>(p);
+    while (n) {
+      int w = ssl_ ? SSL_write(ssl_, c, n) : ::send(fd_, c, n, MSG_NOSIGNAL);
+      if (w <= 0) return false;
+      c += w;
+      n -= w;
+    }
+    return true;
+  }
+
+  bool write(const std::string& s) { return write(s.data(), s.size()); }
+
+  // RST instead of FIN, like a dropped mobile link or a crashed proxy
+  void reset() {
+    linger lg = { 1, 0 };
+    setsockopt(fd_, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    reset_ = true;
+  }
+
+private:
+  int fd_;
+  SSL* ssl_;
+  bool reset_ = false;
+};
+
+struct Request {
+  std::string method, path, host;
+  std::map<std::string, std::string> headers;   // lower-case names
+};
+
+// Reads one request header block; leftover bytes stay in pending
+bool readRequest(Conn& c, std::string& pending, Request& req) {
+  size_t end;
+  while ((end = pending.find("\r\n\r\n")) == std::string::npos) {
+    char buf[2048];
+    int n = c.read(buf, sizeof(buf));
+    if (n <= 0 || pending.size() > 16384) return false;
+    pending.append(buf, n);
+  }
+  std::istringstream head(pending.substr(0, end));
+  pending.erase(0, end + 4);
+
+  std::string line, version;
+  std::getline(head, line);
+  std::istringstream first(line);
+  first >> req.method >> req.path >> version;
+  while (std::getline(head, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    size_t colon = line.find(':');
+    if (colon == std::string::npos) continue;
+    std::string name = line.substr(0, colon);
+    for (char& ch : name) ch = tolower(ch);
+    size_t v = line.find_first_not_of(' ', colon + 1);
+    req.headers[name] = v == std::string::npos ? "" : line.substr(v);
+  }
+  req.host = req.headers["host"];
+  return !req.method.empty();
+}
+
+bool loadFile(const std::string& path, std::string& out) {
+  if (path.find("..") != std::string::npos) return false;
+  std::ifstream in(scenario.root + path, std::ios::binary);
+  if (!in) return false;
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  out = ss.str();
+  return true;
+}
+
+std::string etagOf(const std::string& data) {
+  uint64_t h = 1469598103934665603ull;   // FNV-1a
+  for (unsigned char ch : data) h = (h ^ ch) * 1099511628211ull;
+  char buf[24];
+  snprintf(buf, sizeof(buf), "\"%016llx\"", (unsigned long long)h);
+  return buf;
+}
+
+const char* reasonOf(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 206: return "Partial Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 307: return "Temporary Redirect";
+    case 308: return "Permanent Redirect";
+    case 404: return "Not Found";
+    case 416: return "Range Not Satisfiable";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "Status";
+  }
+}
+
+void logRequest(int connId, const Request& req, int status, uint64_t bytes, double ms,
+                const std::string& note) {
+  std::lock_guard<std::mutex> l(logMutex);
+  double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  auto range = req.headers.find("range");
+  printf("%9.3f #%-4d %-4s %-21s %-48s %-18s -> %3d %8llu B %7.1f ms %s\n", t, connId,
+         req.method.c_str(), req.host.c_str(), req.path.c_str(),
+         range == req.headers.end() ? "" : range->second.c_str(), status, (unsigned long long)bytes, ms,
+         note.c_str());
+  fflush(stdout);
+  totals[req.host + req.path + " " + std::to_string(status)]++;   // host: which mirror
+  totalBytes += bytes;
+}
+
+// Body with throttle, reset and chunked framing; false if the connection is gone
+bool sendBody(Conn& c, const char* data, size_t n, const Behaviour& b, uint64_t& sent, std::string& note) {
+  const size_t slice = b.throttle ? std::max<uint64_t>(64, b.throttle / 20) : 16384;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t off = 0; off < n;) {
+    size_t len = std::min(slice, n - off);
+    if (b.reset >= 0 && sent + len >= (uint64_t)b.reset) {
+      len = b.reset - sent;
+      if (len && b.chunked) {
+        char size[24];
+        snprintf(size, sizeof(size), "%zx\r\n", len);
+        c.write(size, strlen(size));
+      }
+      if (len) c.write(data + off, len);
+      sent += len;
+      c.reset();
+      note += "reset ";
+      return false;
+    }
+    if (b.chunked) {
+      char size[24];
+      snprintf(size, sizeof(size), "%zx\r\n", len);
+      if (!c.write(size, strlen(size)) || !c.write(data + off, len) || !c.write("\r\n", 2)) return false;
+    } else if (!c.write(data + off, len)) {
+      return false;
+    }
+    off += len;
+    sent += len;
+    if (b.throttle) {
+      auto due = start + std::chrono::microseconds(sent * 1000000 / b.throttle);
+      std::this_thread::sleep_until(due);
+    }
+  }
+  if (b.chunked && !c.write("0\r\n\r\n", 5)) return false;
+  return true;
+}
+
+// One request; false closes the connection
+bool handle(Conn& c, int connId, const Request& req, bool tls, int port) {
+  auto start = std::chrono::steady_clock::now();
+  auto elapsedMs = [&]() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  // /__r/<left>-<code>/<path>: inside a redirect chain, rules already applied
+  std::string path = req.path;
+  Behaviour b;
+  unsigned chainLeft = 0;
+  bool inChain = path.rfind("/__r/", 0) == 0;
+  if (inChain) {
+    size_t slash = path.find('/', 5);
+    sscanf(path.c_str() + 5, "%u-%d", &chainLeft, &b.redirectCode);
+    path = slash == std::string::npos ? "/" : path.substr(slash);
+  }
+  size_t query = path.find('?');
+  if (query != std::string::npos) path.resize(query);
+
+  if (!inChain) {
+    b = behaviourFor(path, port, false);
+    if (!b.redirects) b = behaviourFor(path, port, true);
+  } else if (chainLeft == 0) {
+    b = behaviourFor(path, port, true);
+    b.redirects = 0;
+  }
+  if (b.latencyMs) std::this_thread::sleep_for(std::chrono::milliseconds(b.latencyMs));
+
+  std::string connHdr = b.close ? "Connection: close\r\n" : "Connection: keep-alive\r\n";
+  std::string note;
+
+  unsigned redirectsLeft = inChain ? chainLeft : b.redirects;
+  if (redirectsLeft) {
+    std::string base = std::string(tls ? "https" : "http") + "://" + req.host;
+    std::string location = base + "/__r/" + std::to_string(redirectsLeft - 1) + "-" +
+                           std::to_string(b.redirectCode) + path;
+    std::string h = "HTTP/1.1 " + std::to_string(b.redirectCode) + " " + reasonOf(b.redirectCode) +
+                    "\r\nLocation: " + location + "\r\nContent-Length: 0\r\n" + connHdr + "\r\n";
+    bool ok = c.write(h);
+    logRequest(connId, req, b.redirectCode, 0, elapsedMs(), "-> " + location);
+    return ok && !b.close;
+  }
+
+  if (b.status) {
+    std::string h = "HTTP/1.1 " + std::to_string(b.status) + " " + reasonOf(b.status) + "\r\n";
+    if (b.retryAfter >= 0) h += "Retry-After: " + std::to_string(b.retryAfter) + "\r\n";
+    h += "Content-Length: 0\r\n" + connHdr + "\r\n";
+    bool ok = c.write(h);
+    logRequest(connId, req, b.status, 0, elapsedMs(), "injected");
+    return ok && !b.close;
+  }
+
+  std::string data;
+  if (!loadFile(path, data)) {
+    std::string h = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n" + connHdr + "\r\n";
+    bool ok = c.write(h);
+    logRequest(connId, req, 404, 0, elapsedMs(), "");
+    return ok && !b.close;
+  }
+
+  std::string etag = etagOf(data);
+  auto inm = req.headers.find("if-none-match");
+  if (inm != req.headers.end() && inm->second == etag) {
+    std::string h = "HTTP/1.1 304 Not Modified\r\nETag: " + etag + "\r\n" + connHdr + "\r\n";
+    bool ok = c.write(h);
+    logRequest(connId, req, 304, 0, elapsedMs(), "");
+    return ok && !b.close;
+  }
+
+  if (b.corrupt >= 0 && (size_t)b.corrupt < data.size()) {
+    data[b.corrupt] ^= 0x01;
+    note += "corrupt ";
+  }
+
+  int status = 200;
+  size_t from = 0, to = data.size();   // [from, to)
+  auto range = req.headers.find("range");
+  if (range != req.headers.end() && !b.noRange) {
+    unsigned long long a = 0, z = 0;
+    int n = sscanf(range->second.c_str(), "bytes=%llu-%llu", &a, &z);
+    if (n >= 1 && a < data.size()) {
+      from = a;
+      to = n == 2 ? std::min<size_t>(z + 1, data.size()) : data.size();
+      status = 206;
+    } else {
+      std::string h = "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */" +
+                      std::to_string(data.size()) + "\r\nContent-Length: 0\r\n" + connHdr + "\r\n";
+      bool ok = c.write(h);
+      logRequest(connId, req, 416, 0, elapsedMs(), "");
+      return ok && !b.close;
+    }
+  }
+
+  bool closeAfter = b.close || b.lengthDelta != 0;
+  std::string h = "HTTP/1.1 " + std::to_string(status) + " " + reasonOf(status) + "\r\n";
+  h += "ETag: " + etag + "\r\nAccept-Ranges: bytes\r\n";
+  auto ends = [&path](const char* ext) {
+    return path.size() > strlen(ext) && path.compare(path.size() - strlen(ext), std::string::npos, ext) == 0;
+  };
+  h += "Content-Type: " + std::string(ends(".json") ? "application/json"
+                                      : ends(".cbor") ? "application/cbor" : "application/octet-stream") + "\r\n";
+  if (status == 206) {
+    h += "Content-Range: bytes " + std::to_string(from) + "-" + std::to_string(to - 1) + "/" +
+         std::to_string(data.size()) + "\r\n";
+  }
+  if (b.chunked) {
+    h += "Transfer-Encoding: chunked\r\n";
+  } else {
+    long long length = (long long)(to - from) + b.lengthDelta;
+    h += "Content-Length: " + std::to_string(std::max(0ll, length)) + "\r\n";
+    if (b.lengthDelta) note += "length" + std::string(b.lengthDelta > 0 ? "+" : "") + std::to_string(b.lengthDelta) + " ";
+  }
+  h += closeAfter ? "Connection: close\r\n\r\n" : connHdr + "\r\n";
+
+  uint64_t sent = 0;
+  bool ok = c.write(h);
+  if (ok && req.method != "HEAD") ok = sendBody(c, data.data() + from, to - from, b, sent, note);
+  if (b.throttle) note += "throttle " + std::to_string(b.throttle) + " B/s ";
+  logRequest(connId, req, status, sent, elapsedMs(), note);
+  return ok && !closeAfter;
+}
+
+void serve(std::unique_ptr<Conn> c, int connId, bool tls, int port) {
+  std::string pending;
+  Request req;
+  while (readRequest(*c, pending, req)) {
+    if (!handle(*c, connId, req, tls, port)) break;
+    req = Request();
+  }
+}
+
+// --- TLS ------------------------------------------------------------------------
+
+// Throwaway self-signed certificate for this run only (devices use setInsecure()
+// or pin whatever the scenario's cert is)
+bool selfSigned(SSL_CTX* ctx) {
+  EVP_PKEY* key = EVP_RSA_gen(2048);
+  X509* cert = X509_new();
+  if (!key || !cert) return false;
+  ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+  X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+  X509_gmtime_adj(X509_getm_notAfter(cert), 7 * 24 * 3600);
+  X509_set_pubkey(cert, key);
+  X509_NAME* name = X509_get_subject_name(cert);
+  X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"ota-mock", -1, -1, 0);
+  X509_set_issuer_name(cert, name);
+  bool ok = X509_sign(cert, key, EVP_sha256()) > 0 && SSL_CTX_use_certificate(ctx, cert) == 1 &&
+            SSL_CTX_use_PrivateKey(ctx, key) == 1;
+  X509_free(cert);
+  EVP_PKEY_free(key);
+  return ok;
+}
+
+SSL_CTX* tlsContext(const Listen& l) {
+  SSL_CTX* ctx = SSL_CTX_new(TLS_server_method());
+  SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);   // BearSSL on the device speaks TLS 1.2
+  bool ok = l.cert.empty()
+              ? selfSigned(ctx)
+              : SSL_CTX_use_certificate_chain_file(ctx, l.cert.c_str()) == 1 &&
+                SSL_CTX_use_PrivateKey_file(ctx, l.key.c_str(), SSL_FILETYPE_PEM) == 1;
+  if (!ok) {
+    ERR_print_errors_fp(stderr);
+    SSL_CTX_free(ctx);
+    return nullptr;
+  }
+  return ctx;
+}
+
+void listenLoop(Listen l) {
+  SSL_CTX* ctx = l.tls ? tlsContext(l) : nullptr;
+  if (l.tls && !ctx) {
+    fprintf(stderr, "mock_server: no TLS context for port %d\n", l.port);
+    return;
+  }
+  int fd = socket(AF_INET6, SOCK_STREAM, 0);
+  int on = 1, off = 0;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+  sockaddr_in6 addr = {};
+  addr.sin6_family = AF_INET6;
+  addr.sin6_port = htons(l.port);
+  addr.sin6_addr = in6addr_any;
+  if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+    fprintf(stderr, "mock_server: cannot listen on %d: %s\n", l.port, strerror(errno));
+    return;
+  }
+  printf("listening %s://0.0.0.0:%d, root %s\n", l.tls ? "https" : "http", l.port, scenario.root.c_str());
+  fflush(stdout);
+
+  static std::atomic<int> nextId{ 1 };
+  for (;;) {
+    int cfd = accept(fd, nullptr, nullptr);
+    if (cfd < 0) continue;
+    setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    int id = nextId++;
+    std::thread([cfd, ctx, id, tls = l.tls, port = l.port]() {
+      SSL* ssl = nullptr;
+      if (tls) {
+        ssl = SSL_new(ctx);
+        SSL_set_fd(ssl, cfd);
+        if (SSL_accept(ssl) != 1) {
+          SSL_free(ssl);
+          close(cfd);
+          return;
+        }
+      }
+      serve(std::make_unique<Conn>(cfd, ssl), id, tls, port);
+    }).detach();
+  }
+}
+
+void printTotals() {
+  std::lock_guard<std::mutex> l(logMutex);
+  printf("\n%-72s %8s\n", "host/path status", "requests");
+  for (const auto& t : totals) printf("%-72s %8llu\n", t.first.c_str(), (unsigned long long)t.second);
+  printf("%-72s %8llu\n", "body bytes", (unsigned long long)totalBytes);
+  fflush(stdout);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 2) {
+    fprintf(stderr, "usage: mock_server [SCENARIO]\n");
+    return 2;
+  }
+  if (argc == 2 && !parseScenario(argv[1], scenario)) return 1;
+  if (argc == 1) scenario.listens.push_back(Listen{ false, 8080, "", "" });
+
+  // Connection threads inherit the mask, only main takes SIGINT/SIGTERM
+  signal(SIGPIPE, SIG_IGN);
+  sigset_t stop;
+  sigemptyset(&stop);
+  sigaddset(&stop, SIGINT);
+  sigaddset(&stop, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &stop, nullptr);
+
+  for (const Listen& l : scenario.listens) std::thread(listenLoop, l).detach();
+  int sig;
+  sigwait(&stop, &sig);
+  printTotals();
+  return 0;
+}
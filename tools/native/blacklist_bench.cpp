@@ -0,0 +1,172 @@
+// The per-version blacklist (src/ota_blacklist.cpp) over the OTA journal,
+// on the core stand-in of tools/native:
+//
+//   make -C tools/native blacklist_bench
+//   tools/native/blacklist_bench
+//
+// - backoff: blacklistBackoffS() doubles from BLACKLIST_BASE_S and stays at
+//   BLACKLIST_MAX_S
+// - no clock: before the wall clock is valid, the wait counts from the
+//   attempt of this session
+// - wall clock (restored from RTC memory, then set by hand): after each
+//   failure the version waits exactly its backoff, after
+//   BLACKLIST_POISON_FAILURES it is poisoned, through a reboot and the same
+//   manifest; a different manifest clears it
+// - reverted: a rollback poisons the version at once
+// - json: /blacklist lists the versions and the failure codes
+//
+// Exit code 1 if a check fails.
+
+#include <string>
+
+#include <Arduino.h>
+#include <StreamString.h>
+#include <sys/time.h>
+#include <user_interface.h>
+
+#include "native.h"
+#include "ota_blacklist.h"
+#include "ota_journal.h"
+#include "rtc_layout.h"
+#include "time_sync.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+  printf("  %-56s %s\n", what.c_str(), ok ? "ok" : "FAIL");
+  if (!ok) failures++;
+}
+
+const char* URL = "https://ota.example.com/fw/esp8266-power.bin";
+const char* URL_MOVED = "https://ota.example.com/fw/v2/esp8266-power.bin";
+const char* V1 = "2025.01.01";
+const char* V2 = "2025.02.01";
+const char* V3 = "2025.03.01";
+
+// At a whole second, so the checks right after it see the same second
+void setClock(uint32_t s) {
+  struct timeval tv = { (time_t)s, 0 };
+  settimeofday(&tv, nullptr);
+}
+
+void fail(const char* version, int16_t code) {
+  blacklistAttempt(version);
+  journalOtaBegin(version);
+  journalOtaEnd(code, 1000);
+}
+
+std::string verdict(const char* version) {
+  uint32_t waitS;
+  BlacklistVerdict v = blacklistCheck(version, &waitS);
+  return std::string(blacklistVerdictName(v)) + " " + std::to_string(waitS);
+}
+
+void backoff() {
+  printf("backoff:\n");
+  uint32_t expect = BLACKLIST_BASE_S;
+  bool doubling = true;
+  for (uint16_t f = 1; f <= 20; f++) {
+    if (blacklistBackoffS(f) != expect) doubling = false;
+    expect = min<uint32_t>(expect * 2, BLACKLIST_MAX_S);
+  }
+  printf("  %u %u %u ... %u s\n", blacklistBackoffS(1), blacklistBackoffS(2), blacklistBackoffS(3),
+         blacklistBackoffS(20));
+  check(doubling, "doubles from the base, up to the maximum");
+  check(blacklistBackoffS(0) == BLACKLIST_BASE_S, "no failure yet: the base");
+  check(blacklistBackoffS(65535) == BLACKLIST_MAX_S, "maximum for any count");
+}
+
+void noClock() {
+  printf("no clock:\n");
+  blacklistManifest(V1, URL);
+  check(verdict(V1) == "allow 0", "unknown version allowed");
+  fail(V1, -104);
+  check(journalVersion(V1)->lastAttemptS == 0, "attempt without a wall clock");
+  check(verdict(V1) == "backoff " + std::to_string(BLACKLIST_BASE_S), "waits its backoff from this attempt");
+}
+
+void wallClock() {
+  printf("wall clock:\n");
+  TimeRtc rec = { TIME_MAGIC, 1700000000, system_get_rtc_time(), system_rtc_clock_cali_proc() };
+  ESP.rtcUserMemoryWrite(RTC_BLOCK_TIME, reinterpret_cast<uint32_t*>(&rec), sizeof(rec));
+  timeBegin();
+  check(timeState() == TIME_RESTORED, "clock restored from RTC memory");
+
+  blacklistManifest(V1, URL_MOVED);
+  check(!journalVersion(V1), "different manifest clears the counters");
+
+  uint32_t now = 1700000000;
+  bool exact = true, allowed = true;
+  for (uint16_t f = 1; f < BLACKLIST_POISON_FAILURES; f++) {
+    setClock(now);
+    fail(V1, -104);
+    uint32_t wait = blacklistBackoffS(f);
+    if (verdict(V1) != "backoff " + std::to_string(wait)) exact = false;
+    setClock(now + wait - 1);
+    if (verdict(V1) != "backoff 1") exact = false;
+    now += wait;
+    setClock(now);
+    if (verdict(V1) != "allow 0") allowed = false;
+  }
+  check(exact, "waits the backoff of its failure count");
+  check(allowed, "allowed once the backoff is over");
+
+  fail(V1, -104);
+  check(verdict(V1) == "poisoned 0", "poisoned after the last allowed failure");
+  setClock(now + 10 * BLACKLIST_MAX_S);
+  check(verdict(V1) == "poisoned 0", "poisoned for good");
+  journalBegin();
+  blacklistManifest(V1, URL_MOVED);
+  check(verdict(V1) == "poisoned 0", "poisoned through a reboot and the same manifest");
+  blacklistManifest(V1, URL);
+  check(verdict(V1) == "allow 0", "allowed after the manifest changed");
+}
+
+void reverted() {
+  printf("reverted:\n");
+  blacklistManifest(V2, URL);
+  journalOtaBegin(V2);
+  journalOtaEnd(JOURNAL_OTA_OK, 1000);
+  check(verdict(V2) == "allow 0", "successful attempt not counted");
+  journalVersionFailed(V2, JOURNAL_OTA_REVERTED);
+  check(verdict(V2) == "poisoned 0", "rolled back: poisoned at the first failure");
+}
+
+void json() {
+  printf("json:\n");
+  setClock(1800000000);
+  for (int i = 0; i < 2; i++) fail(V3, -106);
+  StreamString out;
+  blacklistWriteJson(out);
+  printf("  %s\n", out.c_str());
+  check(out.indexOf("{\"version\":\"2025.02.01\",\"attempts\":1,\"failures\":1,\"last_error\":-1001,"
+                    "\"verdict\":\"poisoned\",\"wait_s\":0}") >= 0 &&
+            out.indexOf("{\"version\":\"2025.03.01\",\"attempts\":2,\"failures\":2,\"last_error\":-106,"
+                        "\"verdict\":\"backoff\",\"wait_s\":600}") >= 0,
+        "versions with their counters and verdicts");
+  // the codes outlive the manifest changes
+  check(out.indexOf("\"-104\":6") >= 0 && out.indexOf("\"-1001\":1") >= 0 && out.indexOf("\"-106\":2") >= 0,
+        "failure codes counted across manifests");
+}
+
+}  // namespace
+
+int main() {
+  memset(nativeFlash, 0xFF, sizeof(nativeFlash));   // erased
+  journalBegin();
+
+  backoff();
+  noClock();
+  wallClock();
+  reverted();
+  json();
+
+  if (failures) {
+    fprintf(stderr, "blacklist_bench: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("blacklist_bench: ok\n");
+  return 0;
+}
@@ -0,0 +1,583 @@
+// Core stand-in for tools/native: String, Print/Stream, Serial, time,
+// ESP (flash, RTC memory, heap figures), eboot command, MD5Builder.
+
+#include <openssl/evp.h>
+#include <unistd.h>
+
+#include <Arduino.h>
+#include <MD5Builder.h>
+#include <coredecls.h>
+#include <eboot_command.h>
+#include <flash_hal.h>
+#include <user_interface.h>
+
+#include "native.h"
+
+#undef time
+#undef gettimeofday
+#undef settimeofday
+
+HardwareSerial Serial;
+EspClass ESP;
+
+size_t strlcpy(char* dst, const char* src, size_t size) {
+  size_t n = strlen(src);
+  if (size) {
+    size_t c = n < size - 1 ? n : size - 1;
+    memcpy(dst, src, c);
+    dst[c] = 0;
+  }
+  return n;
+}
+
+size_t strlcat(char* dst, const char* src, size_t size) {
+  size_t d = strnlen(dst, size);
+  return d == size ? size + strlen(src) : d + strlcpy(dst + d, src, size - d);
+}
+
+// --- time ---
+
+static uint64_t monotonicUs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static const uint64_t bootUs = monotonicUs();
+
+unsigned long micros() {
+  return (unsigned long)(uint32_t)(monotonicUs() - bootUs);
+}
+
+unsigned long millis() {
+  return (unsigned long)(uint32_t)((monotonicUs() - bootUs) / 1000);
+}
+
+static int64_t clockOffsetUs = 0;   // device clock = uptime + offset
+static BoolCB timeSetCb;
+static uint32_t sntpAtMs = 0;       // 0 = no reply pending
+
+static void sntpPoll() {
+  if (!sntpAtMs || millis() < sntpAtMs) return;
+  sntpAtMs = 0;
+  struct timeval host;
+  gettimeofday(&host, nullptr);
+  clockOffsetUs = (int64_t)host.tv_sec * 1000000 + host.tv_usec - (int64_t)(monotonicUs() - bootUs);
+  if (timeSetCb) timeSetCb(true);
+}
+
+void delay(unsigned long ms) {
+  uint32_t start = millis();
+  for (;;) {
+    sntpPoll();
+    nativeTick();
+    uint32_t spent = millis() - start;
+    if (spent >= ms) break;
+    usleep(min<uint32_t>(ms - spent, 10) * 1000);
+  }
+}
+
+void yield() {
+  sntpPoll();
+  nativeTick();
+}
+
+void settimeofday_cb(const BoolCB& cb) {
+  timeSetCb = cb;
+}
+
+void configTime(int, int, const char*, const char*, const char*) {
+  const char* delayMs = getenv("NATIVE_SNTP_DELAY_MS");
+  sntpAtMs = millis() + (delayMs ? atoi(delayMs) : 1500) + 1;
+}
+
+time_t nativeTime(time_t* t) {
+  time_t now = (time_t)(((int64_t)(monotonicUs() - bootUs) + clockOffsetUs) / 1000000);
+  if (t) *t = now;
+  return now;
+}
+
+int nativeGettimeofday(struct timeval* tv, void*) {
+  int64_t us = (int64_t)(monotonicUs() - bootUs) + clockOffsetUs;
+  tv->tv_sec = us / 1000000;
+  tv->tv_usec = us % 1000000;
+  return 0;
+}
+
+int nativeSettimeofday(const struct timeval* tv, const struct timezone*) {
+  clockOffsetUs = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec - (int64_t)(monotonicUs() - bootUs);
+  if (timeSetCb) timeSetCb(false);
+  return 0;
+}
+
+// ~5.75 us per tick, as a calibrated ESP8266 RTC
+static const uint32_t RTC_CALI = 23552;
+
+uint32_t system_get_rtc_time() {
+  return (uint32_t)(monotonicUs() * 4096 / RTC_CALI);
+}
+
+uint32_t system_rtc_clock_cali_proc() {
+  return RTC_CALI;
+}
+
+// --- pins ---
+
+static uint8_t pins[17];
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < sizeof(pins)) pins[pin] = value;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < sizeof(pins) ? pins[pin] : LOW;
+}
+
+// --- String, Print, Stream, Serial ---
+
+String::String(long v, unsigned char base) {
+  if (base == 10) {
+    _s = std::to_string(v);
+  } else if (v < 0) {
+    _s = "-" + String((unsigned long)-v, base)._s;
+  } else {
+    *this = String((unsigned long)v, base);
+  }
+}
+
+String::String(unsigned long v, unsigned char base) {
+  do {
+    _s.insert(_s.begin(), "0123456789abcdefghijklmnopqrstuvwxyz"[v % base]);
+    v /= base;
+  } while (v);
+}
+
+String::String(double v, unsigned char decimals) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+  _s = buf;
+}
+
+void String::replace(const String& find, const String& with) {
+  if (find._s.empty()) return;
+  for (size_t at = _s.find(find._s); at != std::string::npos; at = _s.find(find._s, at + with._s.size())) {
+    _s.replace(at, find._s.size(), with._s);
+  }
+}
+
+void String::trim() {
+  size_t b = _s.find_first_not_of(" \t\r\n");
+  if (b == std::string::npos) {
+    _s.clear();
+    return;
+  }
+  _s = _s.substr(b, _s.find_last_not_of(" \t\r\n") - b + 1);
+}
+
+static size_t vprint(Print& out, const char* fmt, va_list ap) {
+  char buf[256];
+  va_list copy;
+  va_copy(copy, ap);
+  int n = vsnprintf(buf, sizeof(buf), fmt, copy);
+  va_end(copy);
+  if (n < 0) return 0;
+  if ((size_t)n < sizeof(buf)) return out.write(reinterpret_cast<const uint8_t*>(buf), n);
+  std::string big(n + 1, 0);
+  vsnprintf(&big[0], big.size(), fmt, ap);
+  return out.write(reinterpret_cast<const uint8_t*>(big.data()), n);
+}
+
+size_t Print::printf(const char* fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  size_t n = vprint(*this, fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+size_t Print::printf_P(const char* fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  size_t n = vprint(*this, fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+int Stream::timedRead() {
+  uint32_t start = millis();
+  do {
+    int c = read();
+    if (c >= 0) return c;
+    yield();
+    usleep(200);
+  } while (millis() - start < _timeout);
+  return -1;
+}
+
+size_t Stream::readBytes(char* buf, size_t n) {
+  size_t count = 0;
+  while (count < n) {
+    int c = timedRead();
+    if (c < 0) break;
+    buf[count++] = (char)c;
+  }
+  return count;
+}
+
+String Stream::readStringUntil(char terminator) {
+  String s;
+  for (int c = timedRead(); c >= 0 && c != terminator; c = timedRead()) s.concat((char)c);
+  return s;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t n) {
+  return fwrite(buf, 1, n, stdout);
+}
+
+void HardwareSerial::flush() {
+  fflush(stdout);
+}
+
+// --- ESP ---
+
+static uint32_t freeHeap() {
+  // custom_budget_heap minus what the SDK and Wi-Fi take (tools/arena_sim)
+  static const char* env = getenv("NATIVE_FREE_HEAP");
+  return env ? strtoul(env, nullptr, 0) : 49152 - 9216;
+}
+
+uint32_t EspClass::getFreeHeap() {
+  return freeHeap();
+}
+
+uint32_t EspClass::getMaxFreeBlockSize() {
+  return freeHeap() - 2048;
+}
+
+uint8_t EspClass::getHeapFragmentation() {
+  return 5;
+}
+
+void EspClass::getHeapStats(uint32_t* free, uint32_t* max, uint8_t* frag) {
+  if (free) *free = getFreeHeap();
+  if (max) *max = getMaxFreeBlockSize();
+  if (frag) *frag = getHeapFragmentation();
+}
+
+void EspClass::restart() {
+  nativeRestart(REASON_SOFT_RESTART);
+}
+
+const char* EspClass::getSdkVersion() {
+  return system_get_sdk_version();
+}
+
+String EspClass::getResetReason() {
+  switch (nativeResetReason) {
+    case REASON_DEFAULT_RST: return F("Power On");
+    case REASON_WDT_RST: return F("Hardware Watchdog");
+    case REASON_EXCEPTION_RST: return F("Exception");
+    case REASON_SOFT_WDT_RST: return F("Software Watchdog");
+    case REASON_SOFT_RESTART: return F("Software/System restart");
+    case REASON_DEEP_SLEEP_AWAKE: return F("Deep-Sleep Wake");
+    case REASON_EXT_SYS_RST: return F("External System");
+    default: return F("Unknown");
+  }
+}
+
+rst_info* EspClass::getResetInfoPtr() {
+  static rst_info info;
+  info.reason = nativeResetReason;
+  return &info;
+}
+
+uint32_t EspClass::getSketchSize() {
+  static uint32_t size = nativeImageSize(0);   // cached, as in the core
+  return size;
+}
+
+uint32_t EspClass::getFreeSketchSpace() {
+  uint32_t used = (getSketchSize() + FLASH_SECTOR_SIZE - 1) & ~(FLASH_SECTOR_SIZE - 1);
+  return FS_PHYS_ADDR - used;
+}
+
+int32_t nativeFlashBudget = -1;
+
+static void powerCutCheck() {
+  if (nativeFlashBudget == 0) nativeRestart(REASON_DEFAULT_RST);
+}
+
+// NOR flash: erase sets a sector to 0xFF, programming only clears bits
+bool EspClass::flashEraseSector(uint32_t sector) {
+  if ((sector + 1) * FLASH_SECTOR_SIZE > NATIVE_FLASH_SIZE) return false;
+  powerCutCheck();
+  memset(nativeFlash + sector * FLASH_SECTOR_SIZE, 0xFF, FLASH_SECTOR_SIZE);
+  return true;
+}
+
+bool EspClass::flashWrite(uint32_t address, const uint8_t* data, size_t size) {
+  if ((address & 3) || (size & 3) || address + size > NATIVE_FLASH_SIZE) return false;
+  for (size_t i = 0; i < size; i++) {
+    powerCutCheck();
+    if (nativeFlashBudget > 0) nativeFlashBudget--;
+    nativeFlash[address + i] &= data[i];
+  }
+  return true;
+}
+
+bool EspClass::flashWrite(uint32_t address, const uint32_t* data, size_t size) {
+  return flashWrite(address, reinterpret_cast<const uint8_t*>(data), size);
+}
+
+bool EspClass::flashRead(uint32_t address, uint8_t* data, size_t size) {
+  if (address + size > NATIVE_FLASH_SIZE) return false;
+  memcpy(data, nativeFlash + address, size);
+  return true;
+}
+
+bool EspClass::flashRead(uint32_t address, uint32_t* data, size_t size) {
+  return flashRead(address, reinterpret_cast<uint8_t*>(data), size);
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size) {
+  if (offset * 4 + size > NATIVE_RTC_SIZE || (size & 3)) return false;
+  memcpy(data, nativeRtc + offset * 4, size);
+  return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size) {
+  if (offset * 4 + size > NATIVE_RTC_SIZE || (size & 3)) return false;
+  memcpy(nativeRtc + offset * 4, data, size);
+  return true;
+}
+
+// --- eboot command, RTC blocks 0..31 ---
+
+static uint32_t crc32(const void* data, size_t len) {
+  uint32_t crc = 0xffffffff;
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < len; i++) {
+    crc ^= p[i];
+    for (int b = 0; b < 8; b++) crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+  }
+  return crc;
+}
+
+int eboot_command_read(struct eboot_command* cmd) {
+  memcpy(cmd, nativeRtc, sizeof(*cmd));
+  if ((cmd->magic & EBOOT_MAGIC_MASK) != EBOOT_MAGIC) return 1;
+  return crc32(cmd, offsetof(eboot_command, crc32)) == cmd->crc32 ? 0 : 1;
+}
+
+void eboot_command_write(struct eboot_command* cmd) {
+  cmd->magic = EBOOT_MAGIC;
+  cmd->crc32 = crc32(cmd, offsetof(eboot_command, crc32));
+  memcpy(nativeRtc, cmd, sizeof(*cmd));
+}
+
+void eboot_command_clear() {
+  memset(nativeRtc, 0, sizeof(eboot_command));
+}
+
+// --- MD5Builder ---
+
+MD5Builder::MD5Builder() : _ctx(EVP_MD_CTX_new()) {}
+
+MD5Builder::~MD5Builder() {
+  EVP_MD_CTX_free(static_cast<EVP_MD_CTX*>(_ctx));
+}
+
+void MD5Builder::begin() {
+  EVP_DigestInit_ex(static_cast<EVP_MD_CTX*>(_ctx), EVP_md5(), nullptr);
+  memset(_buf, 0, sizeof(_buf));
+}
+
+void MD5Builder::add(const uint8_t* data, uint16_t len) {
+  EVP_DigestUpdate(static_cast<EVP_MD_CTX*>(_ctx), data, len);
+}
+
+void MD5Builder::calculate() {
+  unsigned int n = sizeof(_buf);
+  EVP_DigestFinal_ex(static_cast<EVP_MD_CTX*>(_ctx), _buf, &n);
+}
+
+void MD5Builder::getBytes(uint8_t* output) const {
+  memcpy(output, _buf, sizeof(_buf));
+}
+
+void MD5Builder::getChars(char* output) const {
+  for (int i = 0; i < 16; i++) sprintf(output + i * 2, "%02x", _buf[i]);
+}
+
+String MD5Builder::toString() const {
+  char s[33];
+  getChars(s);
+  return s;
+}
+
+// --- Updater ---
+
+UpdaterClass Update;
+
+static const char* updaterError(uint8_t err) {
+  switch (err) {
+    case UPDATE_ERROR_OK: return "No Error";
+    case UPDATE_ERROR_WRITE: return "Flash Write Failed";
+    case UPDATE_ERROR_ERASE: return "Flash Erase Failed";
+    case UPDATE_ERROR_READ: return "Flash Read Failed";
+    case UPDATE_ERROR_SPACE: return "Not Enough Space";
+    case UPDATE_ERROR_SIZE: return "Bad Size Given";
+    case UPDATE_ERROR_STREAM: return "Stream Read Timeout";
+    case UPDATE_ERROR_MD5: return "MD5 Check Failed";
+    case UPDATE_ERROR_MAGIC_BYTE: return "Magic byte is wrong, not 0xE9";
+    default: return "UNKNOWN";
+  }
+}
+
+String UpdaterClass::getErrorString() const {
+  return updaterError(_error);
+}
+
+void UpdaterClass::reset() {
+  if (_ledPin >= 0) digitalWrite(_ledPin, !_ledOn);
+  _size = _written = _buffered = 0;
+  _md5 = String();
+}
+
+void UpdaterClass::fail(uint8_t error) {
+  _error = error;
+  reset();
+}
+
+bool UpdaterClass::begin(size_t size, int, int ledPin, uint8_t ledOn) {
+  if (_size) return false;   // already running
+  _error = UPDATE_ERROR_OK;
+  if (size == 0) {
+    _error = UPDATE_ERROR_SIZE;
+    return false;
+  }
+  uint32_t rounded = (size + FLASH_SECTOR_SIZE - 1) & ~(FLASH_SECTOR_SIZE - 1);
+  uint32_t sketch = (ESP.getSketchSize() + FLASH_SECTOR_SIZE - 1) & ~(FLASH_SECTOR_SIZE - 1);
+  if (rounded > FS_PHYS_ADDR || FS_PHYS_ADDR - rounded < sketch) {
+    _error = UPDATE_ERROR_SPACE;
+    return false;
+  }
+  uint8_t running[4];
+  ESP.flashRead(0, running, sizeof(running));
+  _runningMode = running[2];
+  _start = FS_PHYS_ADDR - rounded;
+  _size = size;
+  _ledPin = ledPin;
+  _ledOn = ledOn;
+  _hash.begin();
+  if (_ledPin >= 0) digitalWrite(_ledPin, _ledOn);
+  return true;
+}
+
+bool UpdaterClass::setMD5(const char* expected_md5) {
+  if (strlen(expected_md5) != 32) return false;
+  _md5 = expected_md5;
+  return true;
+}
+
+// One sector, padded with 0xFF
+bool UpdaterClass::flushBuffer() {
+  uint32_t off = _written - _buffered;
+  if (off == 0) {
+    if (_buf[0] != 0xE9) {
+      fail(UPDATE_ERROR_MAGIC_BYTE);
+      return false;
+    }
+    _buf[2] = _runningMode;   // keep the flash mode of the running sketch
+  }
+  _hash.add(_buf, _buffered);
+  memset(_buf + _buffered, 0xFF, FLASH_SECTOR_SIZE - _buffered);
+  uint32_t addr = _start + off;
+  if (!ESP.flashEraseSector(addr / FLASH_SECTOR_SIZE)) {
+    fail(UPDATE_ERROR_ERASE);
+    return false;
+  }
+  if (!ESP.flashWrite(addr, _buf, FLASH_SECTOR_SIZE)) {
+    fail(UPDATE_ERROR_WRITE);
+    return false;
+  }
+  _buffered = 0;
+  if (_progress) _progress(_written, _size);
+  return true;
+}
+
+size_t UpdaterClass::write(uint8_t* data, size_t len) {
+  if (hasError() || !isRunning()) return 0;
+  if (len > remaining()) {
+    fail(UPDATE_ERROR_SPACE);
+    return 0;
+  }
+  size_t left = len;
+  while (left) {
+    size_t n = std::min(left, (size_t)FLASH_SECTOR_SIZE - _buffered);
+    memcpy(_buf + _buffered, data, n);
+    _buffered += n;
+    _written += n;
+    data += n;
+    left -= n;
+    if ((_buffered == FLASH_SECTOR_SIZE || !remaining()) && !flushBuffer()) return 0;
+  }
+  return len;
+}
+
+// A read that times out gets one more try after 100 ms, as in the core
+size_t UpdaterClass::writeStream(Stream& data) {
+  if (hasError() || !isRunning()) return 0;
+  size_t written = 0;
+  while (remaining()) {
+    size_t want = std::min((size_t)FLASH_SECTOR_SIZE - _buffered, remaining());
+    size_t got = data.readBytes(_buf + _buffered, want);
+    if (got == 0) {
+      delay(100);
+      got = data.readBytes(_buf + _buffered, want);
+      if (got == 0) {
+        fail(UPDATE_ERROR_STREAM);
+        return written;
+      }
+    }
+    _buffered += got;
+    _written += got;
+    written += got;
+    if ((_buffered == FLASH_SECTOR_SIZE || !remaining()) && !flushBuffer()) return written;
+    yield();
+  }
+  return written;
+}
+
+bool UpdaterClass::end(bool evenIfRemaining) {
+  if (!isRunning()) return false;
+  if (hasError() || (!isFinished() && !evenIfRemaining)) {
+    reset();
+    return false;
+  }
+  if (evenIfRemaining) {
+    if (_buffered && !flushBuffer()) return false;
+    _size = _written;
+  }
+  _hash.calculate();
+  if (_md5.length() && !_hash.toString().equalsIgnoreCase(_md5)) {
+    fail(UPDATE_ERROR_MD5);
+    return false;
+  }
+
+  eboot_command cmd;
+  memset(&cmd, 0, sizeof(cmd));
+  cmd.action = ACTION_COPY_RAW;
+  cmd.args[0] = _start;
+  cmd.args[1] = 0;
+  cmd.args[2] = _size;
+  eboot_command_write(&cmd);
+  reset();
+  return true;
+}
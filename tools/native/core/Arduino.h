@@ -0,0 +1,296 @@
+// Host stand-in for the parts of the ESP8266 Arduino core (3.1) the
+// firmware uses, for tools/native. Declarations follow the core so
+// src/*.cpp compile unchanged; behaviour is documented where it differs.
+
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "flash_hal.h"   // FLASH_SECTOR_SIZE, through Esp.h in the core
+#include "native_time.h"
+
+using std::max;
+using std::min;
+
+// --- pgmspace: flash and RAM are the same on the host ---
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper*>(p))
+#define F(s) FPSTR(s)
+#define pgm_read_byte(p) (*reinterpret_cast<const uint8_t*>(p))
+#define pgm_read_word(p) (*reinterpret_cast<const uint16_t*>(p))
+#define pgm_read_dword(p) (*reinterpret_cast<const uint32_t*>(p))
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define memcpy_P memcpy
+#define snprintf_P snprintf
+#define vsnprintf_P vsnprintf
+#define sprintf_P sprintf
+
+class __FlashStringHelper;
+
+size_t strlcpy(char* dst, const char* src, size_t size);
+size_t strlcat(char* dst, const char* src, size_t size);
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// --- time, pins ---
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define LED_BUILTIN 2
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+// --- math, characters ---
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+inline bool isAlphaNumeric(int c) { return isalnum(c) != 0; }
+
+// --- String ---
+
+#define DEC 10
+#define HEX 16
+
+class String {
+ public:
+  String() {}
+  String(const char* s) : _s(s ? s : "") {}
+  String(const std::string& s) : _s(s) {}
+  String(const __FlashStringHelper* s) : _s(reinterpret_cast<const char*>(s)) {}
+  explicit String(char c) : _s(1, c) {}
+  explicit String(int v) : _s(std::to_string(v)) {}
+  explicit String(unsigned v) : _s(std::to_string(v)) {}
+  explicit String(long v) : _s(std::to_string(v)) {}
+  explicit String(unsigned long v) : _s(std::to_string(v)) {}
+  String(int v, unsigned char base) : String((long)v, base) {}
+  String(unsigned v, unsigned char base) : String((unsigned long)v, base) {}
+  String(long v, unsigned char base);
+  String(unsigned long v, unsigned char base);
+  explicit String(double v, unsigned char decimals = 2);
+
+  const char* c_str() const { return _s.c_str(); }
+  unsigned int length() const { return _s.size(); }
+  bool isEmpty() const { return _s.empty(); }
+  explicit operator bool() const { return true; }
+
+  char operator[](unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+  char& operator[](unsigned int i) { return _s[i]; }
+  char charAt(unsigned int i) const { return (*this)[i]; }
+
+  String& operator=(const char* s) { _s = s ? s : ""; return *this; }
+  String& operator+=(const String& s) { _s += s._s; return *this; }
+  String& operator+=(const char* s) { _s += s ? s : ""; return *this; }
+  String& operator+=(char c) { _s += c; return *this; }
+  bool concat(const char* s, unsigned int n) { _s.append(s, n); return true; }
+  bool concat(char c) { _s += c; return true; }
+
+  bool operator==(const String& s) const { return _s == s._s; }
+  bool operator==(const char* s) const { return _s == (s ? s : ""); }
+  bool operator!=(const String& s) const { return _s != s._s; }
+  bool operator!=(const char* s) const { return !(*this == s); }
+  bool operator<(const String& s) const { return _s < s._s; }
+
+  bool equals(const String& s) const { return _s == s._s; }
+  bool equalsIgnoreCase(const String& s) const { return strcasecmp(c_str(), s.c_str()) == 0; }
+  bool startsWith(const String& p) const { return _s.compare(0, p._s.size(), p._s) == 0; }
+  bool endsWith(const String& p) const {
+    return _s.size() >= p._s.size() && _s.compare(_s.size() - p._s.size(), p._s.size(), p._s) == 0;
+  }
+
+  int indexOf(char c, unsigned int from = 0) const { return pos(_s.find(c, from)); }
+  int indexOf(const String& s, unsigned int from = 0) const { return pos(_s.find(s._s, from)); }
+  int lastIndexOf(char c) const { return pos(_s.rfind(c)); }
+  String substring(unsigned int from) const { return from < _s.size() ? _s.substr(from) : std::string(); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (to > _s.size()) to = _s.size();
+    return from < to ? _s.substr(from, to - from) : std::string();
+  }
+
+  void toLowerCase() { for (char& c : _s) c = tolower((unsigned char)c); }
+  void toUpperCase() { for (char& c : _s) c = toupper((unsigned char)c); }
+  void trim();
+  void remove(unsigned int index, unsigned int count = (unsigned int)-1) { _s.erase(index, count); }
+  void replace(char find, char with) { std::replace(_s.begin(), _s.end(), find, with); }
+  void replace(const String& find, const String& with);
+  void toCharArray(char* buf, unsigned int size, unsigned int index = 0) const {
+    if (size) strlcpy(buf, index < _s.size() ? c_str() + index : "", size);
+  }
+  void clear() { _s.clear(); }
+  bool reserve(unsigned int n) { _s.reserve(n); return true; }
+  long toInt() const { return strtol(c_str(), nullptr, 10); }
+
+  const std::string& str() const { return _s; }
+
+ protected:
+  std::string _s;
+
+ private:
+  static int pos(size_t p) { return p == std::string::npos ? -1 : (int)p; }
+};
+
+inline String operator+(const String& a, const String& b) { return String(a.str() + b.str()); }
+inline String operator+(const String& a, const char* b) { return String(a.str() + (b ? b : "")); }
+inline String operator+(const char* a, const String& b) { return String((a ? a : "") + b.str()); }
+inline String operator+(const String& a, char c) { return String(a.str() + c); }
+
+// --- Print / Stream ---
+
+class Print;
+
+class Printable {
+ public:
+  virtual ~Printable() {}
+  virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t n) {
+    size_t done = 0;
+    while (done < n && write(buf[done])) done++;
+    return done;
+  }
+  size_t write(const char* s) { return s ? write(reinterpret_cast<const uint8_t*>(s), strlen(s)) : 0; }
+  size_t write(const char* buf, size_t n) { return write(reinterpret_cast<const uint8_t*>(buf), n); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+  size_t printf_P(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String& s) { return write(s.c_str(), s.length()); }
+  size_t print(const __FlashStringHelper* s) { return print(reinterpret_cast<const char*>(s)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned v) { return printf("%u", v); }
+  size_t print(long v) { return printf("%ld", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+  size_t print(const Printable& p) { return p.printTo(*this); }
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T& v) { return print(v) + println(); }
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long ms) { _timeout = ms; }
+  unsigned long getTimeout() const { return _timeout; }
+  virtual size_t readBytes(char* buf, size_t n);
+  size_t readBytes(uint8_t* buf, size_t n) { return readBytes(reinterpret_cast<char*>(buf), n); }
+  String readStringUntil(char terminator);
+
+ protected:
+  int timedRead();
+  unsigned long _timeout = 1000;
+};
+
+// stdout; reads nothing
+class HardwareSerial : public Stream {
+ public:
+  void begin(unsigned long) {}
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buf, size_t n) override;
+  using Print::write;
+  int availableForWrite() override { return 128; }
+  void flush() override;
+};
+
+extern HardwareSerial Serial;
+
+// --- ESP ---
+
+#define WDTO_8S 8000
+
+struct rst_info;
+
+// Flash is a file-backed 4 MB image (tools/native/native.cpp), RTC user
+// memory 512 bytes kept across ESP.restart(). The heap figures are fixed:
+// NATIVE_FREE_HEAP, the free heap of an idle device with custom_budget_heap.
+class EspClass {
+ public:
+  void restart() __attribute__((noreturn));
+  void wdtEnable(uint32_t) {}
+  void wdtDisable() {}
+  void wdtFeed() {}
+
+  uint32_t getFreeHeap();
+  uint32_t getMaxFreeBlockSize();
+  uint8_t getHeapFragmentation();
+  void getHeapStats(uint32_t* free = nullptr, uint32_t* max = nullptr, uint8_t* frag = nullptr);
+  uint32_t getFreeContStack() { return 2048; }
+  uint32_t getChipId() { return 0x00c0ffee; }
+  uint32_t getCycleCount() { return micros() * 80; }
+
+  uint32_t getSketchSize();
+  uint32_t getFreeSketchSpace();
+  uint32_t getFlashChipSize() { return 4u << 20; }
+  uint32_t getFlashChipRealSize() { return 4u << 20; }
+  uint32_t getFlashChipId() { return 0x1640ef; }
+  uint8_t getCpuFreqMHz() { return 80; }
+  String getCoreVersion() { return "3_1_2"; }
+  const char* getSdkVersion();
+  String getResetReason();
+  bool eraseConfig();
+  rst_info* getResetInfoPtr();
+
+  bool flashEraseSector(uint32_t sector);
+  bool flashWrite(uint32_t address, const uint32_t* data, size_t size);
+  bool flashWrite(uint32_t address, const uint8_t* data, size_t size);
+  bool flashRead(uint32_t address, uint32_t* data, size_t size);
+  bool flashRead(uint32_t address, uint8_t* data, size_t size);
+
+  bool rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size);
+  bool rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size);
+};
+
+extern EspClass ESP;
+
+#include "Updater.h"   // Update, as in the core
+
+#endif
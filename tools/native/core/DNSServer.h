@@ -0,0 +1,36 @@
+#ifndef NATIVE_DNSSERVER_H
+#define NATIVE_DNSSERVER_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+enum class DNSReplyCode {
+  NoError = 0,
+  FormError = 1,
+  ServerFailure = 2,
+  NonExistentDomain = 3,
+  NotImplemented = 4,
+  Refused = 5,
+};
+
+// The captive portal's DNS: clients reach the host by its address, so
+// nothing listens and processNextRequest() has nothing to answer.
+class DNSServer {
+ public:
+  void setErrorReplyCode(const DNSReplyCode& code) { _code = code; }
+  void setTTL(const uint32_t& ttl) { _ttl = ttl; }
+  bool start(const uint16_t& port, const String& domainName, const IPAddress& resolvedIP) {
+    (void)port;
+    (void)domainName;
+    (void)resolvedIP;
+    return true;
+  }
+  void stop() {}
+  void processNextRequest() {}
+
+ private:
+  DNSReplyCode _code = DNSReplyCode::NonExistentDomain;
+  uint32_t _ttl = 60;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef NATIVE_ESP8266HTTPCLIENT_H
+#define NATIVE_ESP8266HTTPCLIENT_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+#include <vector>
+
+// The core's HTTPClient (3.1) as far as the firmware uses it: begin()
+// works on a clone() of the client, end() keeps the connection when
+// setReuse(true) and the server keeps it alive, getStream() is the raw
+// connection (chunked framing included), redirects are followed inside
+// GET() only if asked to.
+
+#define HTTPC_ERROR_CONNECTION_FAILED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_STREAM (-6)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_TOO_LESS_RAM (-8)
+#define HTTPC_ERROR_ENCODING (-9)
+#define HTTPC_ERROR_STREAM_WRITE (-10)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+#define HTTPCLIENT_DEFAULT_TCP_TIMEOUT 5000
+
+enum t_http_codes {
+  HTTP_CODE_OK = 200,
+  HTTP_CODE_PARTIAL_CONTENT = 206,
+  HTTP_CODE_MOVED_PERMANENTLY = 301,
+  HTTP_CODE_FOUND = 302,
+  HTTP_CODE_SEE_OTHER = 303,
+  HTTP_CODE_NOT_MODIFIED = 304,
+  HTTP_CODE_TEMPORARY_REDIRECT = 307,
+  HTTP_CODE_PERMANENT_REDIRECT = 308,
+  HTTP_CODE_BAD_REQUEST = 400,
+  HTTP_CODE_FORBIDDEN = 403,
+  HTTP_CODE_NOT_FOUND = 404,
+  HTTP_CODE_TOO_MANY_REQUESTS = 429,
+  HTTP_CODE_INTERNAL_SERVER_ERROR = 500,
+  HTTP_CODE_SERVICE_UNAVAILABLE = 503,
+};
+
+enum followRedirects_t {
+  HTTPC_DISABLE_FOLLOW_REDIRECTS,
+  HTTPC_STRICT_FOLLOW_REDIRECTS,
+  HTTPC_FORCE_FOLLOW_REDIRECTS,
+};
+
+class HTTPClient {
+ public:
+  bool begin(WiFiClient& client, const String& url);
+  void end();
+  bool connected();
+
+  void setReuse(bool reuse) { _reuse = reuse; }
+  void useHTTP10(bool http10) { _useHTTP10 = http10; }
+  void setTimeout(uint16_t ms);
+  void setUserAgent(const String& ua) { _userAgent = ua; }
+  void setFollowRedirects(followRedirects_t follow) { _follow = follow; }
+  void setRedirectLimit(uint16_t limit) { _redirectLimit = limit; }
+
+  void addHeader(const String& name, const String& value, bool first = false, bool replace = true);
+  void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+  String header(const char* name);
+  bool hasHeader(const char* name);
+
+  int GET();
+  int sendRequest(const char* type);
+
+  int getSize() { return _size; }
+  const String& getLocation() { return _location; }
+  WiFiClient& getStream() { return *_client; }
+  WiFiClient* getStreamPtr() { return _client.get(); }
+
+  static String errorToString(int error);
+
+ private:
+  struct Header {
+    String key;
+    String value;
+  };
+
+  bool parseUrl(const String& url);
+  bool setURL(const String& location);
+  bool connect();
+  void disconnect(bool preserveClient);
+  int handleHeaderResponse();
+  bool readLine(String& line);
+  void clear();
+
+  std::unique_ptr<WiFiClient> _client;
+  String _scheme;
+  String _host;
+  uint16_t _port = 0;
+  String _uri;
+  String _headers;
+  String _userAgent = "ESP8266HTTPClient";
+  std::vector<Header> _collect;
+  String _location;
+  int _size = -1;
+  int _returnCode = 0;
+  uint16_t _tcpTimeout = HTTPCLIENT_DEFAULT_TCP_TIMEOUT;
+  uint16_t _redirectLimit = 10;
+  followRedirects_t _follow = HTTPC_DISABLE_FOLLOW_REDIRECTS;
+  bool _reuse = true;
+  bool _canReuse = false;
+  bool _useHTTP10 = false;
+};
+
+#endif
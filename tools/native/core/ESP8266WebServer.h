@@ -0,0 +1,117 @@
+#ifndef NATIVE_ESP8266WEBSERVER_H
+#define NATIVE_ESP8266WEBSERVER_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+#include <vector>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+enum class HTTPAuthMethod { BASIC_AUTH, DIGEST_AUTH };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+#define HTTP_UPLOAD_BUFLEN 2048
+
+struct HTTPUpload {
+  HTTPUploadStatus status;
+  String filename;
+  String name;
+  String type;
+  size_t totalSize;
+  size_t currentSize;
+  uint8_t buf[HTTP_UPLOAD_BUFLEN];
+};
+
+// One request per connection, handled inside handleClient(), with the
+// response framing of the core's ESP8266WebServer: Content-Length, or
+// chunked after setContentLength(CONTENT_LENGTH_UNKNOWN), headers from
+// sendHeader(), "Connection: close". Query and urlencoded POST arguments
+// and the collectHeaders() headers are parsed; multipart uploads are not,
+// so an upload handler never runs. Port 80 is mapped to NATIVE_HTTP_PORT
+// (default 8088) so no privileges are needed.
+class ESP8266WebServer {
+ public:
+  typedef std::function<void()> THandlerFunction;
+
+  explicit ESP8266WebServer(int port = 80) : _port(port) {}
+  ~ESP8266WebServer() { stop(); }
+
+  void on(const String& uri, THandlerFunction fn) { on(uri, HTTP_ANY, fn); }
+  void on(const String& uri, HTTPMethod method, THandlerFunction fn);
+  void on(const String& uri, HTTPMethod method, THandlerFunction fn, THandlerFunction upload) {
+    (void)upload;
+    on(uri, method, fn);
+  }
+  void onNotFound(THandlerFunction fn) { _notFound = fn; }
+  void begin();
+  void stop();
+  void close() { stop(); }
+  void handleClient();
+
+  const String& uri() const { return _uri; }
+  HTTPMethod method() const { return _method; }
+  WiFiClient& client() { return _currentClient; }
+  HTTPUpload& upload() { return _upload; }
+
+  const String& arg(const String& name) const;
+  const String& arg(int i) const;
+  const String& argName(int i) const;
+  int args() const { return _args.size(); }
+  bool hasArg(const String& name) const;
+  void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+  const String& header(const String& name) const;
+  bool hasHeader(const String& name) const;
+  const String& hostHeader() const { return _hostHeader; }
+
+  bool authenticate(const char* username, const char* password);
+  void requestAuthentication(HTTPAuthMethod mode = HTTPAuthMethod::BASIC_AUTH, const char* realm = nullptr,
+                             const String& authFailMsg = String());
+
+  void send(int code, const char* contentType = nullptr, const String& content = String());
+  void send(int code, const String& contentType, const String& content) {
+    send(code, contentType.c_str(), content);
+  }
+  void send_P(int code, PGM_P contentType, PGM_P content) { send_P(code, contentType, content, strlen_P(content)); }
+  void send_P(int code, PGM_P contentType, PGM_P content, size_t contentLength);
+  void setContentLength(const size_t contentLength) { _contentLength = contentLength; }
+  void sendHeader(const String& name, const String& value, bool first = false);
+  void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+  void sendContent(const char* content, size_t size);
+  void sendContent_P(PGM_P content) { sendContent(content, strlen_P(content)); }
+  void sendContent_P(PGM_P content, size_t size) { sendContent(content, size); }
+
+ private:
+  struct Route {
+    String uri;
+    HTTPMethod method;
+    THandlerFunction fn;
+  };
+  struct Pair {
+    String name;
+    String value;
+  };
+
+  void parseArgs(const std::string& encoded);
+  void sendHead(int code, const char* contentType, size_t contentLength);
+  void write(const char* data, size_t n);
+
+  int _port;
+  int _listen = -1;
+  WiFiClient _currentClient;
+  String _uri;
+  HTTPMethod _method = HTTP_GET;
+  std::vector<Route> _routes;
+  THandlerFunction _notFound;
+  std::vector<Pair> _args;
+  std::vector<Pair> _headers;       // collected names, values of this request
+  String _hostHeader;
+  String _responseHeaders;
+  size_t _contentLength = CONTENT_LENGTH_NOT_SET;
+  bool _chunked = false;
+  bool _sent = false;
+  HTTPUpload _upload = {};
+};
+
+#endif
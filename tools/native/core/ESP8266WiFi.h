@@ -0,0 +1,143 @@
+#ifndef NATIVE_ESP8266WIFI_H
+#define NATIVE_ESP8266WIFI_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <WiFiClient.h>
+#include <WiFiUdp.h>
+
+#include <vector>
+
+#include "user_interface.h"
+
+// The station is connected through the host's network, from boot and
+// after every begin(); only disconnect() takes it down. Modes, the stored
+// station config, the soft AP and scans are modelled far enough for
+// lib/WiFiManager (tools/native/portal_bench.cpp): a scan finds nativeAps.
+enum WiFiMode_t { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 };
+enum wl_status_t {
+  WL_NO_SHIELD = 255,
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_WRONG_PASSWORD = 6,
+  WL_DISCONNECTED = 7,
+};
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+enum wl_enc_type { ENC_TYPE_WEP = 5, ENC_TYPE_TKIP = 2, ENC_TYPE_CCMP = 4, ENC_TYPE_NONE = 7, ENC_TYPE_AUTO = 8 };
+
+struct NativeAp {
+  String ssid;
+  int32_t rssi;
+  uint8_t encryption;   // wl_enc_type
+  int32_t channel;
+  uint8_t bssid[6];
+  bool hidden;
+};
+
+class ESP8266WiFiClass {
+ public:
+  bool mode(WiFiMode_t m);
+  WiFiMode_t getMode() { return _mode; }
+  bool enableSTA(bool enable) { return mode((WiFiMode_t)(enable ? _mode | WIFI_STA : _mode & ~WIFI_STA)); }
+  bool enableAP(bool enable) { return mode((WiFiMode_t)(enable ? _mode | WIFI_AP : _mode & ~WIFI_AP)); }
+  void persistent(bool persistent) { _persistent = persistent; }
+  bool setSleep(bool) { return true; }
+  bool setAutoReconnect(bool) { return true; }
+  bool setAutoConnect(bool) { return true; }
+  bool getAutoConnect() { return true; }
+  void setOutputPower(float) {}
+
+  // --- station ---
+  wl_status_t begin(const char* ssid, const char* passphrase = nullptr, int32_t channel = 0,
+                    const uint8_t* bssid = nullptr, bool connect = true);
+  wl_status_t begin(const String& ssid, const String& passphrase = String(), int32_t channel = 0,
+                    const uint8_t* bssid = nullptr, bool connect = true) {
+    return begin(ssid.c_str(), passphrase.c_str(), channel, bssid, connect);
+  }
+  wl_status_t begin();
+  bool config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress(),
+              IPAddress dns2 = IPAddress());
+  bool disconnect(bool wifioff = false);
+  bool reconnect() { return begin() == WL_CONNECTED; }
+  int8_t waitForConnectResult(unsigned long timeoutLength = 60000);
+  bool beginWPSConfig() { return false; }
+
+  wl_status_t status() { return _connected ? WL_CONNECTED : WL_DISCONNECTED; }
+  bool isConnected() { return status() == WL_CONNECTED; }
+  IPAddress localIP();
+  IPAddress subnetMask();
+  IPAddress gatewayIP();
+  IPAddress dnsIP(uint8_t dns = 0);
+  String macAddress() { return "5C:CF:7F:C0:FF:EE"; }
+  String SSID() const;
+  String psk() const;
+  String BSSIDstr() { return "02:00:00:00:00:01"; }
+  int32_t channel() { return 6; }
+  int32_t RSSI() { return _connected ? -60 : 31; }
+  String hostname() { return _hostname; }
+  bool hostname(const char* name) {
+    _hostname = name;
+    return true;
+  }
+  bool hostname(const String& name) { return hostname(name.c_str()); }
+  int hostByName(const char* host, IPAddress& result, uint32_t timeoutMs = 10000);
+
+  // --- soft AP ---
+  bool softAP(const String& ssid, const String& passphrase = String(), int channel = 1, int ssidHidden = 0,
+              int maxConnection = 4);
+  bool softAPConfig(IPAddress local, IPAddress gateway, IPAddress subnet);
+  bool softAPdisconnect(bool wifioff = false);
+  uint8_t softAPgetStationNum() { return 0; }
+  IPAddress softAPIP() { return _mode & WIFI_AP ? _apIp : IPAddress(); }
+  String softAPmacAddress() { return "5E:CF:7F:C0:FF:EE"; }
+  String softAPSSID() const;
+
+  // --- scan: synchronous, or done at the next scanComplete() ---
+  int8_t scanNetworks(bool async = false, bool showHidden = false, uint8_t channel = 0, uint8_t* ssid = nullptr);
+  void scanNetworksAsync(std::function<void(int)> onComplete, bool showHidden = false);
+  int8_t scanComplete();
+  void scanDelete() { _scan.clear(); _scanState = WIFI_SCAN_FAILED; }
+  String SSID(uint8_t i) { return i < _scan.size() ? _scan[i].ssid : String(); }
+  int32_t RSSI(uint8_t i) { return i < _scan.size() ? _scan[i].rssi : 0; }
+  uint8_t encryptionType(uint8_t i) { return i < _scan.size() ? _scan[i].encryption : -1; }
+  int32_t channel(uint8_t i) { return i < _scan.size() ? _scan[i].channel : 0; }
+  bool isHidden(uint8_t i) { return i < _scan.size() && _scan[i].hidden; }
+  String BSSIDstr(uint8_t i);
+
+  // Host only: the networks a scan finds
+  std::vector<NativeAp> nativeAps;
+
+ private:
+  friend bool wifi_station_get_config(struct station_config*);
+  friend bool wifi_station_get_config_default(struct station_config*);
+  friend bool wifi_station_disconnect();
+  friend bool wifi_softap_get_config(struct softap_config*);
+  friend class EspClass;
+
+  int8_t finishScan();
+
+  WiFiMode_t _mode = WIFI_STA;
+  bool _persistent = true;
+  bool _connected = true;
+  station_config _sta = {};
+  station_config _staStored = {};   // what persistent(true) writes to flash
+  softap_config _ap = {};
+  IPAddress _staIp;                 // set by config(), else 127.0.0.1
+  IPAddress _apIp = IPAddress(192, 168, 4, 1);
+  String _hostname = "ESP-C0FFEE";
+  std::vector<NativeAp> _scan;
+  int8_t _scanState = WIFI_SCAN_FAILED;
+  bool _scanHidden = false;
+  std::function<void(int)> _scanDone;
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif
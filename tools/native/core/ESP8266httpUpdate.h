@@ -0,0 +1,61 @@
+#ifndef NATIVE_ESP8266HTTPUPDATE_H
+#define NATIVE_ESP8266HTTPUPDATE_H
+
+#include <Arduino.h>
+#include <ESP8266HTTPClient.h>
+#include <Updater.h>
+#include <WiFiClient.h>
+
+// ESP8266HTTPUpdate with the core's Updater (Updater.h) behind it: x-MD5
+// is checked if the server sends it; errors of the Updater are positive.
+
+#define HTTP_UE_TOO_LESS_SPACE (-100)
+#define HTTP_UE_SERVER_NOT_REPORT_SIZE (-101)
+#define HTTP_UE_SERVER_FILE_NOT_FOUND (-102)
+#define HTTP_UE_SERVER_FORBIDDEN (-103)
+#define HTTP_UE_SERVER_WRONG_HTTP_CODE (-104)
+#define HTTP_UE_SERVER_FAULTY_MD5 (-105)
+#define HTTP_UE_BIN_VERIFY_HEADER_FAILED (-106)
+#define HTTP_UE_BIN_FOR_WRONG_FLASH (-107)
+#define HTTP_UE_SERVER_UNAUTHORIZED (-108)
+
+enum HTTPUpdateResult { HTTP_UPDATE_FAILED, HTTP_UPDATE_NO_UPDATES, HTTP_UPDATE_OK };
+typedef HTTPUpdateResult t_httpUpdate_return;
+
+class ESP8266HTTPUpdate {
+ public:
+  void rebootOnUpdate(bool reboot) { _rebootOnUpdate = reboot; }
+  void setFollowRedirects(followRedirects_t follow) { _follow = follow; }
+  void setLedPin(int pin = -1, uint8_t ledOn = HIGH) {
+    _ledPin = pin;
+    _ledOn = ledOn;
+  }
+
+  void onStart(std::function<void()> cb) { _cbStart = cb; }
+  void onEnd(std::function<void()> cb) { _cbEnd = cb; }
+  void onError(std::function<void(int)> cb) { _cbError = cb; }
+  void onProgress(std::function<void(int, int)> cb) { _cbProgress = cb; }
+
+  t_httpUpdate_return update(WiFiClient& client, const String& url, const String& currentVersion = "");
+
+  int getLastError() { return _lastError; }
+  String getLastErrorString();
+
+ private:
+  void setLastError(int err);
+  int runUpdate(Stream& in, uint32_t size, const String& md5);
+
+  std::function<void()> _cbStart;
+  std::function<void()> _cbEnd;
+  std::function<void(int)> _cbError;
+  std::function<void(int, int)> _cbProgress;
+  followRedirects_t _follow = HTTPC_DISABLE_FOLLOW_REDIRECTS;
+  int _lastError = 0;
+  int _ledPin = -1;
+  uint8_t _ledOn = LOW;
+  bool _rebootOnUpdate = true;
+};
+
+extern ESP8266HTTPUpdate ESPhttpUpdate;
+
+#endif
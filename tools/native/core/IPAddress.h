@@ -0,0 +1,48 @@
+#ifndef NATIVE_IPADDRESS_H
+#define NATIVE_IPADDRESS_H
+
+#include <Arduino.h>
+
+// IPv4 only; the uint32_t form is in network order, as in the core
+class IPAddress : public Printable {
+ public:
+  IPAddress() {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _b{ a, b, c, d } {}
+  IPAddress(uint32_t addr) { memcpy(_b, &addr, 4); }
+
+  operator uint32_t() const {
+    uint32_t addr;
+    memcpy(&addr, _b, 4);
+    return addr;
+  }
+  bool operator==(const IPAddress& o) const { return memcmp(_b, o._b, 4) == 0; }
+  bool operator!=(const IPAddress& o) const { return !(*this == o); }
+
+  uint8_t operator[](int i) const { return _b[i]; }
+  uint8_t& operator[](int i) { return _b[i]; }
+  bool isSet() const { return _b[0] || _b[1] || _b[2] || _b[3]; }
+
+  bool fromString(const char* s) {
+    unsigned v[4];
+    char end;
+    if (sscanf(s, "%u.%u.%u.%u%c", &v[0], &v[1], &v[2], &v[3], &end) != 4) return false;
+    for (int i = 0; i < 4; i++) {
+      if (v[i] > 255) return false;
+      _b[i] = v[i];
+    }
+    return true;
+  }
+  bool fromString(const String& s) { return fromString(s.c_str()); }
+
+  String toString() const {
+    char s[16];
+    snprintf(s, sizeof(s), "%u.%u.%u.%u", _b[0], _b[1], _b[2], _b[3]);
+    return s;
+  }
+  size_t printTo(Print& p) const override { return p.print(toString()); }
+
+ private:
+  uint8_t _b[4] = { 0, 0, 0, 0 };
+};
+
+#endif
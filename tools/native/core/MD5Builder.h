@@ -0,0 +1,27 @@
+#ifndef NATIVE_MD5BUILDER_H
+#define NATIVE_MD5BUILDER_H
+
+#include <Arduino.h>
+
+class MD5Builder {
+ public:
+  MD5Builder();
+  ~MD5Builder();
+  MD5Builder(const MD5Builder&) = delete;
+  MD5Builder& operator=(const MD5Builder&) = delete;
+
+  void begin();
+  void add(const uint8_t* data, uint16_t len);
+  void add(const char* data) { add(reinterpret_cast<const uint8_t*>(data), strlen(data)); }
+  void add(const String& s) { add(reinterpret_cast<const uint8_t*>(s.c_str()), s.length()); }
+  void calculate();
+  void getBytes(uint8_t* output) const;
+  void getChars(char* output) const;
+  String toString() const;
+
+ private:
+  void* _ctx;
+  uint8_t _buf[16];
+};
+
+#endif
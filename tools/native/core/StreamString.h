@@ -0,0 +1,28 @@
+#ifndef NATIVE_STREAMSTRING_H
+#define NATIVE_STREAMSTRING_H
+
+#include <Arduino.h>
+
+class StreamString : public String, public Stream {
+ public:
+  size_t write(uint8_t c) override {
+    _s += (char)c;
+    return 1;
+  }
+  size_t write(const uint8_t* buf, size_t n) override {
+    _s.append(reinterpret_cast<const char*>(buf), n);
+    return n;
+  }
+  using Print::write;
+  int availableForWrite() override { return 1024; }
+  int available() override { return _s.size(); }
+  int read() override {
+    if (_s.empty()) return -1;
+    uint8_t c = _s[0];
+    _s.erase(0, 1);
+    return c;
+  }
+  int peek() override { return _s.empty() ? -1 : (uint8_t)_s[0]; }
+};
+
+#endif
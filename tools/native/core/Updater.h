@@ -0,0 +1,70 @@
+#ifndef NATIVE_UPDATER_H
+#define NATIVE_UPDATER_H
+
+#include <Arduino.h>
+#include <MD5Builder.h>
+
+// The core's Updater on nativeFlash: the image goes right below
+// FS_PHYS_ADDR a sector at a time, the first sector must start with 0xE9
+// and keeps the running flash mode, end() checks the MD5 if one was set
+// and leaves an eboot copy command in RTC memory.
+
+#define UPDATE_ERROR_OK 0
+#define UPDATE_ERROR_WRITE 1
+#define UPDATE_ERROR_ERASE 2
+#define UPDATE_ERROR_READ 3
+#define UPDATE_ERROR_SPACE 4
+#define UPDATE_ERROR_SIZE 5
+#define UPDATE_ERROR_STREAM 6
+#define UPDATE_ERROR_MD5 7
+#define UPDATE_ERROR_MAGIC_BYTE 10
+
+#define U_FLASH 0
+
+class UpdaterClass {
+ public:
+  typedef std::function<void(size_t, size_t)> THandlerFunction_Progress;
+
+  bool begin(size_t size, int command = U_FLASH, int ledPin = -1, uint8_t ledOn = LOW);
+  size_t write(uint8_t* data, size_t len);
+  size_t writeStream(Stream& data);
+  bool end(bool evenIfRemaining = false);
+  bool setMD5(const char* expected_md5);
+  UpdaterClass& onProgress(THandlerFunction_Progress fn) {
+    _progress = fn;
+    return *this;
+  }
+
+  void printError(Print& out) { out.println(getErrorString()); }
+  String getErrorString() const;
+  uint8_t getError() const { return _error; }
+  bool hasError() const { return _error != UPDATE_ERROR_OK; }
+  void clearError() { _error = UPDATE_ERROR_OK; }
+  bool isRunning() const { return _size > 0; }
+  bool isFinished() const { return _size > 0 && _written == _size; }
+  size_t size() const { return _size; }
+  size_t progress() const { return _written; }
+  size_t remaining() const { return _size - _written; }
+
+ private:
+  void reset();
+  bool flushBuffer();
+  void fail(uint8_t error);
+
+  uint8_t _error = UPDATE_ERROR_OK;
+  size_t _size = 0;
+  size_t _written = 0;   // bytes taken, buffered or on flash
+  size_t _buffered = 0;
+  uint32_t _start = 0;
+  uint8_t _runningMode = 0;
+  int _ledPin = -1;
+  uint8_t _ledOn = LOW;
+  String _md5;
+  MD5Builder _hash;
+  THandlerFunction_Progress _progress;
+  uint8_t _buf[FLASH_SECTOR_SIZE];
+};
+
+extern UpdaterClass Update;
+
+#endif
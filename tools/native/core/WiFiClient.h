@@ -0,0 +1,45 @@
+#ifndef NATIVE_WIFICLIENT_H
+#define NATIVE_WIFICLIENT_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+struct NativeConn;
+
+// A TCP socket. Copies share the connection and its settings, like the
+// BearSSL client's shared context in the core (the core's plain client
+// shares only an open connection); the last copy closes it.
+class WiFiClient : public Stream {
+ public:
+  WiFiClient();
+  explicit WiFiClient(int fd);   // a connection ESP8266WebServer accepted
+  virtual ~WiFiClient() {}
+  virtual std::unique_ptr<WiFiClient> clone() const {
+    return std::unique_ptr<WiFiClient>(new WiFiClient(*this));
+  }
+
+  virtual int connect(const char* host, uint16_t port);
+  virtual int connect(const String& host, uint16_t port) { return connect(host.c_str(), port); }
+  virtual int connect(IPAddress ip, uint16_t port);
+  virtual uint8_t connected();
+  virtual bool stop(unsigned int maxWaitMs = 0);
+  void setNoDelay(bool) {}
+  IPAddress localIP();
+  IPAddress remoteIP();
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buf, size_t n) override;
+  using Print::write;
+  int availableForWrite() override { return 1460; }
+  int available() override;
+  int read() override;
+  int peek() override;
+  virtual int read(uint8_t* buf, size_t n);
+  size_t readBytes(char* buf, size_t n) override;   // waits up to the timeout for all of it
+  size_t peekBytes(uint8_t* buf, size_t n);          // what is there, waits for the first byte
+
+ protected:
+  std::shared_ptr<NativeConn> _conn;
+};
+
+#endif
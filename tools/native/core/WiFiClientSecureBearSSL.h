@@ -0,0 +1,51 @@
+#ifndef NATIVE_WIFICLIENTSECUREBEARSSL_H
+#define NATIVE_WIFICLIENTSECUREBEARSSL_H
+
+#include <WiFiClient.h>
+
+// BearSSL's API on OpenSSL. setBufferSizes() is recorded, not enforced.
+namespace BearSSL {
+
+class PublicKey {
+ public:
+  explicit PublicKey(const char* pem);
+  bool isRSA() const { return _type == 1; }
+  bool isEC() const { return _type == 2; }
+  const std::string& der() const { return _der; }   // SubjectPublicKeyInfo
+
+ private:
+  std::string _der;
+  int _type = 0;
+};
+
+class X509List {
+ public:
+  explicit X509List(const char* pem) : _pem(pem) {}
+  size_t getCount() const;
+  const std::string& pem() const { return _pem; }
+
+ private:
+  std::string _pem;
+};
+
+class WiFiClientSecure : public WiFiClient {
+ public:
+  WiFiClientSecure();
+  std::unique_ptr<WiFiClient> clone() const override {
+    return std::unique_ptr<WiFiClient>(new WiFiClientSecure(*this));
+  }
+
+  using WiFiClient::connect;
+  int connect(const char* host, uint16_t port) override;
+
+  void setInsecure();
+  void setKnownKey(const PublicKey* pk);
+  void setTrustAnchors(const X509List* ta);
+  void setX509Time(time_t now);
+  void setBufferSizes(int recv, int xmit);
+  int getLastSSLError(char* dest = nullptr, size_t len = 0);
+};
+
+}  // namespace BearSSL
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef NATIVE_WIFIMANAGER_H
+#define NATIVE_WIFIMANAGER_H
+
+#include <Arduino.h>
+
+// Stored credentials that always work: autoConnect() returns at once and
+// the portal never opens (lib/WiFiManager is not built for the host)
+class WiFiManager {
+ public:
+  void setConfigPortalTimeout(unsigned long) {}
+  void setAPCallback(std::function<void(WiFiManager*)> cb) { _apCallback = cb; }
+  bool autoConnect(const char*) { return true; }
+
+  bool _asyncScan = false;
+
+ private:
+  std::function<void(WiFiManager*)> _apCallback;
+};
+
+#endif
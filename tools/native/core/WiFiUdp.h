@@ -0,0 +1,10 @@
+#ifndef NATIVE_WIFIUDP_H
+#define NATIVE_WIFIUDP_H
+
+// No UDP on the host: only the static stopAll() the OTA upload path calls
+class WiFiUDP {
+ public:
+  static void stopAll() {}
+};
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef NATIVE_CORE_VERSION_H
+#define NATIVE_CORE_VERSION_H
+
+// platform = espressif8266 is not pinned in platformio.ini: its current core
+#define ARDUINO_ESP8266_GIT_DESC 3.1.2
+#define ARDUINO_ESP8266_RELEASE_3_1_2
+#define ARDUINO_ESP8266_RELEASE "3_1_2"
+
+#endif
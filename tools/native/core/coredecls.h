@@ -0,0 +1,11 @@
+#ifndef NATIVE_COREDECLS_H
+#define NATIVE_COREDECLS_H
+
+#include <functional>
+
+using BoolCB = std::function<void(bool)>;
+
+// Called with true when SNTP sets the clock, false for settimeofday()
+void settimeofday_cb(const BoolCB& cb);
+
+#endif
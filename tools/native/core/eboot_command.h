@@ -0,0 +1,29 @@
+#ifndef NATIVE_EBOOT_COMMAND_H
+#define NATIVE_EBOOT_COMMAND_H
+
+#include <stdint.h>
+
+// As the core's: the command lives in RTC user memory, blocks 0..31
+// (include/rtc_layout.h); tools/native/native.cpp carries it out on the
+// next boot like eboot
+
+#define EBOOT_MAGIC 0xeb001000
+#define EBOOT_MAGIC_MASK 0xfffff000
+
+enum action_t {
+  ACTION_COPY_RAW = 0x00000001,
+  ACTION_LOAD_APP = 0xffffffff,
+};
+
+struct eboot_command {
+  uint32_t magic;
+  enum action_t action;
+  uint32_t args[29];
+  uint32_t crc32;
+};
+
+int eboot_command_read(struct eboot_command* cmd);
+void eboot_command_write(struct eboot_command* cmd);
+void eboot_command_clear();
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef NATIVE_FLASH_HAL_H
+#define NATIVE_FLASH_HAL_H
+
+// eagle.flash.4m2m.ld, as platformio.ini builds the device
+
+#define FLASH_SECTOR_SIZE 0x1000
+#define FS_PHYS_ADDR 0x200000
+#define FS_PHYS_SIZE 0x1FA000
+
+#endif
@@ -0,0 +1,26 @@
+// The device clock of tools/native: starts at 0 on every boot like the
+// ESP8266's, set by settimeofday() and the simulated SNTP reply. The host
+// clock is never touched. Included by Arduino.h after <time.h> and
+// <sys/time.h>, so the firmware's calls land here.
+
+#ifndef NATIVE_TIME_H
+#define NATIVE_TIME_H
+
+#include <sys/time.h>
+#include <time.h>
+
+#include <functional>
+
+time_t nativeTime(time_t* t);
+int nativeGettimeofday(struct timeval* tv, void* tz);
+int nativeSettimeofday(const struct timeval* tv, const struct timezone* tz);
+
+#define time(t) nativeTime(t)
+#define gettimeofday(tv, tz) nativeGettimeofday(tv, tz)
+#define settimeofday(tv, tz) nativeSettimeofday(tv, tz)
+
+// SNTP answers NATIVE_SNTP_DELAY_MS after configTime() with the host time
+void configTime(int timezone, int daylightOffset, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+
+#endif
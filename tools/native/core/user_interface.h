@@ -0,0 +1,99 @@
+#ifndef NATIVE_USER_INTERFACE_H
+#define NATIVE_USER_INTERFACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum rst_reason {
+  REASON_DEFAULT_RST = 0,
+  REASON_WDT_RST = 1,
+  REASON_EXCEPTION_RST = 2,
+  REASON_SOFT_WDT_RST = 3,
+  REASON_SOFT_RESTART = 4,
+  REASON_DEEP_SLEEP_AWAKE = 5,
+  REASON_EXT_SYS_RST = 6,
+};
+
+struct rst_info {
+  uint32_t reason;
+  uint32_t exccause;
+  uint32_t epc1;
+  uint32_t epc2;
+  uint32_t epc3;
+  uint32_t excvaddr;
+  uint32_t depc;
+};
+
+// RTC timer: keeps counting across resets, in units of the calibration
+uint32_t system_get_rtc_time();
+uint32_t system_rtc_clock_cali_proc();   // microseconds per tick, Q12
+
+const char* system_get_sdk_version();
+uint8_t system_get_boot_version();
+void system_print_meminfo();
+
+// --- Wi-Fi, backed by the radio model of ESP8266WiFi.h ---
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+
+#define ETS_UART_INTR_DISABLE()
+#define ETS_UART_INTR_ENABLE()
+
+enum station_status {
+  STATION_IDLE = 0,
+  STATION_CONNECTING,
+  STATION_WRONG_PASSWORD,
+  STATION_NO_AP_FOUND,
+  STATION_CONNECT_FAIL,
+  STATION_GOT_IP,
+};
+
+struct station_config {
+  uint8 ssid[32];
+  uint8 password[64];
+  uint8 bssid_set;
+  uint8 bssid[6];
+};
+
+struct softap_config {
+  uint8 ssid[32];
+  uint8 password[64];
+  uint8 ssid_len;
+  uint8 channel;
+  uint8 authmode;
+  uint8 ssid_hidden;
+  uint8 max_connection;
+  uint16 beacon_interval;
+};
+
+typedef enum { WIFI_COUNTRY_POLICY_AUTO, WIFI_COUNTRY_POLICY_MANUAL } WIFI_COUNTRY_POLICY;
+
+typedef struct {
+  char cc[3];
+  uint8 schan;
+  uint8 nchan;
+  uint8 policy;
+} wifi_country_t;
+
+uint8 wifi_get_opmode();
+bool wifi_set_opmode(uint8 mode);
+bool wifi_set_opmode_current(uint8 mode);
+bool wifi_station_get_config(struct station_config* config);
+bool wifi_station_get_config_default(struct station_config* config);
+bool wifi_station_disconnect();
+uint8 wifi_station_get_connect_status();
+bool wifi_softap_get_config(struct softap_config* config);
+uint8 wifi_softap_get_station_num();
+bool wifi_get_country(wifi_country_t* country);
+bool wifi_set_country(wifi_country_t* country);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+// The response body framing of HttpBodyStream (src/http_body.cpp) on the
+// core stand-in of tools/native, without a server:
+//
+//   make -C tools/native http_body_bench
+//   tools/native/http_body_bench
+//
+// Each case is a raw body as it follows the response headers, with the next
+// response of a kept-alive connection behind it. It is read through the
+// stream and drained, once with everything arrived, once arriving a byte
+// at a time (the framing state has to carry over between reads), and once
+// with the parser stopping after the first byte (drain() reads the rest).
+// Checked: the decoded body, whether the body ended where the framing says
+// (done), was refused (failed) or is still open, and that the bytes after
+// the body are left on the connection.
+//
+// Exit code 1 if a check fails.
+
+#include <string>
+
+#include <Arduino.h>
+
+#include "http_body.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+  printf("  %-56s %s\n", what.c_str(), ok ? "ok" : "FAIL");
+  if (!ok) failures++;
+}
+
+// A connection whose bytes arrive up to `arrived`
+class Feed : public Stream {
+ public:
+  explicit Feed(const std::string& data) : _data(data) {}
+
+  int available() override { return _arrived - _pos; }
+  int read() override { return _pos < _arrived ? (uint8_t)_data[_pos++] : -1; }
+  int peek() override { return _pos < _arrived ? (uint8_t)_data[_pos] : -1; }
+  size_t write(uint8_t) override { return 0; }
+  using Print::write;
+
+  // 0: all of it
+  bool arrive(size_t n) {
+    if (_arrived == _data.size()) return false;
+    _arrived = n && n < _data.size() - _arrived ? _arrived + n : _data.size();
+    return true;
+  }
+  std::string rest() const { return _data.substr(_pos); }
+
+ private:
+  std::string _data;
+  size_t _pos = 0;
+  size_t _arrived = 0;
+};
+
+const char* NEXT = "HTTP/1.1 200 OK\r\n";
+
+enum End { DONE, FAILED, OPEN };
+
+struct Case {
+  const char* name;
+  const char* raw;       // the body and its framing; NEXT follows unless OPEN
+  int contentLength;     // -1: none
+  bool chunked;
+  const char* body;      // what the parser reads
+  End end;
+};
+
+const Case CASES[] = {
+  { "length", "hello", 5, false, "hello", DONE },
+  { "length 0", "", 0, false, "", DONE },
+  { "length, body short of it", "hel", 5, false, "hel", OPEN },
+  { "no length: until close", "hello", -1, false, "hello", OPEN },
+  { "chunked", "5\r\nhello\r\n0\r\n\r\n", -1, true, "hello", DONE },
+  { "chunked, two chunks, hex size", "2\r\nhe\r\nA\r\nllo, world\r\n0\r\n\r\n", -1, true, "hello, world", DONE },
+  { "chunked, upper and lower hex", "a\r\n0123456789\r\nB\r\nabcdefghijk\r\n0\r\n\r\n", -1, true,
+    "0123456789abcdefghijk", DONE },
+  { "chunked, LF only", "5\nhello\n0\n\n", -1, true, "hello", DONE },
+  { "chunked, extension", "5;name=value\r\nhello\r\n0;x\r\n\r\n", -1, true, "hello", DONE },
+  { "chunked, whitespace before CRLF", "5 \r\nhello\r\n0\t\r\n\r\n", -1, true, "hello", DONE },
+  { "chunked, whitespace before extension", "5\t;ext\r\nhello\r\n0 ;x\r\n\r\n", -1, true, "hello", DONE },
+  { "chunked, trailers", "5\r\nhello\r\n0\r\nX-Sum: 1\r\nX-More: 2\r\n\r\n", -1, true, "hello", DONE },
+  { "chunked, \"1 2\" is not 0x12", "1 2\r\nxxxxxxxxxxxxxxxxxx\r\n0\r\n\r\n", -1, true, "", FAILED },
+  { "chunked, space before the size", " 5\r\nhello\r\n0\r\n\r\n", -1, true, "", FAILED },
+  { "chunked, junk after the size", "5 z\r\nhello\r\n0\r\n\r\n", -1, true, "", FAILED },
+  { "chunked, no size", "\r\nhello\r\n0\r\n\r\n", -1, true, "", FAILED },
+  { "chunked, no CRLF after the data", "5\r\nhelloX\r\n0\r\n\r\n", -1, true, "hello", FAILED },
+  { "chunked, size overflow", "FFFFFFFFF\r\n", -1, true, "", FAILED },
+  { "chunked, cut in the last chunk", "5\r\nhello\r\n0\r\n", -1, true, "hello", OPEN },
+};
+
+// Reads like deserializeJson() does (read() until -1, or until it has
+// seen enough: `stop` bytes), then drains
+void run(const Case& c, size_t step, size_t stop = SIZE_MAX) {
+  std::string raw = c.raw;
+  if (c.end != OPEN) raw += NEXT;
+  Feed in(raw);
+  HttpBodyStream body(in, c.contentLength, c.chunked);
+  std::string got;
+  for (bool more = in.arrive(step); more; more = in.arrive(step)) {
+    for (int ch; got.size() < stop && (ch = body.read()) >= 0;) got += (char)ch;
+  }
+  body.drain(20);
+
+  End end = body.done() ? DONE : body.failed() ? FAILED : OPEN;
+  std::string what = std::string(c.name) + (step == 1 ? ", bytewise" : stop != SIZE_MAX ? ", parser stops" : "");
+  std::string expect = std::string(c.body).substr(0, stop);
+  bool ok = got == expect && end == c.end;
+  if (end == DONE) ok = ok && in.rest() == NEXT;
+  check(ok, what);
+  if (got != expect) printf("    body \"%s\", expected \"%s\"\n", got.c_str(), expect.c_str());
+}
+
+}  // namespace
+
+int main() {
+  for (const Case& c : CASES) {
+    run(c, 0);
+    run(c, 1);
+    if (strlen(c.body) > 1) run(c, 0, 1);
+  }
+
+  if (failures) {
+    fprintf(stderr, "http_body_bench: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("http_body_bench: ok\n");
+  return 0;
+}
@@ -0,0 +1,183 @@
+// The OTA journal (src/ota_journal.cpp) on the flash of the core stand-in
+// of tools/native, with the power cuts of nativeFlashBudget:
+//
+//   make -C tools/native journal_bench
+//   tools/native/journal_bench [polls]
+//
+// - replay: `polls` manifest polls (default 5000, the result changing every
+//   10th), an ETag and a failed OTA attempt, then a boot: the state comes
+//   back, and the boot replays no more than the active sector
+// - interrupted: a boot in the middle of an attempt closes it as
+//   JOURNAL_OTA_INTERRUPTED, a failure of that version
+// - power cuts: from the same journal, alternating polls (a record each,
+//   and compactions) cut after every 7th programmed byte up to 12000, each
+//   followed by a boot: the state is a prefix of what was written, nothing
+//   recorded before is lost, and the journal keeps appending afterwards
+//
+// Exit code 1 if a check fails.
+
+#include <string>
+
+#include <Arduino.h>
+
+#include "flash_layout.h"
+#include "log.h"
+#include "native.h"
+#include "ota_journal.h"
+
+// The driver hooks of native.cpp: a restart is a power cut here
+uint8_t nativeFlash[NATIVE_FLASH_SIZE];
+uint8_t nativeRtc[NATIVE_RTC_SIZE];
+uint32_t nativeResetReason = 0;
+
+struct PowerCut {};
+
+void nativeRestart(uint32_t) {
+  throw PowerCut();
+}
+
+void nativeTick() {}
+
+uint32_t nativeImageSize(uint32_t) {
+  return 0;
+}
+
+namespace {
+
+// Keeps what the log drains, for the replay line
+class Capture : public HardwareSerial {
+ public:
+  int availableForWrite() override { return 128; }
+  size_t write(uint8_t c) override {
+    text += (char)c;
+    return 1;
+  }
+  size_t write(const uint8_t* buf, size_t n) override {
+    text.append(reinterpret_cast<const char*>(buf), n);
+    return n;
+  }
+  void flush() override {}
+  std::string text;
+};
+
+Capture logOut;
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+  printf("  %-56s %s\n", what.c_str(), ok ? "ok" : "FAIL");
+  if (!ok) failures++;
+}
+
+struct Replay {
+  unsigned sector, seq, bytes, ms;
+};
+
+// A boot: replays the journal, returns what it logged about it
+Replay boot() {
+  logOut.text.clear();
+  journalBegin();
+  logFlush();
+  Replay r = {};
+  size_t at = logOut.text.find("Replayed sector");
+  if (at != std::string::npos) {
+    sscanf(logOut.text.c_str() + at, "Replayed sector %u seq %u: %u bytes in %u ms", &r.sector, &r.seq, &r.bytes,
+           &r.ms);
+  }
+  return r;
+}
+
+const char* VERSION = "2025.01.01";
+
+void replay(uint32_t polls) {
+  printf("replay:\n");
+  boot();   // empty journal
+  for (uint32_t i = 0; i < polls; i++) journalPoll(i % 10 == 0 ? 304 : 200, 100 + i % 7);
+  journalEtag("\"abc123\"");
+  journalOtaBegin(VERSION);
+  for (uint32_t off = 0; off < 400000; off += 1024) journalOtaProgress(off);
+  journalOtaEnd(-104, 5000);
+  OtaJournalState before = journalState();
+
+  Replay r = boot();
+  const OtaJournalState& s = journalState();
+  printf("  sector %u, seq %u: %u bytes replayed in %u ms, %u of %u polls\n", r.sector, r.seq, r.bytes, r.ms,
+         s.polls, before.polls);
+  check(r.bytes > 0 && r.bytes <= FLASH_SECTOR_SIZE, "boot replays one sector at most");
+  check(r.seq >= JOURNAL_SECTORS, "sectors used round-robin");
+  // polls in between result changes are counted in RAM only
+  check(s.polls <= before.polls && s.polls + 10 >= before.polls, "poll count within the last change");
+  check(s.lastPollCode == before.lastPollCode, "last poll result");
+  check(!strcmp(s.etag, "\"abc123\""), "ETag");
+  check(!strcmp(s.otaVersion, VERSION) && s.otaResult == -104 && s.otaMs == 5000 && !s.otaInProgress,
+        "last attempt and its result");
+  check(s.otaOffset == 393216, "download offset at the last 64 KB step");
+  const JournalVersionStats* v = journalVersion(VERSION);
+  check(v && v->attempts == 1 && v->failures == 1 && v->lastError == -104, "version stats");
+}
+
+void interrupted() {
+  printf("interrupted:\n");
+  journalOtaBegin(VERSION);
+  journalOtaProgress(200000);
+  boot();
+  const OtaJournalState& s = journalState();
+  const JournalVersionStats* v = journalVersion(VERSION);
+  check(!s.otaInProgress && s.otaResult == JOURNAL_OTA_INTERRUPTED && s.otaOffset == 200000,
+        "attempt closed as interrupted at its offset");
+  check(v && v->attempts == 2 && v->failures == 2 && v->lastError == JOURNAL_OTA_INTERRUPTED,
+        "counted as a failure of the version");
+}
+
+void powerCuts() {
+  printf("power cuts:\n");
+  static uint8_t saved[NATIVE_FLASH_SIZE];
+  memcpy(saved, nativeFlash, sizeof(saved));
+  int cuts = 0, consistent = 0, working = 0, damaged = 0;
+  for (int32_t cut = 0; cut < 12000; cut += 7) {
+    memcpy(nativeFlash, saved, sizeof(saved));
+    boot();
+    OtaJournalState before = journalState();
+    uint32_t written = 0;
+    nativeFlashBudget = cut;
+    try {
+      for (int i = 0; i < 2000; i++, written++) journalPoll(i & 1 ? 500 : 200, 1);
+    } catch (PowerCut&) {
+    }
+    nativeFlashBudget = -1;
+
+    boot();
+    if (logOut.text.find("Damaged record") != std::string::npos) damaged++;
+    const OtaJournalState& s = journalState();
+    const JournalVersionStats* v = journalVersion(VERSION);
+    cuts++;
+    if (s.polls >= before.polls && s.polls <= before.polls + written + 1 && !strcmp(s.etag, before.etag) &&
+        !strcmp(s.otaVersion, before.otaVersion) && v && v->attempts == 2 && v->failures == 2) {
+      consistent++;
+    }
+    journalPoll(201, 1);
+    boot();
+    if (journalState().lastPollCode == 201) working++;
+  }
+  printf("  %d cuts, %d of them inside a record\n", cuts, damaged);
+  check(consistent == cuts, "state after every cut a prefix of what was written");
+  check(working == cuts, "journal appends after every cut");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t polls = argc > 1 ? (uint32_t)atoi(argv[1]) : 5000;
+  memset(nativeFlash, 0xFF, sizeof(nativeFlash));   // erased
+  logBegin(logOut);
+
+  replay(polls);
+  interrupted();
+  powerCuts();
+
+  if (failures) {
+    fprintf(stderr, "journal_bench: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("journal_bench: ok\n");
+  return 0;
+}
@@ -0,0 +1,153 @@
+// Manifest polls on a cold versus a kept-alive connection: the request
+// sequence of httpCheckAndUpdate() (HTTPClient with setReuse(true) and
+// HTTP/1.1, the body read through HttpBodyStream, drain(), end()) on the
+// core stand-in of tools/native, against tools/mock_server.
+//
+//   make -C tools/native keepalive_bench
+//   (in a tools/release output dir) mock_server tools/mock_server/scenarios/keepalive.txt
+//   tools/native/keepalive_bench https://127.0.0.1:8443/manifest.json [polls]
+//
+// cold: a new client and HTTPClient per poll (what useHTTP10(true) did:
+//       TCP + TLS setup every time)
+// warm: one client kept between polls, as main.cpp does while the heap
+//       allows; a server close (every 5th response in keepalive.txt) must
+//       be noticed and cost one reconnect, not a failed poll
+//
+// Prints median and p90 per poll and the handshakes per poll. Host times:
+// the ratio shows what keep-alive saves, the ESP8266 pays ~1 s per
+// handshake instead of milliseconds. Exit code 1 if a poll fails or the
+// warm run reconnects on every poll.
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <Arduino.h>
+#include <ESP8266HTTPClient.h>
+#include <WiFiClientSecureBearSSL.h>
+
+#include "http_body.h"
+
+namespace {
+
+uint32_t handshakes = 0;
+
+// Counts connects like TimedTlsClient (main.cpp), which the copies
+// HTTPClient makes with clone() must keep doing
+class CountingTlsClient : public BearSSL::WiFiClientSecure {
+ public:
+  using BearSSL::WiFiClientSecure::connect;
+  int connect(const char* host, uint16_t port) override {
+    handshakes++;
+    return BearSSL::WiFiClientSecure::connect(host, port);
+  }
+  std::unique_ptr<WiFiClient> clone() const override {
+    return std::unique_ptr<WiFiClient>(new CountingTlsClient(*this));
+  }
+};
+
+class CountingClient : public WiFiClient {
+ public:
+  using WiFiClient::connect;
+  int connect(const char* host, uint16_t port) override {
+    handshakes++;
+    return WiFiClient::connect(host, port);
+  }
+  std::unique_ptr<WiFiClient> clone() const override {
+    return std::unique_ptr<WiFiClient>(new CountingClient(*this));
+  }
+};
+
+std::unique_ptr<WiFiClient> makeClient(const String& url) {
+  if (!url.startsWith("https:")) return std::unique_ptr<WiFiClient>(new CountingClient());
+  CountingTlsClient* tls = new CountingTlsClient();
+  tls->setInsecure();
+  return std::unique_ptr<WiFiClient>(tls);
+}
+
+// One poll as httpCheckAndUpdate() makes it; true on a complete 200
+bool poll(HTTPClient& http, WiFiClient& client, const String& url) {
+  static const char* HEADERS[] = { "Transfer-Encoding" };
+  http.begin(client, url);
+  http.useHTTP10(false);
+  http.setReuse(true);
+  http.collectHeaders(HEADERS, 1);
+  int code = http.GET();
+  bool ok = false;
+  if (code == HTTP_CODE_OK) {
+    HttpBodyStream body(http.getStream(), http.getSize(),
+                        http.header("Transfer-Encoding").equalsIgnoreCase("chunked"));
+    ok = body.drain(5000);
+    if (!ok) http.getStream().stop();
+  } else {
+    fprintf(stderr, "keepalive_bench: HTTP %d\n", code);
+  }
+  http.end();
+  return ok;
+}
+
+struct Result {
+  std::vector<double> ms;
+  uint32_t handshakes = 0;
+  uint32_t failed = 0;
+};
+
+double percentile(std::vector<double> v, double p) {
+  std::sort(v.begin(), v.end());
+  return v.empty() ? 0 : v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+Result run(const String& url, int polls, bool warm) {
+  Result r;
+  uint32_t before = handshakes;
+  std::unique_ptr<WiFiClient> client;
+  std::unique_ptr<HTTPClient> http;
+  for (int i = 0; i < polls; i++) {
+    auto start = std::chrono::steady_clock::now();
+    if (!warm || !client) {
+      http.reset();   // before the client, as otaCleanup() does
+      client = makeClient(url);
+      http.reset(new HTTPClient());
+    }
+    if (!poll(*http, *client, url)) r.failed++;
+    r.ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+  }
+  r.handshakes = handshakes - before;
+  return r;
+}
+
+void print(const char* mode, const Result& r) {
+  printf("%-5s %6zu %11u %11.3f %9.3f %7u\n", mode, r.ms.size(), r.handshakes, percentile(r.ms, 0.5),
+         percentile(r.ms, 0.9), r.failed);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: keepalive_bench URL [polls]\n");
+    return 2;
+  }
+  String url = argv[1];
+  int polls = argc > 2 ? std::max(1, atoi(argv[2])) : 20;
+
+  // Warm first: the scenario's closes (5th and 10th response) land on it
+  Result warm = run(url, polls, true);
+  Result cold = run(url, polls, false);
+  printf("%-5s %6s %11s %11s %9s %7s\n", "mode", "polls", "handshakes", "median ms", "p90 ms", "failed");
+  print("cold", cold);
+  print("warm", warm);
+  if (warm.ms.size() && cold.ms.size()) {
+    printf("warm/cold median: %.3f\n", percentile(warm.ms, 0.5) / percentile(cold.ms, 0.5));
+  }
+
+  if (cold.failed || warm.failed) {
+    fprintf(stderr, "keepalive_bench: %u poll(s) failed\n", cold.failed + warm.failed);
+    return 1;
+  }
+  if (polls > 1 && warm.handshakes >= (uint32_t)polls) {
+    fprintf(stderr, "keepalive_bench: every warm poll reconnected, keep-alive is not working\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,249 @@
+// The logging layer (src/log.cpp) on the core stand-in of tools/native,
+// built with LOG_LEVEL_INFO like the firmware:
+//
+//   make -C tools/native log_bench
+//   tools/native/log_bench [chunks] [work_us]
+//
+// - output: what the ring drains for every supported conversion, against
+//   the expected text
+// - elision: a LOGD's arguments are not evaluated and its format string is
+//   not in the binary
+// - non-blocking: with the UART FIFO full, LOG calls and logLoop() return
+//   at once and count what the full ring drops
+// - OTA hot path: an update of `chunks` 1 KB chunks with `work_us` of busy
+//   work each (default 1024 and 200, a stand-in for the flash write) and a
+//   progress line per chunk, through a 115200 baud UART with the 128 byte
+//   TX FIFO of the ESP8266: LOGI + logLoop() against the blocking
+//   Serial.printf() it replaces, and the same with the 100 ms throttle of
+//   onProgress. Host times; the ratio is what carries over.
+//
+// Exit code 1 if an output line differs, the LOGD is not elided, a call
+// blocks on the full FIFO, or logging costs the hot path more than the
+// blocking baseline.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <Arduino.h>
+
+#include "log.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double usSince(Clock::time_point t) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - t).count();
+}
+
+void busy(uint32_t us) {
+  auto t = Clock::now();
+  while (usSince(t) < us) {}
+}
+
+// TX FIFO drained at the line rate on the host clock; write() waits for
+// room like the core's uart_write() does. bytesPerUs 0: drains at once.
+class Uart : public HardwareSerial {
+ public:
+  static constexpr int FIFO = 128;
+
+  explicit Uart(double bytesPerUs, bool keep) : rate_(bytesPerUs), keep_(keep) {}
+
+  int availableForWrite() override {
+    if (!rate_) return FIFO;
+    double now = usSince(start_);
+    fill_ = std::max(0.0, fill_ - (now - at_) * rate_);
+    at_ = now;
+    return FIFO - (int)std::ceil(fill_);
+  }
+
+  size_t write(uint8_t c) override {
+    while (availableForWrite() <= 0) {}
+    fill_ += 1;
+    if (keep_) text += (char)c;
+    return 1;
+  }
+
+  size_t write(const uint8_t* buf, size_t n) override {
+    for (size_t i = 0; i < n; i++) write(buf[i]);
+    return n;
+  }
+
+  void flush() override {}
+
+  std::string text;
+
+ private:
+  Clock::time_point start_ = Clock::now();
+  double rate_;
+  bool keep_;
+  double fill_ = 0;
+  double at_ = 0;
+};
+
+// Always full: nothing leaves
+class StuckUart : public HardwareSerial {
+ public:
+  int availableForWrite() override { return 0; }
+  size_t write(uint8_t) override { written++; return 0; }
+  size_t write(const uint8_t*, size_t n) override { written += n; return 0; }
+  void flush() override {}
+  size_t written = 0;
+};
+
+int failures = 0;
+
+// Drops what is left in the ring, before the sink goes out of scope
+void discardPending() {
+  static Uart discard(0, false);
+  logBegin(discard);
+  logFlush();
+}
+
+void check(bool ok, const char* what) {
+  printf("  %-44s %s\n", what, ok ? "ok" : "FAIL");
+  if (!ok) failures++;
+}
+
+void output() {
+  printf("output:\n");
+  Uart uart(0, true);
+  logBegin(uart);
+  String version("v1.2.3");
+  LOGI("OTA", "Free heap: %u bytes", 12345u);
+  LOGE("OTA", "JSON error: %s", "IncompleteInput");
+  LOGI("OTA", "%d%% (%d/%d)\r", 42, 1000, 2000);
+  LOGI("OTA", "New: %s -> %s", "v1.0.0", version);
+  LOGW("MEM", "%-6s|%5lu|%08lx|%.2f|%lld", "ab", 7UL, 0xBEEFUL, 3.14159, -5LL);
+  LOGI("FMT", "%i %c %X %+d %5.1f%%", -7, 'z', 0xABu, 3, 99.44);
+  LOGI("FMT", "%s", (const char*)nullptr);
+  LOGI("WiFi", "no args");
+  logFlush();
+  const char* want =
+      "[OTA] Free heap: 12345 bytes\n"
+      "[OTA] JSON error: IncompleteInput\n"
+      "[OTA] 42% (1000/2000)\r"
+      "\n[OTA] New: v1.0.0 -> v1.2.3\n"
+      "[MEM] ab    |    7|0000beef|3.14|-5\n"
+      "[FMT] -7 z AB +3  99.4%\n"
+      "[FMT] (null)\n"
+      "[WiFi] no args\n";
+  bool same = uart.text == want;
+  if (!same) fprintf(stderr, "got:\n%s\nwant:\n%s\n", uart.text.c_str(), want);
+  check(same, "formatted lines as expected");
+}
+
+void elision() {
+  printf("elision (LOG_LEVEL %d):\n", LOG_LEVEL);
+  int evaluated = 0;
+  LOGD("BENCH", "elided-debug-format %d", ++evaluated);
+  check(evaluated == 0, "LOGD arguments not evaluated");
+
+  // The needle is built at run time, so only an emitted format string matches
+  std::string needle = "tamrof-gubed-dedile";
+  std::reverse(needle.begin(), needle.end());
+  std::ifstream self("/proc/self/exe", std::ios::binary);
+  std::string image((std::istreambuf_iterator<char>(self)), std::istreambuf_iterator<char>());
+  check(!image.empty() && image.find(needle) == std::string::npos, "LOGD format string not in the binary");
+}
+
+void nonBlocking() {
+  printf("non-blocking:\n");
+  StuckUart uart;
+  logBegin(uart);
+  uint32_t before = logDropped();
+  double worst = 0;
+  for (int i = 0; i < 2000; i++) {
+    auto t = Clock::now();
+    LOGI("OTA", "%d%% (%d/%d)\r", i % 100, i, 2000);
+    logLoop();
+    worst = std::max(worst, usSince(t));
+  }
+  printf("  2000 records, %u dropped, slowest call %.1f us\n", logDropped() - before, worst);
+  check(uart.written == 0, "nothing written to the full FIFO");
+  check(logDropped() - before > 0, "full ring drops and counts");
+  check(worst < 1000, "no call waits for the UART");
+  discardPending();
+}
+
+struct HotPath {
+  double us;
+  uint32_t lines;
+};
+
+// One update: chunk work, onProgress every chunk or every 100 ms
+HotPath update(int chunks, uint32_t workUs, bool ring, bool throttle) {
+  Uart uart(115200 / 10 / 1e6, false);   // 8N1: 10 bits per byte
+  logBegin(uart);
+  auto start = Clock::now();
+  double lastLine = -1e9;
+  uint32_t lines = 0;
+  for (int cur = 1; cur <= chunks; cur++) {
+    busy(workUs);
+    double now = usSince(start);
+    if (!throttle || now - lastLine > 100000) {
+      int pct = cur * 100 / chunks;
+      if (ring) {
+        LOGI("OTA", "%d%% (%d/%d)\r", pct, cur * 1024, chunks * 1024);
+      } else {
+        char buf[48];
+        int n = snprintf(buf, sizeof(buf), "%d%% (%d/%d)\r", pct, cur * 1024, chunks * 1024);
+        uart.write((const uint8_t*)buf, n);
+      }
+      lastLine = now;
+      lines++;
+    }
+    if (ring) logLoop();
+  }
+  HotPath r = { usSince(start), lines };
+  discardPending();
+  return r;
+}
+
+void hotPath(int chunks, uint32_t workUs) {
+  printf("OTA hot path: %d chunks of 1 KB, %u us work each, 115200 baud:\n", chunks, workUs);
+  printf("  %-30s %10s %8s %10s\n", "progress line", "ms", "lines", "KB/s");
+  double base = 0;
+  for (int throttle = 0; throttle < 2; throttle++) {
+    for (int ring = 0; ring < 2; ring++) {
+      uint32_t droppedBefore = logDropped();
+      HotPath r = update(chunks, workUs, ring, throttle);
+      char name[48];
+      snprintf(name, sizeof(name), "%s, %s", throttle ? "every 100 ms" : "every chunk",
+               ring ? "LOGI" : "Serial.printf");
+      printf("  %-30s %10.1f %8u %10.0f", name, r.us / 1000, r.lines, chunks / (r.us / 1e6));
+      if (ring) printf("   (%u dropped)", logDropped() - droppedBefore);
+      printf("\n");
+      if (!ring) {
+        base = r.us;
+      } else {
+        // allow the host's scheduling noise, not a cost
+        check(r.us <= base * 1.1, throttle ? "LOGI no slower, throttled" : "LOGI no slower, every chunk");
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int chunks = argc > 1 ? std::max(1, atoi(argv[1])) : 1024;
+  uint32_t workUs = argc > 2 ? (uint32_t)atoi(argv[2]) : 200;
+
+  output();
+  elision();
+  nonBlocking();
+  hotPath(chunks, workUs);
+
+  if (failures) {
+    fprintf(stderr, "log_bench: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("log_bench: ok\n");
+  return 0;
+}
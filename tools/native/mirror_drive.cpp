@@ -0,0 +1,69 @@
+// Manifest polls through mirrorsGet() (src/mirrors.cpp, with the redirect
+// cache, HttpBodyStream and the log it uses) on the core stand-in of tools/native, against
+// the four mirror ports of tools/mock_server/scenarios/mirrors.txt: 8081
+// the primary, which turns slow (6 s) for four requests after its third,
+// 8082 slow throughout (1.5 s), 8083 failing its first two requests, 8084
+// not listening.
+//
+//   make -C tools/native mirror_drive
+//   (in a tools/release output dir) mock_server tools/mock_server/scenarios/mirrors.txt
+//   tools/native/mirror_drive http://127.0.0.1:8081/manifest.json
+//     "http://127.0.0.1:8082 http://127.0.0.1:8083 http://127.0.0.1:8084" [polls]
+//
+// Prints the MIRROR log and the time of every poll, then the per-host
+// gauges of /metrics. Exit code 1 if a poll gets no manifest, or if one
+// waits out the primary's slow answer instead of failing over within its
+// budget.
+
+#include <algorithm>
+
+#include <Arduino.h>
+#include <ESP8266HTTPClient.h>
+#include <WiFiClientSecureBearSSL.h>
+
+#include "http_body.h"
+#include "log.h"
+#include "mirrors.h"
+
+// The primary's latency while it is slow, see mirrors.txt
+#define SLOW_PRIMARY_MS 6000UL
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: mirror_drive URL \"MIRROR_BASE ...\" [polls]\n");
+    return 2;
+  }
+  int polls = argc > 3 ? std::max(1, atoi(argv[3])) : 12;
+  logBegin(Serial);
+  mirrorsSet(MIRRORS_MANIFEST, argv[1]);
+  mirrorsAdd(MIRRORS_MANIFEST, argv[2]);
+
+  BearSSL::WiFiClientSecure tls;
+  tls.setInsecure();
+  HTTPClient http;
+  int failed = 0, waited = 0, failovers = 0;
+  for (int poll = 0; poll < polls; poll++) {
+    uint32_t start = millis();
+    uint8_t used = 0;
+    int code = mirrorsGet(http, tls, MIRRORS_MANIFEST, nullptr, 20000, &used);
+    if (code == HTTP_CODE_OK) {   // the body, as the manifest parser reads it
+      HttpBodyStream body(http.getStream(), http.getSize(), false);
+      if (!body.drain(5000)) code = HTTPC_ERROR_READ_TIMEOUT;
+    }
+    http.end();
+    uint32_t ms = millis() - start;
+    logFlush();
+    printf("poll %2d: %d from %s in %u ms\n", poll, code, mirrorsUrl(MIRRORS_MANIFEST, used), ms);
+    if (code != HTTP_CODE_OK) failed++;
+    if (used) failovers++;
+    if (ms >= SLOW_PRIMARY_MS) waited++;
+  }
+
+  printf("\n");
+  mirrorsWriteText(Serial);
+  Serial.flush();
+  printf("\npolls %d, failed %d, answered by a mirror %d, waited out the slow primary %d\n", polls,
+         failed, failovers, waited);
+  if (failed || waited) return 1;
+  return 0;
+}
@@ -0,0 +1,267 @@
+// Native host build of the firmware: src/*.cpp unchanged, against the core
+// stand-in in tools/native/core (HTTPClient, Updater, BearSSL on OpenSSL,
+// flash and RTC memory), so the whole OTA path - manifest, delta or full
+// download, eboot copy, reboot, rollback confirmation - runs on a PC
+// against tools/mock_server.
+//
+//   make -C tools/native                   ota_native, mock_server, release
+//   tools/native/run_scenarios.sh          every shipped scenario, checked
+//
+//   OTA_MOCK_URL=http://127.0.0.1:8080/manifest.cbor
+//   tools/native/ota_native --flash flash.img --image v1.0.0=old.bin
+//       --image v1.1.0=public/firmware/esp8266-power-v1.1.0.bin
+//       [--seconds 60] [--boots 5] [--metrics metrics.txt]
+//
+// The flash is a 4 MB file: a new one starts as 0xFF with the first
+// --image at 0x0. Which version runs is read back from flash on every
+// boot (image bytes compared with each --image, flash mode byte ignored);
+// flash holding none of them exits 3 - the device would not boot.
+//
+// ESP.restart() saves flash and RTC memory and execs this binary again,
+// which plays eboot: a copy command in RTC memory is carried out before
+// setup(). The run ends after --seconds in total (exit 0, /metrics written
+// to --metrics) or when a boot beyond --boots is asked for (exit 1).
+//
+// The device clock starts at 0 on each boot and SNTP answers after
+// NATIVE_SNTP_DELAY_MS (1500); the status server is on NATIVE_HTTP_PORT
+// (8088). Heap figures are fixed (NATIVE_FREE_HEAP), see core/Arduino.h.
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <Arduino.h>
+#include <StreamString.h>
+#include <eboot_command.h>
+#include <flash_hal.h>
+#include <user_interface.h>
+
+#include <string>
+#include <vector>
+
+#include "metrics.h"
+#include "native.h"
+
+void setup();
+void loop();
+
+uint8_t nativeFlash[NATIVE_FLASH_SIZE];
+uint8_t nativeRtc[NATIVE_RTC_SIZE];
+uint32_t nativeResetReason = REASON_DEFAULT_RST;
+
+namespace {
+
+const uint32_t APP_START = 0x1000;     // eboot's sector, then the app
+
+struct Image {
+  std::string version;
+  std::vector<uint8_t> bytes;
+};
+
+std::vector<Image> images;
+std::string flashFile;
+std::string metricsFile;
+char** selfArgv;
+const char* running = "";
+unsigned boot = 0;
+unsigned maxBoots = 5;
+uint64_t deadlineMs = 0;
+
+uint64_t monotonicMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+bool readFile(const std::string& path, std::vector<uint8_t>& out) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return false;
+  uint8_t buf[65536];
+  size_t n;
+  out.clear();
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+bool writeFile(const std::string& path, const void* data, size_t len) {
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) return false;
+  bool ok = fwrite(data, 1, len, f) == len;
+  return fclose(f) == 0 && ok;
+}
+
+std::string rtcFile() {
+  return flashFile + ".rtc";
+}
+
+void saveState() {
+  fflush(stdout);
+  if (!writeFile(flashFile, nativeFlash, NATIVE_FLASH_SIZE) || !writeFile(rtcFile(), nativeRtc, NATIVE_RTC_SIZE)) {
+    fprintf(stderr, "native: cannot write %s\n", flashFile.c_str());
+    _exit(2);
+  }
+}
+
+// eboot: carry out a copy command left by the Updater (or ota_delta)
+void eboot() {
+  eboot_command cmd;
+  if (eboot_command_read(&cmd) || cmd.action != ACTION_COPY_RAW) return;
+  uint32_t from = cmd.args[0], to = cmd.args[1], size = cmd.args[2];
+  eboot_command_clear();
+  if (from + size > NATIVE_FLASH_SIZE || to + size > NATIVE_FLASH_SIZE) {
+    printf("[NATIVE] eboot: bad copy command 0x%x -> 0x%x (%u bytes)\n", from, to, size);
+    return;
+  }
+  for (uint32_t sector = to / FLASH_SECTOR_SIZE; sector * FLASH_SECTOR_SIZE < to + size; sector++) {
+    memset(nativeFlash + sector * FLASH_SECTOR_SIZE, 0xFF, FLASH_SECTOR_SIZE);
+  }
+  memcpy(nativeFlash + to, nativeFlash + from, size);
+  printf("[NATIVE] eboot: copied %u bytes from 0x%x to 0x%x\n", size, from, to);
+}
+
+// The image in flash, by comparing the bytes (the Updater rewrites the
+// flash mode byte at offset 2)
+const Image* identify() {
+  for (const Image& img : images) {
+    if (img.bytes.size() < 3 || img.bytes.size() > NATIVE_FLASH_SIZE) continue;
+    if (memcmp(nativeFlash, img.bytes.data(), 2) == 0 &&
+        memcmp(nativeFlash + 3, img.bytes.data() + 3, img.bytes.size() - 3) == 0) {
+      return &img;
+    }
+  }
+  return nullptr;
+}
+
+void usage() {
+  fprintf(stderr, "usage: ota_native --flash FILE --image VERSION=BIN [--image ...] "
+                  "[--seconds S] [--boots N] [--metrics FILE]\n");
+  exit(2);
+}
+
+}  // namespace
+
+const char* nativeFwVersion() {
+  return running;
+}
+
+const char* nativeManifestUrl() {
+  const char* url = getenv("OTA_MOCK_URL");
+  return url ? url : "http://127.0.0.1:8080/manifest.cbor";
+}
+
+const char* nativeManifestMirrors() {
+  const char* mirrors = getenv("OTA_MOCK_MIRRORS");
+  return mirrors ? mirrors : "";
+}
+
+uint32_t nativeImageSize(uint32_t addr) {
+  uint32_t pos = addr + APP_START;
+  if (pos + 8 > NATIVE_FLASH_SIZE || nativeFlash[pos] != 0xE9) return 0;
+  uint8_t segments = nativeFlash[pos + 1];
+  pos += 8;
+  for (uint8_t i = 0; i < segments; i++) {
+    if (pos + 8 > NATIVE_FLASH_SIZE) return 0;
+    uint32_t size;
+    memcpy(&size, nativeFlash + pos + 4, 4);
+    pos += 8 + size;
+  }
+  return pos > NATIVE_FLASH_SIZE ? 0 : ((pos + 16) & ~15u) - addr;
+}
+
+void nativeRestart(uint32_t reason) {
+  saveState();
+  if (boot + 1 > maxBoots) {
+    printf("[NATIVE] boot %u asked for, --boots is %u: stopping\n", boot + 1, maxBoots);
+    exit(1);
+  }
+  printf("[NATIVE] restart (reason %u)\n", reason);
+  fflush(stdout);
+  setenv("NATIVE_BOOT", std::to_string(boot + 1).c_str(), 1);
+  setenv("NATIVE_RESET", std::to_string(reason).c_str(), 1);
+  setenv("NATIVE_DEADLINE", std::to_string(deadlineMs).c_str(), 1);
+  execv("/proc/self/exe", selfArgv);
+  perror("native: exec");
+  _exit(2);
+}
+
+void nativeTick() {
+  static bool stopping = false;
+  if (stopping || monotonicMs() < deadlineMs) return;
+  stopping = true;
+  saveState();
+  if (!metricsFile.empty()) {
+    StreamString body;
+    metricsWriteText(body);
+    writeFile(metricsFile, body.c_str(), body.length());
+  }
+  printf("[NATIVE] time is up, running %s after %u boot(s)\n", running, boot + 1);
+  exit(0);
+}
+
+int main(int argc, char** argv) {
+  selfArgv = argv;
+  signal(SIGPIPE, SIG_IGN);
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+
+  unsigned seconds = 60;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    if (i + 1 >= argc) usage();
+    std::string v = argv[++i];
+    if (a == "--flash") {
+      flashFile = v;
+    } else if (a == "--image") {
+      size_t eq = v.find('=');
+      if (eq == std::string::npos) usage();
+      Image img{ v.substr(0, eq), {} };
+      if (!readFile(v.substr(eq + 1), img.bytes)) {
+        fprintf(stderr, "native: cannot read %s\n", v.c_str() + eq + 1);
+        return 2;
+      }
+      images.push_back(std::move(img));
+    } else if (a == "--seconds") {
+      seconds = atoi(v.c_str());
+    } else if (a == "--boots") {
+      maxBoots = atoi(v.c_str());
+    } else if (a == "--metrics") {
+      metricsFile = v;
+    } else {
+      usage();
+    }
+  }
+  if (flashFile.empty() || images.empty()) usage();
+
+  const char* env = getenv("NATIVE_BOOT");
+  boot = env ? atoi(env) : 0;
+  env = getenv("NATIVE_RESET");
+  nativeResetReason = env ? atoi(env) : REASON_DEFAULT_RST;
+  env = getenv("NATIVE_DEADLINE");
+  deadlineMs = env ? strtoull(env, nullptr, 10) : monotonicMs() + seconds * 1000ull;
+
+  std::vector<uint8_t> stored;
+  if (readFile(flashFile, stored) && stored.size() == NATIVE_FLASH_SIZE) {
+    memcpy(nativeFlash, stored.data(), NATIVE_FLASH_SIZE);
+  } else {
+    memset(nativeFlash, 0xFF, NATIVE_FLASH_SIZE);
+    memcpy(nativeFlash, images[0].bytes.data(), min(images[0].bytes.size(), (size_t)NATIVE_FLASH_SIZE));
+  }
+  // Power-on clears RTC memory, a restart keeps it
+  if (!boot || !readFile(rtcFile(), stored) || stored.size() != NATIVE_RTC_SIZE) {
+    memset(nativeRtc, 0, NATIVE_RTC_SIZE);
+  } else {
+    memcpy(nativeRtc, stored.data(), NATIVE_RTC_SIZE);
+  }
+
+  eboot();
+  const Image* img = identify();
+  if (!img) {
+    printf("[NATIVE] boot %u: flash holds none of the --image files\n", boot + 1);
+    saveState();
+    return 3;
+  }
+  running = img->version.c_str();
+  printf("[NATIVE] boot %u (reset reason %u): %s\n", boot + 1, nativeResetReason, running);
+
+  setup();
+  for (;;) loop();
+}
@@ -0,0 +1,38 @@
+// Shared between the core stand-in (tools/native/core.cpp, net.cpp) and
+// the driver (native.cpp). Also force-included into src/*.cpp, where
+// FW_VERSION, FW_MANIFEST_URL and FW_MANIFEST_MIRRORS resolve to the
+// functions below.
+
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NATIVE_FLASH_SIZE (4u << 20)
+#define NATIVE_RTC_SIZE 512u
+
+extern uint8_t nativeFlash[NATIVE_FLASH_SIZE];
+extern uint8_t nativeRtc[NATIVE_RTC_SIZE];
+extern uint32_t nativeResetReason;
+
+// Flash bytes left to program before a power cut, -1 (the default) for no
+// limit. Once it is 0, the next program or erase calls nativeRestart()
+// with REASON_DEFAULT_RST instead, a half-written word stays half written.
+extern int32_t nativeFlashBudget;
+
+const char* nativeFwVersion();       // version of the image eboot started
+const char* nativeManifestUrl();     // $OTA_MOCK_URL, as the d1_mini_mock env
+const char* nativeManifestMirrors(); // $OTA_MOCK_MIRRORS
+
+// Saves flash and RTC memory and runs the binary again: the next boot
+void nativeRestart(uint32_t reason) __attribute__((noreturn));
+
+// From delay() and yield(): ends the run at --seconds
+void nativeTick();
+
+// Size of the image at addr as the core computes it (headers of the app
+// image after eboot's sector), 0 if there is none
+uint32_t nativeImageSize(uint32_t addr);
+
+#endif
@@ -0,0 +1,998 @@
+// Network part of the core stand-in for tools/native: WiFiClient over
+// sockets, BearSSL::WiFiClientSecure over OpenSSL, HTTPClient,
+// ESP8266HTTPUpdate (with the Updater), ESP8266WebServer, WiFi.hostByName.
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509_vfy.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <Arduino.h>
+#include <ESP8266HTTPClient.h>
+#include <ESP8266WebServer.h>
+#include <ESP8266WiFi.h>
+#include <ESP8266httpUpdate.h>
+#include <MD5Builder.h>
+#include <WiFiClientSecureBearSSL.h>
+#include <eboot_command.h>
+#include <flash_hal.h>
+
+#include "native.h"
+
+ESP8266HTTPUpdate ESPhttpUpdate;
+
+// BearSSL error codes the firmware may log
+static const int BR_ERR_BAD_PARAM = 1;
+static const int BR_ERR_IO = 31;
+static const int BR_ERR_X509_NOT_TRUSTED = 62;
+
+enum Trust : uint8_t { TRUST_NONE, TRUST_INSECURE, TRUST_KEY, TRUST_ANCHORS };
+
+struct NativeConn {
+  int fd = -1;
+  SSL_CTX* ctx = nullptr;
+  SSL* ssl = nullptr;
+  bool secure = false;
+  bool eof = false;             // peer closed or reset
+  std::string rx;               // received, not yet read
+  size_t rxPos = 0;
+
+  Trust trust = TRUST_NONE;
+  std::string keyDer;
+  std::string anchorsPem;
+  time_t x509Time = 0;
+  int sslError = 0;
+  std::string sslErrorText;
+
+  ~NativeConn() { close(); }
+
+  void close() {
+    if (ssl) SSL_free(ssl);
+    if (ctx) SSL_CTX_free(ctx);
+    if (fd >= 0) ::close(fd);
+    ssl = nullptr;
+    ctx = nullptr;
+    fd = -1;
+    eof = false;
+    rx.clear();
+    rxPos = 0;
+  }
+
+  size_t buffered() const { return rx.size() - rxPos; }
+
+  // Reads what arrived; with waitMs > 0 waits that long for something
+  void fill(uint32_t waitMs) {
+    if (fd < 0 || eof || buffered()) return;
+    if (rxPos) {
+      rx.clear();
+      rxPos = 0;
+    }
+    if (!ssl || !SSL_pending(ssl)) {
+      struct pollfd p = { fd, POLLIN, 0 };
+      if (poll(&p, 1, waitMs) <= 0) return;
+    }
+    // Readable may be only a TLS 1.3 session ticket: a blocking SSL_read
+    // would then wait for application data up to the socket timeout
+    char buf[4096];
+    int n;
+    if (ssl) {
+      fcntl(fd, F_SETFL, O_NONBLOCK);
+      n = SSL_read(ssl, buf, sizeof(buf));
+      fcntl(fd, F_SETFL, 0);
+    } else {
+      n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+    }
+    if (n > 0) {
+      rx.append(buf, n);
+    } else if (!ssl && n < 0 && (errno == EAGAIN || errno == EINTR)) {
+      return;
+    } else if (ssl && n <= 0 && SSL_get_error(ssl, n) == SSL_ERROR_WANT_READ) {
+      return;
+    } else {
+      eof = true;
+    }
+  }
+};
+
+// --- WiFi ---
+
+static bool resolve(const char* host, struct sockaddr_in& addr) {
+  struct addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* res = nullptr;
+  if (getaddrinfo(host, nullptr, &hints, &res) != 0 || !res) return false;
+  addr = *reinterpret_cast<struct sockaddr_in*>(res->ai_addr);
+  freeaddrinfo(res);
+  return true;
+}
+
+int ESP8266WiFiClass::hostByName(const char* host, IPAddress& result, uint32_t) {
+  struct sockaddr_in addr;
+  if (!resolve(host, addr)) return 0;
+  const uint8_t* b = reinterpret_cast<const uint8_t*>(&addr.sin_addr.s_addr);
+  result = IPAddress(b[0], b[1], b[2], b[3]);
+  return 1;
+}
+
+// --- WiFiClient ---
+
+WiFiClient::WiFiClient() : _conn(std::make_shared<NativeConn>()) {
+  _timeout = 5000;
+}
+
+WiFiClient::WiFiClient(int fd) : WiFiClient() {
+  _conn->fd = fd;
+}
+
+static IPAddress sockAddr(int fd, bool peer) {
+  struct sockaddr_in addr = {};
+  socklen_t len = sizeof(addr);
+  if (fd < 0 || (peer ? getpeername(fd, reinterpret_cast<struct sockaddr*>(&addr), &len)
+                      : getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &len)) != 0) {
+    return IPAddress();
+  }
+  return IPAddress((uint32_t)addr.sin_addr.s_addr);
+}
+
+IPAddress WiFiClient::localIP() {
+  return sockAddr(_conn->fd, false);
+}
+
+IPAddress WiFiClient::remoteIP() {
+  return sockAddr(_conn->fd, true);
+}
+
+static int tcpConnect(NativeConn& c, const struct sockaddr_in& addr, uint32_t timeoutMs) {
+  c.close();
+  c.fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  if (c.fd < 0) return 0;
+  if (connect(c.fd, reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr)) != 0 &&
+      errno != EINPROGRESS) {
+    c.close();
+    return 0;
+  }
+  struct pollfd p = { c.fd, POLLOUT, 0 };
+  int err = 0;
+  socklen_t len = sizeof(err);
+  if (poll(&p, 1, timeoutMs) != 1 || getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err) {
+    c.close();
+    return 0;
+  }
+  int flags = 1;
+  setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &flags, sizeof(flags));
+  // blocking from here on, bounded by the timeout
+  struct timeval tv = { (time_t)(timeoutMs / 1000), (suseconds_t)(timeoutMs % 1000) * 1000 };
+  setsockopt(c.fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(c.fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  fcntl(c.fd, F_SETFL, 0);
+  return 1;
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+  struct sockaddr_in addr;
+  if (!resolve(host, addr)) {
+    _conn->close();
+    return 0;
+  }
+  addr.sin_port = htons(port);
+  return tcpConnect(*_conn, addr, _timeout);
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+  return connect(ip.toString().c_str(), port);
+}
+
+uint8_t WiFiClient::connected() {
+  if (_conn->fd < 0) return 0;
+  _conn->fill(0);
+  return !_conn->eof || _conn->buffered();
+}
+
+bool WiFiClient::stop(unsigned int) {
+  _conn->close();
+  return true;
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t n) {
+  NativeConn& c = *_conn;
+  size_t done = 0;
+  while (c.fd >= 0 && done < n) {
+    int w = c.ssl ? SSL_write(c.ssl, buf + done, n - done) : send(c.fd, buf + done, n - done, MSG_NOSIGNAL);
+    if (w <= 0) break;
+    done += w;
+  }
+  return done;
+}
+
+int WiFiClient::available() {
+  _conn->fill(0);
+  return _conn->buffered();
+}
+
+int WiFiClient::read() {
+  _conn->fill(0);
+  if (!_conn->buffered()) return -1;
+  return (uint8_t)_conn->rx[_conn->rxPos++];
+}
+
+int WiFiClient::peek() {
+  _conn->fill(0);
+  if (!_conn->buffered()) return -1;
+  return (uint8_t)_conn->rx[_conn->rxPos];
+}
+
+int WiFiClient::read(uint8_t* buf, size_t n) {
+  _conn->fill(0);
+  size_t got = min(n, _conn->buffered());
+  memcpy(buf, _conn->rx.data() + _conn->rxPos, got);
+  _conn->rxPos += got;
+  return got;
+}
+
+size_t WiFiClient::readBytes(char* buf, size_t n) {
+  uint32_t start = millis();
+  size_t got = 0;
+  while (got < n) {
+    uint32_t spent = millis() - start;
+    if (spent >= _timeout) break;
+    _conn->fill(min<uint32_t>(_timeout - spent, 50));
+    if (!_conn->buffered()) {
+      if (_conn->fd < 0 || _conn->eof) break;
+      yield();
+      continue;
+    }
+    got += read(reinterpret_cast<uint8_t*>(buf) + got, n - got);
+  }
+  return got;
+}
+
+size_t WiFiClient::peekBytes(uint8_t* buf, size_t n) {
+  uint32_t start = millis();
+  while (!_conn->buffered() && _conn->fd >= 0 && !_conn->eof && millis() - start < _timeout) {
+    _conn->fill(50);
+    yield();
+  }
+  size_t got = min(n, _conn->buffered());
+  memcpy(buf, _conn->rx.data() + _conn->rxPos, got);
+  return got;
+}
+
+// --- BearSSL on OpenSSL ---
+
+namespace BearSSL {
+
+PublicKey::PublicKey(const char* pem) {
+  BIO* bio = BIO_new_mem_buf(pem, -1);
+  EVP_PKEY* key = PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);
+  BIO_free(bio);
+  if (!key) return;
+  int id = EVP_PKEY_base_id(key);
+  _type = id == EVP_PKEY_RSA ? 1 : id == EVP_PKEY_EC ? 2 : 0;
+  unsigned char* der = nullptr;
+  int len = i2d_PUBKEY(key, &der);
+  if (len > 0) _der.assign(reinterpret_cast<char*>(der), len);
+  OPENSSL_free(der);
+  EVP_PKEY_free(key);
+}
+
+size_t X509List::getCount() const {
+  BIO* bio = BIO_new_mem_buf(_pem.data(), _pem.size());
+  size_t n = 0;
+  while (X509* cert = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr)) {
+    X509_free(cert);
+    n++;
+  }
+  BIO_free(bio);
+  ERR_clear_error();
+  return n;
+}
+
+WiFiClientSecure::WiFiClientSecure() {
+  _conn->secure = true;
+}
+
+void WiFiClientSecure::setInsecure() {
+  _conn->trust = TRUST_INSECURE;
+}
+
+void WiFiClientSecure::setKnownKey(const PublicKey* pk) {
+  _conn->trust = TRUST_KEY;
+  _conn->keyDer = pk ? pk->der() : std::string();
+}
+
+void WiFiClientSecure::setTrustAnchors(const X509List* ta) {
+  _conn->trust = TRUST_ANCHORS;
+  _conn->anchorsPem = ta ? ta->pem() : std::string();
+}
+
+void WiFiClientSecure::setX509Time(time_t now) {
+  _conn->x509Time = now;
+}
+
+void WiFiClientSecure::setBufferSizes(int, int) {}
+
+int WiFiClientSecure::getLastSSLError(char* dest, size_t len) {
+  if (dest && len) strlcpy(dest, _conn->sslErrorText.c_str(), len);
+  return _conn->sslError;
+}
+
+static int failTls(NativeConn& c, int err, const char* text) {
+  c.close();
+  c.sslError = err;
+  c.sslErrorText = text;
+  return 0;
+}
+
+int WiFiClientSecure::connect(const char* host, uint16_t port) {
+  NativeConn& c = *_conn;
+  c.sslError = 0;
+  c.sslErrorText.clear();
+  if (!WiFiClient::connect(host, port)) return 0;
+  if (c.trust == TRUST_NONE) return failTls(c, BR_ERR_BAD_PARAM, "no trust anchors or key set");
+
+  c.ctx = SSL_CTX_new(TLS_client_method());
+  if (c.trust == TRUST_ANCHORS) {
+    X509_STORE* store = SSL_CTX_get_cert_store(c.ctx);
+    BIO* bio = BIO_new_mem_buf(c.anchorsPem.data(), c.anchorsPem.size());
+    while (X509* cert = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr)) {
+      X509_STORE_add_cert(store, cert);
+      X509_free(cert);
+    }
+    BIO_free(bio);
+    ERR_clear_error();
+    SSL_CTX_set_verify(c.ctx, SSL_VERIFY_PEER, nullptr);
+    X509_VERIFY_PARAM_set_time(SSL_CTX_get0_param(c.ctx), c.x509Time);
+  } else {
+    SSL_CTX_set_verify(c.ctx, SSL_VERIFY_NONE, nullptr);
+  }
+  c.ssl = SSL_new(c.ctx);
+  SSL_set_fd(c.ssl, c.fd);
+  SSL_set_tlsext_host_name(c.ssl, host);
+  if (c.trust == TRUST_ANCHORS) SSL_set1_host(c.ssl, host);
+
+  if (SSL_connect(c.ssl) != 1) {
+    bool verify = SSL_get_verify_result(c.ssl) != X509_V_OK;
+    char text[120];
+    ERR_error_string_n(ERR_get_error(), text, sizeof(text));
+    ERR_clear_error();
+    return failTls(c, verify ? BR_ERR_X509_NOT_TRUSTED : BR_ERR_IO, text);
+  }
+  if (c.trust == TRUST_KEY) {
+    X509* peer = SSL_get1_peer_certificate(c.ssl);
+    unsigned char* der = nullptr;
+    int len = peer ? i2d_PUBKEY(X509_get0_pubkey(peer), &der) : 0;
+    bool same = len > 0 && std::string(reinterpret_cast<char*>(der), len) == c.keyDer;
+    OPENSSL_free(der);
+    X509_free(peer);
+    if (!same) return failTls(c, BR_ERR_X509_NOT_TRUSTED, "server key is not the pinned one");
+  }
+  return 1;
+}
+
+}  // namespace BearSSL
+
+// --- HTTPClient ---
+
+bool HTTPClient::begin(WiFiClient& client, const String& url) {
+  _client = client.clone();
+  clear();
+  return parseUrl(url);
+}
+
+void HTTPClient::clear() {
+  _returnCode = 0;
+  _size = -1;
+  _headers.clear();
+  _location.clear();
+  for (Header& h : _collect) h.value.clear();
+}
+
+bool HTTPClient::parseUrl(const String& url) {
+  int sep = url.indexOf("://");
+  if (sep < 0) return false;
+  _scheme = url.substring(0, sep);
+  _scheme.toLowerCase();
+  if (_scheme != "http" && _scheme != "https") return false;
+  String rest = url.substring(sep + 3);
+  int slash = rest.indexOf('/');
+  String host = slash < 0 ? rest : rest.substring(0, slash);
+  _uri = slash < 0 ? String("/") : rest.substring(slash);
+  int colon = host.indexOf(':');
+  _port = _scheme == "https" ? 443 : 80;
+  if (colon >= 0) {
+    _port = host.substring(colon + 1).toInt();
+    host = host.substring(0, colon);
+  }
+  _host = host;
+  return _host.length() > 0;
+}
+
+// Location of a redirect, followed inside GET(): a path keeps the host,
+// a URL must keep the scheme
+bool HTTPClient::setURL(const String& location) {
+  if (location.startsWith("/")) {
+    _uri = location;
+    clear();
+    return true;
+  }
+  if (!location.startsWith(_scheme + ":")) return false;
+  _canReuse = false;
+  disconnect(true);
+  return parseUrl(location);
+}
+
+void HTTPClient::setTimeout(uint16_t ms) {
+  _tcpTimeout = ms;
+  if (connected()) _client->setTimeout(ms);
+}
+
+void HTTPClient::addHeader(const String& name, const String& value, bool first, bool) {
+  String line = name + ": " + value + "\r\n";
+  if (first) {
+    _headers = line + _headers;
+  } else {
+    _headers += line;
+  }
+}
+
+void HTTPClient::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+  _collect.clear();
+  for (size_t i = 0; i < headerKeysCount; i++) _collect.push_back({ headerKeys[i], String() });
+}
+
+String HTTPClient::header(const char* name) {
+  for (const Header& h : _collect) {
+    if (h.key.equalsIgnoreCase(name)) return h.value;
+  }
+  return String();
+}
+
+bool HTTPClient::hasHeader(const char* name) {
+  return header(name).length() > 0;
+}
+
+bool HTTPClient::connected() {
+  return _client && (_client->connected() || _client->available() > 0);
+}
+
+bool HTTPClient::connect() {
+  if (_reuse && _canReuse && connected()) {
+    while (_client->available() > 0) _client->read();
+    return true;
+  }
+  if (!_client) return false;
+  _client->setTimeout(_tcpTimeout);
+  return _client->connect(_host.c_str(), _port) && connected();
+}
+
+void HTTPClient::disconnect(bool preserveClient) {
+  if (connected()) {
+    while (_client->available() > 0) _client->read();
+    if (!(_reuse && _canReuse)) {
+      _client->stop();
+      if (!preserveClient) _client = nullptr;
+    }
+  } else if (!preserveClient) {
+    _client = nullptr;
+  }
+}
+
+void HTTPClient::end() {
+  disconnect(false);
+  clear();
+}
+
+bool HTTPClient::readLine(String& line) {
+  line = _client->readStringUntil('\n');
+  line.trim();
+  return true;
+}
+
+int HTTPClient::handleHeaderResponse() {
+  if (!connected()) return HTTPC_ERROR_NOT_CONNECTED;
+  _returnCode = 0;
+  _size = -1;
+  _canReuse = _reuse;
+  String transferEncoding;
+  uint32_t lastData = millis();
+  while (connected()) {
+    if (_client->available() <= 0) {
+      if (millis() - lastData > _tcpTimeout) return HTTPC_ERROR_READ_TIMEOUT;
+      yield();
+      usleep(500);
+      continue;
+    }
+    String line;
+    readLine(line);
+    lastData = millis();
+    if (line.startsWith("HTTP/1.")) {
+      if (_canReuse) _canReuse = line[7] != '0';
+      _returnCode = line.substring(9, line.indexOf(' ', 9)).toInt();
+    } else if (line.indexOf(':') > 0) {
+      int colon = line.indexOf(':');
+      String key = line.substring(0, colon);
+      String value = line.substring(colon + 1);
+      value.trim();
+      if (key.equalsIgnoreCase("Content-Length")) _size = value.toInt();
+      if (_canReuse && key.equalsIgnoreCase("Connection") && value.indexOf("close") >= 0 &&
+          value.indexOf("keep-alive") < 0) {
+        _canReuse = false;
+      }
+      if (key.equalsIgnoreCase("Transfer-Encoding")) transferEncoding = value;
+      if (key.equalsIgnoreCase("Location")) _location = value;
+      for (Header& h : _collect) {
+        if (h.key.equalsIgnoreCase(key.c_str())) h.value = value;
+      }
+    }
+    if (line.length() == 0) {
+      if (!_returnCode) return HTTPC_ERROR_NO_HTTP_SERVER;
+      if (transferEncoding.length() && !transferEncoding.equalsIgnoreCase("chunked")) {
+        return HTTPC_ERROR_ENCODING;
+      }
+      if (transferEncoding.length()) _size = -1;
+      return _returnCode;
+    }
+  }
+  return HTTPC_ERROR_CONNECTION_LOST;
+}
+
+static bool followable(int code, followRedirects_t follow) {
+  if (follow == HTTPC_DISABLE_FOLLOW_REDIRECTS) return false;
+  return code == HTTP_CODE_MOVED_PERMANENTLY || code == HTTP_CODE_FOUND || code == HTTP_CODE_SEE_OTHER ||
+         code == HTTP_CODE_TEMPORARY_REDIRECT || code == HTTP_CODE_PERMANENT_REDIRECT;
+}
+
+int HTTPClient::sendRequest(const char* type) {
+  uint16_t redirects = 0;
+  int code;
+  for (;;) {
+    if (!connect()) {
+      if (connected()) _client->stop();
+      return HTTPC_ERROR_CONNECTION_FAILED;
+    }
+    bool defaultPort = _port == (_scheme == "https" ? 443 : 80);
+    String request = String(type) + " " + _uri + (_useHTTP10 ? " HTTP/1.0" : " HTTP/1.1") +
+                     "\r\nHost: " + _host + (defaultPort ? String() : ":" + String((unsigned)_port)) +
+                     "\r\nUser-Agent: " + _userAgent +
+                     "\r\nConnection: " + (_reuse ? "keep-alive" : "close") + "\r\n";
+    if (!_useHTTP10) request += "Accept-Encoding: identity;q=1,chunked;q=0.1,*;q=0\r\n";
+    request += _headers + "\r\n";
+    if (_client->write(request.c_str(), request.length()) != request.length()) {
+      _client->stop();
+      return HTTPC_ERROR_SEND_HEADER_FAILED;
+    }
+    code = handleHeaderResponse();
+    if (code < 0) {
+      if (connected()) _client->stop();
+      return code;
+    }
+    if (!followable(code, _follow) || redirects >= _redirectLimit || !_location.length()) return code;
+    redirects++;
+    String headers = _headers;
+    if (!setURL(_location)) return code;
+    _headers = headers;
+  }
+}
+
+int HTTPClient::GET() {
+  return sendRequest("GET");
+}
+
+String HTTPClient::errorToString(int error) {
+  switch (error) {
+    case HTTPC_ERROR_CONNECTION_FAILED: return F("connection failed");
+    case HTTPC_ERROR_SEND_HEADER_FAILED: return F("send header failed");
+    case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return F("send payload failed");
+    case HTTPC_ERROR_NOT_CONNECTED: return F("not connected");
+    case HTTPC_ERROR_CONNECTION_LOST: return F("connection lost");
+    case HTTPC_ERROR_NO_STREAM: return F("no stream");
+    case HTTPC_ERROR_NO_HTTP_SERVER: return F("no HTTP server");
+    case HTTPC_ERROR_TOO_LESS_RAM: return F("too less ram");
+    case HTTPC_ERROR_ENCODING: return F("Transfer-Encoding not supported");
+    case HTTPC_ERROR_STREAM_WRITE: return F("Stream write error");
+    case HTTPC_ERROR_READ_TIMEOUT: return F("read Timeout");
+    default: return String();
+  }
+}
+
+// --- ESP8266HTTPUpdate ---
+
+void ESP8266HTTPUpdate::setLastError(int err) {
+  _lastError = err;
+  if (_cbError) _cbError(err);
+}
+
+String ESP8266HTTPUpdate::getLastErrorString() {
+  if (_lastError == 0) return String();
+  if (_lastError > 0) {
+    char s[64];
+    snprintf(s, sizeof(s), "Update error: ERROR[%d]: %s", _lastError, Update.getErrorString().c_str());
+    return s;
+  }
+  if (_lastError > -100) return String(F("HTTP error: ")) + HTTPClient::errorToString(_lastError);
+  switch (_lastError) {
+    case HTTP_UE_TOO_LESS_SPACE: return F("Not Enough space");
+    case HTTP_UE_SERVER_NOT_REPORT_SIZE: return F("Server Did Not Report Size");
+    case HTTP_UE_SERVER_FILE_NOT_FOUND: return F("File Not Found (404)");
+    case HTTP_UE_SERVER_FORBIDDEN: return F("Forbidden (403)");
+    case HTTP_UE_SERVER_WRONG_HTTP_CODE: return F("Wrong HTTP Code");
+    case HTTP_UE_SERVER_FAULTY_MD5: return F("Wrong MD5");
+    case HTTP_UE_BIN_VERIFY_HEADER_FAILED: return F("Verify Bin Header Failed");
+    case HTTP_UE_BIN_FOR_WRONG_FLASH: return F("New Binary Does Not Fit Flash Size");
+    case HTTP_UE_SERVER_UNAUTHORIZED: return F("Unauthorized (401)");
+    default: return String();
+  }
+}
+
+// Through the Updater, as in the core: returns an Updater error or 0
+int ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5) {
+  if (!Update.begin(size, U_FLASH, _ledPin, _ledOn)) return Update.getError();
+  Update.onProgress(_cbProgress);
+  if (md5.length() && !Update.setMD5(md5.c_str())) {
+    Update.end();
+    return HTTP_UE_SERVER_FAULTY_MD5;
+  }
+  if (Update.writeStream(in) != size || !Update.end()) {
+    int err = Update.getError();
+    Update.end();   // drops a run that stopped short
+    return err ? err : UPDATE_ERROR_STREAM;
+  }
+  return 0;
+}
+
+t_httpUpdate_return ESP8266HTTPUpdate::update(WiFiClient& client, const String& url, const String& currentVersion) {
+  HTTPClient http;
+  if (!http.begin(client, url)) {
+    setLastError(HTTPC_ERROR_CONNECTION_FAILED);
+    return HTTP_UPDATE_FAILED;
+  }
+  http.useHTTP10(true);
+  http.setTimeout(8000);
+  http.setFollowRedirects(_follow);
+  http.setUserAgent(F("ESP8266-http-Update"));
+  http.addHeader(F("x-ESP8266-free-space"), String(ESP.getFreeSketchSpace()));
+  http.addHeader(F("x-ESP8266-sketch-size"), String(ESP.getSketchSize()));
+  http.addHeader(F("x-ESP8266-mode"), F("sketch"));
+  if (currentVersion.length()) http.addHeader(F("x-ESP8266-version"), currentVersion);
+  const char* headers[] = { "x-MD5" };
+  http.collectHeaders(headers, 1);
+
+  int code = http.GET();
+  int len = http.getSize();
+  if (code <= 0) {
+    setLastError(code);
+    http.end();
+    return HTTP_UPDATE_FAILED;
+  }
+
+  t_httpUpdate_return ret = HTTP_UPDATE_FAILED;
+  switch (code) {
+    case HTTP_CODE_OK:
+      if (len <= 0) {
+        setLastError(HTTP_UE_SERVER_NOT_REPORT_SIZE);
+      } else if (len > (int)ESP.getFreeSketchSpace()) {
+        setLastError(HTTP_UE_TOO_LESS_SPACE);
+      } else {
+        if (_cbStart) _cbStart();
+        WiFiClient& tcp = http.getStream();
+        uint8_t magic[4];
+        if (tcp.peekBytes(magic, 4) != 4 || (magic[0] != 0xE9 && magic[0] != 0x1f)) {
+          setLastError(HTTP_UE_BIN_VERIFY_HEADER_FAILED);
+          break;
+        }
+        int err = runUpdate(tcp, len, http.header("x-MD5"));
+        if (err) {
+          setLastError(err);
+          break;
+        }
+        ret = HTTP_UPDATE_OK;
+        http.end();
+        if (_cbEnd) _cbEnd();
+        if (_rebootOnUpdate) ESP.restart();
+      }
+      break;
+    case HTTP_CODE_NOT_MODIFIED:
+      ret = HTTP_UPDATE_NO_UPDATES;
+      break;
+    case HTTP_CODE_NOT_FOUND:
+      setLastError(HTTP_UE_SERVER_FILE_NOT_FOUND);
+      break;
+    case HTTP_CODE_FORBIDDEN:
+      setLastError(HTTP_UE_SERVER_FORBIDDEN);
+      break;
+    default:
+      setLastError(HTTP_UE_SERVER_WRONG_HTTP_CODE);
+      break;
+  }
+  http.end();
+  return ret;
+}
+
+// --- ESP8266WebServer ---
+
+static const char* statusText(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 500: return "Internal Server Error";
+    default: return "";
+  }
+}
+
+static std::string urlDecode(const std::string& s) {
+  std::string out;
+  for (size_t i = 0; i < s.size(); i++) {
+    if (s[i] == '+') {
+      out += ' ';
+    } else if (s[i] == '%' && i + 2 < s.size() && isxdigit((unsigned char)s[i + 1]) &&
+               isxdigit((unsigned char)s[i + 2])) {
+      out += (char)strtol(s.substr(i + 1, 2).c_str(), nullptr, 16);
+      i += 2;
+    } else {
+      out += s[i];
+    }
+  }
+  return out;
+}
+
+static const String& emptyValue() {
+  static const String empty;
+  return empty;
+}
+
+void ESP8266WebServer::on(const String& uri, HTTPMethod method, THandlerFunction fn) {
+  _routes.push_back({ uri, method, fn });
+}
+
+void ESP8266WebServer::begin() {
+  if (_listen >= 0) return;
+  int port = _port;
+  if (port == 80) {
+    const char* env = getenv("NATIVE_HTTP_PORT");
+    port = env ? atoi(env) : 8088;
+  }
+  _listen = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  int one = 1;
+  setsockopt(_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  if (bind(_listen, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 || listen(_listen, 4) != 0) {
+    fprintf(stderr, "native: web server cannot listen on %d\n", port);
+    ::close(_listen);
+    _listen = -1;
+  }
+}
+
+void ESP8266WebServer::stop() {
+  if (_listen >= 0) ::close(_listen);
+  _listen = -1;
+}
+
+void ESP8266WebServer::parseArgs(const std::string& encoded) {
+  size_t at = 0;
+  while (at < encoded.size()) {
+    size_t end = encoded.find('&', at);
+    if (end == std::string::npos) end = encoded.size();
+    std::string pair = encoded.substr(at, end - at);
+    size_t eq = pair.find('=');
+    if (!pair.empty()) {
+      _args.push_back({ urlDecode(pair.substr(0, eq)), eq == std::string::npos ? "" : urlDecode(pair.substr(eq + 1)) });
+    }
+    at = end + 1;
+  }
+}
+
+void ESP8266WebServer::handleClient() {
+  if (_listen < 0) return;
+  int fd = accept4(_listen, nullptr, nullptr, SOCK_CLOEXEC);
+  if (fd < 0) return;
+  std::string request;
+  char buf[1024];
+  struct pollfd p = { fd, POLLIN, 0 };
+  size_t headEnd;
+  while ((headEnd = request.find("\r\n\r\n")) == std::string::npos && poll(&p, 1, 1000) == 1) {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0) break;
+    request.append(buf, n);
+  }
+  _currentClient = WiFiClient(fd);
+  size_t sp1 = request.find(' ');
+  size_t sp2 = sp1 == std::string::npos ? sp1 : request.find(' ', sp1 + 1);
+  if (headEnd == std::string::npos || sp2 == std::string::npos) {
+    _currentClient.stop();
+    return;
+  }
+
+  std::string method = request.substr(0, sp1);
+  std::string path = request.substr(sp1 + 1, sp2 - sp1 - 1);
+  size_t query = path.find('?');
+  _uri = urlDecode(path.substr(0, query));
+  _method = method == "GET"    ? HTTP_GET
+            : method == "HEAD" ? HTTP_HEAD
+            : method == "POST" ? HTTP_POST
+            : method == "PUT"  ? HTTP_PUT
+                               : HTTP_ANY;
+  _args.clear();
+  if (query != std::string::npos) parseArgs(path.substr(query + 1));
+
+  for (Pair& h : _headers) h.value = String();
+  _hostHeader = String();
+  String authorization;
+  size_t contentLength = 0;
+  bool form = false;
+  for (size_t at = request.find("\r\n") + 2; at < headEnd;) {
+    size_t end = request.find("\r\n", at);
+    std::string line = request.substr(at, end - at);
+    at = end + 2;
+    size_t colon = line.find(':');
+    if (colon == std::string::npos) continue;
+    String name = line.substr(0, colon);
+    String value = line.substr(line.find_first_not_of(' ', colon + 1) == std::string::npos
+                                   ? line.size()
+                                   : line.find_first_not_of(' ', colon + 1));
+    if (name.equalsIgnoreCase("Host")) _hostHeader = value;
+    if (name.equalsIgnoreCase("Authorization")) authorization = value;
+    if (name.equalsIgnoreCase("Content-Length")) contentLength = value.toInt();
+    if (name.equalsIgnoreCase("Content-Type")) form = value.startsWith("application/x-www-form-urlencoded");
+    for (Pair& h : _headers) {
+      if (h.name.equalsIgnoreCase(name)) h.value = value;
+    }
+  }
+  if (authorization.length()) _headers.push_back({ "Authorization", authorization });
+
+  std::string body = request.substr(headEnd + 4);
+  while (body.size() < contentLength && poll(&p, 1, 1000) == 1) {
+    ssize_t n = recv(fd, buf, std::min(sizeof(buf), contentLength - body.size()), 0);
+    if (n <= 0) break;
+    body.append(buf, n);
+  }
+  if (_method == HTTP_POST) {
+    if (form) {
+      parseArgs(body);
+    } else if (!body.empty()) {
+      _args.push_back({ "plain", body });
+    }
+  }
+
+  _sent = false;
+  _chunked = false;
+  _contentLength = CONTENT_LENGTH_NOT_SET;
+  _responseHeaders = String();
+  bool handled = false;
+  for (Route& r : _routes) {
+    if (r.uri == _uri && (r.method == HTTP_ANY || r.method == _method)) {
+      r.fn();
+      handled = true;
+      break;
+    }
+  }
+  if (!handled && _notFound) {
+    _notFound();
+  } else if (!handled) {
+    send(404, "text/plain", "Not found: " + _uri);
+  }
+  if (authorization.length()) _headers.pop_back();
+  _currentClient.stop();
+}
+
+const String& ESP8266WebServer::arg(const String& name) const {
+  for (const Pair& a : _args) {
+    if (a.name == name) return a.value;
+  }
+  return emptyValue();
+}
+
+const String& ESP8266WebServer::arg(int i) const {
+  return i >= 0 && i < (int)_args.size() ? _args[i].value : emptyValue();
+}
+
+const String& ESP8266WebServer::argName(int i) const {
+  return i >= 0 && i < (int)_args.size() ? _args[i].name : emptyValue();
+}
+
+bool ESP8266WebServer::hasArg(const String& name) const {
+  for (const Pair& a : _args) {
+    if (a.name == name) return true;
+  }
+  return false;
+}
+
+void ESP8266WebServer::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+  _headers.clear();
+  for (size_t i = 0; i < headerKeysCount; i++) _headers.push_back({ headerKeys[i], String() });
+}
+
+const String& ESP8266WebServer::header(const String& name) const {
+  for (const Pair& h : _headers) {
+    if (h.name.equalsIgnoreCase(name)) return h.value;
+  }
+  return emptyValue();
+}
+
+bool ESP8266WebServer::hasHeader(const String& name) const {
+  return header(name).length() > 0;
+}
+
+bool ESP8266WebServer::authenticate(const char* username, const char* password) {
+  String auth = header("Authorization");
+  if (!auth.startsWith("Basic ")) return false;
+  std::string plain = std::string(username) + ":" + password;
+  std::string encoded(4 * ((plain.size() + 2) / 3) + 1, '\0');
+  int n = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(&encoded[0]),
+                          reinterpret_cast<const unsigned char*>(plain.data()), plain.size());
+  encoded.resize(n);
+  return auth.substring(6) == String(encoded);
+}
+
+void ESP8266WebServer::requestAuthentication(HTTPAuthMethod, const char* realm, const String& authFailMsg) {
+  sendHeader("WWW-Authenticate", String("Basic realm=\"") + (realm ? realm : "Login Required") + "\"");
+  send(401, "text/html", authFailMsg);
+}
+
+void ESP8266WebServer::sendHeader(const String& name, const String& value, bool first) {
+  String line = name + ": " + value + "\r\n";
+  _responseHeaders = first ? line + _responseHeaders : _responseHeaders + line;
+}
+
+void ESP8266WebServer::write(const char* data, size_t n) {
+  if (n) _currentClient.write(reinterpret_cast<const uint8_t*>(data), n);
+}
+
+void ESP8266WebServer::sendHead(int code, const char* contentType, size_t contentLength) {
+  sendHeader("Content-Type", contentType ? contentType : "text/html", true);
+  if (_contentLength == CONTENT_LENGTH_NOT_SET) {
+    sendHeader("Content-Length", String((unsigned long)contentLength));
+  } else if (_contentLength != CONTENT_LENGTH_UNKNOWN) {
+    sendHeader("Content-Length", String((unsigned long)_contentLength));
+  } else {
+    _chunked = true;
+    sendHeader("Accept-Ranges", "none");
+    sendHeader("Transfer-Encoding", "chunked");
+  }
+  sendHeader("Connection", "close");
+  char status[64];
+  snprintf(status, sizeof(status), "HTTP/1.1 %d %s\r\n", code, statusText(code));
+  String head = String(status) + _responseHeaders + "\r\n";
+  _responseHeaders = String();
+  write(head.c_str(), head.length());
+  _sent = true;
+}
+
+void ESP8266WebServer::send(int code, const char* contentType, const String& content) {
+  sendHead(code, contentType, content.length());
+  if (content.length()) sendContent(content);
+}
+
+void ESP8266WebServer::send_P(int code, PGM_P contentType, PGM_P content, size_t contentLength) {
+  sendHead(code, contentType, contentLength);
+  if (contentLength) sendContent(content, contentLength);
+}
+
+void ESP8266WebServer::sendContent(const char* content, size_t size) {
+  if (_chunked) {
+    char len[16];
+    int n = snprintf(len, sizeof(len), "%zx\r\n", size);
+    write(len, n);
+  }
+  write(content, size);
+  if (_chunked) {
+    write("\r\n", 2);
+    if (!size) _chunked = false;
+  }
+}
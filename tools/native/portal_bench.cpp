@@ -0,0 +1,387 @@
+// The config portal of lib/WiFiManager on the core stand-in of tools/native,
+// set up as main.cpp does (async scan) with ten networks in range, served
+// by startWebPortal() and driven over loopback: one request, one
+// process() call that accepts and answers it.
+//
+//   make -C tools/native portal_bench portal_bench_stock
+//   tools/native/portal_bench [-n repeats] [--against tools/native/portal_bench_stock]
+//
+// portal_bench_stock is this bench built on the WiFiManager of the baseline
+// commit: style and script inline in every page, each page assembled in
+// one String before it is sent.
+//
+// Per page: the bytes on the wire (status line, headers, body framing), the
+// median handler time of `repeats` requests and the peak heap, the most
+// bytes live through operator new during a request above what was live
+// before it. Per static asset linked by /: a first GET and a revalidation
+// with its ETag in If-None-Match.
+//
+// --against runs the other build first and prints both side by side, with
+// the bytes of a first visit (the page and the assets it links) and of a
+// repeat visit (the page, its assets cached as immutable).
+//
+// Host allocator and host String, host times: the ratios are what carries
+// over. Exit code 1 if a page answers an unexpected status, an asset lacks
+// its ETag or immutable caching, a revalidation is not an empty 304, or
+// with --against a page peaks higher or a repeat visit costs more bytes
+// than in the other build.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiManager.h>
+
+// --- heap: live bytes and their peak, through the global operator new ---
+
+static size_t heapLive = 0;
+static size_t heapPeak = 0;
+
+static const size_t HEADER = alignof(std::max_align_t);
+
+void* operator new(size_t n) {
+  void* p = malloc(n + HEADER);
+  if (!p) throw std::bad_alloc();
+  *static_cast<size_t*>(p) = n;
+  heapLive += n;
+  heapPeak = std::max(heapPeak, heapLive);
+  return static_cast<char*>(p) + HEADER;
+}
+
+void operator delete(void* p) noexcept {
+  if (!p) return;
+  char* block = static_cast<char*>(p) - HEADER;
+  heapLive -= *reinterpret_cast<size_t*>(block);
+  free(block);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  operator delete(p);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+  printf("  %-52s %s\n", what.c_str(), ok ? "ok" : "FAIL");
+  if (!ok) failures++;
+}
+
+struct Reply {
+  int status = 0;
+  std::string head;    // status line and headers
+  std::string body;    // chunked framing removed
+  size_t bytes = 0;    // as received
+  double us = 0;       // median process() call
+  size_t peak = 0;     // bytes above the live heap before the request
+};
+
+int port() {
+  const char* env = getenv("NATIVE_HTTP_PORT");   // as ESP8266WebServer on port 80
+  return env ? atoi(env) : 8088;
+}
+
+std::string header(const std::string& head, const std::string& name) {
+  std::string lower = head;
+  std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+  std::string key = "\r\n" + name + ":";
+  std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+  size_t at = lower.find(key);
+  if (at == std::string::npos) return std::string();
+  at = head.find_first_not_of(' ', at + key.size());
+  return head.substr(at, head.find("\r\n", at) - at);
+}
+
+std::string unchunk(const std::string& body) {
+  std::string out;
+  size_t at = 0;
+  while (at < body.size()) {
+    size_t len = strtoul(body.c_str() + at, nullptr, 16);
+    at = body.find("\r\n", at) + 2;
+    if (!len) break;
+    out.append(body, at, len);
+    at += len + 2;
+  }
+  return out;
+}
+
+Reply once(WiFiManager& wm, const std::string& path, const std::string& extra) {
+  Reply r;
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port());
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+    close(fd);
+    return r;
+  }
+  std::string req = "GET " + path + " HTTP/1.1\r\nHost: 192.168.4.1\r\n" + extra + "\r\n";
+  send(fd, req.data(), req.size(), 0);
+
+  size_t before = heapLive;
+  heapPeak = heapLive;
+  auto t = Clock::now();
+  wm.process();
+  r.us = std::chrono::duration<double, std::micro>(Clock::now() - t).count();
+  r.peak = heapPeak - before;
+
+  std::string raw;
+  char buf[4096];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) raw.append(buf, n);
+  close(fd);
+  r.bytes = raw.size();
+  size_t end = raw.find("\r\n\r\n");
+  if (end == std::string::npos) return r;
+  r.head = raw.substr(0, end + 2);
+  r.body = raw.substr(end + 4);
+  if (header(r.head, "Transfer-Encoding") == "chunked") r.body = unchunk(r.body);
+  sscanf(r.head.c_str(), "HTTP/1.%*d %d", &r.status);
+  return r;
+}
+
+// The last reply, with the median time and the highest peak
+Reply request(WiFiManager& wm, const std::string& path, int repeats, const std::string& extra = std::string()) {
+  std::vector<double> us;
+  Reply r;
+  size_t peak = 0;
+  for (int i = 0; i < repeats; i++) {
+    r = once(wm, path, extra);
+    us.push_back(r.us);
+    peak = std::max(peak, r.peak);
+  }
+  std::sort(us.begin(), us.end());
+  r.us = us[us.size() / 2];
+  r.peak = peak;
+  return r;
+}
+
+// The asset URLs a page links, in order
+std::vector<std::string> assetsOf(const std::string& page) {
+  std::vector<std::string> urls;
+  for (const char* prefix : { "/wm.css?", "/wm.js?" }) {
+    size_t at = page.find(prefix);
+    if (at != std::string::npos) urls.push_back(page.substr(at, page.find_first_of("\"' >", at) - at));
+  }
+  return urls;
+}
+
+struct Row {
+  std::string kind;   // page, asset, 304
+  std::string path;
+  int status;
+  size_t bytes;
+  double us;
+  size_t peak;
+};
+
+struct Page {
+  const char* path;
+  int status;
+};
+
+// Every page but those that end the portal (exit, close, restart, erase,
+// wifisave); /wifiscan.json feeds the async /wifi of main.cpp
+const Page PAGES[] = {
+  { "/", 200 },      { "/wifi", 200 },   { "/0wifi", 200 },  { "/wifiscan.json", 200 },
+  { "/param", 200 }, { "/info", 200 },   { "/update", 200 }, { "/nope", 404 },
+};
+
+std::vector<Row> run(int repeats) {
+  WiFi.nativeAps.clear();
+  for (int i = 0; i < 10; i++) {
+    NativeAp ap = { "bench-net-" + String(i), -40 - 5 * i, (uint8_t)(i % 3 ? ENC_TYPE_CCMP : ENC_TYPE_NONE),
+                    1 + i % 11, { 0x02, 0x00, 0x00, 0x00, 0x00, (uint8_t)i }, false };
+    WiFi.nativeAps.push_back(ap);
+  }
+  WiFiManager wm;
+  wm.setDebugOutput(false);
+  wm._asyncScan = true;
+  wm.startWebPortal();
+
+  std::vector<Row> rows;
+  std::string root;
+  for (const Page& p : PAGES) {
+    Reply r = request(wm, p.path, repeats);
+    rows.push_back({ "page", p.path, r.status, r.bytes, r.us, r.peak });
+    if (!strcmp(p.path, "/")) root = r.body;
+  }
+  for (const std::string& url : assetsOf(root)) {
+    Reply r = request(wm, url, repeats);
+    rows.push_back({ "asset", url, r.status, r.bytes, r.us, r.peak });
+    bool cached = header(r.head, "Cache-Control").find("immutable") != std::string::npos;
+    std::string etag = header(r.head, "ETag");
+    if (r.status != 200 || !cached || etag.empty() || header(r.head, "Content-Encoding") != "gzip") {
+      rows.back().status = -r.status;   // reported by check()
+    }
+    Reply again = request(wm, url, repeats, "If-None-Match: " + etag + "\r\n");
+    int status = again.status == 304 && again.body.empty() ? 304 : -again.status;
+    rows.push_back({ "304", url, status, again.bytes, again.us, again.peak });
+  }
+  wm.stopWebPortal();
+  return rows;
+}
+
+void table(const std::vector<Row>& rows) {
+  printf("  %-44s %6s %8s %10s %10s\n", "request", "status", "bytes", "handler us", "peak heap");
+  for (const Row& r : rows) {
+    std::string name = r.kind == "304" ? r.path + " (If-None-Match)" : r.path;
+    printf("  %-44s %6d %8zu %10.1f %10zu\n", name.c_str(), abs(r.status), r.bytes, r.us, r.peak);
+  }
+}
+
+void checks(const std::vector<Row>& rows) {
+  bool assets = false;
+  for (const Row& r : rows) {
+    if (r.kind == "page") {
+      int want = 0;
+      for (const Page& p : PAGES) {
+        if (r.path == p.path) want = p.status;
+      }
+      check(r.status == want, r.path + " answers " + std::to_string(want));
+    } else if (r.kind == "asset") {
+      assets = true;
+      check(r.status == 200, r.path.substr(0, r.path.find('?')) + ": gzip, ETag, immutable");
+    } else {
+      check(r.status == 304, r.path.substr(0, r.path.find('?')) + ": revalidation is an empty 304");
+    }
+  }
+  if (!assets) printf("  (no linked assets: style and script inline in every page)\n");
+}
+
+struct Visit {
+  size_t first = 0;
+  size_t repeat = 0;
+};
+
+// A page load: the page and every asset, the assets only the first time
+std::map<std::string, Visit> visits(const std::vector<Row>& rows) {
+  size_t assets = 0;
+  for (const Row& r : rows) {
+    if (r.kind == "asset") assets += r.bytes;
+  }
+  std::map<std::string, Visit> v;
+  for (const Row& r : rows) {
+    if (r.kind == "page" && r.status == 200 && r.path.find('.') == std::string::npos) {
+      v[r.path] = { r.bytes + assets, r.bytes };
+    }
+  }
+  return v;
+}
+
+std::vector<Row> readRows(const char* bench, int repeats) {
+  std::string cmd = std::string(bench) + " --tsv -n " + std::to_string(repeats);
+  FILE* in = popen(cmd.c_str(), "r");
+  std::vector<Row> rows;
+  if (!in) return rows;
+  char line[512];
+  while (fgets(line, sizeof(line), in)) {
+    char kind[16], path[256];
+    Row r;
+    if (sscanf(line, "tsv\t%15s\t%255s\t%d\t%zu\t%lf\t%zu", kind, path, &r.status, &r.bytes, &r.us, &r.peak) == 6) {
+      r.kind = kind;
+      r.path = path;
+      rows.push_back(r);
+    }
+  }
+  if (pclose(in) != 0) fprintf(stderr, "portal_bench: %s failed\n", bench);
+  return rows;
+}
+
+void compare(const std::vector<Row>& other, const std::vector<Row>& rows) {
+  printf("\nagainst the other build (bytes, handler us, peak heap):\n");
+  printf("  %-16s %18s %18s %18s\n", "page", "bytes", "handler us", "peak heap");
+  for (const Row& r : rows) {
+    if (r.kind != "page") continue;
+    auto o = std::find_if(other.begin(), other.end(), [&](const Row& x) { return x.kind == "page" && x.path == r.path; });
+    if (o == other.end() || o->status != r.status) {
+      printf("  %-16s %18s\n", r.path.c_str(), "(new)");
+      continue;
+    }
+    printf("  %-16s %8zu -> %6zu %8.1f -> %6.1f %8zu -> %6zu\n", r.path.c_str(), o->bytes, r.bytes, o->us, r.us,
+           o->peak, r.peak);
+    if (r.status == 200) check(r.peak <= o->peak, r.path + ": peak heap no higher");
+  }
+
+  std::map<std::string, Visit> was = visits(other), now = visits(rows);
+  printf("\npage loads (bytes):\n");
+  printf("  %-16s %18s %18s\n", "page", "first visit", "repeat visit");
+  for (const auto& v : now) {
+    if (!was.count(v.first)) continue;
+    const Visit& o = was[v.first];
+    printf("  %-16s %8zu -> %6zu %8zu -> %6zu\n", v.first.c_str(), o.first, v.second.first, o.repeat,
+           v.second.repeat);
+    check(v.second.repeat <= o.repeat, v.first + ": repeat visit no more bytes");
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int repeats = 20;
+  bool tsv = false;
+  const char* against = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+      repeats = std::max(1, atoi(argv[++i]));
+    } else if (!strcmp(argv[i], "--tsv")) {
+      tsv = true;
+    } else if (!strcmp(argv[i], "--against") && i + 1 < argc) {
+      against = argv[++i];
+    } else {
+      fprintf(stderr, "usage: portal_bench [-n repeats] [--tsv] [--against OTHER_BENCH]\n");
+      return 2;
+    }
+  }
+
+  std::vector<Row> other;
+  if (against) {
+    other = readRows(against, repeats);
+    if (other.empty()) {
+      fprintf(stderr, "portal_bench: no results from %s\n", against);
+      return 1;
+    }
+  }
+
+  std::vector<Row> rows = run(repeats);
+  if (tsv) {
+    for (const Row& r : rows) {
+      printf("tsv\t%s\t%s\t%d\t%zu\t%.1f\t%zu\n", r.kind.c_str(), r.path.c_str(), r.status, r.bytes, r.us, r.peak);
+    }
+    return 0;
+  }
+
+  if (against) {
+    printf("%s:\n", against);
+    table(other);
+    printf("\n");
+  }
+  printf("this build, %d requests each:\n", repeats);
+  table(rows);
+  printf("\nchecks:\n");
+  checks(rows);
+  if (against) compare(other, rows);
+
+  if (failures) {
+    fprintf(stderr, "portal_bench: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("portal_bench: ok\n");
+  return 0;
+}
@@ -0,0 +1,132 @@
+#!/usr/bin/env bash
+# Runs the native firmware build (tools/native) through every scenario in
+# tools/mock_server/scenarios and checks the outcome. From the repository
+# root:
+#
+#   make -C tools/native && tools/native/run_scenarios.sh [SCENARIO ...]
+#
+# Per scenario: src/firmware.bin is released as v1.1.0 (tools/release, with
+# a v1.0.0 that differs in two sectors as --previous-bin, so the delta path
+# runs), mock_server serves it, and ota_native starts on a fresh flash with
+# v1.0.0 for RUN_SECONDS (default 40). Pass: v1.1.0 runs and is confirmed at
+# the end, plus the scenario's own checks below; in flaky the failed
+# download must instead leave v1.0.0 running, in backoff. Logs stay in WORK
+# (default /tmp/ota_native). Exit code 1 if any scenario fails.
+#
+# Built without ArduinoJson (see Makefile) the device reads manifest.cbor
+# only; the scenario rules for /manifest.json are then applied to
+# /manifest.cbor, and the runner says so.
+
+set -u
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+BIN=$ROOT/tools/native
+WORK=${WORK:-/tmp/ota_native}
+RUN_SECONDS=${RUN_SECONDS:-40}
+HOST=127.0.0.1
+
+for tool in ota_native mock_server release; do
+  [ -x "$BIN/$tool" ] || { echo "missing $BIN/$tool, run: make -C tools/native"; exit 2; }
+done
+
+manifest=manifest.json
+if grep -q "not built in (MANIFEST_JSON=0)" "$BIN/ota_native"; then
+  manifest=manifest.cbor
+  echo "NOTE: ota_native is built without ArduinoJson: manifest.json rules run against manifest.cbor"
+fi
+
+failed=0
+
+check() {   # check NAME DESCRIPTION COMMAND...
+  local name=$1 what=$2
+  shift 2
+  if "$@" >/dev/null 2>&1; then
+    echo "  ok    $what"
+  else
+    echo "  FAIL  $what"
+    failed=1
+  fi
+}
+
+run() {   # run NAME SCHEME PORT [MIRROR_PORT ...]
+  local name=$1 scheme=$2 port=$3
+  shift 3
+  local dir=$WORK/$name
+  rm -rf "$dir" && mkdir -p "$dir" && cd "$dir" || exit 2
+
+  cp "$ROOT/src/firmware.bin" new.bin
+  python3 - <<'EOF'
+data = bytearray(open("new.bin", "rb").read())
+for off in (0x20000, 0x40000):          # inside the first app segment
+    for i in range(64):
+        data[off + i] ^= 0x5A
+open("old.bin", "wb").write(data)
+EOF
+
+  local mirrors=() device_mirrors=""
+  for m in "$@"; do
+    mirrors+=(--mirror "$scheme://$HOST:$m/firmware")
+    [ "$m" = 8084 ] || device_mirrors+="${device_mirrors:+ }$scheme://$HOST:$m"
+  done
+  "$BIN/release" --bin new.bin --out public --model esp8266-power --version v1.1.0 \
+    --base-url "$scheme://$HOST:$port/firmware" --previous-bin old.bin "${mirrors[@]}" >release.log 2>&1 ||
+    { echo "$name: release failed, see $dir/release.log"; failed=1; return; }
+
+  sed "s#/manifest\.json#/$manifest#g" "$ROOT/tools/mock_server/scenarios/$name.txt" >scenario.txt
+  "$BIN/mock_server" scenario.txt >server.log 2>&1 &
+  local server=$!
+  sleep 1
+
+  OTA_MOCK_URL="$scheme://$HOST:$port/$manifest" OTA_MOCK_MIRRORS="$device_mirrors" \
+    "$BIN/ota_native" --flash flash.img --image v1.0.0=old.bin --image v1.1.0=new.bin \
+    --seconds "$RUN_SECONDS" --boots 4 --metrics metrics.txt >device.log 2>&1
+  local status=$?
+  kill -INT $server 2>/dev/null
+  wait $server 2>/dev/null
+
+  echo "$name:"
+  check "$name" "device exit code 0 (got $status)" test $status -eq 0
+  check "$name" "no rollback" bash -c '! grep -q "reverting to" device.log'
+  if [ "$name" != flaky ]; then
+    check "$name" "runs v1.1.0 at the end" grep -q "time is up, running v1.1.0" device.log
+    check "$name" "v1.1.0 confirmed" grep -q "v1.1.0 confirmed" device.log
+  fi
+
+  case $name in
+    baseline)
+      check "$name" "delta update (2 sectors)" grep -q "2 downloaded" device.log
+      check "$name" "304 on later polls" grep -q "HTTP: 304" device.log
+      ;;
+    flaky)
+      check "$name" "429 seen" grep -q "HTTP: 429" device.log
+      check "$name" "short hash list: full download" grep -q "Incremental update failed" device.log
+      check "$name" "reset mid-download fails the update" grep -q "FAILED: .*Stream Read Timeout" device.log
+      check "$name" "then backoff" grep -q "v1.1.0 failed recently, retry in" device.log
+      check "$name" "still runs v1.0.0" grep -q "time is up, running v1.0.0" device.log
+      ;;
+    keepalive)
+      check "$name" "polls on the kept-alive connection" grep -q "(kept-alive)" device.log
+      check "$name" "reused connections counted" grep -Eq 'ota_manifest_connections_total\{event="reused"\} [1-9]' metrics.txt
+      check "$name" "server close noticed, new connection" grep -q "HTTP: 304$" device.log
+      ;;
+    mirrors)
+      check "$name" "manifest from a mirror port" grep -Eq ":808[23] +/$manifest" server.log
+      ;;
+    redirects)
+      check "$name" "redirects followed" grep -q "Redirects: [1-9]" device.log
+      ;;
+  esac
+  echo "  logs: $dir"
+}
+
+scenarios=("$@")
+[ ${#scenarios[@]} -gt 0 ] || scenarios=(baseline flaky keepalive mirrors redirects)
+for s in "${scenarios[@]}"; do
+  case $s in
+    baseline|flaky|redirects) run "$s" http 8080 ;;
+    keepalive) run "$s" https 8443 ;;
+    mirrors) run "$s" http 8081 8082 8083 8084 ;;
+    *) echo "unknown scenario $s"; failed=1 ;;
+  esac
+done
+exit $failed
@@ -0,0 +1,20 @@
+// The driver hooks of native.cpp for the benches that link the core
+// stand-in without the firmware: no flash image, no reboots.
+
+#include <cstdlib>
+
+#include "native.h"
+
+uint8_t nativeFlash[NATIVE_FLASH_SIZE];
+uint8_t nativeRtc[NATIVE_RTC_SIZE];
+uint32_t nativeResetReason = 0;
+
+void nativeTick() {}
+
+void nativeRestart(uint32_t) {
+  exit(1);
+}
+
+uint32_t nativeImageSize(uint32_t) {
+  return 0;
+}
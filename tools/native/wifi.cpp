@@ -0,0 +1,227 @@
+// Radio part of the core stand-in for tools/native: modes, the station
+// config, the soft AP and scans of ESP8266WiFiClass, and the SDK calls of
+// user_interface.h that lib/WiFiManager makes on them.
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <user_interface.h>
+
+ESP8266WiFiClass WiFi;
+
+static String field(const uint8_t* s, size_t cap) {
+  return std::string(reinterpret_cast<const char*>(s), strnlen(reinterpret_cast<const char*>(s), cap));
+}
+
+static void setField(uint8_t* dst, size_t cap, const char* s) {
+  memset(dst, 0, cap);
+  if (s) memcpy(dst, s, strnlen(s, cap));
+}
+
+bool ESP8266WiFiClass::mode(WiFiMode_t m) {
+  if ((_mode & WIFI_AP) && !(m & WIFI_AP)) memset(&_ap, 0, sizeof(_ap));
+  _mode = m;
+  if (!(m & WIFI_STA)) _connected = false;
+  return true;
+}
+
+wl_status_t ESP8266WiFiClass::begin(const char* ssid, const char* passphrase, int32_t, const uint8_t*, bool connect) {
+  if (!ssid || !*ssid || strlen(ssid) > 32 || (passphrase && strlen(passphrase) > 64)) return WL_CONNECT_FAILED;
+  setField(_sta.ssid, sizeof(_sta.ssid), ssid);
+  setField(_sta.password, sizeof(_sta.password), passphrase);
+  if (_persistent) _staStored = _sta;
+  return connect ? begin() : status();
+}
+
+wl_status_t ESP8266WiFiClass::begin() {
+  if (!(_mode & WIFI_STA)) mode((WiFiMode_t)(_mode | WIFI_STA));
+  _connected = true;
+  return status();
+}
+
+bool ESP8266WiFiClass::config(IPAddress local, IPAddress, IPAddress, IPAddress, IPAddress) {
+  _staIp = local;
+  return true;
+}
+
+bool ESP8266WiFiClass::disconnect(bool wifioff) {
+  _connected = false;
+  memset(&_sta, 0, sizeof(_sta));
+  if (_persistent) _staStored = _sta;
+  if (wifioff) mode((WiFiMode_t)(_mode & ~WIFI_STA));
+  return true;
+}
+
+int8_t ESP8266WiFiClass::waitForConnectResult(unsigned long) {
+  if (!(_mode & WIFI_STA)) return WL_DISCONNECTED;
+  return status();
+}
+
+IPAddress ESP8266WiFiClass::localIP() {
+  if (!_connected) return IPAddress();
+  return _staIp.isSet() ? _staIp : IPAddress(127, 0, 0, 1);
+}
+
+IPAddress ESP8266WiFiClass::subnetMask() {
+  return _connected ? IPAddress(255, 0, 0, 0) : IPAddress();
+}
+
+IPAddress ESP8266WiFiClass::gatewayIP() {
+  return _connected ? IPAddress(127, 0, 0, 1) : IPAddress();
+}
+
+IPAddress ESP8266WiFiClass::dnsIP(uint8_t) {
+  return _connected ? IPAddress(127, 0, 0, 53) : IPAddress();
+}
+
+String ESP8266WiFiClass::SSID() const {
+  return field(_sta.ssid, sizeof(_sta.ssid));
+}
+
+String ESP8266WiFiClass::psk() const {
+  return field(_sta.password, sizeof(_sta.password));
+}
+
+bool ESP8266WiFiClass::softAP(const String& ssid, const String& passphrase, int channel, int ssidHidden,
+                              int maxConnection) {
+  if (!ssid.length() || ssid.length() > 32) return false;
+  if (passphrase.length() && (passphrase.length() < 8 || passphrase.length() > 64)) return false;
+  mode((WiFiMode_t)(_mode | WIFI_AP));
+  setField(_ap.ssid, sizeof(_ap.ssid), ssid.c_str());
+  setField(_ap.password, sizeof(_ap.password), passphrase.c_str());
+  _ap.ssid_len = ssid.length();
+  _ap.channel = channel;
+  _ap.authmode = passphrase.length() ? 3 : 0;   // AUTH_WPA2_PSK : AUTH_OPEN
+  _ap.ssid_hidden = ssidHidden;
+  _ap.max_connection = maxConnection;
+  _ap.beacon_interval = 100;
+  return true;
+}
+
+bool ESP8266WiFiClass::softAPConfig(IPAddress local, IPAddress, IPAddress) {
+  _apIp = local;
+  return true;
+}
+
+bool ESP8266WiFiClass::softAPdisconnect(bool wifioff) {
+  memset(&_ap, 0, sizeof(_ap));
+  if (wifioff) mode((WiFiMode_t)(_mode & ~WIFI_AP));
+  return true;
+}
+
+String ESP8266WiFiClass::softAPSSID() const {
+  return field(_ap.ssid, sizeof(_ap.ssid));
+}
+
+int8_t ESP8266WiFiClass::finishScan() {
+  _scan.clear();
+  for (const NativeAp& ap : nativeAps) {
+    if (_scanHidden || !ap.hidden) _scan.push_back(ap);
+  }
+  _scanState = _scan.size();
+  return _scanState;
+}
+
+int8_t ESP8266WiFiClass::scanNetworks(bool async, bool showHidden, uint8_t, uint8_t*) {
+  if (!(_mode & WIFI_STA)) mode((WiFiMode_t)(_mode | WIFI_STA));
+  _scanHidden = showHidden;
+  if (async) {
+    _scanState = WIFI_SCAN_RUNNING;
+    return WIFI_SCAN_RUNNING;
+  }
+  return finishScan();
+}
+
+void ESP8266WiFiClass::scanNetworksAsync(std::function<void(int)> onComplete, bool showHidden) {
+  _scanDone = onComplete;
+  scanNetworks(true, showHidden);
+}
+
+int8_t ESP8266WiFiClass::scanComplete() {
+  if (_scanState == WIFI_SCAN_RUNNING) {
+    finishScan();
+    if (_scanDone) {
+      std::function<void(int)> done = _scanDone;
+      _scanDone = nullptr;
+      done(_scanState);
+    }
+  }
+  return _scanState;
+}
+
+String ESP8266WiFiClass::BSSIDstr(uint8_t i) {
+  if (i >= _scan.size()) return String();
+  const uint8_t* b = _scan[i].bssid;
+  char s[18];
+  snprintf(s, sizeof(s), "%02X:%02X:%02X:%02X:%02X:%02X", b[0], b[1], b[2], b[3], b[4], b[5]);
+  return s;
+}
+
+// The SDK's config sectors hold no more than the stored station config here
+bool EspClass::eraseConfig() {
+  memset(&WiFi._staStored, 0, sizeof(WiFi._staStored));
+  return true;
+}
+
+// --- SDK ---
+
+uint8 wifi_get_opmode() {
+  return WiFi.getMode();
+}
+
+bool wifi_set_opmode(uint8 mode) {
+  return WiFi.mode((WiFiMode_t)mode);
+}
+
+bool wifi_set_opmode_current(uint8 mode) {
+  return WiFi.mode((WiFiMode_t)mode);
+}
+
+bool wifi_station_get_config(struct station_config* config) {
+  *config = WiFi._sta;
+  return true;
+}
+
+bool wifi_station_get_config_default(struct station_config* config) {
+  *config = WiFi._staStored;
+  return true;
+}
+
+bool wifi_station_disconnect() {
+  WiFi._connected = false;   // the config stays, unlike WiFi.disconnect()
+  return true;
+}
+
+uint8 wifi_station_get_connect_status() {
+  return WiFi.isConnected() ? STATION_GOT_IP : STATION_IDLE;
+}
+
+bool wifi_softap_get_config(struct softap_config* config) {
+  *config = WiFi._ap;
+  return true;
+}
+
+uint8 wifi_softap_get_station_num() {
+  return WiFi.softAPgetStationNum();
+}
+
+static wifi_country_t country = { "CN", 1, 13, WIFI_COUNTRY_POLICY_AUTO };
+
+bool wifi_get_country(wifi_country_t* c) {
+  *c = country;
+  return true;
+}
+
+bool wifi_set_country(wifi_country_t* c) {
+  country = *c;
+  return true;
+}
+
+const char* system_get_sdk_version() {
+  return "2.2.2-dev(38a443e)";
+}
+
+uint8_t system_get_boot_version() {
+  return 31;
+}
+
+void system_print_meminfo() {}
@@ -0,0 +1,844 @@
+// Release tool: turns firmware.bin into everything build-publish-pages.yml
+// publishes, reading the image once.
+//
+// One pass over the image feeds independent lanes, each on its own thread:
+// MD5 (raw and with the flash mode byte cleared, see include/ota_delta.h),
+// SHA-256, gzip (plus SHA-256 of the .gz) and an output lane that writes
+// the .bin copy, the sector hash list and the sector patch. The per-sector
+// hashes and the comparison with the previous release run on a worker pool.
+// Afterwards the digests are signed (if a key is given) and the manifest is
+// validated against what the device accepts before it is written.
+//
+//   g++ -std=c++17 -O2 -pthread -Iinclude tools/release/release.cpp -lcrypto -lz -o release
+//   ./release --bin firmware.bin --out public --model esp8266-power --version VER
+//             --base-url https://host/firmware [--previous-bin old.bin] [--sign-key key.pem] ...
+//   ./release [--gzip-level N] --bench [MiB ...]   synthetic images, single pass vs
+//                                                  one pass per artifact
+//
+// Artifacts in --out (stem = <model>-<version>):
+//   firmware/<stem>.bin, .bin.gz, .sectors (hash list for ota_delta)
+//   firmware/<stem>.patch              changed sectors vs --previous-bin
+//   firmware/<stem>.bin.sig, .bin.gz.sig   RSA/ECDSA over SHA-256, with --sign-key
+//   firmware/<stem>.release.json       digests, sizes, skip report, timings
+//   manifest.json
+//   manifest.cbor                      the fields the device reads (include/manifest.h)
+//
+// Patch format (little endian): "SPT1" | from size u32 | to size u32 |
+// sector size u32 | count u32 | from MD5 [16] | to MD5 [16], then per changed
+// sector: index u32 + FLASH_SECTOR_SIZE bytes (last one padded with 0xFF).
+//
+// Exit code 1 on a validation failure, nothing is written then except the
+// firmware/ artifacts.
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flash_layout.h"
+#include "manifest.h"
+#include "mirrors.h"
+#include "ota_delta.h"
+#include "rollback.h"
+
+namespace {
+
+const size_t CHUNK = 1 << 20;             // read size, multiple of the sector size
+const size_t SECTORS_PER_JOB = 16;
+const size_t QUEUE_DEPTH = 4;             // chunks in flight per lane
+const uint32_t PATCH_MAGIC = 0x31545053;  // "SPT1"
+const size_t MAX_URL = 255;               // otaUrl / otaSectorsUrl on the device
+static_assert(CHUNK % FLASH_SECTOR_SIZE == 0, "chunks hold whole sectors");
+
+template <typename T>
+class BoundedQueue {
+public:
+  explicit BoundedQueue(size_t cap) : cap_(cap) {}
+
+  void push(T v) {
+    std::unique_lock<std::mutex> l(m_);
+    cv_.wait(l, [&] { return q_.size() < cap_; });
+    q_.push_back(std::move(v));
+    cv_.notify_all();
+  }
+
+  bool pop(T& v) {
+    std::unique_lock<std::mutex> l(m_);
+    cv_.wait(l, [&] { return !q_.empty() || closed_; });
+    if (q_.empty()) return false;
+    v = std::move(q_.front());
+    q_.pop_front();
+    cv_.notify_all();
+    return true;
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> l(m_);
+    closed_ = true;
+    cv_.notify_all();
+  }
+
+private:
+  size_t cap_;
+  bool closed_ = false;
+  std::deque<T> q_;
+  std::mutex m_;
+  std::condition_variable cv_;
+};
+
+struct Chunk {
+  uint64_t offset = 0;
+  std::vector<uint8_t> data;
+  std::vector<uint8_t> hashes;    // DELTA_HASH_LEN per sector
+  std::vector<uint8_t> changed;   // per sector, vs the previous image
+
+  // sector jobs still running
+  unsigned pending = 0;
+  std::mutex m;
+  std::condition_variable cv;
+
+  void jobDone() {
+    std::lock_guard<std::mutex> l(m);
+    if (--pending == 0) cv.notify_all();
+  }
+  void waitJobs() {
+    std::unique_lock<std::mutex> l(m);
+    cv.wait(l, [&] { return pending == 0; });
+  }
+};
+using ChunkPtr = std::shared_ptr<Chunk>;
+
+struct SectorJob {
+  ChunkPtr chunk;
+  size_t first;
+  size_t count;
+};
+
+class Digest {
+public:
+  explicit Digest(const EVP_MD* md) : ctx_(EVP_MD_CTX_new()) { EVP_DigestInit_ex(ctx_, md, nullptr); }
+  ~Digest() { EVP_MD_CTX_free(ctx_); }
+  Digest(const Digest&) = delete;
+  Digest& operator=(const Digest&) = delete;
+
+  void update(const void* p, size_t n) { EVP_DigestUpdate(ctx_, p, n); }
+  std::vector<uint8_t> final() {
+    std::vector<uint8_t> out(EVP_MAX_MD_SIZE);
+    unsigned n = 0;
+    EVP_DigestFinal_ex(ctx_, out.data(), &n);
+    out.resize(n);
+    return out;
+  }
+
+private:
+  EVP_MD_CTX* ctx_;
+};
+
+std::string hex(const std::vector<uint8_t>& v) {
+  static const char* digits = "0123456789abcdef";
+  std::string s;
+  for (uint8_t b : v) {
+    s += digits[b >> 4];
+    s += digits[b & 15];
+  }
+  return s;
+}
+
+bool readFile(const std::string& path, std::vector<uint8_t>& out) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return false;
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+bool writeFile(const std::string& path, const void* data, size_t n) {
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) return false;
+  bool ok = fwrite(data, 1, n, f) == n;
+  return fclose(f) == 0 && ok;
+}
+
+double seconds(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+// --- single pass ------------------------------------------------------------
+
+struct PassInput {
+  std::string bin;
+  std::string stemPath;                 // <out>/firmware/<stem>, without extension
+  const std::vector<uint8_t>* previous = nullptr;
+  unsigned threads = 1;
+  int gzipLevel = 9;
+};
+
+struct PassResult {
+  bool ok = false;
+  std::string error;
+  uint64_t size = 0;
+  uint8_t firstByte = 0;
+  std::vector<uint8_t> md5, md5Normalized, sha256, gzSha256;
+  uint64_t gzSize = 0;
+  uint32_t sectors = 0;
+  uint32_t changed = 0;                 // sectors the device has to download
+  uint32_t requests = 0;                // runs of changed sectors
+  uint64_t patchSize = 0;
+  double seconds = 0;
+};
+
+// Sector hash of the normalized image and whether a device on the previous
+// image has to download it (same rule as loadHashes() in src/ota_delta.cpp)
+void hashSectors(const SectorJob& job, const std::vector<uint8_t>* previous) {
+  Chunk& c = *job.chunk;
+  uint8_t sector[FLASH_SECTOR_SIZE];
+  for (size_t s = job.first; s < job.first + job.count; s++) {
+    size_t off = s * FLASH_SECTOR_SIZE;
+    size_t len = std::min<size_t>(FLASH_SECTOR_SIZE, c.data.size() - off);
+    uint64_t abs = c.offset + off;
+    memcpy(sector, c.data.data() + off, len);
+    if (abs == 0 && len > DELTA_FLASH_MODE_OFFSET) sector[DELTA_FLASH_MODE_OFFSET] = 0;
+
+    uint8_t md[EVP_MAX_MD_SIZE];
+    unsigned n;
+    EVP_Digest(sector, len, md, &n, EVP_md5(), nullptr);
+    memcpy(&c.hashes[s * DELTA_HASH_LEN], md, DELTA_HASH_LEN);
+
+    bool same = false;
+    if (previous && abs + len <= previous->size()) {
+      const uint8_t* old = previous->data() + abs;
+      if (abs == 0 && len > DELTA_FLASH_MODE_OFFSET) {
+        same = memcmp(sector, old, DELTA_FLASH_MODE_OFFSET) == 0 &&
+               memcmp(sector + DELTA_FLASH_MODE_OFFSET + 1, old + DELTA_FLASH_MODE_OFFSET + 1,
+                      len - DELTA_FLASH_MODE_OFFSET - 1) == 0;
+      } else {
+        same = memcmp(sector, old, len) == 0;
+      }
+    }
+    c.changed[s] = !same;
+  }
+  c.jobDone();
+}
+
+class Lane {
+public:
+  explicit Lane(std::function<void(Chunk&)> fn)
+    : queue_(QUEUE_DEPTH), thread_([this, fn] {
+        ChunkPtr c;
+        while (queue_.pop(c)) fn(*c);
+      }) {}
+  void push(const ChunkPtr& c) { queue_.push(c); }
+  void finish() {
+    queue_.close();
+    thread_.join();
+  }
+
+private:
+  BoundedQueue<ChunkPtr> queue_;
+  std::thread thread_;
+};
+
+PassResult runPass(const PassInput& in) {
+  PassResult r;
+  auto start = std::chrono::steady_clock::now();
+
+  FILE* src = fopen(in.bin.c_str(), "rb");
+  if (!src) {
+    r.error = "cannot read " + in.bin;
+    return r;
+  }
+  FILE* binOut = fopen((in.stemPath + ".bin").c_str(), "wb");
+  FILE* gzOut = fopen((in.stemPath + ".bin.gz").c_str(), "wb");
+  FILE* patchOut = in.previous ? fopen((in.stemPath + ".patch").c_str(), "wb") : nullptr;
+  if (!binOut || !gzOut || (in.previous && !patchOut)) {
+    r.error = "cannot write to " + in.stemPath + ".*";
+    for (FILE* f : { src, binOut, gzOut, patchOut }) if (f) fclose(f);
+    return r;
+  }
+
+  Digest md5(EVP_md5()), md5n(EVP_md5()), sha(EVP_sha256()), gzSha(EVP_sha256());
+  std::vector<uint8_t> hashList(DELTA_HEADER_LEN);
+  uint32_t patchCount = 0;
+  bool writeFailed = false;   // main thread; each lane has its own, combined after finish()
+  bool gzWriteFailed = false;
+  bool outWriteFailed = false;
+  bool inRun = false;
+
+  z_stream z = {};
+  deflateInit2(&z, in.gzipLevel, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY);   // +16: gzip wrapper
+  std::vector<uint8_t> zbuf(CHUNK / 2);
+  auto deflateChunk = [&](const uint8_t* p, size_t n, int flush) {
+    z.next_in = const_cast<uint8_t*>(p);
+    z.avail_in = n;
+    do {
+      z.next_out = zbuf.data();
+      z.avail_out = zbuf.size();
+      deflate(&z, flush);
+      size_t out = zbuf.size() - z.avail_out;
+      gzSha.update(zbuf.data(), out);
+      gzWriteFailed |= fwrite(zbuf.data(), 1, out, gzOut) != out;
+      r.gzSize += out;
+    } while (z.avail_out == 0);
+  };
+
+  if (patchOut) {
+    uint8_t placeholder[52] = {};
+    writeFailed |= fwrite(placeholder, 1, sizeof(placeholder), patchOut) != sizeof(placeholder);
+  }
+
+  Lane md5Lane([&](Chunk& c) {
+    md5.update(c.data.data(), c.data.size());
+    if (c.offset == 0 && c.data.size() > DELTA_FLASH_MODE_OFFSET) {
+      uint8_t head[DELTA_FLASH_MODE_OFFSET + 1];
+      memcpy(head, c.data.data(), sizeof(head));
+      head[DELTA_FLASH_MODE_OFFSET] = 0;
+      md5n.update(head, sizeof(head));
+      md5n.update(c.data.data() + sizeof(head), c.data.size() - sizeof(head));
+    } else {
+      md5n.update(c.data.data(), c.data.size());
+    }
+  });
+  Lane shaLane([&](Chunk& c) { sha.update(c.data.data(), c.data.size()); });
+  Lane gzLane([&](Chunk& c) { deflateChunk(c.data.data(), c.data.size(), Z_NO_FLUSH); });
+  Lane outLane([&](Chunk& c) {
+    outWriteFailed |= fwrite(c.data.data(), 1, c.data.size(), binOut) != c.data.size();
+    c.waitJobs();
+    hashList.insert(hashList.end(), c.hashes.begin(), c.hashes.end());
+    for (size_t s = 0; s < c.changed.size(); s++) {
+      bool changed = c.changed[s];
+      r.changed += changed;
+      r.requests += changed && !inRun;
+      inRun = changed;
+      if (!changed || !patchOut) continue;
+      uint8_t sector[FLASH_SECTOR_SIZE];
+      size_t off = s * FLASH_SECTOR_SIZE;
+      size_t len = std::min<size_t>(FLASH_SECTOR_SIZE, c.data.size() - off);
+      memset(sector, 0xFF, sizeof(sector));
+      memcpy(sector, c.data.data() + off, len);
+      uint32_t index = (c.offset + off) / FLASH_SECTOR_SIZE;
+      outWriteFailed |= fwrite(&index, 4, 1, patchOut) != 1 ||
+                        fwrite(sector, 1, sizeof(sector), patchOut) != sizeof(sector);
+      patchCount++;
+    }
+  });
+
+  BoundedQueue<SectorJob> jobs(in.threads * 4);
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < in.threads; i++) {
+    workers.emplace_back([&] {
+      SectorJob job;
+      while (jobs.pop(job)) hashSectors(job, in.previous);
+    });
+  }
+
+  for (;;) {
+    auto c = std::make_shared<Chunk>();
+    c->offset = r.size;
+    c->data.resize(CHUNK);
+    size_t n = fread(c->data.data(), 1, CHUNK, src);
+    if (n == 0) break;
+    c->data.resize(n);
+    if (r.size == 0) r.firstByte = c->data[0];
+    r.size += n;
+
+    size_t sectors = (n + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE;
+    c->hashes.resize(sectors * DELTA_HASH_LEN);
+    c->changed.resize(sectors);
+    c->pending = (sectors + SECTORS_PER_JOB - 1) / SECTORS_PER_JOB;
+    r.sectors += sectors;
+
+    md5Lane.push(c);
+    shaLane.push(c);
+    gzLane.push(c);
+    outLane.push(c);
+    for (size_t s = 0; s < sectors; s += SECTORS_PER_JOB) {
+      jobs.push({ c, s, std::min(SECTORS_PER_JOB, sectors - s) });
+    }
+    if (n < CHUNK) break;
+  }
+  fclose(src);
+
+  jobs.close();
+  for (std::thread& t : workers) t.join();
+  md5Lane.finish();
+  shaLane.finish();
+  gzLane.finish();
+  outLane.finish();
+  deflateChunk(nullptr, 0, Z_FINISH);
+  deflateEnd(&z);
+  writeFailed |= gzWriteFailed || outWriteFailed;
+
+  r.md5 = md5.final();
+  r.md5Normalized = md5n.final();
+  r.sha256 = sha.final();
+  r.gzSha256 = gzSha.final();
+
+  DeltaHeader hdr = { DELTA_MAGIC, (uint32_t)r.size, FLASH_SECTOR_SIZE, 0, {} };
+  memcpy(hdr.md5, r.md5Normalized.data(), sizeof(hdr.md5));
+  memcpy(hashList.data(), &hdr, sizeof(hdr));
+  writeFailed |= !writeFile(in.stemPath + ".sectors", hashList.data(), hashList.size());
+
+  if (patchOut) {
+    Digest prevMd5(EVP_md5());
+    prevMd5.update(in.previous->data(), in.previous->size());
+    std::vector<uint8_t> from = prevMd5.final();
+    uint32_t head[5] = { PATCH_MAGIC, (uint32_t)in.previous->size(), (uint32_t)r.size,
+                         FLASH_SECTOR_SIZE, patchCount };
+    fseek(patchOut, 0, SEEK_SET);
+    writeFailed |= fwrite(head, 1, sizeof(head), patchOut) != sizeof(head) ||
+                   fwrite(from.data(), 1, 16, patchOut) != 16 ||
+                   fwrite(r.md5.data(), 1, 16, patchOut) != 16;
+    fseek(patchOut, 0, SEEK_END);
+    r.patchSize = ftell(patchOut);
+    writeFailed |= fclose(patchOut) != 0;
+  }
+  writeFailed |= fclose(binOut) != 0;
+  writeFailed |= fclose(gzOut) != 0;
+
+  r.seconds = seconds(start);
+  r.ok = !writeFailed && r.size > 0;
+  if (writeFailed) r.error = "write failed in " + in.stemPath + ".*";
+  else if (!r.size) r.error = in.bin + " is empty";
+  return r;
+}
+
+// --- signing ------------------------------------------------------------------
+
+// Signs a SHA-256 digest with the PEM private key (RSA PKCS#1 v1.5 as the
+// core's signing.py, or ECDSA); the key is never generated here
+bool signDigest(const std::string& keyPath, const std::vector<uint8_t>& digest,
+                std::vector<uint8_t>& sig, std::string& error) {
+  FILE* f = fopen(keyPath.c_str(), "r");
+  if (!f) {
+    error = "cannot read " + keyPath;
+    return false;
+  }
+  EVP_PKEY* key = PEM_read_PrivateKey(f, nullptr, nullptr, nullptr);
+  fclose(f);
+  if (!key) {
+    error = keyPath + " is not a PEM private key";
+    return false;
+  }
+  EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(key, nullptr);
+  size_t len = 0;
+  bool ok = ctx && EVP_PKEY_sign_init(ctx) > 0 &&
+            EVP_PKEY_CTX_set_signature_md(ctx, EVP_sha256()) > 0 &&
+            EVP_PKEY_sign(ctx, nullptr, &len, digest.data(), digest.size()) > 0;
+  if (ok) {
+    sig.resize(len);
+    ok = EVP_PKEY_sign(ctx, sig.data(), &len, digest.data(), digest.size()) > 0;
+    sig.resize(len);
+  }
+  if (!ok) error = "signing with " + keyPath + " failed";
+  EVP_PKEY_CTX_free(ctx);
+  EVP_PKEY_free(key);
+  return ok;
+}
+
+// --- manifest -------------------------------------------------------------------
+
+struct Release {
+  std::string model, version, baseUrl, stem;
+  std::string sizeReport, rebootWindow;
+  std::vector<std::string> mirrors;     // base URLs serving the same firmware/ files
+  long rebootDeadline = -1;
+  uint64_t maxSize = 0;
+  bool signedArtifacts = false;
+  bool patch = false;
+};
+
+std::string jsonString(const std::string& s) {
+  std::string out = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') out += '\\';
+    if ((unsigned char)c < 0x20) {
+      char esc[8];
+      snprintf(esc, sizeof(esc), "\\u%04x", c);
+      out += esc;
+      continue;
+    }
+    out += c;
+  }
+  return out + "\"";
+}
+
+bool validWindow(const std::string& w) {
+  unsigned h1, m1, h2, m2;
+  char tail;
+  return sscanf(w.c_str(), "%u:%u-%u:%u%c", &h1, &m1, &h2, &m2, &tail) == 4 &&
+         h1 < 24 && h2 < 24 && m1 < 60 && m2 < 60;
+}
+
+// What the device needs to accept the manifest (src/main.cpp, ota_delta)
+std::vector<std::string> validate(const Release& rel, const PassResult& r) {
+  std::vector<std::string> errors;
+  if (rel.model.empty()) errors.push_back("model is empty");
+  if (rel.version.empty() || rel.version.size() >= ROLLBACK_VERSION_LEN) {
+    errors.push_back("version must be 1.." + std::to_string(ROLLBACK_VERSION_LEN - 1) + " characters");
+  }
+  for (char c : rel.version) {
+    if (!isalnum((unsigned char)c) && !strchr("._-+", c)) {
+      errors.push_back("version contains '" + std::string(1, c) + "'");
+      break;
+    }
+  }
+  if (rel.baseUrl.rfind("http://", 0) != 0 && rel.baseUrl.rfind("https://", 0) != 0) {
+    errors.push_back("base url must be http(s)://");
+  }
+  if (rel.baseUrl.size() + 1 + rel.stem.size() + strlen(".sectors") > MAX_URL) {
+    errors.push_back("urls longer than " + std::to_string(MAX_URL) + " bytes");
+  }
+  if (rel.mirrors.size() > MIRROR_MAX - 1) {
+    errors.push_back("at most " + std::to_string(MIRROR_MAX - 1) + " mirrors");
+  }
+  for (const std::string& m : rel.mirrors) {
+    if (m.rfind("http://", 0) != 0 && m.rfind("https://", 0) != 0) errors.push_back("mirror must be http(s)://");
+    if (m.size() + 1 + rel.stem.size() + strlen(".sectors") > MAX_URL) {
+      errors.push_back("mirror urls longer than " + std::to_string(MAX_URL) + " bytes");
+    }
+  }
+  if (r.firstByte != 0xE9) errors.push_back("image does not start with 0xE9");
+  if (rel.maxSize && r.size > rel.maxSize) {
+    errors.push_back("image " + std::to_string(r.size) + " > max " + std::to_string(rel.maxSize));
+  }
+  if (!rel.rebootWindow.empty() && !validWindow(rel.rebootWindow)) {
+    errors.push_back("reboot window must be HH:MM-HH:MM");
+  }
+  return errors;
+}
+
+std::string manifestJson(const Release& rel, const PassResult& r) {
+  std::string url = rel.baseUrl + "/" + rel.stem;
+  std::string j = "{\n";
+  auto field = [&j](const char* key, const std::string& value, bool last = false) {
+    j += "  \"" + std::string(key) + "\": " + value + (last ? "\n" : ",\n");
+  };
+  field("model", jsonString(rel.model));
+  field("version", jsonString(rel.version));
+  field("url", jsonString(url + ".bin"));
+  field("size", std::to_string(r.size));
+  field("md5", jsonString(hex(r.md5)));
+  field("sha256", jsonString(hex(r.sha256)));
+  field("sectors", jsonString(url + ".sectors"));
+  field("gz", jsonString(url + ".bin.gz"));
+  field("gz_size", std::to_string(r.gzSize));
+  if (rel.signedArtifacts) {
+    field("sig", jsonString(url + ".bin.sig"));
+    field("gz_sig", jsonString(url + ".bin.gz.sig"));
+  }
+  if (rel.patch) field("patch", jsonString(url + ".patch"));
+  if (!rel.mirrors.empty()) {
+    std::string list;
+    for (const std::string& m : rel.mirrors) list += (list.empty() ? "" : ", ") + jsonString(m);
+    field("mirrors", "[" + list + "]");
+  }
+  if (!rel.sizeReport.empty()) field("size_report", jsonString(rel.baseUrl + "/" + rel.sizeReport));
+  if (!rel.rebootWindow.empty()) field("reboot_window", jsonString(rel.rebootWindow));
+  if (rel.rebootDeadline >= 0) field("reboot_deadline", std::to_string(rel.rebootDeadline));
+  field("format", "1", true);
+  return j + "}\n";
+}
+
+// CBOR head: major type and argument in the shortest form (RFC 8949 4.2.1)
+void cborHead(std::string& out, uint8_t major, uint64_t v) {
+  major <<= 5;
+  if (v < 24) {
+    out += (char)(major | v);
+    return;
+  }
+  uint8_t n = v <= 0xFF ? 1 : v <= 0xFFFF ? 2 : v <= 0xFFFFFFFF ? 4 : 8;
+  out += (char)(major | (24 + (n == 1 ? 0 : n == 2 ? 1 : n == 4 ? 2 : 3)));
+  for (int i = n - 1; i >= 0; i--) out += (char)(v >> (8 * i));
+}
+
+void cborText(std::string& out, const std::string& s) {
+  cborHead(out, 3, s.size());
+  out += s;
+}
+
+std::string manifestCbor(const Release& rel) {
+  std::string url = rel.baseUrl + "/" + rel.stem;
+  std::string c;
+  uint8_t fields = 5 + !rel.mirrors.empty() + !rel.rebootWindow.empty() + (rel.rebootDeadline >= 0);
+  cborHead(c, 5, fields);
+  cborHead(c, 0, MANIFEST_KEY_MODEL);
+  cborText(c, rel.model);
+  cborHead(c, 0, MANIFEST_KEY_VERSION);
+  cborText(c, rel.version);
+  cborHead(c, 0, MANIFEST_KEY_URL);
+  cborText(c, url + ".bin");
+  cborHead(c, 0, MANIFEST_KEY_SECTORS);
+  cborText(c, url + ".sectors");
+  if (!rel.mirrors.empty()) {
+    cborHead(c, 0, MANIFEST_KEY_MIRRORS);
+    cborHead(c, 4, rel.mirrors.size());
+    for (const std::string& m : rel.mirrors) cborText(c, m);
+  }
+  if (!rel.rebootWindow.empty()) {
+    cborHead(c, 0, MANIFEST_KEY_REBOOT_WINDOW);
+    cborText(c, rel.rebootWindow);
+  }
+  if (rel.rebootDeadline >= 0) {
+    cborHead(c, 0, MANIFEST_KEY_REBOOT_DEADLINE);
+    cborHead(c, 0, rel.rebootDeadline);
+  }
+  // format, as in the JSON (text key: older devices skip it like any unknown key)
+  cborText(c, "format");
+  cborHead(c, 0, 1);
+  return c;
+}
+
+struct MemReader {
+  const std::string& s;
+  size_t at = 0;
+  size_t readBytes(char* out, size_t n) {
+    n = std::min(n, s.size() - at);
+    memcpy(out, s.data() + at, n);
+    at += n;
+    return n;
+  }
+};
+
+// The device's decoder must read back what was written, field for field
+void checkCbor(const std::string& cbor, const Release& rel, std::vector<std::string>& errors) {
+  MemReader in{ cbor };
+  ManifestFields f;
+  ManifestError e = manifestDecodeCbor(in, f);
+  if (e) {
+    errors.push_back(std::string("manifest.cbor: ") + manifestErrorName(e));
+    return;
+  }
+  std::string mirrors;
+  for (const std::string& m : rel.mirrors) mirrors += (mirrors.empty() ? "" : " ") + m;
+  std::string url = rel.baseUrl + "/" + rel.stem;
+  if (in.at != cbor.size() || f.model != rel.model || f.version != rel.version ||
+      f.url != url + ".bin" || f.sectors != url + ".sectors" || f.mirrors != mirrors ||
+      f.rebootWindow != rel.rebootWindow || f.rebootDeadline != (uint32_t)std::max(0L, rel.rebootDeadline)) {
+    errors.push_back("manifest.cbor does not decode to the manifest");
+  }
+}
+
+std::string reportJson(const PassResult& r, const PassInput& in) {
+  char buf[1024];
+  snprintf(buf, sizeof(buf),
+           "{\n  \"size\": %llu,\n  \"md5\": \"%s\",\n  \"sha256\": \"%s\",\n"
+           "  \"gz_size\": %llu,\n  \"gz_sha256\": \"%s\",\n  \"sectors\": %u,\n"
+           "  \"previous\": %s,\n  \"skipped\": %u,\n  \"downloaded\": %u,\n  \"requests\": %u,\n"
+           "  \"patch_size\": %llu,\n  \"threads\": %u,\n  \"seconds\": %.3f\n}\n",
+           (unsigned long long)r.size, hex(r.md5).c_str(), hex(r.sha256).c_str(),
+           (unsigned long long)r.gzSize, hex(r.gzSha256).c_str(), r.sectors,
+           in.previous ? "true" : "false", in.previous ? r.sectors - r.changed : 0,
+           in.previous ? r.changed : r.sectors, in.previous ? r.requests : 1,
+           (unsigned long long)r.patchSize, in.threads, r.seconds);
+  return buf;
+}
+
+// --- benchmark ------------------------------------------------------------------
+
+// One read per artifact, single thread: what the shell pipeline did
+double runMultiPass(const std::string& bin, const std::string& stemPath, int gzipLevel) {
+  auto start = std::chrono::steady_clock::now();
+  auto eachChunk = [&](const std::function<void(const uint8_t*, size_t)>& fn) {
+    FILE* f = fopen(bin.c_str(), "rb");
+    std::vector<uint8_t> buf(CHUNK);
+    size_t n;
+    while ((n = fread(buf.data(), 1, buf.size(), f)) > 0) fn(buf.data(), n);
+    fclose(f);
+  };
+  Digest md5(EVP_md5()), sha(EVP_sha256());
+  eachChunk([&](const uint8_t* p, size_t n) { md5.update(p, n); });
+  eachChunk([&](const uint8_t* p, size_t n) { sha.update(p, n); });
+  std::vector<uint8_t> hashes;
+  eachChunk([&](const uint8_t* p, size_t n) {
+    for (size_t off = 0; off < n; off += FLASH_SECTOR_SIZE) {
+      uint8_t md[EVP_MAX_MD_SIZE];
+      unsigned len;
+      EVP_Digest(p + off, std::min<size_t>(FLASH_SECTOR_SIZE, n - off), md, &len, EVP_md5(), nullptr);
+      hashes.insert(hashes.end(), md, md + DELTA_HASH_LEN);
+    }
+  });
+  std::string mode = "wb" + std::to_string(gzipLevel);
+  gzFile gz = gzopen((stemPath + ".multi.gz").c_str(), mode.c_str());
+  eachChunk([&](const uint8_t* p, size_t n) { gzwrite(gz, p, n); });
+  gzclose(gz);
+  md5.final();
+  sha.final();
+  return seconds(start);
+}
+
+// Firmware-like content: code-ish bytes with repeats, so gzip has work to do
+std::vector<uint8_t> syntheticImage(size_t size, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::vector<uint8_t> img(size);
+  for (size_t i = 0; i < size; i++) {
+    img[i] = (i % 64 < 40) ? (uint8_t)(rng() & 0x3F) : img[i >= 4096 ? i - 4096 : 0];
+  }
+  img[0] = 0xE9;
+  return img;
+}
+
+int bench(const std::vector<size_t>& sizesMiB, int gzipLevel) {
+  unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+  std::string dir = "/tmp/release-bench";
+  std::string mk = "mkdir -p " + dir;
+  if (system(mk.c_str()) != 0) return 1;
+
+  printf("%8s %12s %14s %14s %10s\n", "MiB", "multi-pass", "1 thread", std::to_string(cores).append(" threads").c_str(), "patch");
+  for (size_t mib : sizesMiB) {
+    std::vector<uint8_t> previous = syntheticImage(mib << 20, 1);
+    std::vector<uint8_t> image = previous;
+    std::mt19937 rng(2);
+    for (size_t s = 0; s < image.size() / FLASH_SECTOR_SIZE / 20; s++) {   // ~5 % of the sectors change
+      image[(rng() % (image.size() / FLASH_SECTOR_SIZE)) * FLASH_SECTOR_SIZE + 100] ^= 0x55;
+    }
+    std::string bin = dir + "/image.bin";
+    writeFile(bin, image.data(), image.size());
+
+    double multi = runMultiPass(bin, dir + "/multi", gzipLevel);
+    PassInput in;
+    in.gzipLevel = gzipLevel;
+    in.bin = bin;
+    in.stemPath = dir + "/single";
+    in.previous = &previous;
+    in.threads = 1;
+    PassResult one = runPass(in);
+    in.threads = cores;
+    PassResult many = runPass(in);
+    if (!one.ok || !many.ok || one.md5 != many.md5) {
+      fprintf(stderr, "bench: pass failed\n");
+      return 1;
+    }
+    auto rate = [mib](double s) { return std::to_string((int)(mib / s)) + " MiB/s"; };
+    printf("%8zu %12s %14s %14s %9u%%\n", mib, rate(multi).c_str(), rate(one.seconds).c_str(),
+           rate(many.seconds).c_str(), (unsigned)(100 * many.changed / many.sectors));
+  }
+  return 0;
+}
+
+// --- main -----------------------------------------------------------------------
+
+int usage() {
+  fprintf(stderr,
+          "usage: release --bin FILE --out DIR --model M --version V --base-url URL\n"
+          "               [--previous-bin FILE] [--sign-key PEM] [--max-size BYTES]\n"
+          "               [--size-report NAME] [--reboot-window HH:MM-HH:MM] [--reboot-deadline S]\n"
+          "               [--mirror BASE-URL ...]\n"
+          "               [--threads N] [--gzip-level 1-9]\n"
+          "       release [--gzip-level 1-9] --bench [MiB ...]\n");
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Release rel;
+  PassInput in;
+  std::string out, previousBin, signKey;
+  in.threads = std::max(1u, std::thread::hardware_concurrency());
+
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    if (a == "--bench") {
+      std::vector<size_t> sizes;
+      for (int j = i + 1; j < argc; j++) sizes.push_back(strtoul(argv[j], nullptr, 10));
+      if (sizes.empty()) sizes = { 1, 16, 64 };
+      return bench(sizes, in.gzipLevel);
+    }
+    if (i + 1 >= argc) return usage();
+    std::string v = argv[++i];
+    if (a == "--bin") in.bin = v;
+    else if (a == "--out") out = v;
+    else if (a == "--model") rel.model = v;
+    else if (a == "--version") rel.version = v;
+    else if (a == "--base-url") rel.baseUrl = v;
+    else if (a == "--mirror") rel.mirrors.push_back(v);
+    else if (a == "--previous-bin") previousBin = v;
+    else if (a == "--sign-key") signKey = v;
+    else if (a == "--max-size") rel.maxSize = strtoull(v.c_str(), nullptr, 10);
+    else if (a == "--size-report") rel.sizeReport = v;
+    else if (a == "--reboot-window") rel.rebootWindow = v;
+    else if (a == "--reboot-deadline") rel.rebootDeadline = strtol(v.c_str(), nullptr, 10);
+    else if (a == "--threads") in.threads = std::max(1, atoi(v.c_str()));
+    else if (a == "--gzip-level") in.gzipLevel = std::min(9, std::max(1, atoi(v.c_str())));
+    else return usage();
+  }
+  if (in.bin.empty() || out.empty()) return usage();
+  while (!rel.baseUrl.empty() && rel.baseUrl.back() == '/') rel.baseUrl.pop_back();
+  for (std::string& m : rel.mirrors) {
+    while (!m.empty() && m.back() == '/') m.pop_back();
+  }
+
+  std::vector<uint8_t> previous;
+  if (!previousBin.empty()) {
+    if (readFile(previousBin, previous) && !previous.empty()) {
+      in.previous = &previous;
+      rel.patch = true;
+    } else {
+      fprintf(stderr, "release: no previous image at %s, no patch\n", previousBin.c_str());
+    }
+  }
+
+  rel.stem = rel.model + "-" + rel.version;
+  std::string mk = "mkdir -p '" + out + "/firmware'";
+  if (system(mk.c_str()) != 0) return 1;
+  in.stemPath = out + "/firmware/" + rel.stem;
+
+  PassResult r = runPass(in);
+  if (!r.ok) {
+    fprintf(stderr, "release: %s\n", r.error.c_str());
+    return 1;
+  }
+
+  if (!signKey.empty()) {
+    std::vector<uint8_t> sig, gzSig;
+    std::string error;
+    if (!signDigest(signKey, r.sha256, sig, error) || !signDigest(signKey, r.gzSha256, gzSig, error) ||
+        !writeFile(in.stemPath + ".bin.sig", sig.data(), sig.size()) ||
+        !writeFile(in.stemPath + ".bin.gz.sig", gzSig.data(), gzSig.size())) {
+      fprintf(stderr, "release: %s\n", error.empty() ? "cannot write signatures" : error.c_str());
+      return 1;
+    }
+    rel.signedArtifacts = true;
+  }
+
+  std::vector<std::string> errors = validate(rel, r);
+  std::string cbor = manifestCbor(rel);
+  if (errors.empty()) checkCbor(cbor, rel, errors);
+  for (const std::string& e : errors) fprintf(stderr, "release: manifest: %s\n", e.c_str());
+  if (!errors.empty()) return 1;
+
+  std::string manifest = manifestJson(rel, r);
+  std::string report = reportJson(r, in);
+  if (!writeFile(out + "/manifest.json", manifest.data(), manifest.size()) ||
+      !writeFile(out + "/manifest.cbor", cbor.data(), cbor.size()) ||
+      !writeFile(in.stemPath + ".release.json", report.data(), report.size())) {
+    fprintf(stderr, "release: cannot write the manifest\n");
+    return 1;
+  }
+
+  printf("%s: %llu bytes, %u sectors, gz %llu bytes, %.3f s on %u threads\n", rel.stem.c_str(),
+         (unsigned long long)r.size, r.sectors, (unsigned long long)r.gzSize, r.seconds, in.threads);
+  if (in.previous) {
+    printf("vs previous: %u sectors skipped, %u downloaded in %u Range requests, patch %llu bytes\n",
+           r.sectors - r.changed, r.changed, r.requests, (unsigned long long)r.patchSize);
+  }
+  printf("manifest.json %zu bytes, manifest.cbor %zu bytes\n", manifest.size(), cbor.size());
+  fputs(manifest.c_str(), stdout);
+  return 0;
+}
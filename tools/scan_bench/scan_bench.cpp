@@ -0,0 +1,177 @@
+// Host benchmark and check of the portal's wifiscan sort/dedup
+// (lib/WiFiManager/wm_scan.h) against the selection sort + pairwise String
+// compare it replaced. Scan results come from a fake SDK that counts calls:
+// on the ESP each WiFi.SSID(i) builds a String, so the call count is what
+// carries over, not the host microseconds.
+//
+//   g++ -std=c++17 -O2 -Ilib/WiFiManager tools/scan_bench/scan_bench.cpp -o scan_bench && ./scan_bench
+//
+// For random scans (dense duplicate SSIDs, RSSI ties, forced hash
+// collisions) both must show the same networks, strongest first, each at
+// the RSSI of its strongest AP. Exit code 1 on a mismatch.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "wm_scan.h"
+
+namespace {
+
+struct Ap {
+  int32_t rssi;
+  std::string ssid;
+};
+
+// WiFi.RSSI(i) / WiFi.SSID(i) of the ESP8266 core, counted
+struct FakeSdk {
+  std::vector<Ap> aps;
+  long calls = 0;
+
+  int32_t rssi(int i) {
+    calls++;
+    return aps[i].rssi;
+  }
+  std::string ssid(int i) {
+    calls++;
+    return aps[i].ssid;
+  }
+};
+
+struct Shown {
+  int32_t rssi;
+  std::string ssid;
+  bool operator==(const Shown& o) const { return rssi == o.rssi && ssid == o.ssid; }
+};
+
+// getScanItemOut() before user-026
+std::vector<Shown> oldScan(FakeSdk& sdk) {
+  int n = sdk.aps.size();
+  std::vector<int> indices(n);
+  for (int i = 0; i < n; i++) indices[i] = i;
+  for (int i = 0; i < n; i++) {
+    for (int j = i + 1; j < n; j++) {
+      if (sdk.rssi(indices[j]) > sdk.rssi(indices[i])) std::swap(indices[i], indices[j]);
+    }
+  }
+  for (int i = 0; i < n; i++) {
+    if (indices[i] == -1) continue;
+    std::string cssid = sdk.ssid(indices[i]);
+    for (int j = i + 1; j < n; j++) {
+      // WiFi.SSID(-1) is called too and returns ""
+      if (indices[j] == -1) {
+        sdk.calls++;
+      } else if (cssid == sdk.ssid(indices[j])) {
+        indices[j] = -1;
+      }
+    }
+  }
+  std::vector<Shown> out;
+  for (int i : indices) {
+    if (i != -1) out.push_back({ sdk.aps[i].rssi, sdk.aps[i].ssid });
+  }
+  return out;
+}
+
+// WiFi_scanSnapshot()
+std::vector<Shown> newScan(FakeSdk& sdk, uint32_t (*hash)(const std::string&)) {
+  int n = sdk.aps.size();
+  std::vector<wm_scanitem_t> items;
+  items.reserve(n);
+  for (int i = 0; i < n; i++) {
+    wm_scanitem_t item;
+    item.rssi = sdk.rssi(i);
+    item.enc = 0;
+    item.index = i;
+    item.dup = false;
+    item.hash = hash(sdk.ssid(i));
+    items.push_back(item);
+  }
+  wm_scanSortDedup(items, true, [&](uint8_t a, uint8_t b) { return sdk.ssid(a) == sdk.ssid(b); });
+  std::vector<Shown> out;
+  for (const wm_scanitem_t& item : items) {
+    if (!item.dup) out.push_back({ sdk.aps[item.index].rssi, sdk.aps[item.index].ssid });
+  }
+  return out;
+}
+
+uint32_t fnv(const std::string& s) {
+  return wm_ssidHash(s.data(), s.size());
+}
+
+uint32_t collide(const std::string& s) {
+  return wm_ssidHash(s.data(), s.size()) & 3;   // 4 distinct hashes: every lookup probes
+}
+
+// Order among equal RSSI differs (the old sort was not stable): compare as
+// sets, and check the new output is sorted
+bool sameNetworks(std::vector<Shown> a, std::vector<Shown> b) {
+  auto bySsid = [](const Shown& x, const Shown& y) { return x.ssid < y.ssid; };
+  std::sort(a.begin(), a.end(), bySsid);
+  std::sort(b.begin(), b.end(), bySsid);
+  return a == b;
+}
+
+bool sorted(const std::vector<Shown>& v) {
+  for (size_t i = 1; i < v.size(); i++) {
+    if (v[i].rssi > v[i - 1].rssi) return false;
+  }
+  return true;
+}
+
+FakeSdk randomScan(std::mt19937& rng, int n) {
+  FakeSdk sdk;
+  int names = std::max(1, n * 2 / 3);   // about a third are repeaters/mesh nodes
+  for (int i = 0; i < n; i++) {
+    sdk.aps.push_back({ -30 - (int)(rng() % 60), "net" + std::to_string(rng() % names) });
+  }
+  return sdk;
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 rng(1);
+  int failures = 0;
+  for (int round = 0; round < 2000; round++) {
+    int n = 1 + rng() % 120;
+    FakeSdk sdk = randomScan(rng, n);
+    std::vector<Shown> ref = oldScan(sdk);
+    for (auto hash : { fnv, collide }) {
+      std::vector<Shown> got = newScan(sdk, hash);
+      if (!sameNetworks(ref, got) || !sorted(got)) {
+        if (failures++ < 5) fprintf(stderr, "scan_bench: mismatch, %d APs\n", n);
+      }
+    }
+  }
+  if (failures) {
+    fprintf(stderr, "scan_bench: %d mismatches\n", failures);
+    return 1;
+  }
+
+  printf("%5s %12s %12s %12s %12s\n", "APs", "old us", "old calls", "new us", "new calls");
+  for (int n : { 20, 40, 60, 100 }) {
+    FakeSdk sdk = randomScan(rng, n);
+    const int reps = 2000;
+    double us[2] = { 0, 0 };
+    long calls[2] = { 0, 0 };
+    for (int r = 0; r < reps; r++) {
+      for (int which = 0; which < 2; which++) {
+        sdk.calls = 0;
+        auto start = std::chrono::steady_clock::now();
+        if (which == 0) {
+          oldScan(sdk);
+        } else {
+          newScan(sdk, fnv);
+        }
+        us[which] += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        calls[which] += sdk.calls;
+      }
+    }
+    printf("%5d %12.1f %12ld %12.1f %12ld\n", n, us[0] / reps, calls[0] / reps, us[1] / reps, calls[1] / reps);
+  }
+  return 0;
+}
@@ -0,0 +1,181 @@
+// Host simulation of the wall clock restore (include/time_sync.h).
+//
+// Checks timeRestoreS() on crafted records, then runs a device for --days:
+// the RTC tick counter runs at a calibration that is off by --drift ppm
+// and wraps at 32 bit, the clock is saved like src/time_sync.cpp does
+// (every TIME_SAVE_INTERVAL_MS and before planned restarts), and resets
+// (RTC memory kept) and power cuts (RTC memory garbage, counter from 0)
+// come at random. After every boot the restored time is compared with
+// what its record said plus the true time since; a device that restored
+// keeps saving its restored clock until SNTP answers, as the firmware does.
+//
+//   g++ -std=c++17 -O2 -Iinclude tools/time_sim/time_sim.cpp -o time_sim && ./time_sim
+//   ./time_sim --days 30 --drift 2000 --seed 7
+//
+// Exit code 1 if a check fails.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "time_sync.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+  printf("  %-56s %s\n", what.c_str(), ok ? "ok" : "FAIL");
+  if (!ok) failures++;
+}
+
+const uint32_t CALI = 23552;    // ~5.75 us per tick, << 12
+const uint32_t WALL = 1700000000;
+
+// Counter ticks for at least `seconds`
+uint32_t ticks(double seconds) {
+  return (uint32_t)(uint64_t)ceil(seconds * 1e6 * 4096 / CALI);
+}
+
+void records() {
+  printf("records:\n");
+  TimeRtc rec = { TIME_MAGIC, WALL, 1000, CALI };
+  check(timeRestoreS(rec, 1000) == WALL, "no time passed");
+  check(timeRestoreS(rec, 1000 + ticks(42.5)) == WALL + 42, "elapsed ticks times the calibration");
+  check(timeRestoreS(rec, 1000 + ticks(TIME_RESTORE_MAX_S)) == WALL + TIME_RESTORE_MAX_S,
+        "up to TIME_RESTORE_MAX_S");
+  check(timeRestoreS(rec, 1000 + ticks(TIME_RESTORE_MAX_S + 1)) == 0, "refused past TIME_RESTORE_MAX_S");
+  check(timeRestoreS(rec, 999) == 0, "counter behind the record: refused, not negative");
+
+  TimeRtc wrap = { TIME_MAGIC, WALL, 0xFFFFFFFFu - ticks(10), CALI };
+  check(timeRestoreS(wrap, ticks(20)) == WALL + 30, "across the 32 bit wrap of the counter");
+
+  TimeRtc bad = rec;
+  bad.magic = ~TIME_MAGIC;
+  check(timeRestoreS(bad, 1000) == 0, "wrong magic");
+  bad = rec;
+  bad.wallS = 86400;   // saved before SNTP: the unset clock
+  check(timeRestoreS(bad, 1000) == 0, "unset clock at save");
+  bad = rec;
+  bad.rtcCali = 0;
+  check(timeRestoreS(bad, 1000) == 0, "no calibration");
+  TimeRtc slow = { TIME_MAGIC, WALL, 0, CALI * 2 };
+  check(timeRestoreS(slow, ticks(100)) == WALL + 200, "record's calibration used");
+}
+
+struct Run {
+  uint32_t boots = 0, restored = 0, refused = 0, garbage = 0, wrongGarbage = 0;
+  double worstRestoreS = 0, worstClockS = 0;
+};
+
+uint32_t arg(int argc, char** argv, const char* name, uint32_t def) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (!strcmp(argv[i], name)) return (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+  }
+  return def;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 >= argc || (strcmp(argv[i], "--days") && strcmp(argv[i], "--drift") && strcmp(argv[i], "--seed"))) {
+      fprintf(stderr, "usage: time_sim [--days N] [--drift PPM] [--seed N]\n");
+      return 2;
+    }
+  }
+  uint32_t days = arg(argc, argv, "--days", 30);
+  uint32_t driftPpm = arg(argc, argv, "--drift", 2000);
+  std::mt19937 rng(arg(argc, argv, "--seed", 1));
+
+  records();
+
+  // The counter runs at CALI off by driftPpm; the record says CALI. Time in
+  // seconds of the simulation, events in steps of one second.
+  printf("device: %u days, RTC off by %u ppm\n", days, driftPpm);
+  const double tickUs = CALI / 4096.0 * (1 + driftPpm / 1e6);
+  std::uniform_int_distribution<uint32_t> word;
+  std::uniform_real_distribution<double> uni(0, 1);
+  Run r;
+  uint32_t rtcMem[sizeof(TimeRtc) / 4];
+  for (uint32_t& w : rtcMem) w = word(rng);   // power-on: garbage
+  double counterStart = 0;                    // when the counter was last 0
+  bool valid = false, synced = false;         // this boot
+  double clockErr = 0;                        // device clock - true time, once valid
+  double lastSave = 0;
+  auto counter = [&](double t) { return (uint32_t)(uint64_t)((t - counterStart) * 1e6 / tickUs); };
+  auto save = [&](double t) {
+    if (!valid) return;
+    TimeRtc rec = { TIME_MAGIC, (uint32_t)(WALL + t + clockErr), counter(t), CALI };
+    memcpy(rtcMem, &rec, sizeof(rec));
+    lastSave = t;
+  };
+  auto boot = [&](double t, bool powerOn) {
+    r.boots++;
+    if (powerOn) r.garbage++;
+    TimeRtc rec;
+    memcpy(&rec, rtcMem, sizeof(rec));
+    uint32_t now = timeRestoreS(rec, counter(t));
+    valid = synced = false;
+    if (!now) {
+      r.refused++;
+    } else if (powerOn) {
+      r.wrongGarbage++;   // must never restore from garbage
+    } else {
+      // against what the record said plus the true time since
+      r.restored++;
+      r.worstRestoreS = std::max(r.worstRestoreS, fabs(now - (rec.wallS + (t - lastSave))));
+      valid = true;
+      clockErr = now - (WALL + t);
+      r.worstClockS = std::max(r.worstClockS, fabs(clockErr));
+    }
+  };
+
+  boot(0, true);
+  double syncAt = 5 + uni(rng) * 60;
+  for (double t = 1; t < days * 86400.0; t += 1) {
+    if (!synced && t >= syncAt) {
+      synced = valid = true;   // SNTP answered: saved right away
+      clockErr = 0;
+      save(t);
+    }
+    if (valid && t - lastSave >= TIME_SAVE_INTERVAL_MS / 1000) save(t);
+
+    double p = uni(rng);
+    if (p < 1.0 / (6 * 3600)) {            // planned restart, saved first
+      save(t);
+      boot(t, false);
+    } else if (p < 2.0 / (6 * 3600)) {     // crash or watchdog
+      boot(t, false);
+    } else if (p < 2.0 / (6 * 3600) + 1.0 / (3 * 86400)) {   // power cut
+      for (uint32_t& w : rtcMem) w = word(rng);
+      counterStart = t;
+      boot(t, true);
+    } else {
+      continue;
+    }
+    syncAt = t + 5 + uni(rng) * 60;
+  }
+
+  // A restore is off by the drift over at most TIME_SAVE_INTERVAL_MS plus
+  // the truncation to whole seconds on both ends
+  double bound = TIME_SAVE_INTERVAL_MS / 1000.0 * driftPpm / 1e6 + 2;
+  printf("  %u boots: %u restored, %u refused, %u after power-on\n", r.boots, r.restored, r.refused, r.garbage);
+  printf("  worst restore %.1f s off its record, device clock %.1f s off before SNTP\n", r.worstRestoreS,
+         r.worstClockS);
+  check(r.wrongGarbage == 0, "never restored from power-on garbage");
+  check(r.restored > r.boots / 2, "most resets restore the clock");
+  check(r.worstRestoreS <= bound, "restored within the drift since the last save");
+
+  if (failures) {
+    fprintf(stderr, "time_sim: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("time_sim: ok\n");
+  return 0;
+}
@@ -0,0 +1,415 @@
+// TLS trust data for OTA_TLS_TRUST (include/tls_trust.h): connects to the
+// update hosts, shows their chains and writes the header the device builds
+// with: the public key of each host (TLS_PINS, for TLS_TRUST_KEY) and the
+// roots the chains end in (TLS_ANCHORS, for TLS_TRUST_ANCHORS). Roots come
+// from the system store the chain verified against; a chain that does not
+// verify is reported and its topmost certificate used instead, to be
+// checked by hand. The output is only as good as the network it was taken
+// from: compare the printed pin-sha256 values with another vantage point
+// before committing it.
+//
+//   g++ -std=c++17 -O2 -pthread tools/tls_pins/tls_pins.cpp -lssl -lcrypto -o tls_pins
+//   ./tls_pins [--out include/tls_trust_data.h] [--next-key HOST=PEM ...] HOST[:PORT] ...
+//   ./tls_pins --bench [N]     handshake cost per trust mode, local server
+//
+// --next-key adds a key to try after the live one (announced rotation).
+//
+// The benchmark runs N full handshakes (no resumption, TLS 1.2 ECDHE-RSA
+// like the device) against a local server with a root -> intermediate ->
+// leaf chain of RSA-2048 certificates, in the three modes: no check, leaf
+// key compared with the pin, chain validated against the root. Host CPU
+// figures: they show the share of the validation in a handshake, not the
+// ESP8266 times (ota_tls_connect_ms on /metrics gives those per build).
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string bioString(BIO* b) {
+  char* data;
+  long n = BIO_get_mem_data(b, &data);
+  std::string s(data, n);
+  BIO_free(b);
+  return s;
+}
+
+std::string pemOfKey(EVP_PKEY* key) {
+  BIO* b = BIO_new(BIO_s_mem());
+  PEM_write_bio_PUBKEY(b, key);
+  return bioString(b);
+}
+
+std::string pemOfCert(X509* cert) {
+  BIO* b = BIO_new(BIO_s_mem());
+  PEM_write_bio_X509(b, cert);
+  return bioString(b);
+}
+
+std::string subjectOf(X509* cert) {
+  BIO* b = BIO_new(BIO_s_mem());
+  X509_NAME_print_ex(b, X509_get_subject_name(cert), 0, XN_FLAG_ONELINE);
+  return bioString(b);
+}
+
+// pin-sha256 as in RFC 7469: base64 of the SHA-256 of the DER SubjectPublicKeyInfo
+std::string spkiPin(X509* cert) {
+  unsigned char* der = nullptr;
+  int len = i2d_PUBKEY(X509_get0_pubkey(cert), &der);
+  unsigned char md[32];
+  EVP_Digest(der, len, md, nullptr, EVP_sha256(), nullptr);
+  OPENSSL_free(der);
+  unsigned char b64[64];
+  EVP_EncodeBlock(b64, md, sizeof(md));
+  return (const char*)b64;
+}
+
+std::string notAfter(X509* cert) {
+  BIO* b = BIO_new(BIO_s_mem());
+  ASN1_TIME_print(b, X509_get0_notAfter(cert));
+  return bioString(b);
+}
+
+int tcpConnect(const std::string& host, const std::string& port) {
+  addrinfo hints{}, *res;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0) return -1;
+  int fd = -1;
+  for (addrinfo* a = res; a && fd < 0; a = a->ai_next) {
+    fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(res);
+  return fd;
+}
+
+struct HostTrust {
+  std::string host;
+  std::vector<std::string> keys;   // PEM, live one first
+};
+
+// --- collect ---------------------------------------------------------------------
+
+bool inspect(const std::string& target, HostTrust& out, std::vector<std::string>& anchors) {
+  std::string host = target, port = "443";
+  size_t colon = target.rfind(':');
+  if (colon != std::string::npos) {
+    host = target.substr(0, colon);
+    port = target.substr(colon + 1);
+  }
+  out.host = host;
+
+  SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+  SSL_CTX_set_default_verify_paths(ctx);
+  SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);   // report, do not abort
+  int fd = tcpConnect(host, port);
+  if (fd < 0) {
+    fprintf(stderr, "tls_pins: %s: cannot connect\n", target.c_str());
+    SSL_CTX_free(ctx);
+    return false;
+  }
+  SSL* ssl = SSL_new(ctx);
+  SSL_set_fd(ssl, fd);
+  SSL_set_tlsext_host_name(ssl, host.c_str());
+  SSL_set1_host(ssl, host.c_str());
+  bool ok = SSL_connect(ssl) == 1;
+  if (!ok) {
+    fprintf(stderr, "tls_pins: %s: handshake failed\n", target.c_str());
+  } else {
+    long verify = SSL_get_verify_result(ssl);
+    STACK_OF(X509)* presented = SSL_get_peer_cert_chain(ssl);
+    STACK_OF(X509)* verified = verify == X509_V_OK ? SSL_get0_verified_chain(ssl) : nullptr;
+    printf("%s  %s\n", target.c_str(),
+           verified ? "chain verified" : X509_verify_cert_error_string(verify));
+    STACK_OF(X509)* chain = verified ? verified : presented;
+    for (int i = 0; i < sk_X509_num(chain); i++) {
+      X509* c = sk_X509_value(chain, i);
+      printf("  %d %s\n    pin-sha256 %s  until %s\n", i, subjectOf(c).c_str(), spkiPin(c).c_str(),
+             notAfter(c).c_str());
+    }
+    out.keys.push_back(pemOfKey(X509_get0_pubkey(sk_X509_value(chain, 0))));
+    std::string root = pemOfCert(sk_X509_value(chain, sk_X509_num(chain) - 1));
+    if (!verified) printf("  (not verified: the topmost certificate above becomes the anchor, check it)\n");
+    if (std::find(anchors.begin(), anchors.end(), root) == anchors.end()) anchors.push_back(root);
+  }
+  SSL_free(ssl);
+  close(fd);
+  SSL_CTX_free(ctx);
+  return ok;
+}
+
+std::string cString(const std::string& pem) {
+  return "R\"PEM(" + pem + ")PEM\"";
+}
+
+std::string header(const std::vector<HostTrust>& hosts, const std::vector<std::string>& anchors) {
+  char date[32];
+  time_t now = time(nullptr);
+  strftime(date, sizeof(date), "%Y-%m-%d", gmtime(&now));
+  std::string h = "// Generated by tools/tls_pins on " + std::string(date) + " for";
+  for (const HostTrust& t : hosts) h += " " + t.host;
+  h += ".\n// Review the pins printed by the tool before committing.\n\n#include \"tls_trust.h\"\n\n";
+  std::string pins;
+  int n = 0;
+  for (const HostTrust& t : hosts) {
+    for (const std::string& k : t.keys) {
+      std::string name = "TLS_KEY_" + std::to_string(n++);
+      h += "static const char " + name + "[] PROGMEM = " + cString(k) + ";\n";
+      pins += "  { \"" + t.host + "\", " + name + " },\n";
+    }
+  }
+  h += "\nstatic const TlsPin TLS_PINS[] = {\n" + pins + "};\n\nstatic const char TLS_ANCHORS[] PROGMEM = ";
+  std::string all;
+  for (const std::string& a : anchors) all += a;
+  return h + cString(all) + ";\n";
+}
+
+// --- bench -----------------------------------------------------------------------
+
+EVP_PKEY* newKey() {
+  return EVP_RSA_gen(2048);
+}
+
+X509* newCert(const char* cn, EVP_PKEY* key, X509* issuer, EVP_PKEY* issuerKey, bool ca) {
+  X509* c = X509_new();
+  static long serial = 1;
+  ASN1_INTEGER_set(X509_get_serialNumber(c), serial++);
+  X509_gmtime_adj(X509_getm_notBefore(c), -3600);
+  X509_gmtime_adj(X509_getm_notAfter(c), 24 * 3600);
+  X509_set_pubkey(c, key);
+  X509_NAME_add_entry_by_txt(X509_get_subject_name(c), "CN", MBSTRING_ASC, (const unsigned char*)cn, -1, -1, 0);
+  X509_set_issuer_name(c, X509_get_subject_name(issuer ? issuer : c));
+  X509V3_CTX v3;
+  X509V3_set_ctx(&v3, issuer ? issuer : c, c, nullptr, nullptr, 0);
+  X509_EXTENSION* ext = X509V3_EXT_conf_nid(nullptr, &v3, NID_basic_constraints, ca ? "critical,CA:TRUE" : "CA:FALSE");
+  X509_add_ext(c, ext, -1);
+  X509_EXTENSION_free(ext);
+  X509_sign(c, issuerKey ? issuerKey : key, EVP_sha256());
+  return c;
+}
+
+enum Mode { NONE, PIN, CHAIN };
+
+double handshakeMs(int port, Mode mode, X509* root, const std::string& pinnedDer) {
+  SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+  SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+  SSL_CTX_set_cipher_list(ctx, "ECDHE-RSA-AES128-GCM-SHA256");
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+  SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+  if (mode == CHAIN) {
+    X509_STORE_add_cert(SSL_CTX_get_cert_store(ctx), root);
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+  } else {
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);
+    // without a store there is nothing to verify against; the chain is still parsed
+  }
+  auto start = std::chrono::steady_clock::now();
+  int fd = tcpConnect("127.0.0.1", std::to_string(port));
+  SSL* ssl = SSL_new(ctx);
+  SSL_set_fd(ssl, fd);
+  SSL_set1_host(ssl, mode == CHAIN ? "ota-leaf" : nullptr);
+  bool ok = SSL_connect(ssl) == 1;
+  if (ok && mode == PIN) {
+    unsigned char* der = nullptr;
+    int len = i2d_X509_PUBKEY(X509_get_X509_PUBKEY(SSL_get0_peer_certificate(ssl)), &der);
+    ok = std::string((char*)der, len) == pinnedDer;
+    OPENSSL_free(der);
+  }
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  SSL_shutdown(ssl);
+  SSL_free(ssl);
+  close(fd);
+  SSL_CTX_free(ctx);
+  return ok ? ms : -1;
+}
+
+int bench(int n) {
+  EVP_PKEY* rootKey = newKey();
+  EVP_PKEY* interKey = newKey();
+  EVP_PKEY* leafKey = newKey();
+  X509* root = newCert("ota-root", rootKey, nullptr, nullptr, true);
+  X509* inter = newCert("ota-intermediate", interKey, root, rootKey, true);
+  X509* leaf = newCert("ota-leaf", leafKey, inter, interKey, false);
+  GENERAL_NAMES* san = GENERAL_NAMES_new();
+  GENERAL_NAME* dns = GENERAL_NAME_new();
+  ASN1_IA5STRING* name = ASN1_IA5STRING_new();
+  ASN1_STRING_set(name, "ota-leaf", -1);
+  GENERAL_NAME_set0_value(dns, GEN_DNS, name);
+  sk_GENERAL_NAME_push(san, dns);
+  X509_add1_ext_i2d(leaf, NID_subject_alt_name, san, 0, X509V3_ADD_REPLACE);
+  GENERAL_NAMES_free(san);
+  X509_sign(leaf, interKey, EVP_sha256());
+
+  SSL_CTX* sctx = SSL_CTX_new(TLS_server_method());
+  SSL_CTX_use_certificate(sctx, leaf);
+  SSL_CTX_add1_chain_cert(sctx, inter);
+  SSL_CTX_use_PrivateKey(sctx, leafKey);
+  SSL_CTX_set_session_cache_mode(sctx, SSL_SESS_CACHE_OFF);
+  SSL_CTX_set_options(sctx, SSL_OP_NO_TICKET);
+
+  int lfd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t alen = sizeof(addr);
+  if (bind(lfd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(lfd, 16) != 0) return 1;
+  getsockname(lfd, (sockaddr*)&addr, &alen);
+  int port = ntohs(addr.sin_port);
+  std::atomic<bool> stop{ false };
+  std::thread server([&] {
+    while (!stop) {
+      int fd = accept(lfd, nullptr, nullptr);
+      if (fd < 0) continue;
+      SSL* ssl = SSL_new(sctx);
+      SSL_set_fd(ssl, fd);
+      if (SSL_accept(ssl) == 1) SSL_shutdown(ssl);
+      SSL_free(ssl);
+      close(fd);
+    }
+  });
+
+  unsigned char* der = nullptr;
+  int len = i2d_PUBKEY(leafKey, &der);
+  std::string pinned((char*)der, len);
+  OPENSSL_free(der);
+
+  // modes interleaved, so drift and warm-up hit all three alike
+  const char* names[] = { "insecure", "key pin", "anchors" };
+  std::vector<double> ms[3];
+  for (int i = 0; i < n; i++) {
+    for (Mode m : { NONE, PIN, CHAIN }) {
+      double t = handshakeMs(port, m, root, pinned);
+      if (t < 0) {
+        fprintf(stderr, "tls_pins: %s handshake failed\n", names[m]);
+        return 1;
+      }
+      ms[m].push_back(t);
+    }
+  }
+  printf("%-10s %10s %10s %12s\n", "mode", "median ms", "p90 ms", "vs insecure");
+  double base = 0;
+  for (Mode m : { NONE, PIN, CHAIN }) {
+    std::sort(ms[m].begin(), ms[m].end());
+    double median = ms[m][n / 2];
+    if (m == NONE) base = median;
+    printf("%-10s %10.3f %10.3f %+11.1f%%\n", names[m], median, ms[m][n * 9 / 10], 100 * (median / base - 1));
+  }
+
+  // The handshake difference drowns in loopback noise; the checks alone:
+  // what each mode adds on top of the key exchange
+  X509_STORE* store = X509_STORE_new();
+  X509_STORE_add_cert(store, root);
+  STACK_OF(X509)* untrusted = sk_X509_new_null();
+  sk_X509_push(untrusted, inter);
+  int reps = n * 20;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < reps; i++) {
+    unsigned char* d = nullptr;
+    int l = i2d_X509_PUBKEY(X509_get_X509_PUBKEY(leaf), &d);
+    if (std::string((char*)d, l) != pinned) return 1;
+    OPENSSL_free(d);
+  }
+  double pinUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / reps;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < reps; i++) {
+    X509_STORE_CTX* vctx = X509_STORE_CTX_new();
+    X509_STORE_CTX_init(vctx, store, leaf, untrusted);
+    bool ok = X509_verify_cert(vctx) == 1;
+    X509_STORE_CTX_free(vctx);
+    if (!ok) return 1;
+  }
+  double chainUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / reps;
+  printf("\ncheck only: key compare %.2f us, chain validation %.1f us (%.1f%% of a handshake)\n", pinUs, chainUs,
+         chainUs / 10 / base);
+  sk_X509_free(untrusted);
+  X509_STORE_free(store);
+
+  stop = true;
+  close(tcpConnect("127.0.0.1", std::to_string(port)));   // wake accept()
+  server.join();
+  close(lfd);
+  return 0;
+}
+
+int usage() {
+  fprintf(stderr,
+          "usage: tls_pins [--out FILE] [--next-key HOST=PEM ...] HOST[:PORT] ...\n"
+          "       tls_pins --bench [N]\n");
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string out;
+  std::vector<std::string> targets;
+  std::multimap<std::string, std::string> nextKeys;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    if (a == "--bench") return bench(i + 1 < argc ? std::max(1, atoi(argv[i + 1])) : 200);
+    if (a == "--out" && i + 1 < argc) {
+      out = argv[++i];
+    } else if (a == "--next-key" && i + 1 < argc) {
+      std::string v = argv[++i];
+      size_t eq = v.find('=');
+      if (eq == std::string::npos) return usage();
+      nextKeys.emplace(v.substr(0, eq), v.substr(eq + 1));
+    } else if (a[0] == '-') {
+      return usage();
+    } else {
+      targets.push_back(a);
+    }
+  }
+  if (targets.empty()) return usage();
+
+  std::vector<HostTrust> hosts;
+  std::vector<std::string> anchors;
+  for (const std::string& t : targets) {
+    HostTrust h;
+    if (!inspect(t, h, anchors)) return 1;
+    auto range = nextKeys.equal_range(h.host);
+    for (auto it = range.first; it != range.second; ++it) {
+      std::ifstream f(it->second);
+      std::string pem((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+      if (pem.find("-----BEGIN PUBLIC KEY-----") == std::string::npos) {
+        fprintf(stderr, "tls_pins: %s: not a PEM public key\n", it->second.c_str());
+        return 1;
+      }
+      h.keys.push_back(pem);
+    }
+    hosts.push_back(h);
+  }
+
+  std::string h = header(hosts, anchors);
+  if (out.empty()) {
+    fputs(h.c_str(), stdout);
+  } else if (!(std::ofstream(out) << h)) {
+    fprintf(stderr, "tls_pins: cannot write %s\n", out.c_str());
+    return 1;
+  }
+  return 0;
+}